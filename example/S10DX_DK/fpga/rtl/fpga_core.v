@@ -110,7 +110,8 @@ example_core_pcie_ptile #(
     .WRITE_TX_LIMIT(2**TX_SEQ_NUM_WIDTH),
     .BAR0_APERTURE(BAR0_APERTURE),
     .BAR2_APERTURE(BAR2_APERTURE),
-    .BAR4_APERTURE(BAR4_APERTURE)
+    .BAR4_APERTURE(BAR4_APERTURE),
+    .CLK_FREQ_KHZ(400000)
 )
 core_inst (
     .clk(clk),
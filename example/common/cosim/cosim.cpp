@@ -0,0 +1,979 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Root complex and host memory model for the Verilated example_core_pcie_us
+ *
+ * Drives the UltraScale PCIe hard IP user interfaces (CQ/CC for MMIO, RQ/RC
+ * for DMA, cfg_mgmt, MSI-X) of the 256-bit non-straddled configuration.
+ * DMA addresses are host virtual addresses; the card may only touch ranges
+ * registered with cosim_dma_map.
+ */
+
+#include "cosim.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "Vexample_core_pcie_us.h"
+#include "verilated.h"
+#if VM_TRACE
+#include "verilated_fst_c.h"
+#endif
+
+#ifndef COSIM_CLK_FREQ_KHZ
+#define COSIM_CLK_FREQ_KHZ 250000
+#endif
+
+#ifndef COSIM_BAR0_APERTURE
+#define COSIM_BAR0_APERTURE 24
+#endif
+#ifndef COSIM_BAR2_APERTURE
+#define COSIM_BAR2_APERTURE 24
+#endif
+#ifndef COSIM_BAR4_APERTURE
+#define COSIM_BAR4_APERTURE 16
+#endif
+
+// configuration space layout
+#define CFG_MSIX_CAP 0x60
+#define CFG_PCIE_CAP 0x70
+
+#define CFG_DEVCTL (CFG_PCIE_CAP + 0x08)
+#define CFG_LNKCTL (CFG_PCIE_CAP + 0x10)
+#define CFG_DEVCTL2 (CFG_PCIE_CAP + 0x28)
+
+// TLP types (request descriptor bits 78:75)
+#define REQ_MEM_READ 0x0
+#define REQ_MEM_WRITE 0x1
+
+// completion status
+#define CPL_STATUS_SC 0x0
+#define CPL_STATUS_UR 0x1
+
+// RC error codes
+#define RC_ERROR_NORMAL_TERMINATION 0x0
+#define RC_ERROR_BAD_STATUS 0x2
+
+typedef Vexample_core_pcie_us Vtop;
+
+// beat width in dwords (the user interface is not straddled at this width)
+static const int kBeatDw = sizeof(((Vtop *)nullptr)->s_axis_cq_tdata) / 4;
+
+static_assert(kBeatDw == 4 || kBeatDw == 8, "cosim supports 128 and 256 bit interfaces only");
+
+namespace {
+
+struct Tlp {
+	std::vector<uint32_t> dw;
+	uint8_t first_be;
+	uint8_t last_be;
+	uint64_t release_ps;
+};
+
+struct TxStream {
+	std::deque<Tlp> queue;
+	size_t offset;
+};
+
+struct RxStream {
+	std::vector<uint32_t> dw;
+	uint64_t user;
+	bool active;
+};
+
+struct MmioRead {
+	std::vector<uint32_t> data;
+	uint32_t status;
+	uint64_t release_ps;
+};
+
+struct Irq {
+	int vector;
+	uint64_t release_ps;
+};
+
+struct Bar {
+	uint64_t start;
+	unsigned int aperture;
+};
+
+struct Cosim {
+	Vtop *top;
+#if VM_TRACE
+	VerilatedFstC *trace;
+#endif
+
+	struct cosim_options opts;
+	struct cosim_stats stats;
+
+	uint64_t time_ps;
+	uint64_t period_ps;
+	uint64_t max_time_ps;
+
+	uint32_t cfg[1024];
+
+	Bar bars[6];
+
+	// host to card
+	TxStream cq;
+	TxStream rc;
+
+	// card to host
+	RxStream rq;
+	RxStream cc;
+
+	std::deque<uint32_t> seq_num;
+
+	uint8_t next_tag;
+	std::map<uint8_t, MmioRead> mmio_reads;
+
+	// DMA address ranges (start -> length, reference count)
+	std::map<uint64_t, std::pair<uint64_t, uint32_t>> dma_map;
+
+	std::deque<Irq> irqs;
+
+	bool cfg_mgmt_done;
+	bool msix_sent;
+};
+
+Cosim sim;
+
+} // namespace
+
+double sc_time_stamp()
+{
+	return sim.time_ps;
+}
+
+/*
+ * Signal access
+ *
+ * Wide signals are arrays of 32 bit words, narrower ones plain integers.
+ */
+
+template <typename S>
+static void sig_set(S &sig, const uint32_t *w, int n)
+{
+	for (int k = 0; k < n; k++)
+		sig[k] = w[k];
+}
+
+static void sig_set(QData &sig, const uint32_t *w, int n)
+{
+	sig = w[0] | (n > 1 ? (uint64_t)w[1] << 32 : 0);
+}
+
+template <typename S>
+static void sig_get(const S &sig, uint32_t *w, int n)
+{
+	for (int k = 0; k < n; k++)
+		w[k] = sig[k];
+}
+
+static void sig_get(const QData &sig, uint32_t *w, int n)
+{
+	w[0] = sig;
+	if (n > 1)
+		w[1] = sig >> 32;
+}
+
+template <typename S>
+static constexpr int sig_words(const S &sig)
+{
+	return (sizeof(sig) + 3) / 4;
+}
+
+/*
+ * Configuration space
+ */
+
+static void cfg_init()
+{
+	uint32_t *cfg = sim.cfg;
+
+	memset(sim.cfg, 0, sizeof(sim.cfg));
+
+	// vendor 0x1234, device 0x0001 (matches the driver ID table)
+	cfg[0x00 / 4] = 0x00011234;
+	// status: capabilities list
+	cfg[0x04 / 4] = 0x00100000;
+	// class 0x058000 (memory controller, other)
+	cfg[0x08 / 4] = 0x05800000;
+	cfg[0x2c / 4] = 0x00011234;
+	cfg[0x34 / 4] = CFG_MSIX_CAP;
+
+	// 64 bit BARs
+	for (int k = 0; k < 6; k += 2) {
+		if (!sim.bars[k].aperture)
+			continue;
+
+		cfg[0x10 / 4 + k] = (uint32_t)sim.bars[k].start | 0x4;
+		cfg[0x10 / 4 + k + 1] = sim.bars[k].start >> 32;
+	}
+
+	// MSI-X: 32 vectors, table at BAR4 offset 0, PBA in the upper half of BAR4
+	cfg[CFG_MSIX_CAP / 4 + 0] = 0x11 | CFG_PCIE_CAP << 8 | 0x001f << 16;
+	cfg[CFG_MSIX_CAP / 4 + 1] = 0x00000000 | 4;
+	cfg[CFG_MSIX_CAP / 4 + 2] = (1u << (COSIM_BAR4_APERTURE - 1)) | 4;
+
+	// PCIe capability v2, endpoint
+	cfg[CFG_PCIE_CAP / 4 + 0] = 0x10 | 0x0002 << 16;
+	// DEVCAP: 512 byte max payload supported, extended tags
+	cfg[CFG_PCIE_CAP / 4 + 1] = 0x00000022;
+	// DEVCTL: relaxed ordering, 256 byte max payload, no snoop, 512 byte MRRS
+	cfg[CFG_PCIE_CAP / 4 + 2] = 0x00002830;
+	// LNKCAP: 8 GT/s x8
+	cfg[CFG_PCIE_CAP / 4 + 3] = 0x00000083;
+	// LNKCTL: 64 byte RCB, LNKSTA: 8 GT/s x8
+	cfg[CFG_PCIE_CAP / 4 + 4] = 0x00830000;
+	// DEVCAP2: 10-bit tag completer
+	cfg[CFG_PCIE_CAP / 4 + 9] = 0x00010000;
+}
+
+// writable bits of the emulated registers
+static uint32_t cfg_write_mask(uint32_t offset)
+{
+	switch (offset) {
+	case 0x04:
+		return 0x0000ffff;
+	case CFG_MSIX_CAP:
+		return 0xc0000000;
+	case CFG_DEVCTL:
+	case CFG_LNKCTL:
+	case CFG_DEVCTL2:
+		return 0x0000ffff;
+	default:
+		return 0;
+	}
+}
+
+uint32_t cosim_cfg_read(uint32_t offset)
+{
+	if (offset >= sizeof(sim.cfg))
+		return 0xffffffff;
+
+	return sim.cfg[offset / 4];
+}
+
+void cosim_cfg_write(uint32_t offset, uint32_t value, uint32_t mask)
+{
+	if (offset >= sizeof(sim.cfg))
+		return;
+
+	mask &= cfg_write_mask(offset & ~3);
+	sim.cfg[offset / 4] = (sim.cfg[offset / 4] & ~mask) | (value & mask);
+}
+
+uint32_t cosim_pcie_cap(void)
+{
+	return CFG_PCIE_CAP;
+}
+
+uint32_t cosim_msix_cap(void)
+{
+	return CFG_MSIX_CAP;
+}
+
+uint64_t cosim_bar_start(int bar)
+{
+	if (bar < 0 || bar >= 6 || !sim.bars[bar].aperture)
+		return 0;
+
+	return sim.bars[bar].start;
+}
+
+uint64_t cosim_bar_len(int bar)
+{
+	if (bar < 0 || bar >= 6 || !sim.bars[bar].aperture)
+		return 0;
+
+	return 1ull << sim.bars[bar].aperture;
+}
+
+/*
+ * Host memory
+ */
+
+void cosim_dma_map(uint64_t addr, uint64_t len)
+{
+	auto it = sim.dma_map.find(addr);
+
+	if (it != sim.dma_map.end()) {
+		it->second.first = std::max(it->second.first, len);
+		it->second.second++;
+	} else {
+		sim.dma_map[addr] = std::make_pair(len, 1u);
+	}
+}
+
+void cosim_dma_unmap(uint64_t addr, uint64_t len)
+{
+	auto it = sim.dma_map.find(addr);
+
+	if (it == sim.dma_map.end()) {
+		fprintf(stderr, "cosim: unmap of unmapped DMA address 0x%016llx\n",
+				(unsigned long long)addr);
+		return;
+	}
+
+	if (!--it->second.second)
+		sim.dma_map.erase(it);
+}
+
+// true if the whole range is covered by (possibly several) mapped regions
+static bool dma_check(uint64_t addr, uint64_t len)
+{
+	uint64_t end = addr + len;
+
+	while (addr < end) {
+		auto it = sim.dma_map.upper_bound(addr);
+		bool found = false;
+
+		while (it != sim.dma_map.begin()) {
+			--it;
+			if (it->first + it->second.first > addr) {
+				addr = it->first + it->second.first;
+				found = true;
+				break;
+			}
+		}
+
+		if (!found)
+			return false;
+	}
+
+	return true;
+}
+
+static void dma_fault(const char *op, uint64_t addr, uint64_t len)
+{
+	if (sim.stats.dma_faults++ < 16)
+		fprintf(stderr, "cosim: DMA %s fault at 0x%016llx (%llu bytes)\n", op,
+				(unsigned long long)addr, (unsigned long long)len);
+}
+
+/*
+ * Interrupts
+ */
+
+static void irq_deliver(uint64_t addr, uint32_t data)
+{
+	if ((addr & COSIM_MSI_MASK) != COSIM_MSI_ADDR) {
+		dma_fault("MSI", addr, 4);
+		return;
+	}
+
+	sim.stats.irqs++;
+	sim.irqs.push_back({(int)data, sim.time_ps + sim.opts.mmio_latency_ns * 1000ull});
+}
+
+int cosim_irq_take(void)
+{
+	if (sim.irqs.empty() || sim.irqs.front().release_ps > sim.time_ps)
+		return -1;
+
+	int vector = sim.irqs.front().vector;
+	sim.irqs.pop_front();
+	return vector;
+}
+
+/*
+ * Card requests (RQ)
+ */
+
+static unsigned int byte_count(uint32_t dw_count, uint8_t first_be, uint8_t last_be)
+{
+	static const uint8_t lead[16] = {0, 0, 1, 0, 2, 0, 1, 0, 3, 0, 1, 0, 2, 0, 1, 0};
+	static const uint8_t trail[16] = {0, 3, 2, 2, 1, 1, 1, 1, 0, 0, 0, 0, 0, 0, 0, 0};
+
+	if (dw_count == 1) {
+		if (!first_be)
+			return 1;
+		return 4 - lead[first_be] - trail[first_be];
+	}
+
+	return dw_count * 4 - lead[first_be] - trail[last_be];
+}
+
+static void rc_completion(uint8_t tag, uint16_t requester_id, uint64_t addr,
+		unsigned int remaining, unsigned int len, uint32_t status, uint64_t release_ps)
+{
+	Tlp tlp;
+	uint32_t dw_count = status == CPL_STATUS_SC ? ((addr & 3) + len + 3) / 4 : 0;
+	bool last = len == remaining || status != CPL_STATUS_SC;
+
+	tlp.dw.resize(3 + dw_count);
+	tlp.dw[0] = (addr & 0xfff) |
+			(status == CPL_STATUS_SC ? RC_ERROR_NORMAL_TERMINATION : RC_ERROR_BAD_STATUS) << 12 |
+			(remaining & 0x1fff) << 16 | (uint32_t)last << 30;
+	tlp.dw[1] = dw_count | status << 11 | (uint32_t)requester_id << 16;
+	tlp.dw[2] = tag;
+
+	if (dw_count)
+		memcpy(&tlp.dw[3], (const void *)(uintptr_t)(addr & ~3ull), dw_count * 4);
+
+	tlp.first_be = 0;
+	tlp.last_be = 0;
+	tlp.release_ps = release_ps;
+
+	sim.stats.cpl_tlps++;
+	sim.rc.queue.push_back(std::move(tlp));
+}
+
+static void rq_read(uint64_t addr, unsigned int len, uint8_t tag, uint16_t requester_id)
+{
+	uint64_t release_ps = sim.time_ps + sim.opts.dma_read_latency_ns * 1000ull;
+	unsigned int cpl_size = sim.opts.cpl_size;
+
+	sim.stats.dma_read_reqs++;
+
+	if (!dma_check(addr, len)) {
+		dma_fault("read", addr, len);
+		rc_completion(tag, requester_id, addr, len, 0, CPL_STATUS_UR, release_ps);
+		return;
+	}
+
+	sim.stats.dma_read_bytes += len;
+
+	// split at completion size boundaries
+	while (len) {
+		unsigned int seg = std::min<uint64_t>(len, cpl_size - (addr & (cpl_size - 1)));
+
+		rc_completion(tag, requester_id, addr, len, seg, CPL_STATUS_SC, release_ps);
+		addr += seg;
+		len -= seg;
+	}
+}
+
+static void rq_write(uint64_t addr, const uint32_t *data, uint32_t dw_count,
+		uint8_t first_be, uint8_t last_be)
+{
+	unsigned int len = byte_count(dw_count, first_be, last_be);
+
+	if ((addr & COSIM_MSI_MASK) == COSIM_MSI_ADDR) {
+		irq_deliver(addr, data[0]);
+		return;
+	}
+
+	sim.stats.dma_write_reqs++;
+
+	if (!dma_check(addr, dw_count * 4)) {
+		dma_fault("write", addr, len);
+		return;
+	}
+
+	sim.stats.dma_write_bytes += len;
+
+	uint8_t *ptr = (uint8_t *)(uintptr_t)addr;
+	const uint8_t *src = (const uint8_t *)data;
+
+	for (uint32_t k = 0; k < dw_count; k++) {
+		uint8_t be = k == 0 ? first_be : k == dw_count - 1 ? last_be : 0xf;
+
+		for (int b = 0; b < 4; b++) {
+			if (be & (1 << b))
+				ptr[k * 4 + b] = src[k * 4 + b];
+		}
+	}
+}
+
+static void rq_tlp(const std::vector<uint32_t> &dw, uint64_t user)
+{
+	if (dw.size() < 4) {
+		fprintf(stderr, "cosim: short RQ TLP\n");
+		return;
+	}
+
+	uint64_t addr = ((uint64_t)dw[1] << 32 | dw[0]) & ~3ull;
+	uint32_t dw_count = dw[2] & 0x7ff;
+	uint32_t type = (dw[2] >> 11) & 0xf;
+	uint16_t requester_id = dw[2] >> 16;
+	uint8_t tag = dw[3] & 0xff;
+	uint8_t first_be = user & 0xf;
+	uint8_t last_be = (user >> 4) & 0xf;
+	uint32_t seq = ((user >> 24) & 0xf) | ((user >> 60) & 0x3) << 4;
+
+	switch (type) {
+	case REQ_MEM_READ:
+		rq_read(addr + (first_be ? __builtin_ctz(first_be) : 0),
+				byte_count(dw_count, first_be, last_be), tag, requester_id);
+		break;
+	case REQ_MEM_WRITE:
+		if (dw.size() < 4 + dw_count) {
+			fprintf(stderr, "cosim: RQ write TLP shorter than its length\n");
+			break;
+		}
+		rq_write(addr, &dw[4], dw_count, first_be, last_be);
+		break;
+	default:
+		fprintf(stderr, "cosim: unsupported RQ request type %u\n", type);
+		break;
+	}
+
+	sim.seq_num.push_back(seq);
+}
+
+/*
+ * Card completions (CC)
+ */
+
+static void cc_tlp(const std::vector<uint32_t> &dw)
+{
+	if (dw.size() < 3) {
+		fprintf(stderr, "cosim: short CC TLP\n");
+		return;
+	}
+
+	uint32_t dw_count = dw[1] & 0x7ff;
+	uint32_t status = (dw[1] >> 11) & 0x7;
+	uint8_t tag = dw[2] & 0xff;
+
+	auto it = sim.mmio_reads.find(tag);
+	if (it == sim.mmio_reads.end() || it->second.release_ps) {
+		fprintf(stderr, "cosim: unexpected completion, tag %u\n", tag);
+		return;
+	}
+
+	it->second.status = status;
+	it->second.data.assign(dw.begin() + 3, dw.begin() + 3 + std::min<size_t>(dw_count, dw.size() - 3));
+	it->second.release_ps = sim.time_ps + sim.opts.mmio_latency_ns * 1000ull;
+}
+
+/*
+ * Clocking
+ */
+
+static void drive_tx(TxStream &s, CData &tvalid, CData &tkeep, CData &tlast, uint32_t *data,
+		uint32_t *user, int user_words, int sop_bit)
+{
+	memset(data, 0, kBeatDw * 4);
+	memset(user, 0, user_words * 4);
+
+	tvalid = 0;
+	tkeep = 0;
+	tlast = 0;
+
+	if (s.queue.empty() || s.queue.front().release_ps > sim.time_ps)
+		return;
+
+	const Tlp &tlp = s.queue.front();
+	size_t n = std::min<size_t>(kBeatDw, tlp.dw.size() - s.offset);
+
+	memcpy(data, &tlp.dw[s.offset], n * 4);
+
+	tvalid = 1;
+	tkeep = (1u << n) - 1;
+	tlast = s.offset + n >= tlp.dw.size();
+
+	if (sop_bit < 0) {
+		// RC: byte enables for the valid data dwords
+		for (size_t k = 0; k < n; k++)
+			user[k / 8] |= 0xfu << (k % 8) * 4;
+	} else {
+		user[0] = tlp.first_be | tlp.last_be << 4;
+	}
+
+	if (s.offset == 0) {
+		int bit = sop_bit < 0 ? 32 : sop_bit;
+		user[bit / 32] |= 1u << (bit % 32);
+	}
+}
+
+static void advance_tx(TxStream &s)
+{
+	s.offset += kBeatDw;
+	if (s.offset >= s.queue.front().dw.size()) {
+		s.queue.pop_front();
+		s.offset = 0;
+	}
+}
+
+template <typename D, typename U>
+static bool receive_rx(RxStream &s, const D &tdata, CData tkeep, CData tlast, const U &tuser)
+{
+	uint32_t data[kBeatDw];
+	uint32_t user[4] = {0};
+
+	sig_get(tdata, data, kBeatDw);
+	sig_get(tuser, user, sig_words(tuser));
+
+	if (!s.active) {
+		s.dw.clear();
+		s.user = user[0] | (uint64_t)user[1] << 32;
+		s.active = true;
+	}
+
+	for (int k = 0; k < kBeatDw; k++) {
+		if (tkeep & (1 << k))
+			s.dw.push_back(data[k]);
+	}
+
+	if (tlast)
+		s.active = false;
+
+	return tlast;
+}
+
+static void step()
+{
+	Vtop *top = sim.top;
+	uint32_t data[kBeatDw];
+	uint32_t user[4];
+
+	top->clk = 0;
+	top->eval();
+
+	// host to card streams
+	drive_tx(sim.cq, top->s_axis_cq_tvalid, top->s_axis_cq_tkeep, top->s_axis_cq_tlast,
+			data, user, sig_words(top->s_axis_cq_tuser), 40);
+	sig_set(top->s_axis_cq_tdata, data, kBeatDw);
+	sig_set(top->s_axis_cq_tuser, user, sig_words(top->s_axis_cq_tuser));
+
+	drive_tx(sim.rc, top->s_axis_rc_tvalid, top->s_axis_rc_tkeep, top->s_axis_rc_tlast,
+			data, user, sig_words(top->s_axis_rc_tuser), -1);
+	sig_set(top->s_axis_rc_tdata, data, kBeatDw);
+	sig_set(top->s_axis_rc_tuser, user, sig_words(top->s_axis_rc_tuser));
+
+	top->m_axis_rq_tready = 1;
+	top->m_axis_cc_tready = 1;
+
+	// transmit sequence numbers
+	top->s_axis_rq_seq_num_valid_0 = 0;
+	top->s_axis_rq_seq_num_valid_1 = 0;
+	if (!sim.seq_num.empty()) {
+		top->s_axis_rq_seq_num_0 = sim.seq_num.front();
+		top->s_axis_rq_seq_num_valid_0 = 1;
+		sim.seq_num.pop_front();
+	}
+	if (!sim.seq_num.empty()) {
+		top->s_axis_rq_seq_num_1 = sim.seq_num.front();
+		top->s_axis_rq_seq_num_valid_1 = 1;
+		sim.seq_num.pop_front();
+	}
+
+	// configuration management (one cycle per access)
+	top->cfg_mgmt_read_write_done = 0;
+	if ((top->cfg_mgmt_read || top->cfg_mgmt_write) && !sim.cfg_mgmt_done) {
+		uint32_t offset = top->cfg_mgmt_addr * 4;
+
+		if (top->cfg_mgmt_write) {
+			uint32_t mask = 0;
+
+			for (int k = 0; k < 4; k++) {
+				if (top->cfg_mgmt_byte_enable & (1 << k))
+					mask |= 0xffu << k * 8;
+			}
+
+			cosim_cfg_write(offset, top->cfg_mgmt_write_data, mask);
+		}
+
+		top->cfg_mgmt_read_data = cosim_cfg_read(offset);
+		top->cfg_mgmt_read_write_done = 1;
+	}
+	sim.cfg_mgmt_done = top->cfg_mgmt_read_write_done;
+
+	uint32_t devctl = sim.cfg[CFG_DEVCTL / 4];
+	top->cfg_max_payload = (devctl >> 5) & 0x7;
+	top->cfg_max_read_req = (devctl >> 12) & 0x7;
+	top->cfg_rcb_status = (sim.cfg[CFG_LNKCTL / 4] >> 3) & 0x1;
+
+	// flow control: plenty of posted and non-posted credit, infinite completion credit
+	top->cfg_fc_ph = 0x80;
+	top->cfg_fc_pd = 0x800;
+	top->cfg_fc_nph = 0x80;
+	top->cfg_fc_npd = 0x800;
+	top->cfg_fc_cplh = 0;
+	top->cfg_fc_cpld = 0;
+
+	uint32_t msix_ctrl = sim.cfg[CFG_MSIX_CAP / 4] >> 16;
+	top->cfg_interrupt_msix_enable = (msix_ctrl >> 15) & 1;
+	top->cfg_interrupt_msix_mask = (msix_ctrl >> 14) & 1;
+	top->cfg_interrupt_msix_sent = sim.msix_sent;
+	top->cfg_interrupt_msix_fail = 0;
+	sim.msix_sent = false;
+
+	top->eval();
+
+	// handshakes at the rising edge
+	bool cq_xfer = top->s_axis_cq_tvalid && top->s_axis_cq_tready;
+	bool rc_xfer = top->s_axis_rc_tvalid && top->s_axis_rc_tready;
+
+	if (top->m_axis_rq_tvalid && receive_rx(sim.rq, top->m_axis_rq_tdata, top->m_axis_rq_tkeep,
+			top->m_axis_rq_tlast, top->m_axis_rq_tuser))
+		rq_tlp(sim.rq.dw, sim.rq.user);
+
+	if (top->m_axis_cc_tvalid && receive_rx(sim.cc, top->m_axis_cc_tdata, top->m_axis_cc_tkeep,
+			top->m_axis_cc_tlast, top->m_axis_cc_tuser))
+		cc_tlp(sim.cc.dw);
+
+	if (top->cfg_interrupt_msix_int) {
+		irq_deliver(top->cfg_interrupt_msix_address, top->cfg_interrupt_msix_data);
+		sim.msix_sent = true;
+	}
+
+	top->clk = 1;
+	top->eval();
+
+	if (cq_xfer)
+		advance_tx(sim.cq);
+	if (rc_xfer)
+		advance_tx(sim.rc);
+
+#if VM_TRACE
+	if (sim.trace) {
+		sim.trace->dump(sim.time_ps);
+		sim.trace->dump(sim.time_ps + sim.period_ps / 2);
+	}
+#endif
+
+	sim.time_ps += sim.period_ps;
+	sim.stats.cycles++;
+
+	if (sim.max_time_ps && sim.time_ps > sim.max_time_ps) {
+		fprintf(stderr, "cosim: simulation time limit of %llu ns reached\n",
+				(unsigned long long)sim.opts.max_time_ns);
+		cosim_finish();
+		exit(2);
+	}
+}
+
+uint64_t cosim_time_ns(void)
+{
+	return sim.time_ps / 1000;
+}
+
+void cosim_advance_ns(uint64_t ns)
+{
+	uint64_t end = sim.time_ps + ns * 1000;
+
+	while (sim.time_ps < end)
+		step();
+}
+
+void cosim_wait_irq(uint64_t ns)
+{
+	uint64_t end = sim.time_ps + ns * 1000;
+
+	while (sim.time_ps < end) {
+		if (!sim.irqs.empty() && sim.irqs.front().release_ps <= sim.time_ps)
+			return;
+		step();
+	}
+}
+
+/*
+ * MMIO
+ */
+
+static int bar_lookup(int bar, uint64_t offset, size_t len)
+{
+	if (bar < 0 || bar >= 6 || !sim.bars[bar].aperture ||
+			offset + len > (1ull << sim.bars[bar].aperture)) {
+		fprintf(stderr, "cosim: MMIO access outside BAR%d (offset 0x%llx, %zu bytes)\n",
+				bar, (unsigned long long)offset, len);
+		abort();
+	}
+
+	return bar;
+}
+
+static Tlp cq_request(uint32_t type, int bar, uint64_t offset, size_t len, uint8_t tag)
+{
+	uint64_t addr = sim.bars[bar].start + offset;
+	uint64_t end = addr + len;
+	uint32_t dw_count = ((end + 3) / 4) - (addr / 4);
+	Tlp tlp;
+
+	tlp.dw.resize(4);
+	tlp.dw[0] = (uint32_t)addr & ~3u;
+	tlp.dw[1] = addr >> 32;
+	tlp.dw[2] = dw_count | type << 11;
+	tlp.dw[3] = tag | (uint32_t)bar << 16 | sim.bars[bar].aperture << 19;
+
+	tlp.first_be = (0xf << (addr & 3)) & 0xf;
+	if (dw_count == 1) {
+		tlp.first_be &= 0xf >> ((4 - (end & 3)) & 3);
+		tlp.last_be = 0;
+	} else {
+		tlp.last_be = 0xf >> ((4 - (end & 3)) & 3);
+	}
+
+	tlp.release_ps = sim.time_ps + sim.opts.mmio_latency_ns * 1000ull;
+
+	return tlp;
+}
+
+void cosim_mmio_write(int bar, uint64_t offset, const void *data, size_t len)
+{
+	bar_lookup(bar, offset, len);
+
+	// CPU write buffer full
+	while (sim.cq.queue.size() >= sim.opts.posted_limit)
+		step();
+
+	Tlp tlp = cq_request(REQ_MEM_WRITE, bar, offset, len, 0);
+	uint32_t dw_count = tlp.dw[2] & 0x7ff;
+
+	tlp.dw.resize(4 + dw_count, 0);
+	memcpy((uint8_t *)&tlp.dw[4] + (offset & 3), data, len);
+
+	sim.stats.mmio_writes++;
+	sim.cq.queue.push_back(std::move(tlp));
+}
+
+void cosim_mmio_read(int bar, uint64_t offset, void *data, size_t len)
+{
+	bar_lookup(bar, offset, len);
+
+	uint8_t tag = sim.next_tag++;
+
+	if (sim.mmio_reads.count(tag)) {
+		fprintf(stderr, "cosim: MMIO read tag %u still outstanding\n", tag);
+		abort();
+	}
+
+	sim.mmio_reads[tag] = MmioRead{{}, 0, 0};
+	sim.cq.queue.push_back(cq_request(REQ_MEM_READ, bar, offset, len, tag));
+	sim.stats.mmio_reads++;
+
+	for (;;) {
+		auto it = sim.mmio_reads.find(tag);
+
+		if (it->second.release_ps && it->second.release_ps <= sim.time_ps) {
+			const MmioRead &rd = it->second;
+
+			if (rd.status != CPL_STATUS_SC || rd.data.size() * 4 < (offset & 3) + len) {
+				fprintf(stderr, "cosim: MMIO read of BAR%d offset 0x%llx failed (status %u)\n",
+						bar, (unsigned long long)offset, rd.status);
+				memset(data, 0xff, len);
+			} else {
+				memcpy(data, (const uint8_t *)rd.data.data() + (offset & 3), len);
+			}
+
+			sim.mmio_reads.erase(it);
+			return;
+		}
+
+		step();
+	}
+}
+
+/*
+ * Setup
+ */
+
+void cosim_default_options(struct cosim_options *opts)
+{
+	memset(opts, 0, sizeof(*opts));
+	opts->mmio_latency_ns = 250;
+	opts->dma_read_latency_ns = 500;
+	opts->cpl_size = 64;
+	opts->posted_limit = 64;
+}
+
+int cosim_init(const struct cosim_options *opts, int argc, char **argv)
+{
+	sim.opts = *opts;
+
+	if (!sim.opts.cpl_size || (sim.opts.cpl_size & (sim.opts.cpl_size - 1)) ||
+			sim.opts.cpl_size > 256) {
+		fprintf(stderr, "cosim: completion size must be a power of two up to 256\n");
+		return -1;
+	}
+
+	if (!sim.opts.posted_limit)
+		sim.opts.posted_limit = 1;
+
+	sim.period_ps = 1000000000ull / COSIM_CLK_FREQ_KHZ;
+	sim.max_time_ps = sim.opts.max_time_ns * 1000;
+
+	sim.bars[0] = {0xf0000000ull, COSIM_BAR0_APERTURE};
+	sim.bars[2] = {0xf1000000ull, COSIM_BAR2_APERTURE};
+	sim.bars[4] = {0xf2000000ull, COSIM_BAR4_APERTURE};
+
+	cfg_init();
+
+	Verilated::commandArgs(argc, argv);
+
+	sim.top = new Vtop;
+
+	if (sim.opts.trace_file) {
+#if VM_TRACE
+		Verilated::traceEverOn(true);
+		sim.trace = new VerilatedFstC;
+		sim.top->trace(sim.trace, 99);
+		sim.trace->open(sim.opts.trace_file);
+#else
+		fprintf(stderr, "cosim: tracing not enabled in this build (TRACE=1)\n");
+		return -1;
+#endif
+	}
+
+	Vtop *top = sim.top;
+
+	top->clk = 0;
+	top->rst = 1;
+	top->s_axis_cq_tvalid = 0;
+	top->s_axis_rc_tvalid = 0;
+	top->cfg_interrupt_msix_vec_pending_status = 0;
+
+	for (int k = 0; k < 16; k++)
+		step();
+
+	top->rst = 0;
+
+	for (int k = 0; k < 16; k++)
+		step();
+
+	return 0;
+}
+
+void cosim_finish(void)
+{
+	if (!sim.top)
+		return;
+
+	sim.top->final();
+
+#if VM_TRACE
+	if (sim.trace) {
+		sim.trace->close();
+		delete sim.trace;
+		sim.trace = nullptr;
+	}
+#endif
+
+	delete sim.top;
+	sim.top = nullptr;
+}
+
+void cosim_get_stats(struct cosim_stats *stats)
+{
+	*stats = sim.stats;
+}
@@ -0,0 +1,121 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (c) 2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Interface between the kernel shim (C, kshim/) and the simulated root
+ * complex and host memory (C++, cosim.cpp), plus the shim entry points used
+ * by the top level.
+ */
+
+#ifndef COSIM_H
+#define COSIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// MSI-X messages to this address range are delivered as interrupts, with the
+// vector number in the message data
+#define COSIM_MSI_ADDR 0xfee00000ULL
+#define COSIM_MSI_MASK 0xfff00000ULL
+
+// model options, set before cosim_init
+struct cosim_options {
+	// one-way host to card MMIO latency
+	uint32_t mmio_latency_ns;
+	// DMA read request to first completion
+	uint32_t dma_read_latency_ns;
+	// completion payload size (read completion boundary multiple)
+	uint32_t cpl_size;
+	// maximum queued posted MMIO writes before the CPU stalls
+	uint32_t posted_limit;
+	// abort once the simulation passes this time (0 = no limit)
+	uint64_t max_time_ns;
+	// waveform file (needs a build with TRACE=1)
+	const char *trace_file;
+};
+
+struct cosim_stats {
+	uint64_t cycles;
+	uint64_t mmio_reads;
+	uint64_t mmio_writes;
+	uint64_t dma_read_reqs;
+	uint64_t dma_write_reqs;
+	uint64_t dma_read_bytes;
+	uint64_t dma_write_bytes;
+	uint64_t cpl_tlps;
+	uint64_t irqs;
+	uint64_t dma_faults;
+};
+
+void cosim_default_options(struct cosim_options *opts);
+int cosim_init(const struct cosim_options *opts, int argc, char **argv);
+void cosim_finish(void);
+void cosim_get_stats(struct cosim_stats *stats);
+
+// simulation time
+uint64_t cosim_time_ns(void);
+void cosim_advance_ns(uint64_t ns);
+// advance until an interrupt is pending or ns have passed
+void cosim_wait_irq(uint64_t ns);
+
+// BARs (bus addresses and sizes, 0 if not present)
+uint64_t cosim_bar_start(int bar);
+uint64_t cosim_bar_len(int bar);
+
+// MMIO accesses (non-posted reads wait for the completion)
+void cosim_mmio_read(int bar, uint64_t offset, void *data, size_t len);
+void cosim_mmio_write(int bar, uint64_t offset, const void *data, size_t len);
+
+// configuration space (dword aligned, mask selects the bytes written)
+uint32_t cosim_cfg_read(uint32_t offset);
+void cosim_cfg_write(uint32_t offset, uint32_t value, uint32_t mask);
+uint32_t cosim_pcie_cap(void);
+uint32_t cosim_msix_cap(void);
+
+// host memory the card may access (DMA addresses are host virtual addresses)
+void cosim_dma_map(uint64_t addr, uint64_t len);
+void cosim_dma_unmap(uint64_t addr, uint64_t len);
+
+// next delivered interrupt vector, -1 if none
+int cosim_irq_take(void);
+
+// kernel shim entry points (kshim/kshim.c)
+int kshim_module_init(void);
+void kshim_module_exit(void);
+// result of the driver probe (0 if bound)
+int kshim_probe_status(void);
+int kshim_param_set(const char *name, const char *value);
+void kshim_param_print(void);
+void kshim_run_work(void);
+long kshim_ioctl(unsigned int cmd, unsigned long arg);
+void kshim_set_debug(int enable);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COSIM_H */
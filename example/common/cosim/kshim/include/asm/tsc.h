@@ -0,0 +1,5 @@
+/* SPDX-License-Identifier: MIT */
+#ifndef KSHIM_ASM_TSC_H
+#define KSHIM_ASM_TSC_H
+#include "kshim.h"
+#endif
@@ -0,0 +1,5 @@
+/* SPDX-License-Identifier: MIT */
+#ifndef KSHIM_LINUX_DMA_MAPPING_H
+#define KSHIM_LINUX_DMA_MAPPING_H
+#include "kshim.h"
+#endif
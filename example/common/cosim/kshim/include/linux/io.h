@@ -0,0 +1,5 @@
+/* SPDX-License-Identifier: MIT */
+#ifndef KSHIM_LINUX_IO_H
+#define KSHIM_LINUX_IO_H
+#include "kshim.h"
+#endif
@@ -0,0 +1,1541 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "kshim.h"
+
+#include <ctype.h>
+#include <sys/mman.h>
+
+// time charged to the CPU for one cpu_relax() in a polling loop
+#define KSHIM_RELAX_NS 10
+
+// interrupt numbers handed out for MSI-X vectors
+#define KSHIM_IRQ_BASE 32
+#define KSHIM_MAX_IRQS 64
+
+#define KSHIM_MAX_PARAMS 32
+#define KSHIM_MAX_IOMAPS 64
+
+unsigned int tsc_khz = 1000000;
+bool kshim_debug;
+
+const struct cpumask kshim_node_cpumask = { { 0x1 } };
+const struct cpumask kshim_online_cpumask = { { 0x1 } };
+
+static struct mm_struct kshim_mm;
+struct task_struct kshim_current = { .mm = &kshim_mm };
+
+/*
+ * Logging
+ */
+
+static const char *kshim_driver_name = "";
+
+void kshim_vprintk(const char *level, const struct device *dev, const char *fmt, va_list args)
+{
+	char buf[1024];
+	u64 t = cosim_time_ns();
+	size_t len;
+
+	vsnprintf(buf, sizeof(buf), fmt, args);
+
+	len = strlen(buf);
+	while (len > 0 && buf[len - 1] == '\n')
+		buf[--len] = 0;
+
+	printf("[%5llu.%06llu] ", (unsigned long long)(t / NSEC_PER_SEC),
+			(unsigned long long)((t / NSEC_PER_USEC) % USEC_PER_SEC));
+	if (dev)
+		printf("%s %s: ", kshim_driver_name, dev->name);
+	printf("%s\n", buf);
+	fflush(stdout);
+}
+
+void kshim_printk(const char *level, const struct device *dev, const char *fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	kshim_vprintk(level, dev, fmt, args);
+	va_end(args);
+}
+
+void kshim_set_debug(int enable)
+{
+	kshim_debug = enable;
+}
+
+void print_hex_dump(const char *level, const char *prefix_str, int prefix_type,
+		int rowsize, int groupsize, const void *buf, size_t len, bool ascii)
+{
+	const u8 *ptr = buf;
+	char line[256];
+	size_t k, j;
+	int pos;
+
+	for (k = 0; k < len; k += rowsize) {
+		pos = 0;
+
+		if (prefix_type == DUMP_PREFIX_OFFSET)
+			pos += snprintf(line + pos, sizeof(line) - pos, "%08zx: ", k);
+		else if (prefix_type == DUMP_PREFIX_ADDRESS)
+			pos += snprintf(line + pos, sizeof(line) - pos, "%p: ", ptr + k);
+
+		for (j = k; j < k + rowsize && j < len && pos < (int)sizeof(line) - 4; j++)
+			pos += snprintf(line + pos, sizeof(line) - pos, "%02x ", ptr[j]);
+
+		if (pos > 0)
+			line[pos - 1] = 0;
+
+		kshim_printk(level, NULL, "%s%s", prefix_str, line);
+	}
+}
+
+/*
+ * Library functions
+ */
+
+void sort(void *base, size_t num, size_t size,
+		int (*cmp)(const void *, const void *),
+		void (*swap)(void *, void *, int))
+{
+	qsort(base, num, size, cmp);
+}
+
+int scnprintf(char *buf, size_t size, const char *fmt, ...)
+{
+	va_list args;
+	int ret;
+
+	va_start(args, fmt);
+	ret = vsnprintf(buf, size, fmt, args);
+	va_end(args);
+
+	if (ret < 0)
+		return 0;
+	if ((size_t)ret >= size)
+		return size ? size - 1 : 0;
+	return ret;
+}
+
+// fixed seed, so runs are repeatable
+u32 get_random_u32(void)
+{
+	static u32 state = 0x12345678;
+
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+bool sysfs_streq(const char *s1, const char *s2)
+{
+	while (*s1 && *s1 == *s2) {
+		s1++;
+		s2++;
+	}
+
+	if (*s1 == *s2)
+		return true;
+	if (!*s1 && *s2 == '\n' && !s2[1])
+		return true;
+	if (*s1 == '\n' && !s1[1] && !*s2)
+		return true;
+	return false;
+}
+
+char *strim(char *s)
+{
+	size_t len = strlen(s);
+
+	while (len && isspace((unsigned char)s[len - 1]))
+		s[--len] = 0;
+	while (isspace((unsigned char)*s))
+		s++;
+
+	return s;
+}
+
+ssize_t strscpy(char *dst, const char *src, size_t count)
+{
+	size_t len = strnlen(src, count);
+
+	if (!count)
+		return -E2BIG;
+
+	if (len == count) {
+		memcpy(dst, src, count - 1);
+		dst[count - 1] = 0;
+		return -E2BIG;
+	}
+
+	memcpy(dst, src, len + 1);
+	return len;
+}
+
+int __sysfs_match_string(const char * const *array, size_t n, const char *str)
+{
+	size_t k;
+
+	for (k = 0; k < n && array[k]; k++) {
+		if (sysfs_streq(array[k], str))
+			return k;
+	}
+
+	return -EINVAL;
+}
+
+/*
+ * Module parameters
+ */
+
+struct kshim_param {
+	const char *name;
+	void *ptr;
+	enum kshim_param_type type;
+};
+
+static struct kshim_param kshim_params[KSHIM_MAX_PARAMS];
+static int kshim_param_count;
+
+void kshim_param_register(const char *name, void *ptr, enum kshim_param_type type)
+{
+	if (kshim_param_count >= KSHIM_MAX_PARAMS) {
+		fprintf(stderr, "kshim: too many module parameters\n");
+		abort();
+	}
+
+	kshim_params[kshim_param_count].name = name;
+	kshim_params[kshim_param_count].ptr = ptr;
+	kshim_params[kshim_param_count].type = type;
+	kshim_param_count++;
+}
+
+int kshim_param_set(const char *name, const char *value)
+{
+	char *end;
+	int k;
+
+	for (k = 0; k < kshim_param_count; k++) {
+		struct kshim_param *p = &kshim_params[k];
+
+		if (strcmp(p->name, name))
+			continue;
+
+		switch (p->type) {
+		case KSHIM_PARAM_bool:
+			if (!strcmp(value, "1") || !strcmp(value, "y") || !strcmp(value, "Y"))
+				*(bool *)p->ptr = true;
+			else if (!strcmp(value, "0") || !strcmp(value, "n") || !strcmp(value, "N"))
+				*(bool *)p->ptr = false;
+			else
+				return -EINVAL;
+			return 0;
+		case KSHIM_PARAM_int:
+			*(int *)p->ptr = strtol(value, &end, 0);
+			return *end ? -EINVAL : 0;
+		case KSHIM_PARAM_uint:
+			*(unsigned int *)p->ptr = strtoul(value, &end, 0);
+			return *end ? -EINVAL : 0;
+		}
+	}
+
+	return -ENOENT;
+}
+
+void kshim_param_print(void)
+{
+	int k;
+
+	for (k = 0; k < kshim_param_count; k++) {
+		struct kshim_param *p = &kshim_params[k];
+
+		switch (p->type) {
+		case KSHIM_PARAM_bool:
+			printf("  %s=%c\n", p->name, *(bool *)p->ptr ? 'Y' : 'N');
+			break;
+		case KSHIM_PARAM_int:
+			printf("  %s=%d\n", p->name, *(int *)p->ptr);
+			break;
+		case KSHIM_PARAM_uint:
+			printf("  %s=%u\n", p->name, *(unsigned int *)p->ptr);
+			break;
+		}
+	}
+}
+
+/*
+ * Memory
+ */
+
+void *kzalloc(size_t size, gfp_t flags)
+{
+	return calloc(1, size);
+}
+
+void *kmalloc(size_t size, gfp_t flags)
+{
+	return (flags & __GFP_ZERO) ? calloc(1, size) : malloc(size);
+}
+
+void *kmalloc_array(size_t n, size_t size, gfp_t flags)
+{
+	if (size && n > SIZE_MAX / size)
+		return NULL;
+	return kmalloc(n * size, flags);
+}
+
+void *kcalloc(size_t n, size_t size, gfp_t flags)
+{
+	return calloc(n, size);
+}
+
+void kfree(const void *ptr)
+{
+	free((void *)ptr);
+}
+
+void *vmalloc(unsigned long size)
+{
+	return malloc(size);
+}
+
+void *vzalloc(unsigned long size)
+{
+	return calloc(1, size);
+}
+
+void vfree(const void *ptr)
+{
+	free((void *)ptr);
+}
+
+// device managed allocations, released when the driver unbinds
+struct kshim_devres {
+	struct kshim_devres *next;
+};
+
+static struct kshim_devres *kshim_devres_list;
+
+void *devm_kzalloc(struct device *dev, size_t size, gfp_t flags)
+{
+	struct kshim_devres *res = calloc(1, sizeof(*res) + size);
+
+	if (!res)
+		return NULL;
+
+	res->next = kshim_devres_list;
+	kshim_devres_list = res;
+
+	return res + 1;
+}
+
+static void kshim_devres_release(void)
+{
+	while (kshim_devres_list) {
+		struct kshim_devres *res = kshim_devres_list;
+
+		kshim_devres_list = res->next;
+		free(res);
+	}
+}
+
+struct page *alloc_pages_node(int nid, gfp_t flags, unsigned int order)
+{
+	struct page *page = calloc(1, sizeof(*page));
+
+	if (!page)
+		return NULL;
+
+	page->virt = aligned_alloc(PAGE_SIZE, PAGE_SIZE << order);
+	if (!page->virt) {
+		free(page);
+		return NULL;
+	}
+
+	if (flags & __GFP_ZERO)
+		memset(page->virt, 0, PAGE_SIZE << order);
+
+	page->order = order;
+	page->owned = true;
+
+	return page;
+}
+
+void __free_pages(struct page *page, unsigned int order)
+{
+	if (!page)
+		return;
+
+	free(page->virt);
+	free(page);
+}
+
+// user pages are the process's own memory, pinning just describes them
+long pin_user_pages_fast(unsigned long start, int nr_pages, unsigned int gup_flags,
+		struct page **pages)
+{
+	int k;
+
+	for (k = 0; k < nr_pages; k++) {
+		pages[k] = calloc(1, sizeof(struct page));
+		if (!pages[k]) {
+			while (k > 0)
+				free(pages[--k]);
+			return -ENOMEM;
+		}
+
+		pages[k]->virt = (void *)(start + k * PAGE_SIZE);
+	}
+
+	return nr_pages;
+}
+
+long get_user_pages_fast(unsigned long start, int nr_pages, unsigned int gup_flags,
+		struct page **pages)
+{
+	return pin_user_pages_fast(start, nr_pages, gup_flags, pages);
+}
+
+void put_page(struct page *page)
+{
+	if (!page->owned)
+		free(page);
+}
+
+void unpin_user_pages_dirty_lock(struct page **pages, unsigned long npages, bool make_dirty)
+{
+	unsigned long k;
+
+	for (k = 0; k < npages; k++)
+		put_page(pages[k]);
+}
+
+int remap_pfn_range(struct vm_area_struct *vma, unsigned long addr, unsigned long pfn,
+		unsigned long size, pgprot_t prot)
+{
+	// no user mappings of the simulated BARs
+	return -ENXIO;
+}
+
+/*
+ * Interrupts
+ */
+
+struct kshim_irq {
+	irq_handler_t handler;
+	void *dev_id;
+	u64 count;
+};
+
+static struct kshim_irq kshim_irqs[KSHIM_MAX_IRQS];
+static int kshim_irq_disable_depth;
+static bool kshim_in_irq;
+static u64 kshim_spurious_irqs;
+
+static void kshim_dispatch_irqs(void)
+{
+	int vec;
+
+	if (kshim_irq_disable_depth || kshim_in_irq)
+		return;
+
+	kshim_in_irq = true;
+
+	while ((vec = cosim_irq_take()) >= 0) {
+		struct kshim_irq *irq = vec < KSHIM_MAX_IRQS ? &kshim_irqs[vec] : NULL;
+
+		if (irq && irq->handler) {
+			irq->count++;
+			irq->handler(KSHIM_IRQ_BASE + vec, irq->dev_id);
+		} else if (!kshim_spurious_irqs++) {
+			pr_warn("kshim: interrupt on unregistered vector %d", vec);
+		}
+	}
+
+	kshim_in_irq = false;
+}
+
+unsigned long kshim_irq_save(void)
+{
+	return kshim_irq_disable_depth++;
+}
+
+void kshim_irq_restore(unsigned long flags)
+{
+	kshim_irq_disable_depth = flags;
+	kshim_dispatch_irqs();
+}
+
+/*
+ * CPUs and threads
+ */
+
+int cpulist_parse(const char *buf, struct cpumask *mask)
+{
+	unsigned long a, b;
+	char *end;
+
+	mask->bits[0] = 0;
+
+	while (*buf && *buf != '\n') {
+		a = b = strtoul(buf, &end, 10);
+		if (end == buf)
+			return -EINVAL;
+		buf = end;
+
+		if (*buf == '-') {
+			b = strtoul(++buf, &end, 10);
+			if (end == buf || b < a)
+				return -EINVAL;
+			buf = end;
+		}
+
+		if (b >= 8 * sizeof(unsigned long))
+			return -ERANGE;
+
+		for (; a <= b; a++)
+			mask->bits[0] |= 1UL << a;
+
+		if (*buf == ',')
+			buf++;
+		else if (*buf && *buf != '\n')
+			return -EINVAL;
+	}
+
+	return 0;
+}
+
+struct task_struct *kthread_create_on_node(int (*fn)(void *data), void *data, int node,
+		const char *fmt, ...)
+{
+	// the model is single threaded; concurrent benchmarks are hardware only
+	return ERR_PTR(-EOPNOTSUPP);
+}
+
+/*
+ * Time
+ */
+
+static void kshim_advance(u64 ns)
+{
+	cosim_advance_ns(ns);
+	kshim_dispatch_irqs();
+}
+
+void udelay(unsigned long usecs)
+{
+	kshim_advance((u64)usecs * NSEC_PER_USEC);
+}
+
+void ndelay(unsigned long nsecs)
+{
+	kshim_advance(nsecs);
+}
+
+void msleep(unsigned int msecs)
+{
+	kshim_advance((u64)msecs * NSEC_PER_MSEC);
+}
+
+void usleep_range(unsigned long min, unsigned long max)
+{
+	kshim_advance((u64)min * NSEC_PER_USEC);
+}
+
+void cpu_relax(void)
+{
+	kshim_advance(KSHIM_RELAX_NS);
+}
+
+void cond_resched(void)
+{
+	kshim_dispatch_irqs();
+}
+
+/*
+ * Locking and completions
+ */
+
+void kshim_mutex_lock(struct mutex *lock, const char *name)
+{
+	// with one thread, a held lock can never be released
+	if (lock->locked) {
+		fprintf(stderr, "kshim: deadlock on mutex %s\n", name);
+		abort();
+	}
+
+	lock->locked = 1;
+}
+
+void kshim_mutex_unlock(struct mutex *lock, const char *name)
+{
+	if (!lock->locked) {
+		fprintf(stderr, "kshim: unlock of unlocked mutex %s\n", name);
+		abort();
+	}
+
+	lock->locked = 0;
+}
+
+void kshim_down_write(struct rw_semaphore *sem)
+{
+	if (sem->readers || sem->writer) {
+		fprintf(stderr, "kshim: deadlock on rw_semaphore\n");
+		abort();
+	}
+
+	sem->writer = 1;
+}
+
+unsigned long wait_for_completion_timeout(struct completion *x, unsigned long timeout)
+{
+	u64 jiffy_ns = NSEC_PER_SEC / HZ;
+	u64 deadline = cosim_time_ns() + (u64)timeout * jiffy_ns;
+	u64 now;
+
+	kshim_dispatch_irqs();
+
+	while (!x->done) {
+		now = cosim_time_ns();
+		if (now >= deadline)
+			return 0;
+
+		cosim_wait_irq(deadline - now);
+		kshim_dispatch_irqs();
+	}
+
+	x->done--;
+
+	now = cosim_time_ns();
+	return now < deadline ? max_t(u64, (deadline - now) / jiffy_ns, 1) : 1;
+}
+
+/*
+ * Work queues
+ */
+
+static struct work_struct *kshim_work_list;
+
+static bool kshim_queue_work(struct work_struct *work, u64 due_ns)
+{
+	struct work_struct **p;
+
+	if (work->pending)
+		return false;
+
+	work->pending = true;
+	work->due_ns = due_ns;
+	work->next = NULL;
+
+	for (p = &kshim_work_list; *p; p = &(*p)->next)
+		;
+	*p = work;
+
+	return true;
+}
+
+static bool kshim_dequeue_work(struct work_struct *work)
+{
+	struct work_struct **p;
+
+	for (p = &kshim_work_list; *p; p = &(*p)->next) {
+		if (*p == work) {
+			*p = work->next;
+			work->next = NULL;
+			work->pending = false;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool schedule_work(struct work_struct *work)
+{
+	return kshim_queue_work(work, 0);
+}
+
+bool schedule_delayed_work(struct delayed_work *dwork, unsigned long delay)
+{
+	return kshim_queue_work(&dwork->work, cosim_time_ns() + (u64)delay * (NSEC_PER_SEC / HZ));
+}
+
+bool cancel_work_sync(struct work_struct *work)
+{
+	return kshim_dequeue_work(work);
+}
+
+bool cancel_delayed_work_sync(struct delayed_work *dwork)
+{
+	return kshim_dequeue_work(&dwork->work);
+}
+
+// run queued work that is due; delayed work does not hold up the caller
+void kshim_run_work(void)
+{
+	struct work_struct *work;
+
+	for (;;) {
+		u64 now = cosim_time_ns();
+
+		for (work = kshim_work_list; work; work = work->next) {
+			if (work->due_ns <= now)
+				break;
+		}
+
+		if (!work)
+			return;
+
+		kshim_dequeue_work(work);
+		work->func(work);
+	}
+}
+
+/*
+ * Character devices
+ */
+
+static struct miscdevice *kshim_misc_list;
+static struct inode kshim_inode;
+static struct file kshim_file;
+static struct miscdevice *kshim_file_misc;
+
+int misc_register(struct miscdevice *misc)
+{
+	misc->next = kshim_misc_list;
+	kshim_misc_list = misc;
+	return 0;
+}
+
+void misc_deregister(struct miscdevice *misc)
+{
+	struct miscdevice **p;
+
+	for (p = &kshim_misc_list; *p; p = &(*p)->next) {
+		if (*p == misc) {
+			*p = misc->next;
+			return;
+		}
+	}
+}
+
+// ioctl on the (first) registered device, kept open until the module exits
+long kshim_ioctl(unsigned int cmd, unsigned long arg)
+{
+	int ret;
+
+	if (!kshim_file_misc) {
+		if (!kshim_misc_list)
+			return -ENODEV;
+
+		memset(&kshim_file, 0, sizeof(kshim_file));
+		kshim_file.private_data = kshim_misc_list;
+
+		ret = kshim_misc_list->fops->open(&kshim_inode, &kshim_file);
+		if (ret)
+			return ret;
+
+		kshim_file_misc = kshim_misc_list;
+	}
+
+	return kshim_file_misc->fops->unlocked_ioctl(&kshim_file, cmd, arg);
+}
+
+void kshim_release_files(void)
+{
+	if (!kshim_file_misc)
+		return;
+
+	kshim_file_misc->fops->release(&kshim_inode, &kshim_file);
+	kshim_file_misc = NULL;
+}
+
+/*
+ * seq_file and debugfs
+ */
+
+void seq_printf(struct seq_file *s, const char *fmt, ...)
+{
+	va_list args;
+	int len;
+
+	va_start(args, fmt);
+	len = vsnprintf(NULL, 0, fmt, args);
+	va_end(args);
+
+	if (len < 0)
+		return;
+
+	if (s->count + len + 1 > s->size) {
+		size_t size = max_t(size_t, s->size * 2, s->count + len + 1);
+		char *buf = realloc(s->buf, size);
+
+		if (!buf)
+			return;
+
+		s->buf = buf;
+		s->size = size;
+	}
+
+	va_start(args, fmt);
+	vsnprintf(s->buf + s->count, s->size - s->count, fmt, args);
+	va_end(args);
+
+	s->count += len;
+}
+
+void seq_puts(struct seq_file *s, const char *str)
+{
+	seq_printf(s, "%s", str);
+}
+
+int single_open(struct file *file, int (*show)(struct seq_file *, void *), void *data)
+{
+	struct seq_file *s = calloc(1, sizeof(*s));
+
+	if (!s)
+		return -ENOMEM;
+
+	s->private = data;
+	s->show = show;
+	file->private_data = s;
+
+	return 0;
+}
+
+int single_release(struct inode *inode, struct file *file)
+{
+	struct seq_file *s = file->private_data;
+
+	free(s->buf);
+	free(s);
+
+	return 0;
+}
+
+ssize_t seq_read(struct file *file, char __user *buf, size_t size, loff_t *ppos)
+{
+	struct seq_file *s = file->private_data;
+	size_t count;
+	int ret;
+
+	if (*ppos == 0) {
+		s->count = 0;
+		ret = s->show(s, s->private);
+		if (ret)
+			return ret;
+	}
+
+	if ((size_t)*ppos >= s->count)
+		return 0;
+
+	count = min_t(size_t, size, s->count - *ppos);
+	memcpy(buf, s->buf + *ppos, count);
+	*ppos += count;
+
+	return count;
+}
+
+loff_t seq_lseek(struct file *file, loff_t offset, int whence)
+{
+	if (offset || whence)
+		return -EINVAL;
+
+	file->f_pos = 0;
+	return 0;
+}
+
+static struct dentry *kshim_dentry_list;
+
+static struct dentry *kshim_debugfs_add(const char *name, struct dentry *parent,
+		void *data, const struct file_operations *fops)
+{
+	struct dentry *d = calloc(1, sizeof(*d));
+
+	if (!d)
+		return NULL;
+
+	d->name = name;
+	d->parent = parent;
+	d->data = data;
+	d->fops = fops;
+	d->next = kshim_dentry_list;
+	kshim_dentry_list = d;
+
+	return d;
+}
+
+struct dentry *debugfs_create_dir(const char *name, struct dentry *parent)
+{
+	return kshim_debugfs_add(name, parent, NULL, NULL);
+}
+
+struct dentry *debugfs_create_file(const char *name, umode_t mode, struct dentry *parent,
+		void *data, const struct file_operations *fops)
+{
+	return kshim_debugfs_add(name, parent, data, fops);
+}
+
+void debugfs_create_u32(const char *name, umode_t mode, struct dentry *parent, u32 *value)
+{
+	kshim_debugfs_add(name, parent, value, NULL);
+}
+
+void debugfs_create_x32(const char *name, umode_t mode, struct dentry *parent, u32 *value)
+{
+	kshim_debugfs_add(name, parent, value, NULL);
+}
+
+static bool kshim_dentry_under(const struct dentry *d, const struct dentry *root)
+{
+	for (; d; d = d->parent) {
+		if (d == root)
+			return true;
+	}
+
+	return false;
+}
+
+void debugfs_remove_recursive(struct dentry *dentry)
+{
+	struct dentry **p = &kshim_dentry_list;
+
+	if (!dentry)
+		return;
+
+	// children are created after their parent, so come first in the list
+	while (*p) {
+		struct dentry *d = *p;
+
+		if (kshim_dentry_under(d, dentry)) {
+			*p = d->next;
+			if (d != dentry)
+				free(d);
+		} else {
+			p = &d->next;
+		}
+	}
+
+	free(dentry);
+}
+
+/*
+ * File I/O
+ */
+
+size_t copy_to_iter(const void *addr, size_t bytes, struct iov_iter *i)
+{
+	bytes = min(bytes, i->count);
+	memcpy(i->base + i->offset, addr, bytes);
+	i->offset += bytes;
+	i->count -= bytes;
+	return bytes;
+}
+
+size_t copy_from_iter(void *addr, size_t bytes, struct iov_iter *i)
+{
+	bytes = min(bytes, i->count);
+	memcpy(addr, i->base + i->offset, bytes);
+	i->offset += bytes;
+	i->count -= bytes;
+	return bytes;
+}
+
+void iov_iter_revert(struct iov_iter *i, size_t bytes)
+{
+	i->offset -= bytes;
+	i->count += bytes;
+}
+
+// there are no pipes, only read_iter and write_iter are called directly
+ssize_t generic_file_splice_read(struct file *in, loff_t *ppos,
+		struct pipe_inode_info *pipe, size_t len, unsigned int flags)
+{
+	return -EINVAL;
+}
+
+ssize_t iter_file_splice_write(struct pipe_inode_info *pipe, struct file *out,
+		loff_t *ppos, size_t len, unsigned int flags)
+{
+	return -EINVAL;
+}
+
+/*
+ * MMIO
+ *
+ * Each ioremap reserves an inaccessible range of address space, so stray
+ * dereferences of __iomem pointers fault instead of silently reading memory.
+ */
+
+struct kshim_iomap {
+	uintptr_t va;
+	size_t len;
+	int bar;
+	u64 offset;
+	bool wc;
+};
+
+static struct kshim_iomap kshim_iomaps[KSHIM_MAX_IOMAPS];
+static struct kshim_iomap *kshim_iomap_last;
+
+static struct kshim_iomap *kshim_iomap_find(const volatile void __iomem *addr, size_t len)
+{
+	uintptr_t a = (uintptr_t)addr;
+	int k;
+
+	if (kshim_iomap_last && a >= kshim_iomap_last->va &&
+			a + len <= kshim_iomap_last->va + kshim_iomap_last->len)
+		return kshim_iomap_last;
+
+	for (k = 0; k < KSHIM_MAX_IOMAPS; k++) {
+		struct kshim_iomap *m = &kshim_iomaps[k];
+
+		if (m->len && a >= m->va && a + len <= m->va + m->len) {
+			kshim_iomap_last = m;
+			return m;
+		}
+	}
+
+	fprintf(stderr, "kshim: MMIO access to unmapped address %p (%zu bytes)\n", addr, len);
+	abort();
+}
+
+static void __iomem *kshim_ioremap(resource_size_t offset, unsigned long size, bool wc)
+{
+	struct kshim_iomap *m = NULL;
+	int bar;
+	int k;
+
+	for (bar = 0; bar < 6; bar++) {
+		u64 start = cosim_bar_start(bar);
+		u64 len = cosim_bar_len(bar);
+
+		if (len && offset >= start && offset + size <= start + len)
+			break;
+	}
+
+	if (bar == 6 || !size)
+		return NULL;
+
+	for (k = 0; k < KSHIM_MAX_IOMAPS && !m; k++) {
+		if (!kshim_iomaps[k].len)
+			m = &kshim_iomaps[k];
+	}
+
+	if (!m)
+		return NULL;
+
+	m->va = (uintptr_t)mmap(NULL, PAGE_ALIGN(size), PROT_NONE,
+			MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+	if ((void *)m->va == MAP_FAILED)
+		return NULL;
+
+	m->len = size;
+	m->bar = bar;
+	m->offset = offset - cosim_bar_start(bar);
+	m->wc = wc;
+
+	return (void __iomem *)m->va;
+}
+
+void __iomem *ioremap(resource_size_t offset, unsigned long size)
+{
+	return kshim_ioremap(offset, size, false);
+}
+
+void __iomem *ioremap_wc(resource_size_t offset, unsigned long size)
+{
+	return kshim_ioremap(offset, size, true);
+}
+
+void iounmap(volatile void __iomem *addr)
+{
+	int k;
+
+	for (k = 0; k < KSHIM_MAX_IOMAPS; k++) {
+		struct kshim_iomap *m = &kshim_iomaps[k];
+
+		if (m->len && m->va == (uintptr_t)addr) {
+			munmap((void *)m->va, PAGE_ALIGN(m->len));
+			memset(m, 0, sizeof(*m));
+			kshim_iomap_last = NULL;
+			return;
+		}
+	}
+}
+
+static void kshim_mmio_read(const void __iomem *addr, void *data, size_t len)
+{
+	struct kshim_iomap *m = kshim_iomap_find(addr, len);
+
+	cosim_mmio_read(m->bar, m->offset + ((uintptr_t)addr - m->va), data, len);
+	kshim_dispatch_irqs();
+}
+
+static void kshim_mmio_write(void __iomem *addr, const void *data, size_t len)
+{
+	struct kshim_iomap *m = kshim_iomap_find(addr, len);
+
+	cosim_mmio_write(m->bar, m->offset + ((uintptr_t)addr - m->va), data, len);
+	kshim_dispatch_irqs();
+}
+
+u32 ioread32(const void __iomem *addr)
+{
+	u32 value;
+
+	kshim_mmio_read(addr, &value, sizeof(value));
+	return value;
+}
+
+void iowrite32(u32 value, void __iomem *addr)
+{
+	kshim_mmio_write(addr, &value, sizeof(value));
+}
+
+u64 ioread64(const void __iomem *addr)
+{
+	u64 value;
+
+	kshim_mmio_read(addr, &value, sizeof(value));
+	return value;
+}
+
+void iowrite64(u64 value, void __iomem *addr)
+{
+	kshim_mmio_write(addr, &value, sizeof(value));
+}
+
+// write-combined copies go out as one TLP per 64 byte line, uncached ones
+// as one TLP per store
+static void kshim_iowrite_copy(void __iomem *to, const void *from, size_t len, size_t store)
+{
+	struct kshim_iomap *m = kshim_iomap_find(to, len);
+	uintptr_t addr = (uintptr_t)to;
+	const u8 *src = from;
+
+	while (len) {
+		size_t chunk = m->wc ? min_t(size_t, len, 64 - (addr & 63)) : store;
+
+		kshim_mmio_write((void __iomem *)addr, src, chunk);
+		addr += chunk;
+		src += chunk;
+		len -= chunk;
+	}
+}
+
+void __iowrite64_copy(void __iomem *to, const void *from, size_t count)
+{
+	kshim_iowrite_copy(to, from, count * 8, 8);
+}
+
+void __iowrite32_copy(void __iomem *to, const void *from, size_t count)
+{
+	kshim_iowrite_copy(to, from, count * 4, 4);
+}
+
+/*
+ * DMA
+ */
+
+void *dma_alloc_coherent(struct device *dev, size_t size, dma_addr_t *dma_handle, gfp_t gfp)
+{
+	void *ptr = aligned_alloc(PAGE_SIZE, PAGE_ALIGN(size));
+
+	if (!ptr)
+		return NULL;
+
+	memset(ptr, 0, PAGE_ALIGN(size));
+
+	*dma_handle = (uintptr_t)ptr;
+	cosim_dma_map(*dma_handle, size);
+
+	return ptr;
+}
+
+void dma_free_coherent(struct device *dev, size_t size, void *cpu_addr, dma_addr_t dma_handle)
+{
+	cosim_dma_unmap(dma_handle, size);
+	free(cpu_addr);
+}
+
+int dma_mmap_coherent(struct device *dev, struct vm_area_struct *vma,
+		void *cpu_addr, dma_addr_t dma_addr, size_t size)
+{
+	return -ENXIO;
+}
+
+dma_addr_t dma_map_page(struct device *dev, struct page *page, size_t offset,
+		size_t size, enum dma_data_direction dir)
+{
+	dma_addr_t addr = (uintptr_t)page->virt + offset;
+
+	cosim_dma_map(addr, size);
+	return addr;
+}
+
+void dma_unmap_page(struct device *dev, dma_addr_t addr, size_t size,
+		enum dma_data_direction dir)
+{
+	cosim_dma_unmap(addr, size);
+}
+
+// virtually contiguous pages are merged, as an IOMMU would
+int sg_alloc_table_from_pages(struct sg_table *sgt, struct page **pages,
+		unsigned int n_pages, unsigned int offset, unsigned long size, gfp_t gfp_mask)
+{
+	struct scatterlist *sg;
+	unsigned int nents = 1;
+	unsigned int k;
+
+	if (!n_pages)
+		return -EINVAL;
+
+	for (k = 1; k < n_pages; k++) {
+		if ((u8 *)pages[k]->virt != (u8 *)pages[k - 1]->virt + PAGE_SIZE)
+			nents++;
+	}
+
+	sgt->sgl = calloc(nents, sizeof(*sgt->sgl));
+	if (!sgt->sgl)
+		return -ENOMEM;
+
+	sgt->nents = nents;
+	sgt->orig_nents = nents;
+
+	sg = sgt->sgl;
+	sg->page = pages[0];
+	sg->offset = offset;
+	sg->length = min_t(unsigned long, PAGE_SIZE - offset, size);
+	size -= sg->length;
+
+	for (k = 1; k < n_pages; k++) {
+		unsigned int len = min_t(unsigned long, PAGE_SIZE, size);
+
+		if ((u8 *)pages[k]->virt != (u8 *)pages[k - 1]->virt + PAGE_SIZE) {
+			sg++;
+			sg->page = pages[k];
+			sg->offset = 0;
+			sg->length = 0;
+		}
+
+		sg->length += len;
+		size -= len;
+	}
+
+	return 0;
+}
+
+void sg_free_table(struct sg_table *table)
+{
+	free(table->sgl);
+	table->sgl = NULL;
+	table->nents = 0;
+	table->orig_nents = 0;
+}
+
+int dma_map_sg(struct device *dev, struct scatterlist *sg, int nents,
+		enum dma_data_direction dir)
+{
+	int k;
+
+	for (k = 0; k < nents; k++) {
+		sg[k].dma_address = (uintptr_t)sg[k].page->virt + sg[k].offset;
+		sg[k].dma_length = sg[k].length;
+		cosim_dma_map(sg[k].dma_address, sg[k].dma_length);
+	}
+
+	return nents;
+}
+
+void dma_unmap_sg(struct device *dev, struct scatterlist *sg, int nents,
+		enum dma_data_direction dir)
+{
+	int k;
+
+	for (k = 0; k < nents; k++)
+		cosim_dma_unmap(sg[k].dma_address, sg[k].dma_length);
+}
+
+/*
+ * PCI
+ */
+
+static struct pci_bus kshim_bus = { .domain = 0, .number = 1 };
+static struct pci_dev kshim_pdev;
+static struct pci_driver *kshim_bound_driver;
+static int kshim_probe_ret = -ENODEV;
+
+int pci_read_config_dword(const struct pci_dev *dev, int where, u32 *val)
+{
+	*val = cosim_cfg_read(where & ~3);
+	return 0;
+}
+
+int pci_read_config_word(const struct pci_dev *dev, int where, u16 *val)
+{
+	*val = cosim_cfg_read(where & ~3) >> ((where & 2) * 8);
+	return 0;
+}
+
+int pci_write_config_dword(const struct pci_dev *dev, int where, u32 val)
+{
+	cosim_cfg_write(where & ~3, val, 0xffffffff);
+	return 0;
+}
+
+int pci_write_config_word(const struct pci_dev *dev, int where, u16 val)
+{
+	int shift = (where & 2) * 8;
+
+	cosim_cfg_write(where & ~3, (u32)val << shift, 0xffffu << shift);
+	return 0;
+}
+
+int pcie_capability_read_word(struct pci_dev *dev, int pos, u16 *val)
+{
+	return pci_read_config_word(dev, dev->pcie_cap + pos, val);
+}
+
+int pcie_capability_read_dword(struct pci_dev *dev, int pos, u32 *val)
+{
+	return pci_read_config_dword(dev, dev->pcie_cap + pos, val);
+}
+
+int pcie_capability_clear_and_set_word(struct pci_dev *dev, int pos, u16 clear, u16 set)
+{
+	u16 val;
+
+	pcie_capability_read_word(dev, pos, &val);
+	return pci_write_config_word(dev, dev->pcie_cap + pos, (val & ~clear) | set);
+}
+
+void pcie_print_link_status(struct pci_dev *dev)
+{
+	// per lane bandwidth after encoding overhead, in Mb/s
+	static const u32 lane_mbps[] = {0, 2000, 4000, 7877, 15754, 31508};
+	static const char *const speed[] = {"?", "2.5", "5.0", "8.0", "16.0", "32.0"};
+	u16 lnksta;
+	int gen, width;
+	u32 bw;
+
+	pcie_capability_read_word(dev, PCI_EXP_LNKSTA, &lnksta);
+
+	gen = lnksta & PCI_EXP_LNKSTA_CLS;
+	width = (lnksta & PCI_EXP_LNKSTA_NLW) >> 4;
+	if (gen >= (int)ARRAY_SIZE(lane_mbps))
+		gen = 0;
+	bw = lane_mbps[gen] * width;
+
+	dev_info(&dev->dev, "%u.%03u Gb/s available PCIe bandwidth (%s GT/s PCIe x%d link)",
+			bw / 1000, bw % 1000, speed[gen], width);
+}
+
+int pci_enable_device_mem(struct pci_dev *dev)
+{
+	cosim_cfg_write(0x04, 0x0002, 0x0002);
+	return 0;
+}
+
+void pci_disable_device(struct pci_dev *dev)
+{
+	cosim_cfg_write(0x04, 0x0000, 0x0002);
+}
+
+void pci_set_master(struct pci_dev *dev)
+{
+	cosim_cfg_write(0x04, 0x0004, 0x0004);
+}
+
+void pci_clear_master(struct pci_dev *dev)
+{
+	cosim_cfg_write(0x04, 0x0000, 0x0004);
+}
+
+void __iomem *pci_ioremap_bar(struct pci_dev *pdev, int bar)
+{
+	return ioremap(pci_resource_start(pdev, bar), pci_resource_len(pdev, bar));
+}
+
+void pci_iounmap(struct pci_dev *dev, void __iomem *addr)
+{
+	iounmap(addr);
+}
+
+// program the MSI-X table to post the vector number to COSIM_MSI_ADDR
+int pci_alloc_irq_vectors(struct pci_dev *dev, unsigned int min_vecs,
+		unsigned int max_vecs, unsigned int flags)
+{
+	u32 cap = cosim_msix_cap();
+	u32 table, ctrl;
+	unsigned int nvec;
+	unsigned int k;
+
+	if (!(flags & PCI_IRQ_MSIX) || !cap)
+		return -ENOSPC;
+
+	ctrl = cosim_cfg_read(cap) >> 16;
+	table = cosim_cfg_read(cap + 4);
+
+	nvec = min_t(unsigned int, max_vecs, (ctrl & 0x7ff) + 1);
+	nvec = min_t(unsigned int, nvec, KSHIM_MAX_IRQS);
+	if (nvec < min_vecs)
+		return -ENOSPC;
+
+	for (k = 0; k < nvec; k++) {
+		u64 entry = (table & ~7) + k * 16;
+		u32 val;
+
+		val = (u32)COSIM_MSI_ADDR;
+		cosim_mmio_write(table & 7, entry + 0, &val, 4);
+		val = (u32)(COSIM_MSI_ADDR >> 32);
+		cosim_mmio_write(table & 7, entry + 4, &val, 4);
+		val = k;
+		cosim_mmio_write(table & 7, entry + 8, &val, 4);
+		val = 0;
+		cosim_mmio_write(table & 7, entry + 12, &val, 4);
+	}
+
+	// MSI-X enable
+	cosim_cfg_write(cap, 0x80000000, 0xc0000000);
+
+	dev->irq_count = nvec;
+	return nvec;
+}
+
+void pci_free_irq_vectors(struct pci_dev *dev)
+{
+	u32 cap = cosim_msix_cap();
+
+	if (cap)
+		cosim_cfg_write(cap, 0x00000000, 0xc0000000);
+
+	dev->irq_count = 0;
+}
+
+int pci_irq_vector(struct pci_dev *dev, unsigned int nr)
+{
+	if (nr >= (unsigned int)dev->irq_count)
+		return -EINVAL;
+
+	return KSHIM_IRQ_BASE + nr;
+}
+
+int pci_request_irq(struct pci_dev *dev, unsigned int nr, irq_handler_t handler,
+		irq_handler_t thread_fn, void *dev_id, const char *fmt, ...)
+{
+	if (nr >= (unsigned int)dev->irq_count || !handler)
+		return -EINVAL;
+
+	if (kshim_irqs[nr].handler)
+		return -EBUSY;
+
+	kshim_irqs[nr].handler = handler;
+	kshim_irqs[nr].dev_id = dev_id;
+	kshim_irqs[nr].count = 0;
+
+	return 0;
+}
+
+void pci_free_irq(struct pci_dev *dev, unsigned int nr, void *dev_id)
+{
+	if (nr < KSHIM_MAX_IRQS && kshim_irqs[nr].dev_id == dev_id)
+		kshim_irqs[nr].handler = NULL;
+}
+
+// bind to the simulated device as 0000:01:00.0 if the ID table matches
+int pci_register_driver(struct pci_driver *drv)
+{
+	struct pci_dev *pdev = &kshim_pdev;
+	const struct pci_device_id *id;
+	u32 val;
+	int k;
+
+	kshim_driver_name = drv->name;
+
+	memset(pdev, 0, sizeof(*pdev));
+	pdev->dev.name = "0000:01:00.0";
+	pdev->dev.kobj.name = pdev->dev.name;
+	pdev->dev.numa_node = 0;
+	pdev->bus = &kshim_bus;
+	pdev->devfn = 0;
+
+	val = cosim_cfg_read(0x00);
+	pdev->vendor = val & 0xffff;
+	pdev->device = val >> 16;
+	pdev->class = cosim_cfg_read(0x08) >> 8;
+	val = cosim_cfg_read(0x2c);
+	pdev->subsystem_vendor = val & 0xffff;
+	pdev->subsystem_device = val >> 16;
+	pdev->pcie_cap = cosim_pcie_cap();
+
+	for (k = 0; k < 6; k++) {
+		u64 len = cosim_bar_len(k);
+
+		if (!len)
+			continue;
+
+		pdev->resource[k].start = cosim_bar_start(k);
+		pdev->resource[k].end = pdev->resource[k].start + len - 1;
+		pdev->resource[k].flags = IORESOURCE_MEM | IORESOURCE_MEM_64;
+	}
+
+	for (id = drv->id_table; id->vendor; id++) {
+		if ((id->vendor == PCI_ANY_ID || id->vendor == pdev->vendor) &&
+				(id->device == PCI_ANY_ID || id->device == pdev->device))
+			break;
+	}
+
+	if (!id->vendor) {
+		kshim_probe_ret = -ENODEV;
+		pr_warn("kshim: no device matching driver %s", drv->name);
+		return 0;
+	}
+
+	kshim_probe_ret = drv->probe(pdev, id);
+	if (kshim_probe_ret) {
+		pr_err("kshim: probe of %s failed with error %d", pdev->dev.name, kshim_probe_ret);
+		kshim_devres_release();
+		return 0;
+	}
+
+	kshim_bound_driver = drv;
+	return 0;
+}
+
+void pci_unregister_driver(struct pci_driver *drv)
+{
+	if (kshim_bound_driver != drv)
+		return;
+
+	drv->remove(&kshim_pdev);
+	kshim_devres_release();
+	kshim_bound_driver = NULL;
+}
+
+int kshim_probe_status(void)
+{
+	return kshim_probe_ret;
+}
@@ -0,0 +1,1010 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (c) 2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Userspace stand-in for the kernel interfaces used by the example driver.
+ *
+ * Everything runs on one thread against the simulated device: time is the
+ * simulation time, MMIO accesses become TLPs on the CQ interface, DMA
+ * addresses are host virtual addresses checked against the mappings made
+ * through the DMA API, and MSI-X interrupts are delivered whenever the
+ * simulation advances (outside of local_irq_save sections).  Work items run
+ * from the top level (kshim_run_work), never from inside a wait.
+ */
+
+#ifndef KSHIM_H
+#define KSHIM_H
+
+#include <errno.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+
+#include "cosim.h"
+
+// types
+
+typedef uint8_t u8;
+typedef uint16_t u16;
+typedef uint32_t u32;
+typedef unsigned long long u64;
+typedef int8_t s8;
+typedef int16_t s16;
+typedef int32_t s32;
+typedef long long s64;
+
+typedef uint8_t __u8;
+typedef uint16_t __u16;
+typedef uint32_t __u32;
+typedef unsigned long long __u64;
+typedef int32_t __s32;
+typedef long long __s64;
+
+typedef uint16_t __le16;
+typedef uint32_t __le32;
+typedef uint64_t __le64;
+
+typedef u64 dma_addr_t;
+typedef u64 resource_size_t;
+typedef unsigned short umode_t;
+typedef unsigned int gfp_t;
+
+#define __iomem
+#define __user
+#define __init
+#define __exit
+#define __always_unused __attribute__((unused))
+
+#define U32_MAX ((u32)~0U)
+#define U64_MAX ((u64)~0ULL)
+
+#define LINUX_VERSION_CODE KERNEL_VERSION(5, 15, 0)
+#define KERNEL_VERSION(a, b, c) (((a) << 16) + ((b) << 8) + (c))
+
+// helpers
+
+struct list_head {
+	struct list_head *next, *prev;
+};
+
+static inline void INIT_LIST_HEAD(struct list_head *list) { list->next = list->prev = list; }
+
+static inline void list_add(struct list_head *entry, struct list_head *head)
+{
+	entry->next = head->next;
+	entry->prev = head;
+	head->next->prev = entry;
+	head->next = entry;
+}
+
+static inline void list_del(struct list_head *entry)
+{
+	entry->prev->next = entry->next;
+	entry->next->prev = entry->prev;
+}
+
+#define list_for_each_entry(pos, head, member) \
+	for ((pos) = container_of((head)->next, __typeof__(*(pos)), member); \
+			&(pos)->member != (head); \
+			(pos) = container_of((pos)->member.next, __typeof__(*(pos)), member))
+
+#define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
+#define struct_size(p, member, n) (sizeof(*(p)) + (n) * sizeof(*(p)->member))
+
+#define container_of(ptr, type, member) \
+	((type *)((char *)(ptr) - offsetof(type, member)))
+
+#define READ_ONCE(x) (*(const volatile __typeof__(x) *)&(x))
+#define WRITE_ONCE(x, val) (*(volatile __typeof__(x) *)&(x) = (val))
+
+#define min(a, b) ({ __typeof__(a) _a = (a); __typeof__(b) _b = (b); _a < _b ? _a : _b; })
+#define max(a, b) ({ __typeof__(a) _a = (a); __typeof__(b) _b = (b); _a > _b ? _a : _b; })
+#define min_t(t, a, b) ({ t _a = (a); t _b = (b); _a < _b ? _a : _b; })
+#define max_t(t, a, b) ({ t _a = (a); t _b = (b); _a > _b ? _a : _b; })
+#define clamp(v, lo, hi) min(max(v, lo), hi)
+#define clamp_t(t, v, lo, hi) min_t(t, max_t(t, v, lo), hi)
+
+// the libc abs() takes an int, the kernel one any integer type
+#undef abs
+#define abs(x) ({ __typeof__(x) _x = (x); _x < 0 ? -_x : _x; })
+
+#define DIV_ROUND_UP(n, d) (((n) + (d) - 1) / (d))
+#define DIV_ROUND_UP_ULL(n, d) ((unsigned long long)DIV_ROUND_UP((unsigned long long)(n), (d)))
+
+#define array_size(a, b) ((size_t)(a) * (size_t)(b))
+
+static inline u64 div_u64(u64 dividend, u32 divisor) { return dividend / divisor; }
+static inline u64 div64_u64(u64 dividend, u64 divisor) { return dividend / divisor; }
+
+static inline u64 div_u64_rem(u64 dividend, u32 divisor, u32 *remainder)
+{
+	*remainder = dividend % divisor;
+	return dividend / divisor;
+}
+
+static inline u64 mul_u64_u32_div(u64 a, u32 mul, u32 divisor)
+{
+	return (u64)(((unsigned __int128)a * mul) / divisor);
+}
+
+static inline int fls64(u64 x) { return x ? 64 - __builtin_clzll(x) : 0; }
+static inline int ilog2(u64 x) { return fls64(x) - 1; }
+static inline bool is_power_of_2(unsigned long n) { return n != 0 && (n & (n - 1)) == 0; }
+static inline unsigned long roundup_pow_of_two(unsigned long n) { return 1UL << fls64(n - 1); }
+static inline int order_base_2(unsigned long n) { return n > 1 ? ilog2(n - 1) + 1 : 0; }
+
+#define cpu_to_le16(x) ((u16)(x))
+#define cpu_to_le32(x) ((u32)(x))
+#define cpu_to_le64(x) ((u64)(x))
+#define le16_to_cpu(x) ((u16)(x))
+#define le32_to_cpu(x) ((u32)(x))
+#define le64_to_cpu(x) ((u64)(x))
+
+#define wmb() __sync_synchronize()
+#define rmb() __sync_synchronize()
+#define dma_wmb() __sync_synchronize()
+#define dma_rmb() __sync_synchronize()
+
+void sort(void *base, size_t num, size_t size,
+		int (*cmp)(const void *, const void *),
+		void (*swap)(void *, void *, int));
+
+int scnprintf(char *buf, size_t size, const char *fmt, ...);
+
+u32 get_random_u32(void);
+
+// errors
+
+#define MAX_ERRNO 4095
+
+#define IS_ERR_VALUE(x) ((unsigned long)(void *)(x) >= (unsigned long)-MAX_ERRNO)
+
+static inline void *ERR_PTR(long error) { return (void *)error; }
+static inline long PTR_ERR(const void *ptr) { return (long)ptr; }
+static inline bool IS_ERR(const void *ptr) { return IS_ERR_VALUE(ptr); }
+static inline bool IS_ERR_OR_NULL(const void *ptr) { return !ptr || IS_ERR_VALUE(ptr); }
+
+// logging
+
+#define KERN_ERR ""
+#define KERN_WARNING ""
+#define KERN_INFO ""
+#define KERN_DEBUG ""
+
+extern bool kshim_debug;
+
+struct device;
+
+void kshim_vprintk(const char *level, const struct device *dev, const char *fmt, va_list args);
+void kshim_printk(const char *level, const struct device *dev, const char *fmt, ...);
+
+#define printk(fmt, ...) kshim_printk("info", NULL, fmt, ##__VA_ARGS__)
+#define pr_err(fmt, ...) kshim_printk("err", NULL, fmt, ##__VA_ARGS__)
+#define pr_warn(fmt, ...) kshim_printk("warn", NULL, fmt, ##__VA_ARGS__)
+#define pr_info(fmt, ...) kshim_printk("info", NULL, fmt, ##__VA_ARGS__)
+#define dev_err(dev, fmt, ...) kshim_printk("err", dev, fmt, ##__VA_ARGS__)
+#define dev_warn(dev, fmt, ...) kshim_printk("warn", dev, fmt, ##__VA_ARGS__)
+#define dev_info(dev, fmt, ...) kshim_printk("info", dev, fmt, ##__VA_ARGS__)
+#define dev_dbg(dev, fmt, ...) do { \
+	if (kshim_debug) \
+		kshim_printk("dbg", dev, fmt, ##__VA_ARGS__); \
+} while (0)
+
+enum {
+	DUMP_PREFIX_NONE,
+	DUMP_PREFIX_ADDRESS,
+	DUMP_PREFIX_OFFSET
+};
+
+void print_hex_dump(const char *level, const char *prefix_str, int prefix_type,
+		int rowsize, int groupsize, const void *buf, size_t len, bool ascii);
+
+// modules
+
+struct module;
+
+#define THIS_MODULE ((struct module *)0)
+
+#define MODULE_DESCRIPTION(x)
+#define MODULE_AUTHOR(x)
+#define MODULE_LICENSE(x)
+#define MODULE_VERSION(x)
+#define MODULE_DEVICE_TABLE(type, name)
+#define MODULE_PARM_DESC(name, desc)
+
+enum kshim_param_type {
+	KSHIM_PARAM_bool,
+	KSHIM_PARAM_int,
+	KSHIM_PARAM_uint
+};
+
+void kshim_param_register(const char *name, void *ptr, enum kshim_param_type type);
+
+#define module_param(name, type, perm) \
+	static void __attribute__((constructor)) kshim_param_init_##name(void) \
+	{ \
+		kshim_param_register(#name, &name, KSHIM_PARAM_##type); \
+	}
+
+#define module_init(fn) int kshim_module_init(void) { return fn(); }
+void kshim_release_files(void);
+
+// files left open by the top level are closed before the driver unloads
+#define module_exit(fn) void kshim_module_exit(void) { kshim_release_files(); fn(); }
+
+// memory
+
+#define PAGE_SHIFT 12
+#define PAGE_SIZE (1UL << PAGE_SHIFT)
+#define PAGE_MASK (~(PAGE_SIZE - 1))
+#define PAGE_ALIGN(addr) (((addr) + PAGE_SIZE - 1) & PAGE_MASK)
+#define offset_in_page(p) ((unsigned long)(p) & ~PAGE_MASK)
+
+#define GFP_KERNEL 0x0001u
+#define GFP_ATOMIC 0x0002u
+#define __GFP_ZERO 0x0100u
+#define __GFP_NOWARN 0x0200u
+#define __GFP_THISNODE 0x0400u
+
+void *kzalloc(size_t size, gfp_t flags);
+void *kmalloc(size_t size, gfp_t flags);
+void *kmalloc_array(size_t n, size_t size, gfp_t flags);
+void *kcalloc(size_t n, size_t size, gfp_t flags);
+void kfree(const void *ptr);
+
+#define kvmalloc_array kmalloc_array
+#define kvzalloc kzalloc
+#define kvfree kfree
+
+void *vmalloc(unsigned long size);
+void *vzalloc(unsigned long size);
+void vfree(const void *ptr);
+
+void *devm_kzalloc(struct device *dev, size_t size, gfp_t flags);
+
+struct page {
+	void *virt;
+	unsigned int order;
+	bool owned;
+};
+
+static inline void *page_address(const struct page *page) { return page->virt; }
+static inline int page_to_nid(const struct page *page) { return 0; }
+
+static inline int get_order(unsigned long size)
+{
+	return size > PAGE_SIZE ? order_base_2(DIV_ROUND_UP(size, PAGE_SIZE)) : 0;
+}
+
+struct page *alloc_pages_node(int nid, gfp_t flags, unsigned int order);
+void __free_pages(struct page *page, unsigned int order);
+
+#define FOLL_WRITE 0x01
+#define FOLL_LONGTERM 0x100
+
+long pin_user_pages_fast(unsigned long start, int nr_pages, unsigned int gup_flags,
+		struct page **pages);
+void unpin_user_pages_dirty_lock(struct page **pages, unsigned long npages, bool make_dirty);
+long get_user_pages_fast(unsigned long start, int nr_pages, unsigned int gup_flags,
+		struct page **pages);
+void put_page(struct page *page);
+static inline void set_page_dirty_lock(struct page *page) {}
+
+static inline unsigned long copy_to_user(void __user *to, const void *from, unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+static inline unsigned long copy_from_user(void *to, const void __user *from, unsigned long n)
+{
+	memcpy(to, from, n);
+	return 0;
+}
+
+#define u64_to_user_ptr(x) ((void __user *)(uintptr_t)(x))
+
+// NUMA (single node, devices report no affinity)
+
+#define NUMA_NO_NODE (-1)
+#define CONFIG_NR_CPUS 1
+
+struct cpumask {
+	unsigned long bits[1];
+};
+
+extern const struct cpumask kshim_node_cpumask;
+
+#define nr_cpu_ids CONFIG_NR_CPUS
+#define cpumask_bits(maskp) ((maskp)->bits)
+#define cpumask_pr_args(maskp) nr_cpu_ids, cpumask_bits(maskp)
+#define cpumask_of_node(node) (&kshim_node_cpumask)
+#define for_each_online_node(node) for ((node) = 0; (node) < 1; (node)++)
+
+typedef struct cpumask cpumask_var_t[1];
+
+extern const struct cpumask kshim_online_cpumask;
+
+#define cpu_online_mask (&kshim_online_cpumask)
+#define for_each_cpu(cpu, mask) \
+	for ((cpu) = 0; (cpu) < 8 * (int)sizeof(unsigned long); (cpu)++) \
+		if ((mask)->bits[0] & (1UL << (cpu)))
+
+static inline bool cpumask_empty(const struct cpumask *mask) { return !mask->bits[0]; }
+static inline unsigned int cpumask_weight(const struct cpumask *mask) { return __builtin_popcountl(mask->bits[0]); }
+static inline void cpumask_and(struct cpumask *dst, const struct cpumask *a, const struct cpumask *b)
+{
+	dst->bits[0] = a->bits[0] & b->bits[0];
+}
+static inline bool zalloc_cpumask_var(cpumask_var_t *mask, gfp_t flags)
+{
+	(*mask)->bits[0] = 0;
+	return true;
+}
+static inline void free_cpumask_var(cpumask_var_t mask) {}
+int cpulist_parse(const char *buf, struct cpumask *mask);
+
+static inline int numa_node_id(void) { return 0; }
+static inline int cpu_to_node(int cpu) { return 0; }
+static inline int raw_smp_processor_id(void) { return 0; }
+
+// threads (not supported, everything runs on the simulation thread)
+
+typedef struct {
+	int counter;
+} atomic_t;
+
+static inline int atomic_read(const atomic_t *v) { return READ_ONCE(v->counter); }
+static inline void atomic_set(atomic_t *v, int i) { WRITE_ONCE(v->counter, i); }
+static inline void atomic_inc(atomic_t *v) { v->counter++; }
+
+#define smp_load_acquire(p) READ_ONCE(*(p))
+#define smp_store_release(p, v) WRITE_ONCE(*(p), v)
+
+struct mm_struct {
+	unsigned long locked_vm;
+};
+
+struct task_struct {
+	struct mm_struct *mm;
+};
+
+extern struct task_struct kshim_current;
+
+#define current (&kshim_current)
+
+static inline void mmgrab(struct mm_struct *mm) {}
+static inline void mmdrop(struct mm_struct *mm) {}
+
+// no RLIMIT_MEMLOCK, only keeps the count
+static inline int account_locked_vm(struct mm_struct *mm, unsigned long pages, bool inc)
+{
+	mm->locked_vm += inc ? pages : -pages;
+	return 0;
+}
+
+struct task_struct *kthread_create_on_node(int (*fn)(void *data), void *data, int node,
+		const char *fmt, ...);
+static inline void kthread_bind(struct task_struct *t, unsigned int cpu) {}
+static inline int wake_up_process(struct task_struct *t) { return 0; }
+static inline int kthread_stop(struct task_struct *t) { return 0; }
+static inline bool kthread_should_stop(void) { return false; }
+static inline void get_task_struct(struct task_struct *t) {}
+static inline void put_task_struct(struct task_struct *t) {}
+
+// time (simulation time, 1 GHz TSC)
+
+#define HZ 1000
+
+#define MSEC_PER_SEC 1000L
+#define USEC_PER_MSEC 1000L
+#define USEC_PER_SEC 1000000L
+#define NSEC_PER_USEC 1000L
+#define NSEC_PER_MSEC 1000000L
+#define NSEC_PER_SEC 1000000000L
+
+extern unsigned int tsc_khz;
+
+#define jiffies ((unsigned long)(cosim_time_ns() / (NSEC_PER_SEC / HZ)))
+
+#define time_after(a, b) ((long)((b) - (a)) < 0)
+#define time_before(a, b) time_after(b, a)
+
+static inline unsigned long msecs_to_jiffies(unsigned int m) { return m; }
+static inline unsigned long usecs_to_jiffies(unsigned int u) { return DIV_ROUND_UP(u, 1000); }
+static inline unsigned int jiffies_to_msecs(unsigned long j) { return j; }
+
+static inline u64 ktime_get_ns(void) { return cosim_time_ns(); }
+static inline u64 rdtsc_ordered(void) { return cosim_time_ns(); }
+
+void udelay(unsigned long usecs);
+void ndelay(unsigned long nsecs);
+void msleep(unsigned int msecs);
+void usleep_range(unsigned long min, unsigned long max);
+void cpu_relax(void);
+void cond_resched(void);
+
+// interrupts
+
+typedef enum {
+	IRQ_NONE,
+	IRQ_HANDLED
+} irqreturn_t;
+
+typedef irqreturn_t (*irq_handler_t)(int irq, void *dev_id);
+
+unsigned long kshim_irq_save(void);
+void kshim_irq_restore(unsigned long flags);
+
+#define local_irq_save(flags) ((flags) = kshim_irq_save())
+#define local_irq_restore(flags) kshim_irq_restore(flags)
+
+static inline int irq_set_affinity_hint(unsigned int irq, const struct cpumask *m) { return 0; }
+
+// locking (single threaded, checks for recursion)
+
+struct mutex {
+	int locked;
+};
+
+void kshim_mutex_lock(struct mutex *lock, const char *name);
+void kshim_mutex_unlock(struct mutex *lock, const char *name);
+
+#define mutex_init(lock) ((lock)->locked = 0)
+#define mutex_lock(lock) kshim_mutex_lock(lock, #lock)
+#define mutex_unlock(lock) kshim_mutex_unlock(lock, #lock)
+#define mutex_lock_interruptible(lock) (kshim_mutex_lock(lock, #lock), 0)
+
+struct rw_semaphore {
+	int readers;
+	int writer;
+};
+
+static inline void init_rwsem(struct rw_semaphore *sem) { sem->readers = sem->writer = 0; }
+static inline void down_read(struct rw_semaphore *sem) { sem->readers++; }
+static inline void up_read(struct rw_semaphore *sem) { sem->readers--; }
+void kshim_down_write(struct rw_semaphore *sem);
+#define down_write(sem) kshim_down_write(sem)
+static inline void up_write(struct rw_semaphore *sem) { sem->writer = 0; }
+
+// reference counts
+
+struct kref {
+	int refcount;
+};
+
+static inline void kref_init(struct kref *kref) { kref->refcount = 1; }
+static inline void kref_get(struct kref *kref) { kref->refcount++; }
+static inline int kref_put(struct kref *kref, void (*release)(struct kref *kref))
+{
+	if (--kref->refcount)
+		return 0;
+	release(kref);
+	return 1;
+}
+
+// completions
+
+struct completion {
+	unsigned int done;
+};
+
+static inline void init_completion(struct completion *x) { x->done = 0; }
+static inline void reinit_completion(struct completion *x) { x->done = 0; }
+static inline void complete(struct completion *x) { x->done++; }
+
+unsigned long wait_for_completion_timeout(struct completion *x, unsigned long timeout);
+
+// wait queues (with one thread, nobody else can make the condition true,
+// so a wait that would sleep returns as if interrupted)
+
+#define ERESTARTSYS 512
+
+typedef struct {
+	int unused;
+} wait_queue_head_t;
+
+static inline void init_waitqueue_head(wait_queue_head_t *wq) {}
+static inline void wake_up_interruptible(wait_queue_head_t *wq) {}
+
+#define wait_event_interruptible(wq, condition) ((condition) ? 0 : -ERESTARTSYS)
+
+// work queues
+
+struct work_struct;
+
+typedef void (*work_func_t)(struct work_struct *work);
+
+struct work_struct {
+	work_func_t func;
+	struct work_struct *next;
+	bool pending;
+	u64 due_ns;
+};
+
+struct delayed_work {
+	struct work_struct work;
+};
+
+#define INIT_WORK(w, f) do { \
+	(w)->func = (f); \
+	(w)->next = NULL; \
+	(w)->pending = false; \
+} while (0)
+#define INIT_DELAYED_WORK(w, f) INIT_WORK(&(w)->work, f)
+
+#define to_delayed_work(w) container_of(w, struct delayed_work, work)
+
+bool schedule_work(struct work_struct *work);
+bool schedule_delayed_work(struct delayed_work *dwork, unsigned long delay);
+bool cancel_work_sync(struct work_struct *work);
+bool cancel_delayed_work_sync(struct delayed_work *dwork);
+
+// IDs
+
+struct ida {
+	int next;
+};
+
+#define DEFINE_IDA(name) struct ida name = {0}
+
+static inline int ida_alloc(struct ida *ida, gfp_t gfp) { return ida->next++; }
+static inline void ida_free(struct ida *ida, unsigned int id) {}
+
+// devices, files and sysfs
+
+struct kobject {
+	const char *name;
+};
+
+struct device {
+	struct kobject kobj;
+	int numa_node;
+	void *driver_data;
+	const char *name;
+};
+
+static inline void *dev_get_drvdata(const struct device *dev) { return dev->driver_data; }
+static inline void dev_set_drvdata(struct device *dev, void *data) { dev->driver_data = data; }
+static inline int dev_to_node(struct device *dev) { return dev->numa_node; }
+
+struct inode {
+	void *i_private;
+};
+
+struct address_space;
+
+struct file {
+	struct address_space *f_mapping;
+	void *private_data;
+	unsigned int f_flags;
+	loff_t f_pos;
+};
+
+#ifndef O_NONBLOCK
+#define O_NONBLOCK 04000
+#endif
+
+// user mappings are not modelled
+static inline void unmap_mapping_range(struct address_space *mapping, loff_t start,
+		loff_t len, int even_cows) {}
+
+static inline int stream_open(struct inode *inode, struct file *file) { return 0; }
+
+#define IOCB_NOWAIT (1 << 7)
+
+struct kiocb {
+	struct file *ki_filp;
+	loff_t ki_pos;
+	int ki_flags;
+};
+
+// single kernel buffer segment
+struct iov_iter {
+	char *base;
+	size_t count;
+	size_t offset;
+};
+
+static inline void kshim_iov_iter_init(struct iov_iter *i, void *buf, size_t count)
+{
+	i->base = buf;
+	i->count = count;
+	i->offset = 0;
+}
+
+static inline size_t iov_iter_count(const struct iov_iter *i) { return i->count; }
+size_t copy_to_iter(const void *addr, size_t bytes, struct iov_iter *i);
+size_t copy_from_iter(void *addr, size_t bytes, struct iov_iter *i);
+void iov_iter_revert(struct iov_iter *i, size_t bytes);
+
+struct pipe_inode_info;
+
+ssize_t generic_file_splice_read(struct file *in, loff_t *ppos,
+		struct pipe_inode_info *pipe, size_t len, unsigned int flags);
+ssize_t iter_file_splice_write(struct pipe_inode_info *pipe, struct file *out,
+		loff_t *ppos, size_t len, unsigned int flags);
+
+typedef struct {
+	unsigned long pgprot;
+} pgprot_t;
+
+#define pgprot_noncached(prot) (prot)
+#define pgprot_writecombine(prot) (prot)
+
+struct vm_area_struct {
+	unsigned long vm_start;
+	unsigned long vm_end;
+	unsigned long vm_pgoff;
+	pgprot_t vm_page_prot;
+};
+
+int remap_pfn_range(struct vm_area_struct *vma, unsigned long addr, unsigned long pfn,
+		unsigned long size, pgprot_t prot);
+
+struct file_operations {
+	struct module *owner;
+	loff_t (*llseek)(struct file *file, loff_t offset, int whence);
+	ssize_t (*read)(struct file *file, char __user *buf, size_t count, loff_t *ppos);
+	ssize_t (*write)(struct file *file, const char __user *buf, size_t count, loff_t *ppos);
+	ssize_t (*read_iter)(struct kiocb *iocb, struct iov_iter *to);
+	ssize_t (*write_iter)(struct kiocb *iocb, struct iov_iter *from);
+	ssize_t (*splice_read)(struct file *in, loff_t *ppos, struct pipe_inode_info *pipe,
+			size_t len, unsigned int flags);
+	ssize_t (*splice_write)(struct pipe_inode_info *pipe, struct file *out, loff_t *ppos,
+			size_t len, unsigned int flags);
+	long (*unlocked_ioctl)(struct file *file, unsigned int cmd, unsigned long arg);
+	int (*mmap)(struct file *file, struct vm_area_struct *vma);
+	int (*open)(struct inode *inode, struct file *file);
+	int (*release)(struct inode *inode, struct file *file);
+};
+
+#define MISC_DYNAMIC_MINOR 255
+
+struct miscdevice {
+	int minor;
+	const char *name;
+	const struct file_operations *fops;
+	struct device *parent;
+	struct miscdevice *next;
+};
+
+int misc_register(struct miscdevice *misc);
+void misc_deregister(struct miscdevice *misc);
+
+struct attribute {
+	const char *name;
+	umode_t mode;
+};
+
+struct device_attribute {
+	struct attribute attr;
+	ssize_t (*show)(struct device *dev, struct device_attribute *attr, char *buf);
+	ssize_t (*store)(struct device *dev, struct device_attribute *attr,
+			const char *buf, size_t count);
+};
+
+struct attribute_group {
+	const char *name;
+	struct attribute **attrs;
+};
+
+#define DEVICE_ATTR_RO(_name) \
+	struct device_attribute dev_attr_##_name = { \
+		.attr = { .name = #_name, .mode = 0444 }, \
+		.show = _name##_show, \
+	}
+#define DEVICE_ATTR_WO(_name) \
+	struct device_attribute dev_attr_##_name = { \
+		.attr = { .name = #_name, .mode = 0200 }, \
+		.store = _name##_store, \
+	}
+#define DEVICE_ATTR_RW(_name) \
+	struct device_attribute dev_attr_##_name = { \
+		.attr = { .name = #_name, .mode = 0644 }, \
+		.show = _name##_show, \
+		.store = _name##_store, \
+	}
+
+static inline int sysfs_create_group(struct kobject *kobj, const struct attribute_group *grp) { return 0; }
+static inline void sysfs_remove_group(struct kobject *kobj, const struct attribute_group *grp) {}
+
+bool sysfs_streq(const char *s1, const char *s2);
+char *strim(char *s);
+ssize_t strscpy(char *dst, const char *src, size_t count);
+int __sysfs_match_string(const char * const *array, size_t n, const char *str);
+
+#define sysfs_match_string(a, s) __sysfs_match_string(a, ARRAY_SIZE(a), s)
+
+// seq_file and debugfs (files are created but only reachable through the shim)
+
+struct seq_file {
+	char *buf;
+	size_t size;
+	size_t count;
+	void *private;
+	int (*show)(struct seq_file *s, void *data);
+};
+
+void seq_printf(struct seq_file *s, const char *fmt, ...);
+void seq_puts(struct seq_file *s, const char *str);
+int single_open(struct file *file, int (*show)(struct seq_file *, void *), void *data);
+int single_release(struct inode *inode, struct file *file);
+ssize_t seq_read(struct file *file, char __user *buf, size_t size, loff_t *ppos);
+loff_t seq_lseek(struct file *file, loff_t offset, int whence);
+
+struct dentry {
+	const char *name;
+	void *data;
+	const struct file_operations *fops;
+	struct dentry *parent;
+	struct dentry *next;
+};
+
+struct dentry *debugfs_create_dir(const char *name, struct dentry *parent);
+struct dentry *debugfs_create_file(const char *name, umode_t mode, struct dentry *parent,
+		void *data, const struct file_operations *fops);
+void debugfs_create_u32(const char *name, umode_t mode, struct dentry *parent, u32 *value);
+void debugfs_create_x32(const char *name, umode_t mode, struct dentry *parent, u32 *value);
+void debugfs_remove_recursive(struct dentry *dentry);
+
+// ioctl numbers (asm-generic encoding, as seen by userspace)
+
+#define _IOC_NRBITS 8
+#define _IOC_TYPEBITS 8
+#define _IOC_SIZEBITS 14
+#define _IOC_NRSHIFT 0
+#define _IOC_TYPESHIFT (_IOC_NRSHIFT + _IOC_NRBITS)
+#define _IOC_SIZESHIFT (_IOC_TYPESHIFT + _IOC_TYPEBITS)
+#define _IOC_DIRSHIFT (_IOC_SIZESHIFT + _IOC_SIZEBITS)
+#define _IOC_NONE 0U
+#define _IOC_WRITE 1U
+#define _IOC_READ 2U
+
+#define _IOC(dir, type, nr, size) \
+	(((dir) << _IOC_DIRSHIFT) | ((type) << _IOC_TYPESHIFT) | \
+	 ((nr) << _IOC_NRSHIFT) | ((size) << _IOC_SIZESHIFT))
+#define _IO(type, nr) _IOC(_IOC_NONE, (type), (nr), 0)
+#define _IOR(type, nr, size) _IOC(_IOC_READ, (type), (nr), sizeof(size))
+#define _IOW(type, nr, size) _IOC(_IOC_WRITE, (type), (nr), sizeof(size))
+#define _IOWR(type, nr, size) _IOC(_IOC_READ | _IOC_WRITE, (type), (nr), sizeof(size))
+#define _IOC_TYPE(nr) (((nr) >> _IOC_TYPESHIFT) & ((1 << _IOC_TYPEBITS) - 1))
+
+// MMIO (addresses returned by ioremap, see kshim.c)
+
+u32 ioread32(const void __iomem *addr);
+void iowrite32(u32 value, void __iomem *addr);
+u64 ioread64(const void __iomem *addr);
+void iowrite64(u64 value, void __iomem *addr);
+void __iowrite64_copy(void __iomem *to, const void *from, size_t count);
+void __iowrite32_copy(void __iomem *to, const void *from, size_t count);
+
+void __iomem *ioremap(resource_size_t offset, unsigned long size);
+void __iomem *ioremap_wc(resource_size_t offset, unsigned long size);
+void iounmap(volatile void __iomem *addr);
+
+// DMA API (identity mapped, every mapping is registered with the model)
+
+enum dma_data_direction {
+	DMA_BIDIRECTIONAL = 0,
+	DMA_TO_DEVICE = 1,
+	DMA_FROM_DEVICE = 2,
+	DMA_NONE = 3
+};
+
+void *dma_alloc_coherent(struct device *dev, size_t size, dma_addr_t *dma_handle, gfp_t gfp);
+void dma_free_coherent(struct device *dev, size_t size, void *cpu_addr, dma_addr_t dma_handle);
+int dma_mmap_coherent(struct device *dev, struct vm_area_struct *vma,
+		void *cpu_addr, dma_addr_t dma_addr, size_t size);
+
+dma_addr_t dma_map_page(struct device *dev, struct page *page, size_t offset,
+		size_t size, enum dma_data_direction dir);
+void dma_unmap_page(struct device *dev, dma_addr_t addr, size_t size,
+		enum dma_data_direction dir);
+
+static inline int dma_mapping_error(struct device *dev, dma_addr_t addr) { return addr == 0; }
+
+struct scatterlist {
+	struct page *page;
+	unsigned int offset;
+	unsigned int length;
+	dma_addr_t dma_address;
+	unsigned int dma_length;
+};
+
+struct sg_table {
+	struct scatterlist *sgl;
+	unsigned int nents;
+	unsigned int orig_nents;
+};
+
+#define sg_dma_address(sg) ((sg)->dma_address)
+#define sg_dma_len(sg) ((sg)->dma_length)
+#define sg_next(sg) ((sg) + 1)
+#define for_each_sg(sglist, sg, nr, __i) \
+	for (__i = 0, sg = (sglist); __i < (nr); __i++, sg = sg_next(sg))
+
+int sg_alloc_table_from_pages(struct sg_table *sgt, struct page **pages,
+		unsigned int n_pages, unsigned int offset, unsigned long size, gfp_t gfp_mask);
+void sg_free_table(struct sg_table *table);
+
+int dma_map_sg(struct device *dev, struct scatterlist *sg, int nents,
+		enum dma_data_direction dir);
+void dma_unmap_sg(struct device *dev, struct scatterlist *sg, int nents,
+		enum dma_data_direction dir);
+
+static inline void dma_sync_sg_for_cpu(struct device *dev, struct scatterlist *sg, int nelems,
+		enum dma_data_direction dir) {}
+static inline void dma_sync_sg_for_device(struct device *dev, struct scatterlist *sg, int nelems,
+		enum dma_data_direction dir) {}
+
+// PCI
+
+#define PCI_ANY_ID (~0U)
+
+#define PCI_DEVICE(vend, dev) \
+	.vendor = (vend), .device = (dev), \
+	.subvendor = PCI_ANY_ID, .subdevice = PCI_ANY_ID
+
+#define PCI_SLOT(devfn) (((devfn) >> 3) & 0x1f)
+#define PCI_FUNC(devfn) ((devfn) & 0x07)
+
+#define PCI_IRQ_LEGACY 0x01
+#define PCI_IRQ_MSI 0x02
+#define PCI_IRQ_MSIX 0x04
+
+#define PCIE_LINK_STATE_L0S 0x01
+#define PCIE_LINK_STATE_L1 0x02
+#define PCIE_LINK_STATE_CLKPM 0x04
+
+#define IORESOURCE_MEM 0x00000200
+#define IORESOURCE_PREFETCH 0x00002000
+#define IORESOURCE_MEM_64 0x00100000
+
+// PCI Express capability registers (include/uapi/linux/pci_regs.h)
+#define PCI_EXP_DEVCAP 0x04
+#define PCI_EXP_DEVCAP_EXT_TAG 0x00000020
+#define PCI_EXP_DEVCTL 0x08
+#define PCI_EXP_DEVCTL_RELAX_EN 0x0010
+#define PCI_EXP_DEVCTL_PAYLOAD 0x00e0
+#define PCI_EXP_DEVCTL_EXT_TAG 0x0100
+#define PCI_EXP_DEVCTL_PHANTOM 0x0200
+#define PCI_EXP_DEVCTL_NOSNOOP_EN 0x0800
+#define PCI_EXP_DEVCTL_READRQ 0x7000
+#define PCI_EXP_LNKCAP 0x0c
+#define PCI_EXP_LNKCAP_SLS 0x0000000f
+#define PCI_EXP_LNKCAP_MLW 0x000003f0
+#define PCI_EXP_LNKCTL 0x10
+#define PCI_EXP_LNKCTL_RCB 0x0008
+#define PCI_EXP_LNKSTA 0x12
+#define PCI_EXP_LNKSTA_CLS 0x000f
+#define PCI_EXP_LNKSTA_NLW 0x03f0
+#define PCI_EXP_DEVCAP2 0x24
+#define PCI_EXP_DEVCTL2 0x28
+
+struct pci_device_id {
+	u32 vendor, device;
+	u32 subvendor, subdevice;
+	u32 class, class_mask;
+	unsigned long driver_data;
+};
+
+struct pci_bus {
+	int domain;
+	unsigned char number;
+};
+
+struct resource {
+	resource_size_t start;
+	resource_size_t end;
+	unsigned long flags;
+};
+
+struct pci_dev {
+	struct device dev;
+	struct pci_bus *bus;
+	unsigned int devfn;
+	unsigned short vendor;
+	unsigned short device;
+	unsigned short subsystem_vendor;
+	unsigned short subsystem_device;
+	unsigned int class;
+	u8 pcie_cap;
+	struct resource resource[6];
+	int irq_count;
+};
+
+enum probe_type {
+	PROBE_DEFAULT_STRATEGY,
+	PROBE_PREFER_ASYNCHRONOUS,
+	PROBE_FORCE_SYNCHRONOUS
+};
+
+struct device_driver {
+	enum probe_type probe_type;
+};
+
+struct pci_driver {
+	const char *name;
+	const struct pci_device_id *id_table;
+	int (*probe)(struct pci_dev *dev, const struct pci_device_id *id);
+	void (*remove)(struct pci_dev *dev);
+	void (*shutdown)(struct pci_dev *dev);
+	struct device_driver driver;
+};
+
+int pci_register_driver(struct pci_driver *drv);
+void pci_unregister_driver(struct pci_driver *drv);
+
+#define pci_resource_start(dev, bar) ((dev)->resource[(bar)].start)
+#define pci_resource_end(dev, bar) ((dev)->resource[(bar)].end)
+#define pci_resource_flags(dev, bar) ((dev)->resource[(bar)].flags)
+#define pci_resource_len(dev, bar) \
+	((dev)->resource[(bar)].end ? (dev)->resource[(bar)].end - (dev)->resource[(bar)].start + 1 : 0)
+
+static inline int pci_domain_nr(struct pci_bus *bus) { return bus->domain; }
+static inline const char *pci_name(const struct pci_dev *pdev) { return pdev->dev.name; }
+static inline bool pci_is_pcie(struct pci_dev *dev) { return dev->pcie_cap != 0; }
+static inline void *pci_get_drvdata(struct pci_dev *pdev) { return pdev->dev.driver_data; }
+static inline void pci_set_drvdata(struct pci_dev *pdev, void *data) { pdev->dev.driver_data = data; }
+static inline struct pci_dev *pci_upstream_bridge(struct pci_dev *dev) { return NULL; }
+
+int pci_read_config_word(const struct pci_dev *dev, int where, u16 *val);
+int pci_read_config_dword(const struct pci_dev *dev, int where, u32 *val);
+int pci_write_config_word(const struct pci_dev *dev, int where, u16 val);
+int pci_write_config_dword(const struct pci_dev *dev, int where, u32 val);
+
+int pcie_capability_read_word(struct pci_dev *dev, int pos, u16 *val);
+int pcie_capability_read_dword(struct pci_dev *dev, int pos, u32 *val);
+int pcie_capability_clear_and_set_word(struct pci_dev *dev, int pos, u16 clear, u16 set);
+
+#define pcie_capability_set_word(dev, pos, set) pcie_capability_clear_and_set_word(dev, pos, 0, set)
+#define pcie_capability_clear_word(dev, pos, clear) pcie_capability_clear_and_set_word(dev, pos, clear, 0)
+
+void pcie_print_link_status(struct pci_dev *dev);
+static inline int pci_disable_link_state(struct pci_dev *pdev, int state) { return 0; }
+
+int pci_enable_device_mem(struct pci_dev *dev);
+void pci_disable_device(struct pci_dev *dev);
+void pci_set_master(struct pci_dev *dev);
+void pci_clear_master(struct pci_dev *dev);
+static inline int pci_request_regions(struct pci_dev *pdev, const char *name) { return 0; }
+static inline void pci_release_regions(struct pci_dev *pdev) {}
+
+void __iomem *pci_ioremap_bar(struct pci_dev *pdev, int bar);
+void pci_iounmap(struct pci_dev *dev, void __iomem *addr);
+
+int pci_alloc_irq_vectors(struct pci_dev *dev, unsigned int min_vecs,
+		unsigned int max_vecs, unsigned int flags);
+void pci_free_irq_vectors(struct pci_dev *dev);
+int pci_irq_vector(struct pci_dev *dev, unsigned int nr);
+int pci_request_irq(struct pci_dev *dev, unsigned int nr, irq_handler_t handler,
+		irq_handler_t thread_fn, void *dev_id, const char *fmt, ...);
+void pci_free_irq(struct pci_dev *dev, unsigned int nr, void *dev_id);
+
+#endif /* KSHIM_H */
@@ -0,0 +1,320 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+/*
+ * Loads the example driver against the Verilated card, runs the driver
+ * tests and optionally a block DMA benchmark sweep through the same ioctls
+ * userspace uses.
+ */
+
+#include "cosim.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <getopt.h>
+#include <sys/ioctl.h>
+#include <vector>
+
+#include "example_ioctl.h"
+
+static void usage(const char *name)
+{
+	fprintf(stderr,
+		"usage: %s [options] [param=value ...]\n"
+		"\n"
+		"  param=value             driver module parameter\n"
+		"  -t, --tests FLAGS       EDEV_IOCTL_RUN_TESTS flags (default 0x1)\n"
+		"  -b, --bench             run a block DMA benchmark sweep\n"
+		"      --bench-dir DIR     read (to card) or write (from card)\n"
+		"      --bench-buf BUF     coherent, local\n"
+		"      --bench-pattern P   linear, random, list\n"
+		"      --bench-size-min N  smallest block size (default 64)\n"
+		"      --bench-size-max N  largest block size (default 4096)\n"
+		"      --bench-stride N    block stride (default block size)\n"
+		"      --bench-count N     blocks per run (default 32)\n"
+		"      --bench-repeat N    runs per block size (default 4)\n"
+		"      --min-mbps N        fail if largest block median throughput is below N\n"
+		"      --mmio-latency N    one-way MMIO latency in ns\n"
+		"      --dma-latency N     DMA read latency in ns\n"
+		"      --cpl-size N        read completion size in bytes\n"
+		"      --max-time N        abort after N ms of simulated time\n"
+		"      --trace FILE        write an FST waveform (TRACE=1 build)\n"
+		"  -v, --verbose           enable dev_dbg output\n"
+		"  -p, --params            list driver module parameters\n"
+		"  -h, --help              this message\n",
+		name);
+}
+
+static int parse_choice(const char *opt, const char *arg, const char *const *names, int n)
+{
+	for (int k = 0; k < n; k++) {
+		if (!strcmp(arg, names[k]))
+			return k;
+	}
+
+	fprintf(stderr, "invalid value '%s' for --%s\n", arg, opt);
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	static const char *const dir_names[] = {"read", "write"};
+	static const char *const buf_names[] = {"coherent", "user", "local", "remote"};
+	static const char *const pattern_names[] = {"linear", "random", "list"};
+
+	enum {
+		OPT_BENCH_DIR = 256,
+		OPT_BENCH_BUF,
+		OPT_BENCH_PATTERN,
+		OPT_BENCH_SIZE_MIN,
+		OPT_BENCH_SIZE_MAX,
+		OPT_BENCH_STRIDE,
+		OPT_BENCH_COUNT,
+		OPT_BENCH_REPEAT,
+		OPT_MIN_MBPS,
+		OPT_MMIO_LATENCY,
+		OPT_DMA_LATENCY,
+		OPT_CPL_SIZE,
+		OPT_MAX_TIME,
+		OPT_TRACE,
+	};
+
+	static const struct option long_opts[] = {
+		{"tests", required_argument, nullptr, 't'},
+		{"bench", no_argument, nullptr, 'b'},
+		{"bench-dir", required_argument, nullptr, OPT_BENCH_DIR},
+		{"bench-buf", required_argument, nullptr, OPT_BENCH_BUF},
+		{"bench-pattern", required_argument, nullptr, OPT_BENCH_PATTERN},
+		{"bench-size-min", required_argument, nullptr, OPT_BENCH_SIZE_MIN},
+		{"bench-size-max", required_argument, nullptr, OPT_BENCH_SIZE_MAX},
+		{"bench-stride", required_argument, nullptr, OPT_BENCH_STRIDE},
+		{"bench-count", required_argument, nullptr, OPT_BENCH_COUNT},
+		{"bench-repeat", required_argument, nullptr, OPT_BENCH_REPEAT},
+		{"min-mbps", required_argument, nullptr, OPT_MIN_MBPS},
+		{"mmio-latency", required_argument, nullptr, OPT_MMIO_LATENCY},
+		{"dma-latency", required_argument, nullptr, OPT_DMA_LATENCY},
+		{"cpl-size", required_argument, nullptr, OPT_CPL_SIZE},
+		{"max-time", required_argument, nullptr, OPT_MAX_TIME},
+		{"trace", required_argument, nullptr, OPT_TRACE},
+		{"verbose", no_argument, nullptr, 'v'},
+		{"params", no_argument, nullptr, 'p'},
+		{"help", no_argument, nullptr, 'h'},
+		{nullptr, 0, nullptr, 0}
+	};
+
+	struct cosim_options opts;
+	struct edev_ioctl_bench bench;
+	unsigned long tests = EDEV_TEST_SELF;
+	bool run_bench = false;
+	unsigned long long min_mbps = 0;
+	int ret = 0;
+	int opt;
+
+	cosim_default_options(&opts);
+
+	memset(&bench, 0, sizeof(bench));
+	bench.dir = EDEV_DMA_TO_CARD;
+	bench.buf = EDEV_BENCH_BUF_COHERENT;
+	bench.pattern = EDEV_BENCH_PATTERN_LINEAR;
+	bench.region_len = 16384;
+	bench.size_min = 64;
+	bench.size_max = 4096;
+	bench.count = 32;
+	bench.repeat = 4;
+
+	// tests are run explicitly below, not from the probe work item
+	kshim_param_set("test_on_load", "0");
+
+	while ((opt = getopt_long(argc, argv, "t:bvph", long_opts, nullptr)) != -1) {
+		switch (opt) {
+		case 't':
+			tests = strtoul(optarg, nullptr, 0);
+			break;
+		case 'b':
+			run_bench = true;
+			break;
+		case OPT_BENCH_DIR:
+			bench.dir = parse_choice("bench-dir", optarg, dir_names, 2);
+			break;
+		case OPT_BENCH_BUF:
+			bench.buf = parse_choice("bench-buf", optarg, buf_names, 4);
+			// no userspace buffer mapping from here
+			if (bench.buf == EDEV_BENCH_BUF_USER) {
+				fprintf(stderr, "user buffers are not supported\n");
+				return 1;
+			}
+			break;
+		case OPT_BENCH_PATTERN:
+			bench.pattern = parse_choice("bench-pattern", optarg, pattern_names, 3);
+			break;
+		case OPT_BENCH_SIZE_MIN:
+			bench.size_min = strtoul(optarg, nullptr, 0);
+			break;
+		case OPT_BENCH_SIZE_MAX:
+			bench.size_max = strtoul(optarg, nullptr, 0);
+			break;
+		case OPT_BENCH_STRIDE:
+			bench.stride = strtoul(optarg, nullptr, 0);
+			break;
+		case OPT_BENCH_COUNT:
+			bench.count = strtoul(optarg, nullptr, 0);
+			break;
+		case OPT_BENCH_REPEAT:
+			bench.repeat = strtoul(optarg, nullptr, 0);
+			break;
+		case OPT_MIN_MBPS:
+			min_mbps = strtoull(optarg, nullptr, 0);
+			break;
+		case OPT_MMIO_LATENCY:
+			opts.mmio_latency_ns = strtoul(optarg, nullptr, 0);
+			break;
+		case OPT_DMA_LATENCY:
+			opts.dma_read_latency_ns = strtoul(optarg, nullptr, 0);
+			break;
+		case OPT_CPL_SIZE:
+			opts.cpl_size = strtoul(optarg, nullptr, 0);
+			break;
+		case OPT_MAX_TIME:
+			opts.max_time_ns = strtoull(optarg, nullptr, 0) * 1000000;
+			break;
+		case OPT_TRACE:
+			opts.trace_file = optarg;
+			break;
+		case 'v':
+			kshim_set_debug(1);
+			break;
+		case 'p':
+			printf("driver module parameters:\n");
+			kshim_param_print();
+			return 0;
+		case 'h':
+			usage(argv[0]);
+			return 0;
+		default:
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	for (int k = optind; k < argc; k++) {
+		char *eq = strchr(argv[k], '=');
+
+		if (!eq) {
+			fprintf(stderr, "expected param=value, got '%s'\n", argv[k]);
+			return 1;
+		}
+
+		*eq = 0;
+		if (kshim_param_set(argv[k], eq + 1)) {
+			fprintf(stderr, "invalid module parameter %s=%s\n", argv[k], eq + 1);
+			return 1;
+		}
+	}
+
+	auto wall_start = std::chrono::steady_clock::now();
+
+	if (cosim_init(&opts, argc, argv))
+		return 1;
+
+	ret = kshim_module_init();
+	if (ret || kshim_probe_status()) {
+		fprintf(stderr, "driver load failed (init %d, probe %d)\n", ret, kshim_probe_status());
+		cosim_finish();
+		return 1;
+	}
+
+	kshim_run_work();
+
+	if (tests) {
+		ret = kshim_ioctl(EDEV_IOCTL_RUN_TESTS, tests);
+		if (ret)
+			fprintf(stderr, "driver tests failed (%d)\n", ret);
+	}
+
+	if (!ret && run_bench) {
+		std::vector<struct edev_bench_result> results(32);
+
+		bench.num_results = results.size();
+		bench.results = (uintptr_t)results.data();
+
+		ret = kshim_ioctl(EDEV_IOCTL_BENCH, (unsigned long)&bench);
+		if (ret) {
+			fprintf(stderr, "benchmark failed (%d)\n", ret);
+		} else {
+			printf("\n%s, %s buffer, %s pattern, %u blocks x %u runs\n",
+					dir_names[bench.dir], buf_names[bench.buf],
+					pattern_names[bench.pattern], bench.count, bench.repeat);
+			printf("%8s %8s %10s %10s %10s %10s %10s %10s\n", "size", "stride",
+					"min ns", "median ns", "max Mbps", "med Mbps", "req TLPs", "lat ns");
+
+			for (unsigned int k = 0; k < bench.num_results; k++) {
+				const struct edev_bench_result *r = &results[k];
+
+				printf("%8u %8u %10llu %10llu %10llu %10llu %10llu %10llu\n",
+						r->size, r->stride,
+						(unsigned long long)r->min_ns, (unsigned long long)r->median_ns,
+						(unsigned long long)r->max_mbps, (unsigned long long)r->median_mbps,
+						(unsigned long long)r->req_count, (unsigned long long)r->lat_mean_ns);
+			}
+
+			if (min_mbps && bench.num_results &&
+					results[bench.num_results - 1].median_mbps < min_mbps) {
+				fprintf(stderr, "throughput %llu Mbps below limit of %llu Mbps\n",
+						(unsigned long long)results[bench.num_results - 1].median_mbps,
+						min_mbps);
+				ret = 1;
+			}
+		}
+	}
+
+	kshim_module_exit();
+
+	struct cosim_stats stats;
+	cosim_get_stats(&stats);
+	uint64_t sim_ns = cosim_time_ns();
+
+	cosim_finish();
+
+	double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+
+	printf("\nsimulated %llu.%06llu ms (%llu cycles) in %.1f s, %.0f cycles/s\n",
+			(unsigned long long)(sim_ns / 1000000), (unsigned long long)(sim_ns % 1000000),
+			(unsigned long long)stats.cycles, wall, wall > 0 ? stats.cycles / wall : 0.0);
+	printf("MMIO: %llu reads, %llu writes; IRQs: %llu\n",
+			(unsigned long long)stats.mmio_reads, (unsigned long long)stats.mmio_writes,
+			(unsigned long long)stats.irqs);
+	printf("DMA: %llu read requests (%llu bytes, %llu completions), "
+			"%llu write requests (%llu bytes)\n",
+			(unsigned long long)stats.dma_read_reqs, (unsigned long long)stats.dma_read_bytes,
+			(unsigned long long)stats.cpl_tlps, (unsigned long long)stats.dma_write_reqs,
+			(unsigned long long)stats.dma_write_bytes);
+
+	if (stats.dma_faults) {
+		fprintf(stderr, "%llu DMA faults\n", (unsigned long long)stats.dma_faults);
+		ret = 1;
+	}
+
+	return ret ? 1 : 0;
+}
@@ -0,0 +1,811 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "example_driver.h"
+#include "example_ioctl.h"
+#include <linux/delay.h>
+#include <linux/cpumask.h>
+#include <linux/dma-mapping.h>
+#include <linux/gfp.h>
+#include <linux/io.h>
+#include <linux/irqflags.h>
+#include <linux/kthread.h>
+#include <linux/ktime.h>
+#include <linux/log2.h>
+#include <linux/math64.h>
+#include <linux/nodemask.h>
+#include <linux/random.h>
+#include <linux/sched.h>
+#include <linux/sched/task.h>
+#include <linux/slab.h>
+#include <linux/sort.h>
+#include <linux/uaccess.h>
+#include <linux/vmalloc.h>
+
+#include <asm/tsc.h>
+
+u64 edev_cycles_to_ns(struct example_dev *edev, u64 cycles)
+{
+	return mul_u64_u32_div(cycles, USEC_PER_SEC, edev->clk_freq_khz);
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	u64 x = *(const u64 *)a;
+	u64 y = *(const u64 *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+// largest node-local or remote benchmark buffer (an order 10 allocation
+// with 4 KiB pages, which the page allocator provides on every kernel)
+#define EDEV_BENCH_PAGES_MAX_LEN (4UL << 20)
+
+struct edev_bench_pages {
+	struct page *page;
+	unsigned int order;
+	dma_addr_t dma_addr;
+};
+
+static int edev_bench_node(struct example_dev *edev, u32 buf)
+{
+	int local = dev_to_node(edev->dev);
+	int node;
+
+	if (local == NUMA_NO_NODE)
+		local = numa_node_id();
+
+	if (buf == EDEV_BENCH_BUF_LOCAL)
+		return local;
+
+	// first online node other than the one the device is attached to
+	for_each_online_node(node) {
+		if (node != local)
+			return node;
+	}
+
+	return NUMA_NO_NODE;
+}
+
+static int edev_bench_alloc_pages(struct example_dev *edev, struct edev_bench_pages *pg,
+		int node, u64 len)
+{
+	pg->order = get_order(len);
+	pg->page = alloc_pages_node(node, GFP_KERNEL | __GFP_THISNODE | __GFP_ZERO |
+			__GFP_NOWARN, pg->order);
+	if (!pg->page)
+		return -ENOMEM;
+
+	pg->dma_addr = dma_map_page(edev->dev, pg->page, 0, PAGE_SIZE << pg->order,
+			DMA_BIDIRECTIONAL);
+	if (dma_mapping_error(edev->dev, pg->dma_addr)) {
+		__free_pages(pg->page, pg->order);
+		pg->page = NULL;
+		return -ENOMEM;
+	}
+
+	return 0;
+}
+
+static void edev_bench_free_pages(struct example_dev *edev, struct edev_bench_pages *pg)
+{
+	if (!pg->page)
+		return;
+
+	dma_unmap_page(edev->dev, pg->dma_addr, PAGE_SIZE << pg->order, DMA_BIDIRECTIONAL);
+	__free_pages(pg->page, pg->order);
+	pg->page = NULL;
+}
+
+static int edev_bench_buf(struct example_dev *edev, struct example_user_buf *ubuf,
+		struct edev_ioctl_bench *req, struct edev_bench_pages *pg, dma_addr_t *dma_addr)
+{
+	struct scatterlist *sg;
+	u64 offset = req->offset;
+	int node;
+	int ret;
+	int k;
+
+	req->node = NUMA_NO_NODE;
+
+	switch (req->buf) {
+	case EDEV_BENCH_BUF_COHERENT:
+		if (offset > edev->dma_region_len || req->region_len > edev->dma_region_len - offset)
+			return -EINVAL;
+
+		// coherent region is allocated on the device node
+		req->node = dev_to_node(edev->dev);
+		*dma_addr = edev->dma_region_addr + offset;
+		return 0;
+	case EDEV_BENCH_BUF_USER:
+		if (!ubuf)
+			return -EINVAL;
+
+		// benchmark region must be contiguous in bus address space
+		for_each_sg(ubuf->sgt.sgl, sg, ubuf->nents, k) {
+			if (offset < sg_dma_len(sg)) {
+				if (req->region_len > sg_dma_len(sg) - offset)
+					return -EINVAL;
+
+				*dma_addr = sg_dma_address(sg) + offset;
+				return 0;
+			}
+
+			offset -= sg_dma_len(sg);
+		}
+
+		return -EINVAL;
+	case EDEV_BENCH_BUF_LOCAL:
+	case EDEV_BENCH_BUF_REMOTE:
+		if (offset > U64_MAX - req->region_len ||
+				offset + req->region_len > EDEV_BENCH_PAGES_MAX_LEN)
+			return -EINVAL;
+
+		node = edev_bench_node(edev, req->buf);
+		if (node == NUMA_NO_NODE)
+			return -ENODEV;
+
+		ret = edev_bench_alloc_pages(edev, pg, node, offset + req->region_len);
+		if (ret)
+			return ret;
+
+		req->node = page_to_nid(pg->page);
+		*dma_addr = pg->dma_addr + offset;
+		return 0;
+	}
+
+	return -EINVAL;
+}
+
+// host memory address list for EDEV_BENCH_PATTERN_LIST
+struct edev_bench_list {
+	__le64 *buf;
+	dma_addr_t dma_addr;
+	u32 log_size;
+};
+
+static int edev_bench_alloc_list(struct example_dev *edev, struct edev_bench_list *list,
+		u32 count)
+{
+	list->log_size = clamp_t(u32, order_base_2(count),
+			EDEV_BLOCK_LIST_MIN_LOG_SIZE, EDEV_BLOCK_LIST_MAX_LOG_SIZE);
+	list->buf = dma_alloc_coherent(edev->dev, sizeof(*list->buf) << list->log_size,
+			&list->dma_addr, GFP_KERNEL);
+	if (!list->buf)
+		return -ENOMEM;
+
+	return 0;
+}
+
+static void edev_bench_free_list(struct example_dev *edev, struct edev_bench_list *list)
+{
+	if (!list->buf)
+		return;
+
+	dma_free_coherent(edev->dev, sizeof(*list->buf) << list->log_size,
+			list->buf, list->dma_addr);
+	list->buf = NULL;
+}
+
+// set up the block engine address pattern for one run
+static void edev_bench_pattern(struct example_channel *ch, struct edev_ioctl_bench *req,
+		struct edev_bench_list *list, u32 stride)
+{
+	int write = req->dir == EDEV_DMA_FROM_CARD;
+	u32 k;
+
+	switch (req->pattern) {
+	case EDEV_BENCH_PATTERN_RANDOM:
+		dma_block_set_pattern(ch, write, EDEV_BLOCK_MODE_RANDOM,
+				get_random_u32() | 1, 0, 0);
+		break;
+	case EDEV_BENCH_PATTERN_LIST:
+		// same distribution as random mode, but with a fresh list each run
+		for (k = 0; k < (1 << list->log_size); k++)
+			list->buf[k] = cpu_to_le64(((u64)get_random_u32() * stride) & (req->region_len - 1));
+
+		dma_block_set_pattern(ch, write, EDEV_BLOCK_MODE_LIST, 0,
+				list->dma_addr, list->log_size);
+		break;
+	}
+}
+
+static int edev_bench_point(struct example_dev *edev, struct edev_ioctl_bench *req,
+		dma_addr_t dma_addr, struct edev_bench_list *list, u32 size, u64 *ns,
+		struct edev_bench_result *res)
+{
+	struct example_channel *ch = &edev->ch[0];
+	u32 stride = req->stride ? req->stride : size;
+	u32 req_start, cpl_start;
+	struct example_block_lat lat;
+	u64 lat_count = 0, lat_sum = 0;
+	u32 lat_min = U32_MAX, lat_max = 0;
+	u64 cycles;
+	int ret;
+	int k;
+
+	// random and list offsets are aligned to the stride
+	if (req->pattern != EDEV_BENCH_PATTERN_LINEAR && !is_power_of_2(stride))
+		return -EINVAL;
+
+	memset(res, 0, sizeof(*res));
+
+	res->size = size;
+	res->stride = stride;
+	res->count = req->count;
+	res->repeat = req->repeat;
+
+	for (k = 0; k < req->repeat; k++) {
+		edev_bench_pattern(ch, req, list, stride);
+
+		udelay(5);
+
+		if (req->dir == EDEV_DMA_TO_CARD) {
+			req_start = ioread32(ch->hw_addr + 0x000020);
+			cpl_start = ioread32(ch->hw_addr + 0x000024);
+
+			ret = dma_block_read(ch, dma_addr, 0, req->region_len - 1, stride,
+					0, 0, EDEV_CARD_RAM_SIZE - 1, stride, size, req->count);
+
+			cycles = dma_block_cycles(ch, 0);
+
+			udelay(5);
+
+			res->req_count += (u32)(ioread32(ch->hw_addr + 0x000020) - req_start);
+			res->cpl_count += (u32)(ioread32(ch->hw_addr + 0x000024) - cpl_start);
+		} else {
+			req_start = ioread32(ch->hw_addr + 0x000028);
+
+			ret = dma_block_write(ch, dma_addr, 0, req->region_len - 1, stride,
+					0, 0, EDEV_CARD_RAM_SIZE - 1, stride, size, req->count);
+
+			cycles = dma_block_cycles(ch, 1);
+
+			udelay(5);
+
+			res->req_count += (u32)(ioread32(ch->hw_addr + 0x000028) - req_start);
+		}
+
+		if (ret)
+			return ret;
+
+		ns[k] = max_t(u64, edev_cycles_to_ns(edev, cycles), 1);
+
+		dma_block_lat(ch, req->dir != EDEV_DMA_TO_CARD, &lat);
+		if (lat.count) {
+			lat_count += lat.count;
+			lat_sum += lat.sum;
+			lat_min = min(lat_min, lat.min);
+			lat_max = max(lat_max, lat.max);
+		}
+	}
+
+	if (lat_count) {
+		res->lat_min_ns = edev_cycles_to_ns(edev, lat_min);
+		res->lat_mean_ns = div64_u64(edev_cycles_to_ns(edev, lat_sum), lat_count);
+		res->lat_max_ns = edev_cycles_to_ns(edev, lat_max);
+	}
+
+	sort(ns, req->repeat, sizeof(u64), cmp_u64, NULL);
+
+	res->min_ns = ns[0];
+	res->median_ns = ns[req->repeat / 2];
+	res->p99_ns = ns[min_t(u32, (req->repeat * 99) / 100, req->repeat - 1)];
+	res->max_ns = ns[req->repeat - 1];
+
+	res->max_mbps = div64_u64((u64)size * req->count * 8 * 1000, res->min_ns);
+	res->median_mbps = div64_u64((u64)size * req->count * 8 * 1000, res->median_ns);
+	res->p99_mbps = div64_u64((u64)size * req->count * 8 * 1000, res->p99_ns);
+
+	return 0;
+}
+
+int edev_bench(struct example_dev *edev, struct example_user_buf *ubuf,
+		struct edev_ioctl_bench *req)
+{
+	struct edev_bench_result res;
+	struct edev_bench_result __user *results = u64_to_user_ptr(req->results);
+	struct edev_bench_pages pg = {0};
+	struct edev_bench_list list = {0};
+	dma_addr_t dma_addr;
+	u32 num_results = 0;
+	u64 *ns;
+	u64 size;
+	int ret;
+
+	if (req->dir != EDEV_DMA_TO_CARD && req->dir != EDEV_DMA_FROM_CARD)
+		return -EINVAL;
+
+	if (req->pattern > EDEV_BENCH_PATTERN_LIST)
+		return -EINVAL;
+
+	if (!req->repeat || req->repeat > EDEV_BENCH_MAX_REPEAT || !req->count)
+		return -EINVAL;
+
+	if (!req->size_min || req->size_min > req->size_max || req->size_max > EDEV_MAX_BLOCK_LEN)
+		return -EINVAL;
+
+	// offsets wrap within the region, so it must be a power of two
+	if (!req->region_len || !is_power_of_2(req->region_len) || req->region_len < req->size_max)
+		return -EINVAL;
+
+	ret = edev_bench_buf(edev, ubuf, req, &pg, &dma_addr);
+	if (ret)
+		return ret;
+
+	ns = kmalloc_array(req->repeat, sizeof(u64), GFP_KERNEL);
+	if (!ns) {
+		edev_bench_free_pages(edev, &pg);
+		return -ENOMEM;
+	}
+
+	if (req->pattern == EDEV_BENCH_PATTERN_LIST) {
+		ret = edev_bench_alloc_list(edev, &list, req->count);
+		if (ret) {
+			kfree(ns);
+			edev_bench_free_pages(edev, &pg);
+			return ret;
+		}
+	}
+
+	// sweep sizes in powers of two from size_min to size_max
+	for (size = req->size_min; size <= req->size_max && num_results < req->num_results; size *= 2) {
+		ret = edev_bench_point(edev, req, dma_addr, &list, size, ns, &res);
+		if (ret)
+			break;
+
+		if (copy_to_user(&results[num_results], &res, sizeof(res)) != 0) {
+			ret = -EFAULT;
+			break;
+		}
+
+		num_results++;
+	}
+
+	req->num_results = num_results;
+
+	// leave the engine in linear mode for everyone else
+	if (req->pattern != EDEV_BENCH_PATTERN_LINEAR)
+		dma_block_set_pattern(&edev->ch[0], req->dir == EDEV_DMA_FROM_CARD,
+				EDEV_BLOCK_MODE_LINEAR, 0, 0, 0);
+
+	edev_bench_free_list(edev, &list);
+	kfree(ns);
+	edev_bench_free_pages(edev, &pg);
+	return ret;
+}
+
+const u32 edev_mmio_lat_pctls[EDEV_MMIO_LAT_PCTLS] = {5000, 9000, 9900, 9990, 9999};
+
+static int edev_mmio_lat_bucket(u64 ns)
+{
+	int msb;
+	int idx;
+
+	if (ns < 4)
+		return ns;
+
+	msb = fls64(ns) - 1;
+	idx = 4 + (msb - 2) * 4 + ((ns >> (msb - 2)) & 3);
+
+	return min(idx, EDEV_MMIO_LAT_BUCKETS - 1);
+}
+
+// lower bound of histogram bucket
+u64 edev_mmio_lat_bucket_ns(int idx)
+{
+	if (idx < 4)
+		return idx;
+
+	return (u64)(4 + (idx - 4) % 4) << ((idx - 4) / 4);
+}
+
+static u32 edev_calibrate_tsc(void)
+{
+	u64 ns, tsc;
+
+	// measure TSC rate against the monotonic clock
+	ns = ktime_get_ns();
+	tsc = rdtsc_ordered();
+	msleep(20);
+	tsc = rdtsc_ordered() - tsc;
+	ns = ktime_get_ns() - ns;
+
+	return div64_u64(tsc * 1000000, ns);
+}
+
+static u64 edev_tsc_overhead(void)
+{
+	unsigned long flags;
+	u64 min_t = U64_MAX;
+	u64 t;
+	int k;
+
+	// cost of the timestamp pair around each access
+	for (k = 0; k < 1000; k++) {
+		local_irq_save(flags);
+		t = rdtsc_ordered();
+		t = rdtsc_ordered() - t;
+		local_irq_restore(flags);
+
+		min_t = min(min_t, t);
+	}
+
+	return min_t;
+}
+
+int edev_mmio_lat_run(struct example_dev *edev, const struct edev_mmio_lat_params *params,
+		struct edev_mmio_lat *lat)
+{
+	void __iomem *addr;
+	unsigned long flags;
+	u64 *samples;
+	u64 sum = 0;
+	u64 t;
+	u32 n = params->samples;
+	int k, j;
+
+	if (params->mode > EDEV_MMIO_LAT_WRITE_FLUSH)
+		return -EINVAL;
+
+	if (params->bar >= 6 || !edev->bar[params->bar])
+		return -EINVAL;
+
+	if (params->offset & 3 || params->offset > edev->bar_map_len[params->bar] - 4)
+		return -EINVAL;
+
+	if (!n || n > EDEV_MMIO_LAT_MAX_SAMPLES)
+		return -EINVAL;
+
+	samples = vmalloc(array_size(n, sizeof(u64)));
+	if (!samples)
+		return -ENOMEM;
+
+	memset(lat, 0, sizeof(*lat));
+	lat->params = *params;
+
+	lat->tsc_khz = edev_calibrate_tsc();
+	lat->tsc_overhead = edev_tsc_overhead();
+
+	if (abs((long)lat->tsc_khz - (long)tsc_khz) > tsc_khz / 100)
+		dev_warn(edev->dev, "Calibrated TSC %u kHz differs from kernel TSC %u kHz",
+				lat->tsc_khz, tsc_khz);
+
+	addr = edev->bar[params->bar] + params->offset;
+
+	for (k = 0; k < n; k++) {
+		// keep interrupts out of the measured window
+		local_irq_save(flags);
+		t = rdtsc_ordered();
+
+		switch (params->mode) {
+		case EDEV_MMIO_LAT_READ:
+			ioread32(addr);
+			break;
+		case EDEV_MMIO_LAT_WRITE:
+			iowrite32(k, addr);
+			break;
+		case EDEV_MMIO_LAT_WRITE_FLUSH:
+			iowrite32(k, addr);
+			ioread32(addr);
+			break;
+		}
+
+		t = rdtsc_ordered() - t;
+		local_irq_restore(flags);
+
+		t = t > lat->tsc_overhead ? t - lat->tsc_overhead : 0;
+		samples[k] = div64_u64(t * 1000000, lat->tsc_khz);
+
+		if ((k & 1023) == 1023)
+			cond_resched();
+	}
+
+	for (k = 0; k < n; k++) {
+		sum += samples[k];
+		lat->hist[edev_mmio_lat_bucket(samples[k])]++;
+
+		// largest samples, kept in descending order
+		for (j = min_t(int, k, EDEV_MMIO_LAT_TOP); j > 0 && samples[k] > lat->top[j - 1].ns; j--) {
+			if (j < EDEV_MMIO_LAT_TOP)
+				lat->top[j] = lat->top[j - 1];
+		}
+		if (j < EDEV_MMIO_LAT_TOP) {
+			lat->top[j].index = k;
+			lat->top[j].ns = samples[k];
+		}
+	}
+
+	sort(samples, n, sizeof(u64), cmp_u64, NULL);
+
+	lat->min_ns = samples[0];
+	lat->mean_ns = div_u64(sum, n);
+	lat->max_ns = samples[n - 1];
+
+	for (k = 0; k < EDEV_MMIO_LAT_PCTLS; k++)
+		lat->pctl_ns[k] = samples[min_t(u64, div_u64((u64)n * edev_mmio_lat_pctls[k], 10000), n - 1)];
+
+	lat->outlier_threshold_ns = max_t(u64, lat->pctl_ns[0] * EDEV_MMIO_LAT_OUTLIER_FACTOR, 1);
+	for (k = n; k > 0 && samples[k - 1] > lat->outlier_threshold_ns; k--)
+		lat->outlier_count++;
+
+	lat->top_count = min_t(u32, n, EDEV_MMIO_LAT_TOP);
+	lat->valid = true;
+
+	vfree(samples);
+	return 0;
+}
+
+// concurrent MMIO benchmark, one bound kthread per selected CPU
+
+struct edev_mmio_mt_run;
+
+struct edev_mmio_mt_worker {
+	struct edev_mmio_mt_run *run;
+	struct task_struct *task;
+	void __iomem *addr;
+	u32 mode;
+	u32 cpu;
+
+	u64 start_ns;
+	u64 end_ns;
+	u64 sum_ns;
+	u64 min_ns;
+	u64 max_ns;
+	u32 hist[EDEV_MMIO_LAT_BUCKETS];
+};
+
+struct edev_mmio_mt_run {
+	u32 ops;
+	u32 tsc_khz;
+	u64 tsc_overhead;
+
+	atomic_t ready;
+	bool go;
+
+	struct edev_mmio_mt_worker worker[];
+};
+
+static int edev_mmio_mt_thread(void *data)
+{
+	struct edev_mmio_mt_worker *w = data;
+	struct edev_mmio_mt_run *run = w->run;
+	unsigned long flags;
+	u64 t, ns;
+	u32 k;
+
+	// start together, so every thread measures under full contention; a
+	// run that is abandoned stops the thread before releasing it
+	atomic_inc(&run->ready);
+	while (!smp_load_acquire(&run->go) && !kthread_should_stop())
+		cpu_relax();
+
+	if (!smp_load_acquire(&run->go))
+		return 0;
+
+	w->min_ns = U64_MAX;
+	w->start_ns = ktime_get_ns();
+
+	for (k = 0; k < run->ops; k++) {
+		local_irq_save(flags);
+		t = rdtsc_ordered();
+
+		if (w->mode == EDEV_MMIO_MT_READ)
+			ioread32(w->addr);
+		else
+			iowrite32(k, w->addr);
+
+		t = rdtsc_ordered() - t;
+		local_irq_restore(flags);
+
+		t = t > run->tsc_overhead ? t - run->tsc_overhead : 0;
+		ns = div64_u64(t * 1000000, run->tsc_khz);
+
+		w->sum_ns += ns;
+		w->min_ns = min(w->min_ns, ns);
+		w->max_ns = max(w->max_ns, ns);
+		w->hist[edev_mmio_lat_bucket(ns)]++;
+
+		if ((k & 1023) == 1023)
+			cond_resched();
+	}
+
+	w->end_ns = ktime_get_ns();
+
+	return 0;
+}
+
+// lower bound of the bucket holding the given percentile (in units of 0.01%)
+static u64 edev_mmio_mt_pctl(const u32 *hist, u64 n, u32 pctl)
+{
+	u64 target = div_u64(n * pctl, 10000);
+	u64 sum = 0;
+	int k;
+
+	for (k = 0; k < EDEV_MMIO_LAT_BUCKETS - 1; k++) {
+		sum += hist[k];
+		if (sum > target)
+			break;
+	}
+
+	return edev_mmio_lat_bucket_ns(k);
+}
+
+static void edev_mmio_mt_stats(struct edev_mmio_mt_stats *stats, const u32 *hist,
+		u64 ops, u64 ns, u64 sum_ns, u64 min_ns, u64 max_ns)
+{
+	stats->ops = ops;
+	stats->ns = max_t(u64, ns, 1);
+	stats->ops_per_sec = div64_u64(ops * NSEC_PER_SEC, stats->ns);
+
+	stats->min_ns = min_ns;
+	stats->mean_ns = div64_u64(sum_ns, max_t(u64, ops, 1));
+	stats->p50_ns = edev_mmio_mt_pctl(hist, ops, 5000);
+	stats->p99_ns = edev_mmio_mt_pctl(hist, ops, 9900);
+	stats->max_ns = max_ns;
+}
+
+int edev_mmio_mt_run(struct example_dev *edev, const struct edev_mmio_mt_params *params,
+		struct edev_mmio_mt *mt)
+{
+	struct edev_mmio_mt_run *run;
+	struct edev_mmio_mt_worker *w;
+	cpumask_var_t cpus;
+	u32 hist[EDEV_MMIO_LAT_BUCKETS] = {0};
+	u64 start_ns = U64_MAX, end_ns = 0;
+	u64 sum_ns = 0, min_ns = U64_MAX, max_ns = 0;
+	u64 timeout;
+	int n, cpu;
+	int ret;
+	int k, j;
+
+	if (params->mode > EDEV_MMIO_MT_MIXED)
+		return -EINVAL;
+
+	if (params->bar >= 6 || !edev->bar[params->bar])
+		return -EINVAL;
+
+	if (!params->ops || params->ops > EDEV_MMIO_MT_MAX_OPS)
+		return -EINVAL;
+
+	if (!zalloc_cpumask_var(&cpus, GFP_KERNEL))
+		return -ENOMEM;
+
+	ret = cpulist_parse(params->cpus, cpus);
+	if (ret)
+		goto out_free_mask;
+
+	cpumask_and(cpus, cpus, cpu_online_mask);
+	n = cpumask_weight(cpus);
+	if (!n || n > EDEV_MMIO_MT_MAX_THREADS) {
+		ret = -EINVAL;
+		goto out_free_mask;
+	}
+
+	// doorbell threads each write their own line
+	if (params->offset & 3 || params->offset > edev->bar_map_len[params->bar] - 4 ||
+			(params->mode >= EDEV_MMIO_MT_DOORBELL &&
+			params->offset + (n - 1) * 64 > edev->bar_map_len[params->bar] - 4)) {
+		ret = -EINVAL;
+		goto out_free_mask;
+	}
+
+	run = kvzalloc(struct_size(run, worker, n), GFP_KERNEL);
+	if (!run) {
+		ret = -ENOMEM;
+		goto out_free_mask;
+	}
+
+	run->ops = params->ops;
+	run->tsc_khz = edev_calibrate_tsc();
+	run->tsc_overhead = edev_tsc_overhead();
+	atomic_set(&run->ready, 0);
+
+	k = 0;
+	for_each_cpu(cpu, cpus) {
+		w = &run->worker[k];
+		w->run = run;
+		w->cpu = cpu;
+		w->mode = params->mode == EDEV_MMIO_MT_MIXED ? k % EDEV_MMIO_MT_MIXED : params->mode;
+		w->addr = edev->bar[params->bar] + params->offset;
+		if (w->mode == EDEV_MMIO_MT_DOORBELL)
+			w->addr += k * 64;
+
+		w->task = kthread_create_on_node(edev_mmio_mt_thread, w, cpu_to_node(cpu),
+				"edev_mmio/%d", cpu);
+		if (IS_ERR(w->task)) {
+			ret = PTR_ERR(w->task);
+			// threads not yet woken exit without running
+			for (j = 0; j < k; j++) {
+				kthread_stop(run->worker[j].task);
+				put_task_struct(run->worker[j].task);
+			}
+			goto out_free_run;
+		}
+
+		// hold the task, it may exit before kthread_stop
+		get_task_struct(w->task);
+		kthread_bind(w->task, cpu);
+		k++;
+	}
+
+	for (k = 0; k < n; k++)
+		wake_up_process(run->worker[k].task);
+
+	// release the threads once all are spinning; a CPU busy with other work
+	// only delays its own thread
+	timeout = ktime_get_ns() + NSEC_PER_SEC;
+	while (atomic_read(&run->ready) < n && ktime_get_ns() < timeout)
+		usleep_range(100, 200);
+
+	// a partial run would report operations that were never performed, so
+	// abandon it; stopped threads return without touching the BAR
+	if (atomic_read(&run->ready) < n) {
+		dev_warn(edev->dev, "MMIO benchmark: only %d of %d threads started in time",
+				atomic_read(&run->ready), n);
+		ret = -EBUSY;
+	} else {
+		smp_store_release(&run->go, true);
+	}
+
+	for (k = 0; k < n; k++) {
+		kthread_stop(run->worker[k].task);
+		put_task_struct(run->worker[k].task);
+	}
+
+	if (ret)
+		goto out_free_run;
+
+	memset(mt, 0, sizeof(*mt));
+	mt->params = *params;
+	mt->tsc_khz = run->tsc_khz;
+	mt->tsc_overhead = run->tsc_overhead;
+	mt->num_threads = n;
+
+	for (k = 0; k < n; k++) {
+		w = &run->worker[k];
+
+		mt->thread[k].cpu = w->cpu;
+		mt->thread[k].mode = w->mode;
+		edev_mmio_mt_stats(&mt->thread[k].stats, w->hist, run->ops,
+				w->end_ns - w->start_ns, w->sum_ns, w->min_ns, w->max_ns);
+
+		start_ns = min(start_ns, w->start_ns);
+		end_ns = max(end_ns, w->end_ns);
+		sum_ns += w->sum_ns;
+		min_ns = min(min_ns, w->min_ns);
+		max_ns = max(max_ns, w->max_ns);
+		for (j = 0; j < EDEV_MMIO_LAT_BUCKETS; j++)
+			hist[j] += w->hist[j];
+	}
+
+	edev_mmio_mt_stats(&mt->total, hist, (u64)run->ops * n, end_ns - start_ns,
+			sum_ns, min_ns, max_ns);
+	mt->valid = true;
+
+out_free_run:
+	kvfree(run);
+out_free_mask:
+	free_cpumask_var(cpus);
+	return ret;
+}
@@ -0,0 +1,182 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "example_driver.h"
+#include <linux/delay.h>
+#include <linux/device.h>
+#include <linux/dma-mapping.h>
+#include <linux/io.h>
+#include <linux/jiffies.h>
+#include <linux/log2.h>
+#include <linux/timekeeping.h>
+
+// Completion records are posted writes that follow the data of the
+// operation they describe, so once a record is visible the data is too.
+// Reading them from host memory replaces the MMIO reads of the status and
+// completion pointer registers, each of which is a full PCIe round trip.
+
+int edev_create_cq(struct example_dev *edev, struct example_cq *cq, int size,
+		void __iomem *hw_addr, struct example_ring *read_ring,
+		struct example_ring *write_ring)
+{
+	if (size < 2 || size > (1 << EDEV_RING_MAX_LOG_SIZE))
+		return -EINVAL;
+
+	if (!(ioread32(hw_addr + EDEV_CQ_REG_CTRL) & EDEV_CQ_CTRL_SUPPORTED))
+		return -EOPNOTSUPP;
+
+	cq->log_size = ilog2(roundup_pow_of_two(size));
+	cq->size = 1 << cq->log_size;
+	cq->size_mask = cq->size - 1;
+	cq->cons_ptr = 0;
+	cq->overflow = false;
+	cq->last_valid[0] = false;
+	cq->last_valid[1] = false;
+
+	cq->hw_addr = hw_addr;
+
+	cq->buf_size = cq->size * sizeof(*cq->buf);
+	cq->buf = dma_alloc_coherent(edev->dev, cq->buf_size,
+			&cq->buf_dma_addr, GFP_KERNEL | __GFP_ZERO);
+	if (!cq->buf)
+		return -ENOMEM;
+
+	// disable queue while it is reconfigured
+	iowrite32(0, cq->hw_addr + EDEV_CQ_REG_CTRL);
+	// base address
+	iowrite32(cq->buf_dma_addr & 0xffffffff, cq->hw_addr + EDEV_CQ_REG_BASE_ADDR);
+	iowrite32((cq->buf_dma_addr >> 32) & 0xffffffff, cq->hw_addr + EDEV_CQ_REG_BASE_ADDR + 4);
+	// size
+	iowrite32(cq->log_size, cq->hw_addr + EDEV_CQ_REG_LOG_SIZE);
+	// pointers
+	iowrite32(0, cq->hw_addr + EDEV_CQ_REG_PROD_PTR);
+	iowrite32(0, cq->hw_addr + EDEV_CQ_REG_CONS_PTR);
+	// enable
+	iowrite32(EDEV_CQ_CTRL_ENABLE, cq->hw_addr + EDEV_CQ_REG_CTRL);
+
+	// the card must not have operations outstanding on these rings
+	cq->read_ring = read_ring;
+	cq->write_ring = write_ring;
+	read_ring->cq = cq;
+	read_ring->cpl_ptr = read_ring->prod_ptr;
+	write_ring->cq = cq;
+	write_ring->cpl_ptr = write_ring->prod_ptr;
+
+	dev_info(edev->dev, "Created completion queue at 0x%p, %d entries (card FIFO %d)",
+			(void *)cq->buf_dma_addr, cq->size,
+			ioread32(cq->hw_addr + EDEV_CQ_REG_FIFO_SIZE));
+
+	return 0;
+}
+
+void edev_destroy_cq(struct example_dev *edev, struct example_cq *cq)
+{
+	if (!cq->buf)
+		return;
+
+	iowrite32(0, cq->hw_addr + EDEV_CQ_REG_CTRL);
+
+	cq->read_ring->cq = NULL;
+	cq->write_ring->cq = NULL;
+
+	dma_free_coherent(edev->dev, cq->buf_size, cq->buf, cq->buf_dma_addr);
+	cq->buf = NULL;
+	cq->buf_dma_addr = 0;
+}
+
+static void edev_cq_ring_cpl(struct example_ring *ring, u32 rec)
+{
+	// ignore records for operations already counted from the card pointer
+	if (ring->cpl_ptr != ring->prod_ptr)
+		ring->cpl_ptr = (ring->cpl_ptr + 1) & EDEV_RING_PTR_MASK;
+
+	if (rec & EDEV_CQ_REC_ERROR_MASK)
+		ring->cq_error = true;
+}
+
+// consume new records, returns the number of records consumed
+int edev_cq_poll(struct example_cq *cq)
+{
+	int count = 0;
+
+	for (;;) {
+		u32 phase = ((cq->cons_ptr >> cq->log_size) & 1) ? 0 : EDEV_CQ_REC_PHASE;
+		u32 rec = le32_to_cpu(READ_ONCE(cq->buf[cq->cons_ptr & cq->size_mask]));
+		int write = !!(rec & EDEV_CQ_REC_WRITE);
+
+		if ((rec & EDEV_CQ_REC_PHASE) != phase)
+			break;
+
+		if (rec & EDEV_CQ_REC_RING) {
+			edev_cq_ring_cpl(write ? cq->write_ring : cq->read_ring, rec);
+		} else {
+			cq->last_rec[write] = rec;
+			cq->last_valid[write] = true;
+		}
+
+		cq->cons_ptr = (cq->cons_ptr + 1) & EDEV_RING_PTR_MASK;
+		count++;
+	}
+
+	// return the slots to the card
+	if (count)
+		iowrite32(cq->cons_ptr, cq->hw_addr + EDEV_CQ_REG_CONS_PTR);
+
+	return count;
+}
+
+// poll for up to timeout_us, returns true if any records were consumed
+bool edev_cq_spin(struct example_cq *cq, unsigned int timeout_us)
+{
+	u64 t = ktime_get_ns() + timeout_us * NSEC_PER_USEC;
+
+	do {
+		if (edev_cq_poll(cq))
+			return true;
+		cpu_relax();
+	} while (ktime_get_ns() < t);
+
+	return false;
+}
+
+// wait for the record of a single (register) operation
+int edev_cq_wait_single(struct example_cq *cq, int write, u8 tag, u32 *rec,
+		unsigned int timeout_ms)
+{
+	unsigned long t = jiffies + msecs_to_jiffies(timeout_ms);
+
+	for (;;) {
+		edev_cq_poll(cq);
+
+		if (cq->last_valid[write] && (cq->last_rec[write] & EDEV_CQ_REC_TAG_MASK) == tag) {
+			cq->last_valid[write] = false;
+			*rec = cq->last_rec[write];
+			return 0;
+		}
+
+		if (!time_before(jiffies, t))
+			return -ETIMEDOUT;
+
+		usleep_range(10, 20);
+	}
+}
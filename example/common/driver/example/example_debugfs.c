@@ -0,0 +1,478 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "example_driver.h"
+#include <linux/debugfs.h>
+#include <linux/fs.h>
+#include <linux/pci.h>
+#include <linux/seq_file.h>
+#include <linux/string.h>
+#include <linux/uaccess.h>
+
+#include <asm/tsc.h>
+
+static struct dentry *edev_debugfs_root;
+
+static const char *const edev_mmio_lat_mode_str[] = {
+	[EDEV_MMIO_LAT_READ] = "read",
+	[EDEV_MMIO_LAT_WRITE] = "write",
+	[EDEV_MMIO_LAT_WRITE_FLUSH] = "write_flush",
+};
+
+static int edev_mmio_lat_show(struct seq_file *s, void *data)
+{
+	struct example_dev *edev = s->private;
+	struct edev_mmio_lat *lat = &edev->mmio_lat;
+	int k;
+
+	mutex_lock(&edev->dma_lock);
+
+	if (!lat->valid) {
+		seq_puts(s, "no results, write to this file to run\n");
+		goto out;
+	}
+
+	seq_printf(s, "mode: %s\n", edev_mmio_lat_mode_str[lat->params.mode]);
+	seq_printf(s, "addr: BAR%u + 0x%x\n", lat->params.bar, lat->params.offset);
+	seq_printf(s, "samples: %u\n", lat->params.samples);
+	seq_printf(s, "tsc_khz: %u (kernel %u)\n", lat->tsc_khz, tsc_khz);
+	seq_printf(s, "tsc_overhead: %llu cycles\n", lat->tsc_overhead);
+
+	seq_printf(s, "min: %llu ns\n", lat->min_ns);
+	seq_printf(s, "mean: %llu ns\n", lat->mean_ns);
+	for (k = 0; k < EDEV_MMIO_LAT_PCTLS; k++)
+		seq_printf(s, "p%u.%02u: %llu ns\n", edev_mmio_lat_pctls[k] / 100,
+				edev_mmio_lat_pctls[k] % 100, lat->pctl_ns[k]);
+	seq_printf(s, "max: %llu ns\n", lat->max_ns);
+
+	seq_printf(s, "outliers: %u (> %llu ns)\n", lat->outlier_count, lat->outlier_threshold_ns);
+	for (k = 0; k < lat->top_count; k++)
+		seq_printf(s, "  sample %u: %llu ns\n", lat->top[k].index, lat->top[k].ns);
+
+	seq_puts(s, "histogram:\n");
+	for (k = 0; k < EDEV_MMIO_LAT_BUCKETS; k++) {
+		if (!lat->hist[k])
+			continue;
+
+		if (k == EDEV_MMIO_LAT_BUCKETS - 1)
+			seq_printf(s, "  %8llu+     ns: %u\n", edev_mmio_lat_bucket_ns(k), lat->hist[k]);
+		else
+			seq_printf(s, "  %8llu-%-8llu ns: %u\n", edev_mmio_lat_bucket_ns(k),
+					edev_mmio_lat_bucket_ns(k + 1) - 1, lat->hist[k]);
+	}
+
+out:
+	mutex_unlock(&edev->dma_lock);
+	return 0;
+}
+
+static int edev_mmio_lat_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, edev_mmio_lat_show, inode->i_private);
+}
+
+static ssize_t edev_mmio_lat_write(struct file *file, const char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	struct example_dev *edev = ((struct seq_file *)file->private_data)->private;
+	int ret;
+
+	// any write starts a new measurement with the current parameters
+	mutex_lock(&edev->dma_lock);
+	ret = edev_mmio_lat_run(edev, &edev->mmio_lat_params, &edev->mmio_lat);
+	mutex_unlock(&edev->dma_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations edev_mmio_lat_fops = {
+	.owner = THIS_MODULE,
+	.open = edev_mmio_lat_open,
+	.read = seq_read,
+	.write = edev_mmio_lat_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static const char *const edev_mmio_mt_mode_str[] = {
+	[EDEV_MMIO_MT_READ] = "read",
+	[EDEV_MMIO_MT_WRITE] = "write",
+	[EDEV_MMIO_MT_DOORBELL] = "doorbell",
+	[EDEV_MMIO_MT_MIXED] = "mixed",
+};
+
+static void edev_mmio_mt_show_stats(struct seq_file *s, const char *name, u32 mode,
+		const struct edev_mmio_mt_stats *stats)
+{
+	seq_printf(s, "%-6s %-8s %12llu %8llu %8llu %8llu %8llu %8llu\n", name,
+			edev_mmio_mt_mode_str[mode], stats->ops_per_sec, stats->min_ns,
+			stats->mean_ns, stats->p50_ns, stats->p99_ns, stats->max_ns);
+}
+
+static int edev_mmio_mt_show(struct seq_file *s, void *data)
+{
+	struct example_dev *edev = s->private;
+	struct edev_mmio_mt *mt = &edev->mmio_mt;
+	char name[8];
+	int k;
+
+	mutex_lock(&edev->dma_lock);
+
+	if (!mt->valid) {
+		seq_puts(s, "no results, write a CPU list (e.g. 0-3,8) to this file to run\n");
+		goto out;
+	}
+
+	seq_printf(s, "mode: %s\n", edev_mmio_mt_mode_str[mt->params.mode]);
+	seq_printf(s, "addr: BAR%u + 0x%x\n", mt->params.bar, mt->params.offset);
+	seq_printf(s, "ops: %u per thread\n", mt->params.ops);
+	seq_printf(s, "cpus: %s (%u threads)\n", mt->params.cpus, mt->num_threads);
+	seq_printf(s, "tsc_khz: %u (kernel %u)\n", mt->tsc_khz, tsc_khz);
+	seq_printf(s, "tsc_overhead: %llu cycles\n", mt->tsc_overhead);
+	seq_printf(s, "elapsed: %llu ns\n", mt->total.ns);
+
+	// p50/p99 are histogram bucket lower bounds
+	seq_printf(s, "%-6s %-8s %12s %8s %8s %8s %8s %8s\n", "cpu", "mode", "ops/s",
+			"min ns", "mean ns", "p50 ns", "p99 ns", "max ns");
+	for (k = 0; k < mt->num_threads; k++) {
+		snprintf(name, sizeof(name), "%u", mt->thread[k].cpu);
+		edev_mmio_mt_show_stats(s, name, mt->thread[k].mode, &mt->thread[k].stats);
+	}
+	edev_mmio_mt_show_stats(s, "total", mt->params.mode, &mt->total);
+
+out:
+	mutex_unlock(&edev->dma_lock);
+	return 0;
+}
+
+static int edev_mmio_mt_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, edev_mmio_mt_show, inode->i_private);
+}
+
+static ssize_t edev_mmio_mt_write(struct file *file, const char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	struct example_dev *edev = ((struct seq_file *)file->private_data)->private;
+	struct edev_mmio_mt_params *params = &edev->mmio_mt_params;
+	char str[EDEV_MMIO_MT_CPUS_LEN];
+	int ret;
+
+	if (count >= sizeof(str))
+		return -EINVAL;
+
+	if (copy_from_user(str, buf, count))
+		return -EFAULT;
+
+	str[count] = 0;
+	strim(str);
+
+	// the CPU list selects one thread per CPU and starts a run
+	mutex_lock(&edev->dma_lock);
+	strscpy(params->cpus, str, sizeof(params->cpus));
+	ret = edev_mmio_mt_run(edev, params, &edev->mmio_mt);
+	mutex_unlock(&edev->dma_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations edev_mmio_mt_fops = {
+	.owner = THIS_MODULE,
+	.open = edev_mmio_mt_open,
+	.read = seq_read,
+	.write = edev_mmio_mt_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int edev_cpl_fc_limits_show(struct seq_file *s, void *data)
+{
+	struct example_dev *edev = s->private;
+	void __iomem *hw_addr = edev->ch[0].hw_addr;
+
+	mutex_lock(&edev->dma_lock);
+
+	// 0 selects the compile-time limit, 0 there means no limit
+	seq_printf(s, "cplh: %u (compile-time %u)\n", edev->cplh_fc_limit,
+			ioread32(hw_addr + EDEV_REG_CPLH_FC_LIMIT_MAX));
+	seq_printf(s, "cpld: %u (compile-time %u)\n", edev->cpld_fc_limit,
+			ioread32(hw_addr + EDEV_REG_CPLD_FC_LIMIT_MAX));
+	seq_printf(s, "source: %s\n", edev->cpl_budget_valid ? "search" : "manual");
+
+	mutex_unlock(&edev->dma_lock);
+	return 0;
+}
+
+static int edev_cpl_fc_limits_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, edev_cpl_fc_limits_show, inode->i_private);
+}
+
+static ssize_t edev_cpl_fc_limits_write(struct file *file, const char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	struct example_dev *edev = ((struct seq_file *)file->private_data)->private;
+	char str[32];
+	u32 cplh, cpld;
+	int ret = 0;
+
+	if (count >= sizeof(str))
+		return -EINVAL;
+	if (copy_from_user(str, buf, count))
+		return -EFAULT;
+	str[count] = 0;
+
+	// "auto" runs the search, "<cplh> <cpld>" sets the limits directly
+	mutex_lock(&edev->dma_lock);
+	if (sysfs_streq(str, "auto")) {
+		mutex_lock(&edev->ch[0].lock);
+		ret = edev_stream_check_idle(&edev->stream, &edev->ch[0]);
+		if (!ret)
+			ret = edev_cpl_budget_search(edev);
+		mutex_unlock(&edev->ch[0].lock);
+	} else if (sscanf(str, "%u %u", &cplh, &cpld) == 2) {
+		edev_set_cpl_fc_limits(edev, cplh, cpld);
+		edev->cpl_budget_valid = false;
+	} else {
+		ret = -EINVAL;
+	}
+	mutex_unlock(&edev->dma_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations edev_cpl_fc_limits_fops = {
+	.owner = THIS_MODULE,
+	.open = edev_cpl_fc_limits_open,
+	.read = seq_read,
+	.write = edev_cpl_fc_limits_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int edev_irq_mod_show(struct seq_file *s, void *data)
+{
+	struct example_dev *edev = s->private;
+	int k;
+
+	mutex_lock(&edev->irq_mod_lock);
+
+	seq_printf(s, "mode: %s\n", edev->irq_mod_adaptive ? "adaptive" : "fixed");
+	seq_printf(s, "min_interval: %u us\n", edev->irq_min_interval_us);
+
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
+		int dir;
+
+		for (dir = 0; dir < 2; dir++) {
+			seq_printf(s, "ch%d %s: count %u time %u us, events %u irqs %u\n",
+					k, dir ? "write" : "read",
+					ch->irq_mod[dir].count, ch->irq_mod[dir].time_us,
+					ioread32(ch->hw_addr + EDEV_REG_IRQ_EVENT_COUNT + dir * 8),
+					ioread32(ch->hw_addr + EDEV_REG_IRQ_COUNT + dir * 8));
+		}
+	}
+
+	mutex_unlock(&edev->irq_mod_lock);
+	return 0;
+}
+
+static int edev_irq_mod_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, edev_irq_mod_show, inode->i_private);
+}
+
+static ssize_t edev_irq_mod_write(struct file *file, const char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	struct example_dev *edev = ((struct seq_file *)file->private_data)->private;
+	char str[32];
+	u32 mod_count, time_us;
+	int ret = 0;
+	int k;
+
+	if (count >= sizeof(str))
+		return -EINVAL;
+	if (copy_from_user(str, buf, count))
+		return -EFAULT;
+	str[count] = 0;
+
+	// "adaptive", "<count> <time_us>" for all vectors, or "min_interval <us>"
+	mutex_lock(&edev->irq_mod_lock);
+	if (sysfs_streq(str, "adaptive")) {
+		edev_set_irq_mod_adaptive(edev, true);
+	} else if (sscanf(str, "min_interval %u", &time_us) == 1) {
+		edev_set_irq_min_interval(edev, time_us);
+	} else if (sscanf(str, "%u %u", &mod_count, &time_us) == 2) {
+		edev_set_irq_mod_adaptive(edev, false);
+		for (k = 0; k < edev->num_channels; k++) {
+			edev_set_irq_mod(&edev->ch[k], 0, mod_count, time_us);
+			edev_set_irq_mod(&edev->ch[k], 1, mod_count, time_us);
+		}
+	} else {
+		ret = -EINVAL;
+	}
+	mutex_unlock(&edev->irq_mod_lock);
+
+	return ret ? ret : count;
+}
+
+static const struct file_operations edev_irq_mod_fops = {
+	.owner = THIS_MODULE,
+	.open = edev_irq_mod_open,
+	.read = seq_read,
+	.write = edev_irq_mod_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+static int edev_cpl_policy_show(struct seq_file *s, void *data)
+{
+	struct example_dev *edev = s->private;
+	int k;
+
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
+		int dir;
+
+		mutex_lock(&ch->lock);
+		seq_printf(s, "ch%d mode: %s\n", k, edev_cpl_mode_str[ch->cpl_mode]);
+		for (dir = 0; dir < 2; dir++) {
+			struct example_cpl_stats *stats = &ch->cpl_stats[dir];
+			u64 polled = stats->poll + stats->irq;
+
+			seq_printf(s, "ch%d %s: poll %llu irq %llu irq_only %llu, mean poll %llu ns\n",
+					k, dir ? "write" : "read",
+					stats->poll, stats->irq, stats->irq_only,
+					polled ? div64_u64(stats->poll_ns, polled) : 0);
+		}
+		mutex_unlock(&ch->lock);
+	}
+
+	return 0;
+}
+
+static int edev_cpl_policy_open(struct inode *inode, struct file *file)
+{
+	return single_open(file, edev_cpl_policy_show, inode->i_private);
+}
+
+static ssize_t edev_cpl_policy_write(struct file *file, const char __user *buf,
+		size_t count, loff_t *ppos)
+{
+	struct example_dev *edev = ((struct seq_file *)file->private_data)->private;
+	char str[16];
+	int mode;
+	int k;
+
+	if (count >= sizeof(str))
+		return -EINVAL;
+	if (copy_from_user(str, buf, count))
+		return -EFAULT;
+	str[count] = 0;
+
+	// "irq", "poll" or "hybrid" for all channels, or "reset" to clear the statistics
+	if (sysfs_streq(str, "reset")) {
+		for (k = 0; k < edev->num_channels; k++) {
+			mutex_lock(&edev->ch[k].lock);
+			memset(edev->ch[k].cpl_stats, 0, sizeof(edev->ch[k].cpl_stats));
+			mutex_unlock(&edev->ch[k].lock);
+		}
+		return count;
+	}
+
+	mode = sysfs_match_string(edev_cpl_mode_str, str);
+	if (mode < 0)
+		return mode;
+
+	for (k = 0; k < edev->num_channels; k++) {
+		mutex_lock(&edev->ch[k].lock);
+		edev->ch[k].cpl_mode = mode;
+		mutex_unlock(&edev->ch[k].lock);
+	}
+
+	return count;
+}
+
+static const struct file_operations edev_cpl_policy_fops = {
+	.owner = THIS_MODULE,
+	.open = edev_cpl_policy_open,
+	.read = seq_read,
+	.write = edev_cpl_policy_write,
+	.llseek = seq_lseek,
+	.release = single_release,
+};
+
+void edev_debugfs_create(struct example_dev *edev)
+{
+	struct edev_mmio_lat_params *params = &edev->mmio_lat_params;
+	struct edev_mmio_mt_params *mt_params = &edev->mmio_mt_params;
+
+	if (IS_ERR_OR_NULL(edev_debugfs_root))
+		return;
+
+	// defaults: reads from BAR2
+	params->mode = EDEV_MMIO_LAT_READ;
+	params->bar = 2;
+	params->offset = 0;
+	params->samples = 10000;
+
+	mt_params->mode = EDEV_MMIO_MT_READ;
+	mt_params->bar = 2;
+	mt_params->offset = 0;
+	mt_params->ops = 100000;
+	strscpy(mt_params->cpus, "0", sizeof(mt_params->cpus));
+
+	edev->debugfs_dir = debugfs_create_dir(pci_name(edev->pdev), edev_debugfs_root);
+
+	debugfs_create_u32("mmio_lat_mode", 0600, edev->debugfs_dir, &params->mode);
+	debugfs_create_u32("mmio_lat_bar", 0600, edev->debugfs_dir, &params->bar);
+	debugfs_create_x32("mmio_lat_offset", 0600, edev->debugfs_dir, &params->offset);
+	debugfs_create_u32("mmio_lat_samples", 0600, edev->debugfs_dir, &params->samples);
+	debugfs_create_file("mmio_lat", 0600, edev->debugfs_dir, edev, &edev_mmio_lat_fops);
+	debugfs_create_u32("mmio_mt_mode", 0600, edev->debugfs_dir, &mt_params->mode);
+	debugfs_create_u32("mmio_mt_bar", 0600, edev->debugfs_dir, &mt_params->bar);
+	debugfs_create_x32("mmio_mt_offset", 0600, edev->debugfs_dir, &mt_params->offset);
+	debugfs_create_u32("mmio_mt_ops", 0600, edev->debugfs_dir, &mt_params->ops);
+	debugfs_create_file("mmio_mt", 0600, edev->debugfs_dir, edev, &edev_mmio_mt_fops);
+	debugfs_create_file("cpl_fc_limits", 0600, edev->debugfs_dir, edev, &edev_cpl_fc_limits_fops);
+	debugfs_create_file("irq_moderation", 0600, edev->debugfs_dir, edev, &edev_irq_mod_fops);
+	debugfs_create_file("cpl_policy", 0600, edev->debugfs_dir, edev, &edev_cpl_policy_fops);
+}
+
+void edev_debugfs_destroy(struct example_dev *edev)
+{
+	debugfs_remove_recursive(edev->debugfs_dir);
+	edev->debugfs_dir = NULL;
+}
+
+void edev_debugfs_init(void)
+{
+	edev_debugfs_root = debugfs_create_dir(DRIVER_NAME, NULL);
+}
+
+void edev_debugfs_exit(void)
+{
+	debugfs_remove_recursive(edev_debugfs_root);
+	edev_debugfs_root = NULL;
+}
@@ -0,0 +1,455 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "example_driver.h"
+#include "example_ioctl.h"
+#include <linux/dma-mapping.h>
+#include <linux/fs.h>
+#include <linux/mm.h>
+#include <linux/module.h>
+#include <linux/pci.h>
+#include <linux/slab.h>
+#include <linux/uaccess.h>
+#include <linux/version.h>
+
+static int edev_open(struct inode *inode, struct file *file)
+{
+	struct miscdevice *miscdev = file->private_data;
+	struct example_dev *edev = container_of(miscdev, struct example_dev, misc_dev);
+	struct example_file *efile;
+
+	efile = kzalloc(sizeof(*efile), GFP_KERNEL);
+	if (!efile)
+		return -ENOMEM;
+
+	// misc_deregister waits for open, so the device is still registered
+	kref_get(&edev->kref);
+	efile->edev = edev;
+	efile->file = file;
+	mutex_init(&efile->lock);
+	file->private_data = efile;
+
+	mutex_lock(&edev->files_lock);
+	list_add(&efile->list, &edev->files);
+	mutex_unlock(&edev->files_lock);
+
+	// read() and write() are a stream, there is no file position
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 3, 0)
+	return stream_open(inode, file);
+#else
+	return nonseekable_open(inode, file);
+#endif
+}
+
+static int edev_release(struct inode *inode, struct file *file)
+{
+	struct example_file *efile = file->private_data;
+	struct example_dev *edev = efile->edev;
+
+	// the buffer is already unmapped if the device has been removed
+	mutex_lock(&edev->files_lock);
+	list_del(&efile->list);
+	mutex_lock(&efile->lock);
+	if (efile->ubuf)
+		edev_unmap_user_buf(edev, efile->ubuf);
+	mutex_unlock(&efile->lock);
+	mutex_unlock(&edev->files_lock);
+
+	kfree(efile);
+	edev_put(edev);
+
+	return 0;
+}
+
+// Called from remove once the device node is gone.  Waits for file
+// operations in progress, fails later ones with -ENODEV, and drops
+// everything that refers to the hardware: user mappings of the BARs and
+// DMA region, and pinned user buffers.
+void edev_revoke_files(struct example_dev *edev)
+{
+	struct example_file *efile;
+
+	// blocked stream readers and writers hold remove_sem
+	edev_stop_stream(&edev->stream);
+
+	down_write(&edev->remove_sem);
+	edev->removed = true;
+	up_write(&edev->remove_sem);
+
+	mutex_lock(&edev->files_lock);
+	list_for_each_entry(efile, &edev->files, list) {
+		unmap_mapping_range(efile->file->f_mapping, 0, 0, 1);
+
+		mutex_lock(&efile->lock);
+		if (efile->ubuf) {
+			edev_unmap_user_buf(edev, efile->ubuf);
+			efile->ubuf = NULL;
+		}
+		mutex_unlock(&efile->lock);
+	}
+	mutex_unlock(&edev->files_lock);
+}
+
+static int edev_enter(struct example_dev *edev)
+{
+	down_read(&edev->remove_sem);
+
+	if (edev->removed) {
+		up_read(&edev->remove_sem);
+		return -ENODEV;
+	}
+
+	return 0;
+}
+
+static void edev_exit(struct example_dev *edev)
+{
+	up_read(&edev->remove_sem);
+}
+
+// map the part of BAR range [start, end) covered by the VMA
+static int edev_remap_bar_range(struct example_dev *edev, struct vm_area_struct *vma,
+		int bar, unsigned long offset, unsigned long start, unsigned long end,
+		pgprot_t prot)
+{
+	unsigned long map_end = offset + vma->vm_end - vma->vm_start;
+
+	start = max(start, offset);
+	end = min(end, map_end);
+
+	if (start >= end)
+		return 0;
+
+	return remap_pfn_range(vma, vma->vm_start + start - offset,
+			(pci_resource_start(edev->pdev, bar) + start) >> PAGE_SHIFT,
+			end - start, prot);
+}
+
+static int edev_map_bar(struct example_dev *edev, struct vm_area_struct *vma,
+		int bar, unsigned long offset)
+{
+	size_t map_size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (!edev->bar[bar] || offset + map_size > edev->bar_len[bar]) {
+		dev_err(edev->dev, "%s: Tried to map BAR%d range 0x%lx+0x%zx, BAR length 0x%llx",
+				__func__, bar, offset, map_size, (u64)edev->bar_len[bar]);
+		return -EINVAL;
+	}
+
+	if (bar == 0 && edev->ch[0].desc_push_wc) {
+		// keep the memory types consistent with the kernel mappings
+		unsigned long start = 0;
+		int k;
+
+		ret = 0;
+		for (k = 0; k < edev->num_channels && !ret; k++) {
+			unsigned long push = k * EDEV_CHANNEL_STRIDE + EDEV_REG_DESC_PUSH;
+
+			ret = edev_remap_bar_range(edev, vma, bar, offset, start, push,
+					pgprot_noncached(vma->vm_page_prot));
+			if (!ret)
+				ret = edev_remap_bar_range(edev, vma, bar, offset,
+						push, push + PAGE_SIZE,
+						pgprot_writecombine(vma->vm_page_prot));
+			start = push + PAGE_SIZE;
+		}
+		if (!ret)
+			ret = edev_remap_bar_range(edev, vma, bar, offset,
+					start, edev->bar_len[bar],
+					pgprot_noncached(vma->vm_page_prot));
+	} else {
+		ret = remap_pfn_range(vma, vma->vm_start,
+				(pci_resource_start(edev->pdev, bar) + offset) >> PAGE_SHIFT,
+				map_size, pgprot_noncached(vma->vm_page_prot));
+	}
+
+	if (ret)
+		dev_err(edev->dev, "%s: remap_pfn_range failed for BAR%d", __func__, bar);
+	else
+		dev_dbg(edev->dev, "%s: Mapped BAR%d range 0x%lx+0x%zx to process VA 0x%lx",
+				__func__, bar, offset, map_size, vma->vm_start);
+
+	return ret;
+}
+
+static int edev_map_dma_region(struct example_dev *edev, struct vm_area_struct *vma,
+		unsigned long offset)
+{
+	size_t map_size = vma->vm_end - vma->vm_start;
+	int ret;
+
+	if (offset + map_size > PAGE_ALIGN(edev->dma_region_len)) {
+		dev_err(edev->dev, "%s: Tried to map DMA region range 0x%lx+0x%zx, region length 0x%zx",
+				__func__, offset, map_size, edev->dma_region_len);
+		return -EINVAL;
+	}
+
+	// dma_mmap_coherent takes the offset into the buffer from vm_pgoff
+	vma->vm_pgoff = offset >> PAGE_SHIFT;
+
+	ret = dma_mmap_coherent(edev->dev, vma, edev->dma_region,
+			edev->dma_region_addr, edev->dma_region_len);
+
+	if (ret)
+		dev_err(edev->dev, "%s: dma_mmap_coherent failed", __func__);
+	else
+		dev_dbg(edev->dev, "%s: Mapped DMA region range 0x%lx+0x%zx to process VA 0x%lx",
+				__func__, offset, map_size, vma->vm_start);
+
+	return ret;
+}
+
+static int edev_mmap_locked(struct file *file, struct vm_area_struct *vma)
+{
+	struct example_file *efile = file->private_data;
+	struct example_dev *edev = efile->edev;
+	unsigned long offset = vma->vm_pgoff << PAGE_SHIFT;
+	unsigned long region_offset = offset & (EDEV_MMAP_REGION_SIZE - 1);
+
+	switch (offset & ~(EDEV_MMAP_REGION_SIZE - 1)) {
+	case EDEV_MMAP_BAR0_OFFSET:
+		return edev_map_bar(edev, vma, 0, region_offset);
+	case EDEV_MMAP_BAR2_OFFSET:
+		return edev_map_bar(edev, vma, 2, region_offset);
+	case EDEV_MMAP_DMA_OFFSET:
+		return edev_map_dma_region(edev, vma, region_offset);
+	}
+
+	dev_err(edev->dev, "%s: Tried to map an unknown region at page offset 0x%lx",
+			__func__, vma->vm_pgoff);
+	return -EINVAL;
+}
+
+static long edev_ioctl_locked(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	struct example_file *efile = file->private_data;
+	struct example_dev *edev = efile->edev;
+	int ret;
+
+	if (_IOC_TYPE(cmd) != EDEV_IOCTL_TYPE)
+		return -ENOTTY;
+
+	switch (cmd) {
+	case EDEV_IOCTL_INFO:
+		{
+			struct edev_ioctl_info ctl;
+
+			memset(&ctl, 0, sizeof(ctl));
+
+			ctl.bar0_len = edev->bar_len[0];
+			ctl.bar2_len = edev->bar_len[2];
+			ctl.dma_region_len = edev->dma_region_len;
+			ctl.dma_region_addr = edev->dma_region_addr;
+			ctl.num_channels = edev->num_channels;
+
+			if (copy_to_user((void __user *)arg, &ctl, sizeof(ctl)) != 0)
+				return -EFAULT;
+
+			return 0;
+		}
+	case EDEV_IOCTL_MAP_USER:
+		{
+			struct edev_ioctl_user_buf ctl;
+			struct example_user_buf *ubuf;
+
+			if (copy_from_user(&ctl, (void __user *)arg, sizeof(ctl)) != 0)
+				return -EFAULT;
+
+			mutex_lock(&efile->lock);
+
+			if (efile->ubuf) {
+				ret = -EBUSY;
+			} else {
+				ubuf = edev_map_user_buf(edev, ctl.addr, ctl.len);
+				if (IS_ERR(ubuf)) {
+					ret = PTR_ERR(ubuf);
+				} else {
+					efile->ubuf = ubuf;
+					ret = 0;
+				}
+			}
+
+			mutex_unlock(&efile->lock);
+
+			return ret;
+		}
+	case EDEV_IOCTL_UNMAP_USER:
+		mutex_lock(&efile->lock);
+
+		if (efile->ubuf) {
+			edev_unmap_user_buf(edev, efile->ubuf);
+			efile->ubuf = NULL;
+			ret = 0;
+		} else {
+			ret = -EINVAL;
+		}
+
+		mutex_unlock(&efile->lock);
+
+		return ret;
+	case EDEV_IOCTL_USER_DMA:
+		{
+			struct edev_ioctl_user_dma ctl;
+			struct example_channel *ch;
+
+			if (copy_from_user(&ctl, (void __user *)arg, sizeof(ctl)) != 0)
+				return -EFAULT;
+
+			// the buffer must stay mapped while the DMA runs
+			mutex_lock(&efile->lock);
+
+			if (!efile->ubuf) {
+				mutex_unlock(&efile->lock);
+				return -EINVAL;
+			}
+
+			// each CPU submits on its own channel where possible
+			ch = edev_get_channel(edev);
+
+			mutex_lock(&ch->lock);
+			ret = edev_stream_check_idle(&edev->stream, ch);
+			if (!ret)
+				ret = edev_user_buf_dma(ch, efile->ubuf, ctl.dir, ctl.offset,
+						ctl.len, ctl.block_len, ctl.ram_addr, &ctl.cycles);
+			mutex_unlock(&ch->lock);
+
+			mutex_unlock(&efile->lock);
+
+			ctl.channel = ch->index;
+
+			if (ret)
+				return ret;
+
+			if (copy_to_user((void __user *)arg, &ctl, sizeof(ctl)) != 0)
+				return -EFAULT;
+
+			return 0;
+		}
+	case EDEV_IOCTL_BENCH:
+		{
+			struct edev_ioctl_bench ctl;
+
+			if (copy_from_user(&ctl, (void __user *)arg, sizeof(ctl)) != 0)
+				return -EFAULT;
+
+			mutex_lock(&efile->lock);
+			mutex_lock(&edev->dma_lock);
+			mutex_lock(&edev->ch[0].lock);
+			ret = edev_stream_check_idle(&edev->stream, &edev->ch[0]);
+			if (!ret)
+				ret = edev_bench(edev, efile->ubuf, &ctl);
+			mutex_unlock(&edev->ch[0].lock);
+			mutex_unlock(&edev->dma_lock);
+			mutex_unlock(&efile->lock);
+
+			if (ret)
+				return ret;
+
+			if (copy_to_user((void __user *)arg, &ctl, sizeof(ctl)) != 0)
+				return -EFAULT;
+
+			return 0;
+		}
+	case EDEV_IOCTL_RUN_TESTS:
+		return edev_run_tests(edev, arg);
+	default:
+		return -ENOTTY;
+	}
+}
+
+static int edev_mmap(struct file *file, struct vm_area_struct *vma)
+{
+	struct example_file *efile = file->private_data;
+	int ret;
+
+	ret = edev_enter(efile->edev);
+	if (ret)
+		return ret;
+
+	ret = edev_mmap_locked(file, vma);
+
+	edev_exit(efile->edev);
+	return ret;
+}
+
+static long edev_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
+{
+	struct example_file *efile = file->private_data;
+	long ret;
+
+	ret = edev_enter(efile->edev);
+	if (ret)
+		return ret;
+
+	ret = edev_ioctl_locked(file, cmd, arg);
+
+	edev_exit(efile->edev);
+	return ret;
+}
+
+static ssize_t edev_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct example_file *efile = iocb->ki_filp->private_data;
+	ssize_t ret;
+
+	ret = edev_enter(efile->edev);
+	if (ret)
+		return ret;
+
+	ret = edev_stream_read_iter(iocb, to);
+
+	edev_exit(efile->edev);
+	return ret;
+}
+
+static ssize_t edev_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct example_file *efile = iocb->ki_filp->private_data;
+	ssize_t ret;
+
+	ret = edev_enter(efile->edev);
+	if (ret)
+		return ret;
+
+	ret = edev_stream_write_iter(iocb, from);
+
+	edev_exit(efile->edev);
+	return ret;
+}
+
+const struct file_operations edev_fops = {
+	.owner = THIS_MODULE,
+	.open = edev_open,
+	.release = edev_release,
+	.read_iter = edev_read_iter,
+	.write_iter = edev_write_iter,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(6, 5, 0)
+	.splice_read = copy_splice_read,
+#else
+	.splice_read = generic_file_splice_read,
+#endif
+	.splice_write = iter_file_splice_write,
+	.mmap = edev_mmap,
+	.unlocked_ioctl = edev_ioctl,
+};
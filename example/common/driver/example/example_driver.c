@@ -22,12 +22,16 @@
  */
 
 #include "example_driver.h"
+#include "example_ioctl.h"
 #include <linux/module.h>
 #include <linux/pci.h>
 #include <linux/version.h>
 #include <linux/delay.h>
-
-#include <asm/tsc.h>
+#include <linux/idr.h>
+#include <linux/interrupt.h>
+#include <linux/slab.h>
+#include <linux/topology.h>
+#include <linux/workqueue.h>
 
 #if LINUX_VERSION_CODE < KERNEL_VERSION(5, 4, 0)
 #include <linux/pci-aspm.h>
@@ -42,272 +46,1521 @@ static int edev_probe(struct pci_dev *pdev, const struct pci_device_id *ent);
 static void edev_remove(struct pci_dev *pdev);
 static void edev_shutdown(struct pci_dev *pdev);
 
-static int enumerate_bars(struct example_dev *edev, struct pci_dev *pdev);
-static int map_bars(struct example_dev *edev, struct pci_dev *pdev);
-static void free_bars(struct example_dev *edev, struct pci_dev *pdev);
+static int enumerate_bars(struct example_dev *edev, struct pci_dev *pdev);
+static int map_bars(struct example_dev *edev, struct pci_dev *pdev);
+static void free_bars(struct example_dev *edev, struct pci_dev *pdev);
+static int edev_map_channels(struct example_dev *edev);
+static void edev_unmap_channels(struct example_dev *edev);
+
+static const struct pci_device_id pci_ids[] = {
+	{PCI_DEVICE(0x1234, 0x0001)},
+	{0 /* end */ }
+};
+
+MODULE_DEVICE_TABLE(pci, pci_ids);
+
+static DEFINE_IDA(edev_instance_ida);
+
+static unsigned int test_on_load = EDEV_TEST_SELF;
+module_param(test_on_load, uint, 0444);
+MODULE_PARM_DESC(test_on_load, "Tests to run in the background after probe (bit 0: self-test, bit 1: benchmarks, bit 2: completion credit limit search)");
+
+static bool desc_push_wc = true;
+module_param(desc_push_wc, bool, 0444);
+MODULE_PARM_DESC(desc_push_wc, "Map the descriptor push window write-combined");
+
+static bool ten_bit_tags = true;
+module_param(ten_bit_tags, bool, 0444);
+MODULE_PARM_DESC(ten_bit_tags, "Enable 10-bit tags when supported along the path to the root port");
+
+static unsigned int irq_mod_count;
+module_param(irq_mod_count, uint, 0444);
+MODULE_PARM_DESC(irq_mod_count, "Completion events per interrupt (with irq_mod_time_us as the upper bound on delay)");
+
+static unsigned int irq_mod_time_us;
+module_param(irq_mod_time_us, uint, 0444);
+MODULE_PARM_DESC(irq_mod_time_us, "Maximum interrupt delay after the first completion event, in microseconds");
+
+static unsigned int irq_min_interval_us;
+module_param(irq_min_interval_us, uint, 0444);
+MODULE_PARM_DESC(irq_min_interval_us, "Minimum interval between interrupts on each vector, in microseconds");
+
+static bool irq_mod_adaptive;
+module_param(irq_mod_adaptive, bool, 0444);
+MODULE_PARM_DESC(irq_mod_adaptive, "Adjust interrupt moderation from the observed completion rate");
+
+static unsigned int cpl_mode = EDEV_CPL_MODE_HYBRID;
+module_param(cpl_mode, uint, 0444);
+MODULE_PARM_DESC(cpl_mode, "Block operation completion wait (0: interrupt, 1: poll, 2: poll for the estimated transfer time, then interrupt)");
+
+#ifndef PCI_EXP_DEVCAP2_10BIT_TAG_COMP
+#define PCI_EXP_DEVCAP2_10BIT_TAG_COMP 0x00010000
+#endif
+#ifndef PCI_EXP_DEVCAP2_10BIT_TAG_REQ
+#define PCI_EXP_DEVCAP2_10BIT_TAG_REQ 0x00020000
+#endif
+#ifndef PCI_EXP_DEVCTL2_10BIT_TAG_REQ_EN
+#define PCI_EXP_DEVCTL2_10BIT_TAG_REQ_EN 0x1000
+#endif
+
+const char *const edev_cpl_mode_str[EDEV_CPL_MODE_COUNT] = {
+	[EDEV_CPL_MODE_IRQ] = "irq",
+	[EDEV_CPL_MODE_POLL] = "poll",
+	[EDEV_CPL_MODE_HYBRID] = "hybrid",
+};
+
+// read a 64-bit counter as two 32-bit halves, re-reading if the high word
+// changed under us
+u64 edev_read64(void __iomem *addr)
+{
+	u32 lo, hi;
+
+	do {
+		hi = ioread32(addr + 4);
+		lo = ioread32(addr);
+	} while (ioread32(addr + 4) != hi);
+
+	return ((u64)hi << 32) | lo;
+}
+
+static void edev_cpl_irq_enable(struct example_channel *ch, int write, bool enable)
+{
+	u32 bit = write ? 0x2 : 0x1;
+
+	if (enable)
+		ch->int_en |= bit;
+	else
+		ch->int_en &= ~bit;
+
+	iowrite32(ch->int_en, ch->hw_addr + 0x000008);
+}
+
+// Pick the poll window for a block operation of len bytes (0 to sleep on
+// the interrupt right away).  Short transfers finish in about the time it
+// takes to wake a sleeping thread, so polling for the estimated transfer
+// time avoids the wakeup without spinning through long transfers.  The
+// interrupt is masked while polling; call before starting the operation.
+static u64 edev_cpl_begin(struct example_channel *ch, int write, u64 len)
+{
+	u64 poll_ns;
+
+	switch (ch->cpl_mode) {
+	case EDEV_CPL_MODE_POLL:
+		poll_ns = EDEV_BLOCK_TIMEOUT_MS * NSEC_PER_MSEC;
+		break;
+	case EDEV_CPL_MODE_HYBRID:
+		poll_ns = EDEV_CPL_EST_BASE_NS + div_u64(len * 1000, EDEV_CPL_EST_MBPS);
+		if (poll_ns > EDEV_CPL_POLL_MAX_NS)
+			poll_ns = 0;
+		else
+			poll_ns *= EDEV_CPL_POLL_SLACK;
+		break;
+	default:
+		poll_ns = 0;
+	}
+
+	if (poll_ns)
+		edev_cpl_irq_enable(ch, write, false);
+	else
+		ch->cpl_stats[write].irq_only++;
+
+	return poll_ns;
+}
+
+static int dma_block_wait(struct example_channel *ch, int write, u64 poll_ns)
+{
+	struct example_cpl_stats *stats = &ch->cpl_stats[write];
+	struct completion *cpl = write ? &ch->dma_write_cpl : &ch->dma_read_cpl;
+	unsigned int reg = write ? 0x001100 : 0x001000;
+	unsigned long t;
+
+	t = jiffies + msecs_to_jiffies(EDEV_BLOCK_TIMEOUT_MS);
+
+	if (poll_ns) {
+		u64 start = ktime_get_ns();
+		u64 now;
+		bool done;
+
+		for (;;) {
+			done = !(ioread32(ch->hw_addr + reg) & 1);
+			now = ktime_get_ns();
+			if (done || now - start >= poll_ns)
+				break;
+			// spin through the short estimated window; only a long
+			// poll mode wait that outlasts it gives up the CPU
+			if (now - start < EDEV_CPL_POLL_MAX_NS * EDEV_CPL_POLL_SLACK)
+				cpu_relax();
+			else
+				cond_resched();
+		}
+
+		stats->poll_ns += now - start;
+
+		// completions while masked do not interrupt, so check again
+		// after unmasking before going to sleep
+		edev_cpl_irq_enable(ch, write, true);
+		if (!done)
+			done = !(ioread32(ch->hw_addr + reg) & 1);
+
+		if (done) {
+			stats->poll++;
+			return 0;
+		}
+
+		stats->irq++;
+	}
+
+	// sleep until the block engine interrupts, then confirm it is idle
+	while (ioread32(ch->hw_addr + reg) & 1) {
+		if (!time_before(jiffies, t))
+			return -ETIMEDOUT;
+		wait_for_completion_timeout(cpl, t - jiffies);
+	}
+
+	return 0;
+}
+
+// program the block engine at reg (0x001000 read, 0x001100 write) without starting it
+static void dma_block_setup(struct example_channel *ch, unsigned int reg,
+		dma_addr_t dma_addr, size_t dma_offset,
+		size_t dma_offset_mask, size_t dma_stride,
+		size_t ram_addr, size_t ram_offset,
+		size_t ram_offset_mask, size_t ram_stride,
+		size_t block_len, size_t block_count)
+{
+	void __iomem *addr = ch->hw_addr + reg;
+
+	// DMA base address
+	iowrite32(dma_addr & 0xffffffff, addr + 0x80);
+	iowrite32((dma_addr >> 32) & 0xffffffff, addr + 0x84);
+	// DMA offset address
+	iowrite32(dma_offset & 0xffffffff, addr + 0x88);
+	iowrite32((dma_offset >> 32) & 0xffffffff, addr + 0x8c);
+	// DMA offset mask
+	iowrite32(dma_offset_mask & 0xffffffff, addr + 0x90);
+	iowrite32((dma_offset_mask >> 32) & 0xffffffff, addr + 0x94);
+	// DMA stride
+	iowrite32(dma_stride & 0xffffffff, addr + 0x98);
+	iowrite32((dma_stride >> 32) & 0xffffffff, addr + 0x9c);
+	// RAM base address
+	iowrite32(ram_addr & 0xffffffff, addr + 0xc0);
+	iowrite32((ram_addr >> 32) & 0xffffffff, addr + 0xc4);
+	// RAM offset address
+	iowrite32(ram_offset & 0xffffffff, addr + 0xc8);
+	iowrite32((ram_offset >> 32) & 0xffffffff, addr + 0xcc);
+	// RAM offset mask
+	iowrite32(ram_offset_mask & 0xffffffff, addr + 0xd0);
+	iowrite32((ram_offset_mask >> 32) & 0xffffffff, addr + 0xd4);
+	// RAM stride
+	iowrite32(ram_stride & 0xffffffff, addr + 0xd8);
+	iowrite32((ram_stride >> 32) & 0xffffffff, addr + 0xdc);
+	// clear cycle count
+	iowrite32(0, addr + 0x08);
+	iowrite32(0, addr + 0x0c);
+	// block length
+	iowrite32(block_len, addr + 0x10);
+	// block count
+	iowrite32(block_count, addr + 0x18);
+}
+
+// Select how the block engine generates host addresses; stays in effect
+// for later operations, so callers switch back to linear when done.
+// Random mode steps a 32 bit LFSR from seed (must be non-zero), list mode
+// takes offsets from 2**list_log_size 64 bit entries at list_addr.
+void dma_block_set_pattern(struct example_channel *ch, int write, u32 mode,
+		u32 seed, dma_addr_t list_addr, u32 list_log_size)
+{
+	void __iomem *addr = ch->hw_addr + (write ? 0x001100 : 0x001000);
+
+	iowrite32(seed, addr + 0x20);
+	iowrite32(list_addr & 0xffffffff, addr + 0xa0);
+	iowrite32((list_addr >> 32) & 0xffffffff, addr + 0xa4);
+	iowrite32(list_log_size, addr + 0xa8);
+	iowrite32(mode, addr + 0x04);
+}
+
+// cycles taken by the last block engine run
+u64 dma_block_cycles(struct example_channel *ch, int write)
+{
+	void __iomem *addr = ch->hw_addr + (write ? EDEV_REG_BLOCK_WRITE : EDEV_REG_BLOCK_READ);
+
+	return edev_read64(addr + EDEV_BLOCK_REG_CYCLES);
+}
+
+// per-block latency of the last block engine run (cleared on start)
+void dma_block_lat(struct example_channel *ch, int write, struct example_block_lat *lat)
+{
+	void __iomem *addr = ch->hw_addr + (write ? EDEV_REG_BLOCK_WRITE : EDEV_REG_BLOCK_READ);
+
+	lat->count = ioread32(addr + EDEV_BLOCK_REG_LAT_COUNT);
+	lat->min = ioread32(addr + EDEV_BLOCK_REG_LAT_MIN);
+	lat->max = ioread32(addr + EDEV_BLOCK_REG_LAT_MAX);
+	lat->sum = edev_read64(addr + EDEV_BLOCK_REG_LAT_SUM);
+}
+
+static void dma_block_lat_info(struct example_channel *ch, int write)
+{
+	struct example_dev *edev = ch->edev;
+	struct example_block_lat lat;
+
+	dma_block_lat(ch, write, &lat);
+
+	if (!lat.count)
+		return;
+
+	dev_info(edev->dev, "  block latency: min %lld ns mean %lld ns max %lld ns",
+			edev_cycles_to_ns(edev, lat.min),
+			div_u64(edev_cycles_to_ns(edev, lat.sum), lat.count),
+			edev_cycles_to_ns(edev, lat.max));
+}
+
+int dma_block_read(struct example_channel *ch,
+		dma_addr_t dma_addr, size_t dma_offset,
+		size_t dma_offset_mask, size_t dma_stride,
+		size_t ram_addr, size_t ram_offset,
+		size_t ram_offset_mask, size_t ram_stride,
+		size_t block_len, size_t block_count)
+{
+	struct example_dev *edev = ch->edev;
+	u64 poll_ns;
+	int ret;
+
+	dma_block_setup(ch, 0x001000, dma_addr, dma_offset, dma_offset_mask, dma_stride,
+			ram_addr, ram_offset, ram_offset_mask, ram_stride,
+			block_len, block_count);
+
+	// start
+	poll_ns = edev_cpl_begin(ch, 0, (u64)block_len * block_count);
+	reinit_completion(&ch->dma_read_cpl);
+	iowrite32(1, ch->hw_addr + 0x001000);
+
+	// wait for transfer to complete
+	ret = dma_block_wait(ch, 0, poll_ns);
+	if (ret)
+		dev_warn(edev->dev, "%s: operation timed out", __func__);
+	if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+		dev_warn(edev->dev, "%s: DMA engine busy", __func__);
+	if (!ret && (ioread32(ch->hw_addr + 0x001004) & EDEV_BLOCK_MODE_LIST_ERROR)) {
+		dev_warn(edev->dev, "%s: address list fetch failed", __func__);
+		ret = -EIO;
+	}
+
+	return ret;
+}
+
+int dma_block_write(struct example_channel *ch,
+		dma_addr_t dma_addr, size_t dma_offset,
+		size_t dma_offset_mask, size_t dma_stride,
+		size_t ram_addr, size_t ram_offset,
+		size_t ram_offset_mask, size_t ram_stride,
+		size_t block_len, size_t block_count)
+{
+	struct example_dev *edev = ch->edev;
+	u64 poll_ns;
+	int ret;
+
+	dma_block_setup(ch, 0x001100, dma_addr, dma_offset, dma_offset_mask, dma_stride,
+			ram_addr, ram_offset, ram_offset_mask, ram_stride,
+			block_len, block_count);
+
+	// start
+	poll_ns = edev_cpl_begin(ch, 1, (u64)block_len * block_count);
+	reinit_completion(&ch->dma_write_cpl);
+	iowrite32(1, ch->hw_addr + 0x001100);
+
+	// wait for transfer to complete
+	ret = dma_block_wait(ch, 1, poll_ns);
+	if (ret)
+		dev_warn(edev->dev, "%s: operation timed out", __func__);
+	if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+		dev_warn(edev->dev, "%s: DMA engine busy", __func__);
+	if (!ret && (ioread32(ch->hw_addr + 0x001104) & EDEV_BLOCK_MODE_LIST_ERROR)) {
+		dev_warn(edev->dev, "%s: address list fetch failed", __func__);
+		ret = -EIO;
+	}
+
+	return ret;
+}
+
+// Run the read and write block engines at the same time: reads go from
+// rd_dma_addr to card RAM at rd_ram_addr while writes go from card RAM at
+// wr_ram_addr to wr_dma_addr, with the same block size, stride and count.
+static int dma_block_duplex(struct example_channel *ch,
+		dma_addr_t rd_dma_addr, size_t rd_ram_addr,
+		dma_addr_t wr_dma_addr, size_t wr_ram_addr,
+		size_t dma_offset_mask, size_t ram_offset_mask, size_t stride,
+		size_t block_len, size_t block_count)
+{
+	struct example_dev *edev = ch->edev;
+	u64 rd_poll_ns, wr_poll_ns;
+	int ret, wr_ret;
+
+	dma_block_setup(ch, 0x001000, rd_dma_addr, 0, dma_offset_mask, stride,
+			rd_ram_addr, 0, ram_offset_mask, stride, block_len, block_count);
+	dma_block_setup(ch, 0x001100, wr_dma_addr, 0, dma_offset_mask, stride,
+			wr_ram_addr, 0, ram_offset_mask, stride, block_len, block_count);
+
+	// start both engines back to back
+	rd_poll_ns = edev_cpl_begin(ch, 0, (u64)block_len * block_count);
+	wr_poll_ns = edev_cpl_begin(ch, 1, (u64)block_len * block_count);
+	reinit_completion(&ch->dma_read_cpl);
+	reinit_completion(&ch->dma_write_cpl);
+	iowrite32(1, ch->hw_addr + 0x001000);
+	iowrite32(1, ch->hw_addr + 0x001100);
+
+	// wait for both transfers to complete
+	ret = dma_block_wait(ch, 0, rd_poll_ns);
+	wr_ret = dma_block_wait(ch, 1, wr_poll_ns);
+	if (!ret)
+		ret = wr_ret;
+	if (ret)
+		dev_warn(edev->dev, "%s: operation timed out", __func__);
+	if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+		dev_warn(edev->dev, "%s: DMA engine busy", __func__);
+
+	return ret;
+}
+
+static void dma_block_read_bench(struct example_channel *ch,
+		dma_addr_t dma_addr, u64 size, u64 stride, u64 count)
+{
+	struct example_dev *edev = ch->edev;
+	u64 ns;
+	u32 rd_req;
+	u32 rd_cpl;
+
+	udelay(5);
+
+	rd_req = ioread32(ch->hw_addr + 0x000020);
+	rd_cpl = ioread32(ch->hw_addr + 0x000024);
+
+	dma_block_read(ch, dma_addr, 0, edev->dma_region_len - 1, stride,
+			0, 0, EDEV_CARD_RAM_SIZE - 1, stride, size, count);
+
+	ns = max_t(u64, edev_cycles_to_ns(edev, dma_block_cycles(ch, 0)), 1);
+
+	udelay(5);
+
+	rd_req = ioread32(ch->hw_addr + 0x000020) - rd_req;
+	rd_cpl = ioread32(ch->hw_addr + 0x000024) - rd_cpl;
+
+	dev_info(edev->dev, "read %lld blocks of %lld bytes (total %lld B, stride %lld) in %lld ns (%d req %d cpl): %lld Mbps",
+			count, size, count*size, stride, ns, rd_req, rd_cpl, div64_u64(size * count * 8 * 1000, ns));
+	dma_block_lat_info(ch, 0);
+}
+
+static void dma_block_write_bench(struct example_channel *ch,
+		dma_addr_t dma_addr, u64 size, u64 stride, u64 count)
+{
+	struct example_dev *edev = ch->edev;
+	u64 ns;
+	u32 wr_req;
+
+	udelay(5);
+
+	wr_req = ioread32(ch->hw_addr + 0x000028);
+
+	dma_block_write(ch, dma_addr, 0, edev->dma_region_len - 1, stride,
+			0, 0, EDEV_CARD_RAM_SIZE - 1, stride, size, count);
+
+	ns = max_t(u64, edev_cycles_to_ns(edev, dma_block_cycles(ch, 1)), 1);
+
+	udelay(5);
+
+	wr_req = ioread32(ch->hw_addr + 0x000028) - wr_req;
+
+	dev_info(edev->dev, "wrote %lld blocks of %lld bytes (total %lld B, stride %lld) in %lld ns (%d req): %lld Mbps",
+			count, size, count*size, stride, ns, wr_req, div64_u64(size * count * 8 * 1000, ns));
+	dma_block_lat_info(ch, 1);
+}
+
+// mean and max read latency from the statistics block since the last clear
+static void edev_rd_lat_sample(struct example_channel *ch, u64 *mean_ns, u64 *max_ns)
+{
+	struct example_dev *edev = ch->edev;
+	void __iomem *stats = ch->hw_addr + EDEV_REG_STATS;
+	u32 count = ioread32(stats + EDEV_STATS_REG_LAT_COUNT);
+	u64 sum;
+
+	sum = edev_read64(stats + EDEV_STATS_REG_LAT_SUM);
+
+	*mean_ns = count ? div_u64(edev_cycles_to_ns(edev, sum), count) : 0;
+	*max_ns = edev_cycles_to_ns(edev, ioread32(stats + EDEV_STATS_REG_LAT_MAX));
+}
+
+// Reads from the first half of the DMA region and card RAM while writing
+// from the second halves, compared against the same reads on their own.
+static void dma_block_duplex_bench(struct example_channel *ch,
+		dma_addr_t dma_addr, u64 size, u64 stride, u64 count)
+{
+	struct example_dev *edev = ch->edev;
+	size_t dma_half = edev->dma_region_len / 2;
+	size_t ram_half = EDEV_CARD_RAM_SIZE / 2;
+	bool stats = ioread32(ch->hw_addr + EDEV_REG_STATS + EDEV_STATS_REG_CTRL) & EDEV_STATS_CTRL_PRESENT;
+	u64 solo_mean_ns = 0, solo_max_ns = 0;
+	u64 lat_mean_ns = 0, lat_max_ns = 0;
+	u64 solo_ns, rd_ns, wr_ns, total_ns;
+	u32 rd_req, rd_cpl, wr_req;
+
+	// read-only baseline
+	udelay(5);
+
+	if (stats)
+		iowrite32(EDEV_STATS_CTRL_CLEAR, ch->hw_addr + EDEV_REG_STATS + EDEV_STATS_REG_CTRL);
+
+	dma_block_read(ch, dma_addr, 0, dma_half - 1, stride,
+			0, 0, ram_half - 1, stride, size, count);
+
+	solo_ns = max_t(u64, edev_cycles_to_ns(edev, dma_block_cycles(ch, 0)), 1);
+
+	udelay(5);
+
+	if (stats)
+		edev_rd_lat_sample(ch, &solo_mean_ns, &solo_max_ns);
+
+	// both directions at once
+	udelay(5);
+
+	if (stats)
+		iowrite32(EDEV_STATS_CTRL_CLEAR, ch->hw_addr + EDEV_REG_STATS + EDEV_STATS_REG_CTRL);
+
+	rd_req = ioread32(ch->hw_addr + 0x000020);
+	rd_cpl = ioread32(ch->hw_addr + 0x000024);
+	wr_req = ioread32(ch->hw_addr + 0x000028);
+
+	dma_block_duplex(ch, dma_addr, 0, dma_addr + dma_half, ram_half,
+			dma_half - 1, ram_half - 1, stride, size, count);
+
+	rd_ns = max_t(u64, edev_cycles_to_ns(edev, dma_block_cycles(ch, 0)), 1);
+	wr_ns = max_t(u64, edev_cycles_to_ns(edev, dma_block_cycles(ch, 1)), 1);
+	// both engines start within a couple of register writes of each other
+	total_ns = max(rd_ns, wr_ns);
+
+	udelay(5);
+
+	rd_req = ioread32(ch->hw_addr + 0x000020) - rd_req;
+	rd_cpl = ioread32(ch->hw_addr + 0x000024) - rd_cpl;
+	wr_req = ioread32(ch->hw_addr + 0x000028) - wr_req;
+
+	if (stats)
+		edev_rd_lat_sample(ch, &lat_mean_ns, &lat_max_ns);
+
+	dev_info(edev->dev, "duplex %lld blocks of %lld bytes (stride %lld): read %lld ns (%d req %d cpl): %lld Mbps, write %lld ns (%d req): %lld Mbps, aggregate %lld Mbps (read only %lld Mbps)",
+			count, size, stride,
+			rd_ns, rd_req, rd_cpl, div64_u64(size * count * 8 * 1000, rd_ns),
+			wr_ns, wr_req, div64_u64(size * count * 8 * 1000, wr_ns),
+			div64_u64(2 * size * count * 8 * 1000, total_ns),
+			div64_u64(size * count * 8 * 1000, solo_ns));
+
+	if (stats)
+		dev_info(edev->dev, "duplex read latency: mean %lld ns max %lld ns (read only: mean %lld ns max %lld ns)",
+				lat_mean_ns, lat_max_ns, solo_mean_ns, solo_max_ns);
+}
+
+// returns -EIO if any read completed with an error (lost or bad completions)
+static int dma_cpl_buf_test(struct example_channel *ch, dma_addr_t dma_addr,
+		u64 size, u64 stride, u64 count, int stall)
+{
+	struct example_dev *edev = ch->edev;
+	u64 ns;
+	u32 rd_req;
+	u32 rd_cpl;
+	u32 rd_err;
+	int ret;
+
+	rd_req = ioread32(ch->hw_addr + 0x000020);
+	rd_cpl = ioread32(ch->hw_addr + 0x000024);
+	rd_err = ioread32(ch->hw_addr + EDEV_REG_RD_ERROR_COUNT);
+
+	// DMA base address
+	iowrite32(dma_addr & 0xffffffff, ch->hw_addr + 0x001080);
+	iowrite32((dma_addr >> 32) & 0xffffffff, ch->hw_addr + 0x001084);
+	// DMA offset address
+	iowrite32(0, ch->hw_addr + 0x001088);
+	iowrite32(0, ch->hw_addr + 0x00108c);
+	// DMA offset mask
+	iowrite32(edev->dma_region_len - 1, ch->hw_addr + 0x001090);
+	iowrite32(0, ch->hw_addr + 0x001094);
+	// DMA stride
+	iowrite32(stride & 0xffffffff, ch->hw_addr + 0x001098);
+	iowrite32((stride >> 32) & 0xffffffff, ch->hw_addr + 0x00109c);
+	// RAM base address
+	iowrite32(0, ch->hw_addr + 0x0010c0);
+	iowrite32(0, ch->hw_addr + 0x0010c4);
+	// RAM offset address
+	iowrite32(0, ch->hw_addr + 0x0010c8);
+	iowrite32(0, ch->hw_addr + 0x0010cc);
+	// RAM offset mask
+	iowrite32(EDEV_CARD_RAM_SIZE - 1, ch->hw_addr + 0x0010d0);
+	iowrite32(0, ch->hw_addr + 0x0010d4);
+	// RAM stride
+	iowrite32(stride & 0xffffffff, ch->hw_addr + 0x0010d8);
+	iowrite32((stride >> 32) & 0xffffffff, ch->hw_addr + 0x0010dc);
+	// clear cycle count
+	iowrite32(0, ch->hw_addr + 0x001008);
+	iowrite32(0, ch->hw_addr + 0x00100c);
+	// block length
+	iowrite32(size, ch->hw_addr + 0x001010);
+	// block count
+	iowrite32(count, ch->hw_addr + 0x001018);
+
+	if (stall)
+		iowrite32(stall, ch->hw_addr + 0x000040);
+
+	// start
+	reinit_completion(&ch->dma_read_cpl);
+	iowrite32(1, ch->hw_addr + 0x001000);
+
+	// wait for transfer to complete
+	ret = dma_block_wait(ch, 0, 0);
+	if (ret)
+		dev_warn(edev->dev, "%s: operation timed out", __func__);
+	if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+		dev_warn(edev->dev, "%s: DMA engine busy", __func__);
+
+	ns = max_t(u64, edev_cycles_to_ns(edev, dma_block_cycles(ch, 0)), 1);
+
+	rd_req = ioread32(ch->hw_addr + 0x000020) - rd_req;
+	rd_cpl = ioread32(ch->hw_addr + 0x000024) - rd_cpl;
+	rd_err = ioread32(ch->hw_addr + EDEV_REG_RD_ERROR_COUNT) - rd_err;
+
+	dev_info(edev->dev, "read %lld x %lld B (total %lld B %lld CPLD, stride %lld) in %lld ns (%d req %d cpl): %lld Mbps",
+			count, size, count*size, count*((size+15) / 16), stride, ns, rd_req, rd_cpl, div64_u64(size * count * 8 * 1000, ns));
+
+	if (ret)
+		return ret;
+
+	if (rd_err) {
+		dev_warn(edev->dev, "%s: %d read(s) completed with errors", __func__, rd_err);
+		return -EIO;
+	}
+
+	return 0;
+}
+
+void edev_set_cpl_fc_limits(struct example_dev *edev, u32 cplh, u32 cpld)
+{
+	edev->cplh_fc_limit = min_t(u32, cplh, EDEV_CPLH_FC_LIMIT_MAX);
+	edev->cpld_fc_limit = min_t(u32, cpld, EDEV_CPLD_FC_LIMIT_MAX);
+
+	iowrite32(edev->cplh_fc_limit, edev->ch[0].hw_addr + EDEV_REG_CPLH_FC_LIMIT);
+	iowrite32(edev->cpld_fc_limit, edev->ch[0].hw_addr + EDEV_REG_CPLD_FC_LIMIT);
+}
+
+// one search step: run the stress pattern for the header or data credit
+// limit a few times, with completions held back so they pile up on the card
+#define EDEV_CPL_BUDGET_RUNS 2
+
+static int edev_cpl_budget_try(struct example_dev *edev, u32 cplh, u32 cpld, bool data)
+{
+	struct example_channel *ch = &edev->ch[0];
+	int ret = 0;
+	int k;
+
+	edev_set_cpl_fc_limits(edev, cplh, cpld);
+
+	for (k = 0; k < EDEV_CPL_BUDGET_RUNS && !ret; k++) {
+		if (data)
+			// full 512 byte reads (CPLD)
+			ret = dma_cpl_buf_test(ch, edev->dma_region_addr + 0x0000,
+					512, 512, 256, 100000);
+		else
+			// short unaligned reads, two completions each (CPLH)
+			ret = dma_cpl_buf_test(ch, edev->dma_region_addr + 128 - 8,
+					8+64, 0, 256, 400000);
+	}
+
+	return ret;
+}
+
+// largest limit in [lo, hi] that completes without errors
+static int edev_cpl_budget_bsearch(struct example_dev *edev, u32 lo, u32 hi,
+		bool data, u32 *limit)
+{
+	u32 cplh = edev->cplh_fc_limit;
+	int ret;
+
+	ret = data ? edev_cpl_budget_try(edev, cplh, hi, true)
+		: edev_cpl_budget_try(edev, hi, 0, false);
+	if (ret != -EIO) {
+		*limit = hi;
+		return ret;
+	}
+
+	while (lo < hi) {
+		u32 mid = lo + (hi - lo) / 2;
+
+		ret = data ? edev_cpl_budget_try(edev, cplh, mid, true)
+			: edev_cpl_budget_try(edev, mid, 0, false);
+		if (!ret)
+			lo = mid + 1;
+		else if (ret == -EIO)
+			hi = mid;
+		else
+			return ret;
+	}
+
+	// lo is now the smallest failing limit
+	if (lo <= 1)
+		return -EIO;
+
+	*limit = lo - 1;
+	return 0;
+}
+
+// Search for the largest completion credit limits that never overflow the
+// completion buffer. Overflowed completions are lost and the read completes
+// with an error once the completion timeout expires, so the read error count
+// is used as the pass/fail signal. The header limit is searched first (with
+// the compile-time data limit), then the data limit with that header limit.
+// Call with dma_lock and the channel 0 lock held.
+int edev_cpl_budget_search(struct example_dev *edev)
+{
+	struct example_channel *ch = &edev->ch[0];
+	u32 cplh_max = ioread32(ch->hw_addr + EDEV_REG_CPLH_FC_LIMIT_MAX);
+	u32 cpld_max = ioread32(ch->hw_addr + EDEV_REG_CPLD_FC_LIMIT_MAX);
+	u32 cplh_prev = edev->cplh_fc_limit;
+	u32 cpld_prev = edev->cpld_fc_limit;
+	u32 cplh;
+	u32 cpld;
+	int ret;
+
+	if (!cplh_max || cplh_max > EDEV_CPLH_FC_LIMIT_MAX)
+		cplh_max = EDEV_CPLH_FC_LIMIT_MAX;
+	if (!cpld_max || cpld_max > EDEV_CPLD_FC_LIMIT_MAX)
+		cpld_max = EDEV_CPLD_FC_LIMIT_MAX;
+
+	dev_info(edev->dev, "search completion credit limits (CPLH up to %u, CPLD up to %u)",
+			cplh_max, cpld_max);
+
+	ret = edev_cpl_budget_bsearch(edev, 1, cplh_max, false, &cplh);
+	if (ret)
+		goto fail;
+
+	edev_set_cpl_fc_limits(edev, cplh, 0);
+
+	ret = edev_cpl_budget_bsearch(edev, 1, cpld_max, true, &cpld);
+	if (ret)
+		goto fail;
+
+	edev_set_cpl_fc_limits(edev, cplh, cpld);
+	edev->cpl_budget_valid = true;
+
+	dev_info(edev->dev, "completion credit limits: CPLH %u, CPLD %u", cplh, cpld);
+
+	return 0;
+
+fail:
+	dev_warn(edev->dev, "completion credit limit search failed (%d), keeping CPLH %u, CPLD %u",
+			ret, cplh_prev, cpld_prev);
+	edev_set_cpl_fc_limits(edev, cplh_prev, cpld_prev);
+	return ret;
+}
+
+static void dma_ring_read_bench(struct example_channel *ch,
+		dma_addr_t dma_addr, u64 size, u64 count, int batch, bool push)
+{
+	struct example_dev *edev = ch->edev;
+	struct example_ring *ring = &ch->read_ring;
+	unsigned long t;
+	u64 cycles, ns;
+	u32 rd_req;
+	u32 rd_cpl;
+	u64 k;
+	int n = 0;
+
+	udelay(5);
+
+	rd_req = ioread32(ch->hw_addr + 0x000020);
+	rd_cpl = ioread32(ch->hw_addr + 0x000024);
+	cycles = edev_read64(ch->hw_addr + EDEV_REG_CYCLE_COUNT);
+
+	t = jiffies + msecs_to_jiffies(20000);
+	for (k = 0; k < count; k++) {
+		while (push ?
+				edev_ring_push(ring, dma_addr + ((k * size) & (edev->dma_region_len - 1)),
+					(k * size) & (EDEV_CARD_RAM_SIZE - 1), size, k, 0) :
+				edev_ring_enqueue(ring, dma_addr + ((k * size) & (edev->dma_region_len - 1)),
+					(k * size) & (EDEV_CARD_RAM_SIZE - 1), size, k, 0)) {
+			if (push)
+				edev_ring_push_flush(ring);
+			else
+				edev_ring_doorbell(ring);
+			n = 0;
+			if (time_after(jiffies, t)) {
+				dev_warn(edev->dev, "%s: ring full timeout", __func__);
+				return;
+			}
+		}
+
+		if (++n >= batch) {
+			if (push)
+				edev_ring_push_flush(ring);
+			else
+				edev_ring_doorbell(ring);
+			n = 0;
+		}
+	}
+
+	if (push)
+		edev_ring_push_flush(ring);
+	else
+		edev_ring_doorbell(ring);
+	if (edev_ring_wait(edev, ring, 20000))
+		return;
+
+	ns = max_t(u64, edev_cycles_to_ns(edev, edev_read64(ch->hw_addr + EDEV_REG_CYCLE_COUNT) - cycles), 1);
+
+	udelay(5);
+
+	rd_req = ioread32(ch->hw_addr + 0x000020) - rd_req;
+	rd_cpl = ioread32(ch->hw_addr + 0x000024) - rd_cpl;
+
+	dev_info(edev->dev, "ring %sread %lld blocks of %lld bytes (total %lld B, batch %d) in %lld ns (%d req %d cpl): %lld Mbps",
+			push ? "push " : "", count, size, count*size, batch, ns, rd_req, rd_cpl, div64_u64(size * count * 8 * 1000, ns));
+}
+
+static void dma_ring_write_bench(struct example_channel *ch,
+		dma_addr_t dma_addr, u64 size, u64 count, int batch, bool push)
+{
+	struct example_dev *edev = ch->edev;
+	struct example_ring *ring = &ch->write_ring;
+	unsigned long t;
+	u64 cycles, ns;
+	u32 wr_req;
+	u64 k;
+	int n = 0;
+
+	udelay(5);
+
+	wr_req = ioread32(ch->hw_addr + 0x000028);
+	cycles = edev_read64(ch->hw_addr + EDEV_REG_CYCLE_COUNT);
+
+	t = jiffies + msecs_to_jiffies(20000);
+	for (k = 0; k < count; k++) {
+		while (push ?
+				edev_ring_push(ring, dma_addr + ((k * size) & (edev->dma_region_len - 1)),
+					(k * size) & (EDEV_CARD_RAM_SIZE - 1), size, k, 0) :
+				edev_ring_enqueue(ring, dma_addr + ((k * size) & (edev->dma_region_len - 1)),
+					(k * size) & (EDEV_CARD_RAM_SIZE - 1), size, k, 0)) {
+			if (push)
+				edev_ring_push_flush(ring);
+			else
+				edev_ring_doorbell(ring);
+			n = 0;
+			if (time_after(jiffies, t)) {
+				dev_warn(edev->dev, "%s: ring full timeout", __func__);
+				return;
+			}
+		}
+
+		if (++n >= batch) {
+			if (push)
+				edev_ring_push_flush(ring);
+			else
+				edev_ring_doorbell(ring);
+			n = 0;
+		}
+	}
+
+	if (push)
+		edev_ring_push_flush(ring);
+	else
+		edev_ring_doorbell(ring);
+	if (edev_ring_wait(edev, ring, 20000))
+		return;
+
+	ns = max_t(u64, edev_cycles_to_ns(edev, edev_read64(ch->hw_addr + EDEV_REG_CYCLE_COUNT) - cycles), 1);
+
+	udelay(5);
+
+	wr_req = ioread32(ch->hw_addr + 0x000028) - wr_req;
+
+	dev_info(edev->dev, "ring %swrote %lld blocks of %lld bytes (total %lld B, batch %d) in %lld ns (%d req): %lld Mbps",
+			push ? "push " : "", count, size, count*size, batch, ns, wr_req, div64_u64(size * count * 8 * 1000, ns));
+}
+
+static int dma_ring_copy_test(struct example_channel *ch)
+{
+	struct example_dev *edev = ch->edev;
+	struct device *dev = edev->dev;
+	int k;
+
+	dev_info(dev, "write ring test data");
+	for (k = 0; k < 1024; k++)
+		((char *)edev->dma_region)[0x0400 + k] = k ^ 0x5a;
+	memset(edev->dma_region + 0x0800, 0, 1024);
+
+	dev_info(dev, "start ring copy to card");
+	for (k = 0; k < 4; k++)
+		edev_ring_enqueue(&ch->read_ring, edev->dma_region_addr + 0x0400 + k*256,
+				0x1000 + k*256, 256, k, 0);
+	edev_ring_doorbell(&ch->read_ring);
+
+	if (edev_ring_wait(edev, &ch->read_ring, 1000))
+		return -EIO;
+
+	dev_info(dev, "start ring copy to host");
+	for (k = 0; k < 4; k++)
+		edev_ring_enqueue(&ch->write_ring, edev->dma_region_addr + 0x0800 + k*256,
+				0x1000 + k*256, 256, k, 0);
+	edev_ring_doorbell(&ch->write_ring);
+
+	if (edev_ring_wait(edev, &ch->write_ring, 1000))
+		return -EIO;
+
+	if (memcmp(edev->dma_region + 0x0400, edev->dma_region + 0x0800, 1024) == 0) {
+		dev_info(dev, "ring test data matches");
+	} else {
+		dev_warn(dev, "ring test data mismatch");
+		return -EIO;
+	}
+
+	return 0;
+}
+
+static int edev_self_test(struct example_channel *ch)
+{
+	struct example_dev *edev = ch->edev;
+	struct device *dev = edev->dev;
+	int mismatch = 0;
+	int k;
+
+	// Read/write test
+	dev_info(dev, "write to BAR2");
+	iowrite32(0x11223344, edev->bar[2]);
+
+	dev_info(dev, "read from BAR2");
+	dev_info(dev, "%08x", ioread32(edev->bar[2]));
+
+	// PCIe DMA test
+	dev_info(dev, "write test data");
+	for (k = 0; k < 256; k++)
+		((char *)edev->dma_region)[k] = k;
+
+	dev_info(dev, "read test data");
+	print_hex_dump(KERN_INFO, "", DUMP_PREFIX_NONE, 16, 1,
+			edev->dma_region, 256, true);
+
+	dev_info(dev, "check DMA enable");
+	dev_info(dev, "%08x", ioread32(ch->hw_addr + 0x000000));
+
+	dev_info(dev, "start copy to card");
+	iowrite32((edev->dma_region_addr + 0x0000) & 0xffffffff, ch->hw_addr + 0x000100);
+	iowrite32(((edev->dma_region_addr + 0x0000) >> 32) & 0xffffffff, ch->hw_addr + 0x000104);
+	iowrite32(0x100, ch->hw_addr + 0x000108);
+	iowrite32(0, ch->hw_addr + 0x00010C);  // This seems unnecessary, it will be ignored by the hardware.
+	iowrite32(0x100, ch->hw_addr + 0x000110);
+	reinit_completion(&ch->dma_read_cpl);
+	iowrite32(0xAA, ch->hw_addr + 0x000114);
+
+	if (!wait_for_completion_timeout(&ch->dma_read_cpl, msecs_to_jiffies(1000)))
+		dev_warn(dev, "timed out waiting for read completion");
+
+	dev_info(dev, "Read status");
+	dev_info(dev, "%08x", ioread32(ch->hw_addr + 0x000000));
+	dev_info(dev, "%08x", ioread32(ch->hw_addr + 0x000118));
+
+	dev_info(dev, "start copy to host");
+	iowrite32((edev->dma_region_addr + 0x0200) & 0xffffffff, ch->hw_addr + 0x000200);
+	iowrite32(((edev->dma_region_addr + 0x0200) >> 32) & 0xffffffff, ch->hw_addr + 0x000204);
+	iowrite32(0x100, ch->hw_addr + 0x000208);
+	iowrite32(0, ch->hw_addr + 0x00020C);
+	iowrite32(0x100, ch->hw_addr + 0x000210);
+	reinit_completion(&ch->dma_write_cpl);
+	iowrite32(0x55, ch->hw_addr + 0x000214);
+
+	if (!wait_for_completion_timeout(&ch->dma_write_cpl, msecs_to_jiffies(1000)))
+		dev_warn(dev, "timed out waiting for write completion");
+
+	dev_info(dev, "Read status");
+	dev_info(dev, "%08x", ioread32(ch->hw_addr + 0x000000));
+	dev_info(dev, "%08x", ioread32(ch->hw_addr + 0x000218));
+
+	dev_info(dev, "read test data");
+	print_hex_dump(KERN_INFO, "", DUMP_PREFIX_NONE, 16, 1,
+			edev->dma_region + 0x0200, 256, true);
+
+	if (memcmp(edev->dma_region + 0x0000, edev->dma_region + 0x0200, 256) == 0) {
+		dev_info(dev, "test data matches");
+	} else {
+		dev_warn(dev, "test data mismatch");
+		mismatch = 1;
+	}
+
+	dev_info(dev, "start immediate write to host");
+	iowrite32((edev->dma_region_addr + 0x0200) & 0xffffffff, ch->hw_addr + 0x000200);
+	iowrite32(((edev->dma_region_addr + 0x0200) >> 32) & 0xffffffff, ch->hw_addr + 0x000204);
+	iowrite32(0x44332211, ch->hw_addr + 0x000208);
+	iowrite32(0, ch->hw_addr + 0x00020C);
+	iowrite32(0x4, ch->hw_addr + 0x000210);
+	reinit_completion(&ch->dma_write_cpl);
+	iowrite32(0x800000AA, ch->hw_addr + 0x000214);
+
+	if (!wait_for_completion_timeout(&ch->dma_write_cpl, msecs_to_jiffies(1000)))
+		dev_warn(dev, "timed out waiting for write completion");
+
+	dev_info(dev, "Read status");
+	dev_info(dev, "%08x", ioread32(ch->hw_addr + 0x000000));
+	dev_info(dev, "%08x", ioread32(ch->hw_addr + 0x000218));
+
+	dev_info(dev, "read data");
+	print_hex_dump(KERN_INFO, "", DUMP_PREFIX_NONE, 16, 1,
+			edev->dma_region + 0x0200, 4, true);
+
+	if (ch->cq.buf) {
+		u32 rec;
+
+		dev_info(dev, "check completion record");
+		if (edev_cq_wait_single(&ch->cq, 1, 0xAA, &rec, 1000)) {
+			dev_warn(dev, "timed out waiting for completion record");
+			mismatch = 1;
+		} else {
+			dev_info(dev, "%08x (timestamp %u)", rec, rec >> EDEV_CQ_REC_TS_SHIFT);
+			if (rec & EDEV_CQ_REC_ERROR_MASK)
+				mismatch = 1;
+		}
+	}
+
+	if (!mismatch && dma_ring_copy_test(ch))
+		mismatch = 1;
+
+	return mismatch ? -EIO : 0;
+}
+
+static void edev_benchmarks(struct example_dev *edev)
+{
+	struct example_channel *ch = &edev->ch[0];
+	struct device *dev = edev->dev;
+	struct edev_mmio_lat_params lat_params = {
+		.mode = EDEV_MMIO_LAT_READ,
+		.bar = 2,
+		.offset = 0,
+		.samples = 100000,
+	};
+	u64 size;
+	u64 stride;
+	u64 count;
+	int ret;
+
+	// MMIO read latency distribution (re-run via debugfs mmio_lat)
+	ret = edev_mmio_lat_run(edev, &lat_params, &edev->mmio_lat);
+	if (ret) {
+		dev_warn(dev, "MMIO latency test failed: %d", ret);
+	} else {
+		dev_info(dev, "BAR2 read latency (ns, %u samples): min %llu p50 %llu p99 %llu p99.9 %llu max %llu",
+				lat_params.samples, edev->mmio_lat.min_ns, edev->mmio_lat.pctl_ns[0],
+				edev->mmio_lat.pctl_ns[2], edev->mmio_lat.pctl_ns[3], edev->mmio_lat.max_ns);
+		dev_info(dev, "BAR2 read latency outliers: %u above %llu ns",
+				edev->mmio_lat.outlier_count, edev->mmio_lat.outlier_threshold_ns);
+	}
+
+	dev_info(dev, "test RX completion buffer (CPLH, 8)");
+
+	size = 8;
+	stride = size;
+	for (count = 32; count <= 256; count += 8) {
+		dma_cpl_buf_test(ch,
+				edev->dma_region_addr + 0x0000,
+				size, stride, count, 100000);
+		if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+			return;
+	}
+
+	dev_info(dev, "test RX completion buffer (CPLH, unaligned 8+64)");
+
+	size = 8+64;
+	stride = 0;
+	for (count = 8; count <= 256; count += 8) {
+		dma_cpl_buf_test(ch,
+				edev->dma_region_addr + 128 - 8,
+				size, stride, count, 400000);
+		if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+			return;
+	}
+
+	dev_info(dev, "test RX completion buffer (CPLH, unaligned 8+128+8)");
+
+	size = 8+128+8;
+	stride = 0;
+	for (count = 8; count <= 256; count += 8) {
+		dma_cpl_buf_test(ch,
+				edev->dma_region_addr + 128 - 8,
+				size, stride, count, 100000);
+		if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+			return;
+	}
+
+	dev_info(dev, "test RX completion buffer (CPLD)");
+
+	size = 512;
+	stride = size;
+	for (count = 8; count <= 256; count += 8) {
+		dma_cpl_buf_test(ch,
+				edev->dma_region_addr + 0x0000,
+				size, stride, count, 100000);
+		if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+			return;
+	}
+
+	dev_info(dev, "perform block reads (dma_alloc_coherent)");
+
+	count = 10000;
+	for (size = 1; size <= 8192; size *= 2) {
+		for (stride = size; stride <= max(size, 256llu); stride *= 2) {
+			dma_block_read_bench(ch,
+					edev->dma_region_addr + 0x0000,
+					size, stride, count);
+			if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+				return;
+		}
+	}
+
+	dev_info(dev, "perform block writes (dma_alloc_coherent)");
+
+	count = 10000;
+	for (size = 1; size <= 8192; size *= 2) {
+		for (stride = size; stride <= max(size, 256llu); stride *= 2) {
+			dma_block_write_bench(ch,
+					edev->dma_region_addr + 0x0000,
+					size, stride, count);
+			if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+				return;
+		}
+	}
+
+	dev_info(dev, "perform full-duplex block reads and writes (dma_alloc_coherent)");
+
+	count = 10000;
+	for (size = 64; size <= 8192; size *= 2) {
+		dma_block_duplex_bench(ch,
+				edev->dma_region_addr + 0x0000,
+				size, size, count);
+		if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+			return;
+	}
+
+	dev_info(dev, "perform ring reads (dma_alloc_coherent)");
+
+	count = 10000;
+	for (size = 64; size <= 8192; size *= 2) {
+		dma_ring_read_bench(ch,
+				edev->dma_region_addr + 0x0000,
+				size, count, 32, false);
+		if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+			return;
+	}
+
+	if (ch->desc_push) {
+		dev_info(dev, "perform ring reads via descriptor push (%s)",
+				ch->desc_push_wc ? "write-combined" : "uncached");
+
+		count = 10000;
+		for (size = 64; size <= 8192; size *= 2) {
+			dma_ring_read_bench(ch,
+					edev->dma_region_addr + 0x0000,
+					size, count, EDEV_DESC_PUSH_SLOTS, true);
+			if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+				return;
+		}
+	}
+
+	dev_info(dev, "perform ring writes (dma_alloc_coherent)");
+
+	count = 10000;
+	for (size = 64; size <= 8192; size *= 2) {
+		dma_ring_write_bench(ch,
+				edev->dma_region_addr + 0x0000,
+				size, count, 32, false);
+		if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+			return;
+	}
+
+	if (ch->desc_push) {
+		dev_info(dev, "perform ring writes via descriptor push (%s)",
+				ch->desc_push_wc ? "write-combined" : "uncached");
+
+		count = 10000;
+		for (size = 64; size <= 8192; size *= 2) {
+			dma_ring_write_bench(ch,
+					edev->dma_region_addr + 0x0000,
+					size, count, EDEV_DESC_PUSH_SLOTS, true);
+			if ((ioread32(ch->hw_addr + 0x000000) & 0x300) != 0)
+				return;
+		}
+	}
+}
+
+int edev_run_tests(struct example_dev *edev, unsigned int flags)
+{
+	int ret = 0;
+	int k;
+
+	mutex_lock(&edev->dma_lock);
+
+	for (k = 0; k < edev->num_channels && !ret && (flags & EDEV_TEST_SELF); k++) {
+		dev_info(edev->dev, "self-test on DMA channel %d", k);
+		mutex_lock(&edev->ch[k].lock);
+		ret = edev_stream_check_idle(&edev->stream, &edev->ch[k]);
+		if (!ret)
+			ret = edev_self_test(&edev->ch[k]);
+		mutex_unlock(&edev->ch[k].lock);
+	}
+
+	if (!ret && (flags & EDEV_TEST_CPL_BUDGET)) {
+		mutex_lock(&edev->ch[0].lock);
+		ret = edev_stream_check_idle(&edev->stream, &edev->ch[0]);
+		if (!ret)
+			ret = edev_cpl_budget_search(edev);
+		mutex_unlock(&edev->ch[0].lock);
+	}
+
+	if (!ret && (flags & EDEV_TEST_BENCH)) {
+		mutex_lock(&edev->ch[0].lock);
+		ret = edev_stream_check_idle(&edev->stream, &edev->ch[0]);
+		if (!ret)
+			edev_benchmarks(edev);
+		mutex_unlock(&edev->ch[0].lock);
+	}
+
+	mutex_unlock(&edev->dma_lock);
+
+	for (k = 0; k < edev->num_channels; k++) {
+		dev_info(edev->dev, "Read status (channel %d)", k);
+		dev_info(edev->dev, "%08x", ioread32(edev->ch[k].hw_addr + 0x000000));
+	}
+
+	return ret;
+}
+
+// DMA channel for requests submitted from the current CPU
+struct example_channel *edev_get_channel(struct example_dev *edev)
+{
+	return &edev->ch[raw_smp_processor_id() % edev->num_channels];
+}
+
+static void edev_test_work(struct work_struct *work)
+{
+	struct example_dev *edev = container_of(work, struct example_dev, test_work);
+
+	edev_run_tests(edev, test_on_load);
+}
+
+static irqreturn_t edev_intr(int irq, void *data)
+{
+	struct example_dev *edev = data;
+	int k;
+
+	edev->irqcount++;
+
+	// wake up waiters (vectors may be shared between channels)
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
+
+		if (irq == ch->rd_irq)
+			complete(&ch->dma_read_cpl);
+		if (irq == ch->wr_irq)
+			complete(&ch->dma_write_cpl);
+	}
+
+	return IRQ_HANDLED;
+}
+
+static void edev_set_irq_affinity(struct example_dev *edev, bool enable)
+{
+	int node = dev_to_node(edev->dev);
+	const struct cpumask *mask = NULL;
+	int k;
+
+	if (enable) {
+		// keep completion handling on the CPUs local to the device
+		if (node == NUMA_NO_NODE || cpumask_empty(cpumask_of_node(node)))
+			return;
+
+		mask = cpumask_of_node(node);
+	}
+
+	for (k = 0; k < edev->num_irqs_used; k++)
+		irq_set_affinity_hint(pci_irq_vector(edev->pdev, k), mask);
+
+	if (enable)
+		dev_info(edev->dev, "Completion IRQs affine to node %d (CPUs %*pbl)",
+				node, cpumask_pr_args(mask));
+}
+
+static void edev_free_irqs(struct example_dev *edev)
+{
+	edev_set_irq_affinity(edev, false);
+
+	while (edev->num_irqs_used > 0)
+		pci_free_irq(edev->pdev, --edev->num_irqs_used, edev);
+}
+
+static int edev_request_irqs(struct example_dev *edev)
+{
+	struct pci_dev *pdev = edev->pdev;
+	int count;
+	int ret;
+	int k;
+
+	// separate read and write vectors per channel if there are enough,
+	// otherwise one vector per channel, shared round-robin if necessary
+	if (edev->num_irqs >= edev->num_channels * 2)
+		count = edev->num_channels * 2;
+	else
+		count = min(edev->num_irqs, edev->num_channels);
+
+	for (k = 0; k < count; k++) {
+		ret = pci_request_irq(pdev, k, edev_intr, 0, edev, DRIVER_NAME);
+		if (ret < 0) {
+			dev_err(edev->dev, "Failed to request IRQ");
+			edev_free_irqs(edev);
+			return ret;
+		}
+		edev->num_irqs_used++;
+	}
+
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
+		int rd_vec, wr_vec;
+
+		if (count >= edev->num_channels * 2) {
+			rd_vec = k * 2;
+			wr_vec = k * 2 + 1;
+		} else {
+			rd_vec = k % count;
+			wr_vec = rd_vec;
+		}
+
+		ch->rd_irq = pci_irq_vector(pdev, rd_vec);
+		ch->wr_irq = pci_irq_vector(pdev, wr_vec);
+
+		// Select interrupt vectors for read and write completions
+		iowrite32((wr_vec << 8) | rd_vec, ch->hw_addr + 0x00000c);
+	}
+
+	dev_info(edev->dev, "Using %d IRQ vector(s) for %d DMA channel(s)",
+			count, edev->num_channels);
+
+	edev_set_irq_affinity(edev, true);
+
+	return 0;
+}
+
+void edev_set_irq_mod(struct example_channel *ch, int write, u32 count, u32 time_us)
+{
+	struct example_irq_mod *mod = &ch->irq_mod[write];
 
-static const struct pci_device_id pci_ids[] = {
-	{PCI_DEVICE(0x1234, 0x0001)},
-	{0 /* end */ }
-};
+	mod->count = min_t(u32, count, EDEV_IRQ_MOD_MAX);
+	mod->time_us = min_t(u32, time_us, EDEV_IRQ_MOD_MAX);
 
-MODULE_DEVICE_TABLE(pci, pci_ids);
+	iowrite32((mod->time_us << 16) | mod->count,
+			ch->hw_addr + EDEV_REG_IRQ_MOD + write * 4);
+}
 
-static void dma_block_read(struct example_dev *edev,
-		dma_addr_t dma_addr, size_t dma_offset,
-		size_t dma_offset_mask, size_t dma_stride,
-		size_t ram_addr, size_t ram_offset,
-		size_t ram_offset_mask, size_t ram_stride,
-		size_t block_len, size_t block_count)
+void edev_set_irq_min_interval(struct example_dev *edev, u32 time_us)
 {
-	unsigned long t;
+	edev->irq_min_interval_us = min_t(u32, time_us, EDEV_IRQ_MOD_MAX);
 
-	// DMA base address
-	iowrite32(dma_addr & 0xffffffff, edev->bar[0] + 0x001080);
-	iowrite32((dma_addr >> 32) & 0xffffffff, edev->bar[0] + 0x001084);
-	// DMA offset address
-	iowrite32(dma_offset & 0xffffffff, edev->bar[0] + 0x001088);
-	iowrite32((dma_offset >> 32) & 0xffffffff, edev->bar[0] + 0x00108c);
-	// DMA offset mask
-	iowrite32(dma_offset_mask & 0xffffffff, edev->bar[0] + 0x001090);
-	iowrite32((dma_offset_mask >> 32) & 0xffffffff, edev->bar[0] + 0x001094);
-	// DMA stride
-	iowrite32(dma_stride & 0xffffffff, edev->bar[0] + 0x001098);
-	iowrite32((dma_stride >> 32) & 0xffffffff, edev->bar[0] + 0x00109c);
-	// RAM base address
-	iowrite32(ram_addr & 0xffffffff, edev->bar[0] + 0x0010c0);
-	iowrite32((ram_addr >> 32) & 0xffffffff, edev->bar[0] + 0x0010c4);
-	// RAM offset address
-	iowrite32(ram_offset & 0xffffffff, edev->bar[0] + 0x0010c8);
-	iowrite32((ram_offset >> 32) & 0xffffffff, edev->bar[0] + 0x0010cc);
-	// RAM offset mask
-	iowrite32(ram_offset_mask & 0xffffffff, edev->bar[0] + 0x0010d0);
-	iowrite32((ram_offset_mask >> 32) & 0xffffffff, edev->bar[0] + 0x0010d4);
-	// RAM stride
-	iowrite32(ram_stride & 0xffffffff, edev->bar[0] + 0x0010d8);
-	iowrite32((ram_stride >> 32) & 0xffffffff, edev->bar[0] + 0x0010dc);
-	// clear cycle count
-	iowrite32(0, edev->bar[0] + 0x001008);
-	iowrite32(0, edev->bar[0] + 0x00100c);
-	// block length
-	iowrite32(block_len, edev->bar[0] + 0x001010);
-	// block count
-	iowrite32(block_count, edev->bar[0] + 0x001018);
-	// start
-	iowrite32(1, edev->bar[0] + 0x001000);
+	// shared rate limiter in front of the MSI-X block
+	iowrite32(edev->irq_min_interval_us, edev->ch[0].hw_addr + EDEV_REG_IRQ_MIN_INTERVAL);
+}
 
-	// wait for transfer to complete
-	t = jiffies + msecs_to_jiffies(20000);
-	while (time_before(jiffies, t)) {
-		if ((ioread32(edev->bar[0] + 0x001000) & 1) == 0)
-			break;
+// pick count and time thresholds from the completion event rate
+static void edev_irq_mod_adapt(struct example_channel *ch, int write)
+{
+	struct example_irq_mod *mod = &ch->irq_mod[write];
+	u32 events = ioread32(ch->hw_addr + EDEV_REG_IRQ_EVENT_COUNT + write * 8);
+	u64 rate = (u64)(events - mod->last_events) * MSEC_PER_SEC / EDEV_IRQ_MOD_ADAPT_INTERVAL_MS;
+	u32 count = 0, time_us = 0;
+
+	mod->last_events = events;
+
+	// low rates keep one interrupt per event for the lowest latency
+	if (rate > EDEV_IRQ_MOD_ADAPT_TARGET_RATE) {
+		count = min_t(u64, DIV_ROUND_UP_ULL(rate, EDEV_IRQ_MOD_ADAPT_TARGET_RATE),
+				EDEV_IRQ_MOD_ADAPT_MAX_COUNT);
+		time_us = EDEV_IRQ_MOD_ADAPT_TIME_US;
 	}
 
-	if ((ioread32(edev->bar[0] + 0x001000) & 1) != 0)
-		dev_warn(edev->dev, "%s: operation timed out", __func__);
-	if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-		dev_warn(edev->dev, "%s: DMA engine busy", __func__);
+	if (count != mod->count || time_us != mod->time_us)
+		edev_set_irq_mod(ch, write, count, time_us);
 }
 
-static void dma_block_write(struct example_dev *edev,
-		dma_addr_t dma_addr, size_t dma_offset,
-		size_t dma_offset_mask, size_t dma_stride,
-		size_t ram_addr, size_t ram_offset,
-		size_t ram_offset_mask, size_t ram_stride,
-		size_t block_len, size_t block_count)
+static void edev_irq_mod_work(struct work_struct *work)
 {
-	unsigned long t;
+	struct example_dev *edev = container_of(to_delayed_work(work),
+			struct example_dev, irq_mod_work);
+	int k;
 
-	// DMA base address
-	iowrite32(dma_addr & 0xffffffff, edev->bar[0] + 0x001180);
-	iowrite32((dma_addr >> 32) & 0xffffffff, edev->bar[0] + 0x001184);
-	// DMA offset address
-	iowrite32(dma_offset & 0xffffffff, edev->bar[0] + 0x001188);
-	iowrite32((dma_offset >> 32) & 0xffffffff, edev->bar[0] + 0x00118c);
-	// DMA offset mask
-	iowrite32(dma_offset_mask & 0xffffffff, edev->bar[0] + 0x001190);
-	iowrite32((dma_offset_mask >> 32) & 0xffffffff, edev->bar[0] + 0x001194);
-	// DMA stride
-	iowrite32(dma_stride & 0xffffffff, edev->bar[0] + 0x001198);
-	iowrite32((dma_stride >> 32) & 0xffffffff, edev->bar[0] + 0x00119c);
-	// RAM base address
-	iowrite32(ram_addr & 0xffffffff, edev->bar[0] + 0x0011c0);
-	iowrite32((ram_addr >> 32) & 0xffffffff, edev->bar[0] + 0x0011c4);
-	// RAM offset address
-	iowrite32(ram_offset & 0xffffffff, edev->bar[0] + 0x0011c8);
-	iowrite32((ram_offset >> 32) & 0xffffffff, edev->bar[0] + 0x0011cc);
-	// RAM offset mask
-	iowrite32(ram_offset_mask & 0xffffffff, edev->bar[0] + 0x0011d0);
-	iowrite32((ram_offset_mask >> 32) & 0xffffffff, edev->bar[0] + 0x0011d4);
-	// RAM stride
-	iowrite32(ram_stride & 0xffffffff, edev->bar[0] + 0x0011d8);
-	iowrite32((ram_stride >> 32) & 0xffffffff, edev->bar[0] + 0x0011dc);
-	// clear cycle count
-	iowrite32(0, edev->bar[0] + 0x001108);
-	iowrite32(0, edev->bar[0] + 0x00110c);
-	// block length
-	iowrite32(block_len, edev->bar[0] + 0x001110);
-	// block count
-	iowrite32(block_count, edev->bar[0] + 0x001118);
-	// start
-	iowrite32(1, edev->bar[0] + 0x001100);
+	mutex_lock(&edev->irq_mod_lock);
 
-	// wait for transfer to complete
-	t = jiffies + msecs_to_jiffies(20000);
-	while (time_before(jiffies, t)) {
-		if ((ioread32(edev->bar[0] + 0x001100) & 1) == 0)
-			break;
+	if (edev->irq_mod_adaptive) {
+		for (k = 0; k < edev->num_channels; k++) {
+			edev_irq_mod_adapt(&edev->ch[k], 0);
+			edev_irq_mod_adapt(&edev->ch[k], 1);
+		}
+
+		schedule_delayed_work(&edev->irq_mod_work,
+				msecs_to_jiffies(EDEV_IRQ_MOD_ADAPT_INTERVAL_MS));
 	}
 
-	if ((ioread32(edev->bar[0] + 0x001100) & 1) != 0)
-		dev_warn(edev->dev, "%s: operation timed out", __func__);
-	if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-		dev_warn(edev->dev, "%s: DMA engine busy", __func__);
+	mutex_unlock(&edev->irq_mod_lock);
 }
 
-static void dma_block_read_bench(struct example_dev *edev,
-		dma_addr_t dma_addr, u64 size, u64 stride, u64 count)
+// called with irq_mod_lock held
+void edev_set_irq_mod_adaptive(struct example_dev *edev, bool enable)
 {
-	u64 cycles;
-	u32 rd_req;
-	u32 rd_cpl;
+	int k;
 
-	udelay(5);
+	if (enable == edev->irq_mod_adaptive)
+		return;
 
-	rd_req = ioread32(edev->bar[0] + 0x000020);
-	rd_cpl = ioread32(edev->bar[0] + 0x000024);
+	edev->irq_mod_adaptive = enable;
 
-	dma_block_read(edev, dma_addr, 0, 0x3fff, stride,
-			0, 0, 0x3fff, stride, size, count);
+	if (!enable)
+		return;
 
-	cycles = ioread32(edev->bar[0] + 0x001008);
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
 
-	udelay(5);
+		ch->irq_mod[0].last_events = ioread32(ch->hw_addr + EDEV_REG_IRQ_EVENT_COUNT);
+		ch->irq_mod[1].last_events = ioread32(ch->hw_addr + EDEV_REG_IRQ_EVENT_COUNT + 8);
+	}
 
-	rd_req = ioread32(edev->bar[0] + 0x000020) - rd_req;
-	rd_cpl = ioread32(edev->bar[0] + 0x000024) - rd_cpl;
+	schedule_delayed_work(&edev->irq_mod_work,
+			msecs_to_jiffies(EDEV_IRQ_MOD_ADAPT_INTERVAL_MS));
+}
 
-	dev_info(edev->dev, "read %lld blocks of %lld bytes (total %lld B, stride %lld) in %lld ns (%d req %d cpl): %lld Mbps",
-			count, size, count*size, stride, cycles * 4, rd_req, rd_cpl, size * count * 8 * 1000 / (cycles * 4));
+// Use the clock frequency reported by the card, checked against the cycle
+// counter over a short sleep; older designs report 0 and a design built
+// with the wrong frequency would skew every rate, so fall back to the
+// measured value in both cases.
+static void edev_init_clk_freq(struct example_dev *edev)
+{
+	void __iomem *counter = edev->ch[0].hw_addr + EDEV_REG_CYCLE_COUNT;
+	u32 reported = ioread32(edev->ch[0].hw_addr + EDEV_REG_CLK_FREQ);
+	u64 cycles, ns;
+	u32 measured;
+
+	cycles = edev_read64(counter);
+	ns = ktime_get_ns();
+	msleep(EDEV_CLK_FREQ_CAL_MS);
+	cycles = edev_read64(counter) - cycles;
+	ns = ktime_get_ns() - ns;
+
+	measured = div64_u64(cycles * USEC_PER_SEC, ns);
+
+	if (!reported) {
+		edev->clk_freq_khz = measured;
+	} else if (abs((s64)measured - reported) * 100 > (s64)reported * EDEV_CLK_FREQ_TOLERANCE_PCT) {
+		dev_warn(edev->dev, "Core clock reported as %u kHz, measured %u kHz, using measured value",
+				reported, measured);
+		edev->clk_freq_khz = measured;
+	} else {
+		edev->clk_freq_khz = reported;
+	}
+
+	// a stopped counter would divide by zero later on
+	if (!edev->clk_freq_khz)
+		edev->clk_freq_khz = 1;
+
+	dev_info(edev->dev, "Core clock: %u kHz (%s)", edev->clk_freq_khz,
+			edev->clk_freq_khz == reported ? "reported" : "measured");
 }
 
-static void dma_block_write_bench(struct example_dev *edev,
-		dma_addr_t dma_addr, u64 size, u64 stride, u64 count)
+static void edev_init_irq_mod(struct example_dev *edev)
 {
-	u64 cycles;
-	u32 wr_req;
+	int k;
 
-	udelay(5);
+	mutex_lock(&edev->irq_mod_lock);
 
-	wr_req = ioread32(edev->bar[0] + 0x000028);
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
 
-	dma_block_write(edev, dma_addr, 0, 0x3fff, stride,
-			0, 0, 0x3fff, stride, size, count);
+		// 1 us timer tick
+		iowrite32(DIV_ROUND_UP(edev->clk_freq_khz, 1000) - 1,
+				ch->hw_addr + EDEV_REG_IRQ_PRESCALE);
 
-	cycles = ioread32(edev->bar[0] + 0x001108);
+		edev_set_irq_mod(ch, 0, irq_mod_count, irq_mod_time_us);
+		edev_set_irq_mod(ch, 1, irq_mod_count, irq_mod_time_us);
+	}
 
-	udelay(5);
+	edev_set_irq_min_interval(edev, irq_min_interval_us);
+	edev_set_irq_mod_adaptive(edev, irq_mod_adaptive);
 
-	wr_req = ioread32(edev->bar[0] + 0x000028) - wr_req;
+	mutex_unlock(&edev->irq_mod_lock);
 
-	dev_info(edev->dev, "wrote %lld blocks of %lld bytes (total %lld B, stride %lld) in %lld ns (%d req): %lld Mbps",
-			count, size, count*size, stride, cycles * 4, wr_req, size * count * 8 * 1000 / (cycles * 4));
+	dev_info(edev->dev, "Interrupt moderation: %s, count %u, time %u us, min interval %u us",
+			irq_mod_adaptive ? "adaptive" : "fixed", irq_mod_count,
+			irq_mod_time_us, irq_min_interval_us);
 }
 
-static void dma_cpl_buf_test(struct example_dev *edev, dma_addr_t dma_addr,
-		u64 size, u64 stride, u64 count, int stall)
+static void edev_destroy_rings(struct example_dev *edev)
 {
-	unsigned long t;
-	u64 cycles;
-	u32 rd_req;
-	u32 rd_cpl;
-
-	rd_req = ioread32(edev->bar[0] + 0x000020);
-	rd_cpl = ioread32(edev->bar[0] + 0x000024);
+	int k;
 
-	// DMA base address
-	iowrite32(dma_addr & 0xffffffff, edev->bar[0] + 0x001080);
-	iowrite32((dma_addr >> 32) & 0xffffffff, edev->bar[0] + 0x001084);
-	// DMA offset address
-	iowrite32(0, edev->bar[0] + 0x001088);
-	iowrite32(0, edev->bar[0] + 0x00108c);
-	// DMA offset mask
-	iowrite32(0x3fff, edev->bar[0] + 0x001090);
-	iowrite32(0, edev->bar[0] + 0x001094);
-	// DMA stride
-	iowrite32(stride & 0xffffffff, edev->bar[0] + 0x001098);
-	iowrite32((stride >> 32) & 0xffffffff, edev->bar[0] + 0x00109c);
-	// RAM base address
-	iowrite32(0, edev->bar[0] + 0x0010c0);
-	iowrite32(0, edev->bar[0] + 0x0010c4);
-	// RAM offset address
-	iowrite32(0, edev->bar[0] + 0x0010c8);
-	iowrite32(0, edev->bar[0] + 0x0010cc);
-	// RAM offset mask
-	iowrite32(0x3fff, edev->bar[0] + 0x0010d0);
-	iowrite32(0, edev->bar[0] + 0x0010d4);
-	// RAM stride
-	iowrite32(stride & 0xffffffff, edev->bar[0] + 0x0010d8);
-	iowrite32((stride >> 32) & 0xffffffff, edev->bar[0] + 0x0010dc);
-	// clear cycle count
-	iowrite32(0, edev->bar[0] + 0x001008);
-	iowrite32(0, edev->bar[0] + 0x00100c);
-	// block length
-	iowrite32(size, edev->bar[0] + 0x001010);
-	// block count
-	iowrite32(count, edev->bar[0] + 0x001018);
+	for (k = 0; k < edev->num_channels; k++) {
+		edev_destroy_cq(edev, &edev->ch[k].cq);
+		edev_destroy_ring(edev, &edev->ch[k].write_ring);
+		edev_destroy_ring(edev, &edev->ch[k].read_ring);
+	}
+}
 
-	if (stall)
-		iowrite32(stall, edev->bar[0] + 0x000040);
+// enable extended tags, and 10-bit tags if every bridge up to the root port
+// can complete them (same settings as scripts/pcie_ext_tag.sh and pcie_10b_tag.sh)
+static void edev_configure_tags(struct pci_dev *pdev)
+{
+	struct pci_dev *bridge;
+	u32 devcap;
+	u32 devcap2;
 
-	// start
-	iowrite32(1, edev->bar[0] + 0x001000);
+	if (!pci_is_pcie(pdev))
+		return;
 
-	if (stall)
-		msleep(10);
+	pcie_capability_read_dword(pdev, PCI_EXP_DEVCAP, &devcap);
+	if (devcap & PCI_EXP_DEVCAP_EXT_TAG)
+		pcie_capability_set_word(pdev, PCI_EXP_DEVCTL, PCI_EXP_DEVCTL_EXT_TAG);
 
-	// wait for transfer to complete
-	t = jiffies + msecs_to_jiffies(20000);
-	while (time_before(jiffies, t)) {
-		if ((ioread32(edev->bar[0] + 0x001000) & 1) == 0)
-			break;
-	}
+	pcie_capability_read_dword(pdev, PCI_EXP_DEVCAP2, &devcap2);
+	if (!ten_bit_tags || !(devcap2 & PCI_EXP_DEVCAP2_10BIT_TAG_REQ))
+		goto disable;
 
-	if ((ioread32(edev->bar[0] + 0x001000) & 1) != 0)
-		dev_warn(edev->dev, "%s: operation timed out", __func__);
-	if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-		dev_warn(edev->dev, "%s: DMA engine busy", __func__);
+	for (bridge = pci_upstream_bridge(pdev); bridge; bridge = pci_upstream_bridge(bridge)) {
+		if (!pci_is_pcie(bridge))
+			goto disable;
 
-	cycles = ioread32(edev->bar[0] + 0x001008);
+		pcie_capability_read_dword(bridge, PCI_EXP_DEVCAP2, &devcap2);
+		if (!(devcap2 & PCI_EXP_DEVCAP2_10BIT_TAG_COMP)) {
+			dev_info(&pdev->dev, "10-bit tags not supported by %s", pci_name(bridge));
+			goto disable;
+		}
+	}
 
-	rd_req = ioread32(edev->bar[0] + 0x000020) - rd_req;
-	rd_cpl = ioread32(edev->bar[0] + 0x000024) - rd_cpl;
+	pcie_capability_set_word(pdev, PCI_EXP_DEVCTL2, PCI_EXP_DEVCTL2_10BIT_TAG_REQ_EN);
+	return;
 
-	dev_info(edev->dev, "read %lld x %lld B (total %lld B %lld CPLD, stride %lld) in %lld ns (%d req %d cpl): %lld Mbps",
-			count, size, count*size, count*((size+15) / 16), stride, cycles * 4, rd_req, rd_cpl, size * count * 8 * 1000 / (cycles * 4));
+disable:
+	pcie_capability_clear_word(pdev, PCI_EXP_DEVCTL2, PCI_EXP_DEVCTL2_10BIT_TAG_REQ_EN);
 }
 
-static irqreturn_t edev_intr(int irq, void *data)
+static void edev_free(struct kref *kref)
 {
-	struct example_dev *edev = data;
-	struct device *dev = &edev->pdev->dev;
-
-	edev->irqcount++;
-
-	dev_info(dev, "Interrupt");
+	kfree(container_of(kref, struct example_dev, kref));
+}
 
-	return IRQ_HANDLED;
+void edev_put(struct example_dev *edev)
+{
+	kref_put(&edev->kref, edev_free);
 }
 
 static int edev_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 {
 	int ret = 0;
+	int k;
 	struct example_dev *edev;
 	struct device *dev = &pdev->dev;
 
-	int k;
-	int mismatch = 0;
-
 	dev_info(dev, DRIVER_NAME " probe");
 	dev_info(dev, " Vendor: 0x%04x", pdev->vendor);
 	dev_info(dev, " Device: 0x%04x", pdev->device);
@@ -316,13 +1569,18 @@ static int edev_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 	dev_info(dev, " Class: 0x%06x", pdev->class);
 	dev_info(dev, " PCI ID: %04x:%02x:%02x.%d", pci_domain_nr(pdev->bus),
 			pdev->bus->number, PCI_SLOT(pdev->devfn), PCI_FUNC(pdev->devfn));
+
+	edev_configure_tags(pdev);
+
 	if (pdev->pcie_cap) {
 		u16 devctl;
+		u16 devctl2;
 		u32 lnkcap;
 		u16 lnkctl;
 		u16 lnksta;
 
 		pci_read_config_word(pdev, pdev->pcie_cap + PCI_EXP_DEVCTL, &devctl);
+		pci_read_config_word(pdev, pdev->pcie_cap + PCI_EXP_DEVCTL2, &devctl2);
 		pci_read_config_dword(pdev, pdev->pcie_cap + PCI_EXP_LNKCAP, &lnkcap);
 		pci_read_config_word(pdev, pdev->pcie_cap + PCI_EXP_LNKCTL, &lnkctl);
 		pci_read_config_word(pdev, pdev->pcie_cap + PCI_EXP_LNKSTA, &lnksta);
@@ -343,6 +1601,8 @@ static int edev_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 				devctl & PCI_EXP_DEVCTL_PHANTOM ? "enabled" : "disabled");
 		dev_info(dev, " Extended tags: %s",
 				devctl & PCI_EXP_DEVCTL_EXT_TAG ? "enabled" : "disabled");
+		dev_info(dev, " 10-bit tags: %s",
+				devctl2 & PCI_EXP_DEVCTL2_10BIT_TAG_REQ_EN ? "enabled" : "disabled");
 		dev_info(dev, " No snoop: %s",
 				devctl & PCI_EXP_DEVCTL_NOSNOOP_EN ? "enabled" : "disabled");
 	}
@@ -353,14 +1613,34 @@ static int edev_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 	pcie_print_link_status(pdev);
 #endif
 
-	edev = devm_kzalloc(dev, sizeof(struct example_dev), GFP_KERNEL);
+	// not devm, open files keep it until they are closed
+	edev = kzalloc(sizeof(struct example_dev), GFP_KERNEL);
 	if (!edev)
 		return -ENOMEM;
 
+	kref_init(&edev->kref);
+	init_rwsem(&edev->remove_sem);
+	mutex_init(&edev->files_lock);
+	INIT_LIST_HEAD(&edev->files);
+
 	edev->pdev = pdev;
 	edev->dev = dev;
 	pci_set_drvdata(pdev, edev);
 
+	// Allocate instance ID
+	edev->id = ida_alloc(&edev_instance_ida, GFP_KERNEL);
+	if (edev->id < 0) {
+		ret = edev->id;
+		goto fail_ida;
+	}
+
+	snprintf(edev->name, sizeof(edev->name), DRIVER_NAME "%d", edev->id);
+
+	mutex_init(&edev->dma_lock);
+	INIT_WORK(&edev->test_work, edev_test_work);
+	mutex_init(&edev->irq_mod_lock);
+	INIT_DELAYED_WORK(&edev->irq_mod_work, edev_irq_mod_work);
+
 	// Allocate DMA buffer
 	edev->dma_region_len = 16 * 1024;
 	edev->dma_region = dma_alloc_coherent(dev, edev->dma_region_len,
@@ -370,8 +1650,9 @@ static int edev_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 		goto fail_dma_alloc;
 	}
 
-	dev_info(dev, "Allocated DMA region virt %p, phys %p",
-			edev->dma_region, (void *)edev->dma_region_addr);
+	// coherent allocations are placed on dev_to_node(dev)
+	dev_info(dev, "Allocated DMA region virt %p, phys %p, node %d",
+			edev->dma_region, (void *)edev->dma_region_addr, dev_to_node(dev));
 
 	// Disable ASPM
 	pci_disable_link_state(pdev, PCIE_LINK_STATE_L0S |
@@ -404,222 +1685,125 @@ static int edev_probe(struct pci_dev *pdev, const struct pci_device_id *ent)
 		goto fail_map_bars;
 	}
 
+	// Map DMA channel register windows
+	ret = edev_map_channels(edev);
+	if (ret) {
+		dev_err(dev, "Failed to map DMA channels");
+		goto fail_map_channels;
+	}
+
+	edev_init_clk_freq(edev);
+
 	// Allocate MSI IRQs
 	ret = pci_alloc_irq_vectors(pdev, 1, 32, PCI_IRQ_MSI | PCI_IRQ_MSIX);
 	if (ret < 0) {
 		dev_err(dev, "Failed to allocate IRQs");
-		goto fail_map_bars;
+		goto fail_map_channels;
 	}
 
-	// Set up interrupt
-	ret = pci_request_irq(pdev, 0, edev_intr, 0, edev, DRIVER_NAME);
-	if (ret < 0) {
-		dev_err(dev, "Failed to request IRQ");
-		goto fail_irq;
-	}
+	edev->num_irqs = ret;
 
-	// Read/write test
-	dev_info(dev, "write to BAR2");
-	iowrite32(0x11223344, edev->bar[2]);
+	// Set up interrupts
+	ret = edev_request_irqs(edev);
+	if (ret)
+		goto fail_irq;
 
-	dev_info(dev, "read from BAR2");
-	// fence
-	mb();
-	// Get tsc clock:
-	int ts = rdtsc();
-	int val = ioread32(edev->bar[2]);
-	ts = rdtsc() - ts;
-	mb();
-	dev_info(dev, "%08x", val);
-	dev_info(dev, "TSC clock delta: %d", ts);
-	
-	// Test latency for many reads
-	int nb_reads;
-	for (nb_reads = 1; nb_reads < 100000; nb_reads *= 10) {
-		dev_info(dev, "test latency for %d reads", nb_reads);
-
-		mb();
-		ts = rdtsc();
-		for (k = 0; k < nb_reads; k++) {
-			ioread32(edev->bar[2] + k * 4);
+	// Set up descriptor rings
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
+
+		ret = edev_create_ring(edev, &ch->read_ring, 256,
+				ch->hw_addr + EDEV_REG_READ_RING,
+				ch->desc_push ? ch->desc_push + EDEV_DESC_PUSH_READ : NULL,
+				&ch->dma_read_cpl);
+		if (ret) {
+			dev_err(dev, "Failed to create read descriptor ring");
+			goto fail_rings;
 		}
-		ts = rdtsc() - ts;
-		mb();
-
-		dev_info(dev, "Mean latency for %d reads: %d", nb_reads, ts / nb_reads);
-	}
-
-	// PCIe DMA test
-	dev_info(dev, "write test data");
-	for (k = 0; k < 256; k++)
-		((char *)edev->dma_region)[k] = k;
-
-	dev_info(dev, "read test data");
-	print_hex_dump(KERN_INFO, "", DUMP_PREFIX_NONE, 16, 1,
-			edev->dma_region, 256, true);
-
-	dev_info(dev, "check DMA enable");
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000000));
-
-	dev_info(dev, "enable DMA");
-	iowrite32(0x1, edev->bar[0] + 0x000000);
-
-	dev_info(dev, "check DMA enable");
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000000));
-
-	dev_info(dev, "enable interrupts");
-	iowrite32(0x3, edev->bar[0] + 0x000008);
-
-	dev_info(dev, "start copy to card");
-	iowrite32((edev->dma_region_addr + 0x0000) & 0xffffffff, edev->bar[0] + 0x000100);
-	iowrite32(((edev->dma_region_addr + 0x0000) >> 32) & 0xffffffff, edev->bar[0] + 0x000104);
-	iowrite32(0x100, edev->bar[0] + 0x000108);
-	iowrite32(0, edev->bar[0] + 0x00010C);  // This seems unnecessary, it will be ignored by the hardware.
-	iowrite32(0x100, edev->bar[0] + 0x000110);
-	iowrite32(0xAA, edev->bar[0] + 0x000114);
-
-	msleep(1);
-
-	dev_info(dev, "Read status");
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000000));
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000118));
-
-	dev_info(dev, "start copy to host");
-	iowrite32((edev->dma_region_addr + 0x0200) & 0xffffffff, edev->bar[0] + 0x000200);
-	iowrite32(((edev->dma_region_addr + 0x0200) >> 32) & 0xffffffff, edev->bar[0] + 0x000204);
-	iowrite32(0x100, edev->bar[0] + 0x000208);
-	iowrite32(0, edev->bar[0] + 0x00020C);
-	iowrite32(0x100, edev->bar[0] + 0x000210);
-	iowrite32(0x55, edev->bar[0] + 0x000214);
-
-	msleep(1);
-
-	dev_info(dev, "Read status");
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000000));
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000218));
-
-	dev_info(dev, "read test data");
-	print_hex_dump(KERN_INFO, "", DUMP_PREFIX_NONE, 16, 1,
-			edev->dma_region + 0x0200, 256, true);
-
-	if (memcmp(edev->dma_region + 0x0000, edev->dma_region + 0x0200, 256) == 0) {
-		dev_info(dev, "test data matches");
-	} else {
-		dev_warn(dev, "test data mismatch");
-		mismatch = 1;
-	}
-
-	dev_info(dev, "start immediate write to host");
-	iowrite32((edev->dma_region_addr + 0x0200) & 0xffffffff, edev->bar[0] + 0x000200);
-	iowrite32(((edev->dma_region_addr + 0x0200) >> 32) & 0xffffffff, edev->bar[0] + 0x000204);
-	iowrite32(0x44332211, edev->bar[0] + 0x000208);
-	iowrite32(0, edev->bar[0] + 0x00020C);
-	iowrite32(0x4, edev->bar[0] + 0x000210);
-	iowrite32(0x800000AA, edev->bar[0] + 0x000214);
-
-	msleep(1);
-
-	dev_info(dev, "Read status");
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000000));
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000218));
-
-	dev_info(dev, "read data");
-	print_hex_dump(KERN_INFO, "", DUMP_PREFIX_NONE, 16, 1,
-			edev->dma_region + 0x0200, 4, true);
 
-	if (!mismatch) {
-		u64 size;
-		u64 stride;
-		u64 count;
-
-		dev_info(dev, "disable interrupts");
-		iowrite32(0x0, edev->bar[0] + 0x000008);
-
-		dev_info(dev, "test RX completion buffer (CPLH, 8)");
-
-		size = 8;
-		stride = size;
-		for (count = 32; count <= 256; count += 8) {
-			dma_cpl_buf_test(edev,
-					edev->dma_region_addr + 0x0000,
-					size, stride, count, 100000);
-			if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-				goto out;
+		ret = edev_create_ring(edev, &ch->write_ring, 256,
+				ch->hw_addr + EDEV_REG_WRITE_RING,
+				ch->desc_push ? ch->desc_push + EDEV_DESC_PUSH_WRITE : NULL,
+				&ch->dma_write_cpl);
+		if (ret) {
+			dev_err(dev, "Failed to create write descriptor ring");
+			goto fail_rings;
 		}
 
-		dev_info(dev, "test RX completion buffer (CPLH, unaligned 8+64)");
-
-		size = 8+64;
-		stride = 0;
-		for (count = 8; count <= 256; count += 8) {
-			dma_cpl_buf_test(edev,
-					edev->dma_region_addr + 128 - 8,
-					size, stride, count, 400000);
-			if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-				goto out;
+		// completion records for single and ring operations on this channel
+		ret = edev_create_cq(edev, &ch->cq, 1024,
+				ch->hw_addr + EDEV_REG_CPL_QUEUE,
+				&ch->read_ring, &ch->write_ring);
+		if (ret == -EOPNOTSUPP) {
+			dev_info(dev, "Completion queue not supported, polling registers");
+		} else if (ret) {
+			dev_err(dev, "Failed to create completion queue");
+			goto fail_rings;
 		}
+	}
 
-		dev_info(dev, "test RX completion buffer (CPLH, unaligned 8+128+8)");
-
-		size = 8+128+8;
-		stride = 0;
-		for (count = 8; count <= 256; count += 8) {
-			dma_cpl_buf_test(edev,
-					edev->dma_region_addr + 128 - 8,
-					size, stride, count, 100000);
-			if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-				goto out;
-		}
+	// read()/write() stream through card RAM, on the last channel so it
+	// does not share card RAM with the tests when there is more than one
+	// (with one channel, tests and benchmarks are refused while it is busy)
+	ret = edev_create_stream(edev, &edev->stream, &edev->ch[edev->num_channels - 1]);
+	if (ret) {
+		dev_err(dev, "Failed to allocate stream buffers");
+		goto fail_rings;
+	}
 
-		dev_info(dev, "test RX completion buffer (CPLD)");
+	// Enable DMA and completion interrupts
+	for (k = 0; k < edev->num_channels; k++) {
+		iowrite32(0x1, edev->ch[k].hw_addr + 0x000000);
+		edev->ch[k].int_en = 0x3;
+		iowrite32(edev->ch[k].int_en, edev->ch[k].hw_addr + 0x000008);
+	}
 
-		size = 512;
-		stride = size;
-		for (count = 8; count <= 256; count += 8) {
-			dma_cpl_buf_test(edev,
-					edev->dma_region_addr + 0x0000,
-					size, stride, count, 100000);
-			if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-				goto out;
-		}
+	edev_init_irq_mod(edev);
 
-		dev_info(dev, "perform block reads (dma_alloc_coherent)");
+	// Register user-visible interfaces last, once the device is usable
+	edev->misc_dev.minor = MISC_DYNAMIC_MINOR;
+	edev->misc_dev.name = edev->name;
+	edev->misc_dev.fops = &edev_fops;
+	edev->misc_dev.parent = dev;
 
-		count = 10000;
-		for (size = 1; size <= 8192; size *= 2) {
-			for (stride = size; stride <= max(size, 256llu); stride *= 2) {
-				dma_block_read_bench(edev,
-						edev->dma_region_addr + 0x0000,
-						size, stride, count);
-				if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-					goto out;
-			}
-		}
+	ret = misc_register(&edev->misc_dev);
+	if (ret) {
+		dev_err(dev, "misc_register failed: %d", ret);
+		goto fail_misc;
+	}
 
-		dev_info(dev, "perform block writes (dma_alloc_coherent)");
+	dev_info(dev, "Registered device %s", edev->name);
 
-		count = 10000;
-		for (size = 1; size <= 8192; size *= 2) {
-			for (stride = size; stride <= max(size, 256llu); stride *= 2) {
-				dma_block_write_bench(edev,
-						edev->dma_region_addr + 0x0000,
-						size, stride, count);
-				if ((ioread32(edev->bar[0] + 0x000000) & 0x300) != 0)
-					goto out;
-			}
-		}
-	}
+	edev_debugfs_create(edev);
+	edev_sysfs_create(edev);
 
-out:
-	dev_info(dev, "Read status");
-	dev_info(dev, "%08x", ioread32(edev->bar[0] + 0x000000));
+	// Run self-test and benchmarks in the background
+	if (test_on_load)
+		schedule_work(&edev->test_work);
 
 	// probe complete
 	return 0;
 
 	// error handling
+fail_misc:
+	mutex_lock(&edev->irq_mod_lock);
+	edev->irq_mod_adaptive = false;
+	mutex_unlock(&edev->irq_mod_lock);
+	cancel_delayed_work_sync(&edev->irq_mod_work);
+
+	for (k = 0; k < edev->num_channels; k++) {
+		edev->ch[k].int_en = 0;
+		iowrite32(0, edev->ch[k].hw_addr + 0x000008);
+		iowrite32(0, edev->ch[k].hw_addr + 0x000000);
+	}
+fail_rings:
+	edev_destroy_stream(edev, &edev->stream);
+	edev_destroy_rings(edev);
+	edev_free_irqs(edev);
 fail_irq:
 	pci_free_irq_vectors(pdev);
+fail_map_channels:
+	edev_unmap_channels(edev);
 fail_map_bars:
 	free_bars(edev, pdev);
 	pci_release_regions(pdev);
@@ -629,6 +1813,9 @@ fail_regions:
 fail_enable_device:
 	dma_free_coherent(dev, edev->dma_region_len, edev->dma_region, edev->dma_region_addr);
 fail_dma_alloc:
+	ida_free(&edev_instance_ida, edev->id);
+fail_ida:
+	edev_put(edev);
 	return ret;
 }
 
@@ -639,13 +1826,31 @@ static void edev_remove(struct pci_dev *pdev)
 
 	dev_info(dev, DRIVER_NAME " remove");
 
-	pci_free_irq(pdev, 0, edev);
+	// user-visible interfaces go first so nothing can restart work below
+	edev_sysfs_destroy(edev);
+	edev_debugfs_destroy(edev);
+	misc_deregister(&edev->misc_dev);
+	edev_revoke_files(edev);
+
+	cancel_work_sync(&edev->test_work);
+
+	mutex_lock(&edev->irq_mod_lock);
+	edev->irq_mod_adaptive = false;
+	mutex_unlock(&edev->irq_mod_lock);
+	cancel_delayed_work_sync(&edev->irq_mod_work);
+
+	edev_destroy_stream(edev, &edev->stream);
+	edev_destroy_rings(edev);
+	edev_free_irqs(edev);
 	pci_free_irq_vectors(pdev);
+	edev_unmap_channels(edev);
 	free_bars(edev, pdev);
 	pci_release_regions(pdev);
 	pci_clear_master(pdev);
 	pci_disable_device(pdev);
 	dma_free_coherent(dev, edev->dma_region_len, edev->dma_region, edev->dma_region_addr);
+	ida_free(&edev_instance_ida, edev->id);
+	edev_put(edev);
 }
 
 static void edev_shutdown(struct pci_dev *pdev)
@@ -680,6 +1885,8 @@ static int map_bars(struct example_dev *edev, struct pci_dev *pdev)
 	struct device *dev = &pdev->dev;
 	int i;
 
+	edev->desc_push_wc = desc_push_wc && PAGE_SIZE == 0x1000;
+
 	for (i = 0; i < 6; i++) {
 		resource_size_t bar_start = pci_resource_start(pdev, i);
 		resource_size_t bar_end = pci_resource_end(pdev, i);
@@ -697,15 +1904,37 @@ static int map_bars(struct example_dev *edev, struct pci_dev *pdev)
 			continue;
 		}
 
-		edev->bar[i] = pci_ioremap_bar(pdev, i);
+		// descriptors can still be posted through the ring and
+		// doorbell registers
+		if (i == 0 && edev->desc_push_wc && bar_len < EDEV_REG_DESC_PUSH + 0x1000) {
+			dev_warn(dev, "BAR[0] too small for descriptor push window, using doorbells");
+			edev->desc_push_wc = false;
+		}
+
+		if (i == 0 && edev->desc_push_wc) {
+			// Map the registers uncached and the descriptor push page
+			// write-combined as separate ranges; a WC mapping that
+			// overlaps an existing UC mapping of the same BAR would
+			// be silently downgraded to UC by PAT
+			edev->bar[i] = ioremap(bar_start, EDEV_REG_DESC_PUSH);
+			edev->bar_map_len[i] = EDEV_REG_DESC_PUSH;
+		} else {
+			edev->bar[i] = pci_ioremap_bar(pdev, i);
+			edev->bar_map_len[i] = bar_len;
+		}
 
 		if (!edev->bar[i]) {
 			dev_err(dev, "Could not map BAR[%d]", i);
-			return -1;
+			return -ENOMEM;
 		}
 
 		dev_info(dev, "BAR[%d] mapped at 0x%p with length %llu",
-			i, edev->bar[i], bar_len);
+			i, edev->bar[i], (u64)edev->bar_map_len[i]);
+	}
+
+	if (!edev->bar[0]) {
+		dev_err(dev, "BAR[0] not present");
+		return -ENODEV;
 	}
 
 	return 0;
@@ -725,23 +1954,133 @@ static void free_bars(struct example_dev *edev, struct pci_dev *pdev)
 	}
 }
 
+static int edev_map_channels(struct example_dev *edev)
+{
+	struct device *dev = edev->dev;
+	resource_size_t bar_start = pci_resource_start(edev->pdev, 0);
+	int k;
+
+	// channel count register reads as zero on designs without channels
+	edev->num_channels = ioread32(edev->bar[0] + EDEV_REG_CHANNEL_COUNT);
+	if (edev->num_channels < 1)
+		edev->num_channels = 1;
+
+	if (edev->num_channels > EDEV_MAX_CHANNELS) {
+		dev_warn(dev, "Design has %d DMA channels, using %d",
+				edev->num_channels, EDEV_MAX_CHANNELS);
+		edev->num_channels = EDEV_MAX_CHANNELS;
+	}
+
+	if (edev->num_channels > 1 &&
+			edev->bar_len[0] < (resource_size_t)edev->num_channels * EDEV_CHANNEL_STRIDE) {
+		dev_err(dev, "BAR[0] too small for %d DMA channels", edev->num_channels);
+		return -ENODEV;
+	}
+
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
+		resource_size_t base = k * EDEV_CHANNEL_STRIDE;
+
+		ch->edev = edev;
+		ch->index = k;
+
+		mutex_init(&ch->lock);
+		init_completion(&ch->dma_read_cpl);
+		init_completion(&ch->dma_write_cpl);
+
+		ch->cpl_mode = cpl_mode < EDEV_CPL_MODE_COUNT ? cpl_mode : EDEV_CPL_MODE_HYBRID;
+
+		if (!edev->desc_push_wc) {
+			// BAR mapped uncached in full
+			ch->hw_addr = edev->bar[0] + base;
+			if (edev->bar_len[0] >= base + EDEV_REG_DESC_PUSH + 0x1000)
+				ch->desc_push = ch->hw_addr + EDEV_REG_DESC_PUSH;
+			else
+				ch->desc_push = NULL;
+			ch->desc_push_wc = false;
+		} else {
+			// registers uncached, descriptor push page write-combined
+			if (k == 0)
+				ch->hw_addr = edev->bar[0];
+			else
+				ch->hw_addr = ioremap(bar_start + base, EDEV_REG_DESC_PUSH);
+			ch->desc_push = ioremap_wc(bar_start + base + EDEV_REG_DESC_PUSH, PAGE_SIZE);
+			ch->desc_push_wc = true;
+
+			if (!ch->hw_addr || !ch->desc_push) {
+				dev_err(dev, "Could not map DMA channel %d", k);
+				return -ENOMEM;
+			}
+		}
+
+		if (ioread32(ch->hw_addr + EDEV_REG_CHANNEL_INDEX) != k)
+			dev_warn(dev, "DMA channel %d reports index %d", k,
+					ioread32(ch->hw_addr + EDEV_REG_CHANNEL_INDEX));
+
+		if (ch->desc_push)
+			dev_info(dev, "DMA channel %d registers at 0x%p, descriptor push window at 0x%p (%s)",
+					k, ch->hw_addr, ch->desc_push,
+					ch->desc_push_wc ? "write-combined" : "uncached");
+		else
+			dev_info(dev, "DMA channel %d registers at 0x%p, no descriptor push window",
+					k, ch->hw_addr);
+	}
+
+	return 0;
+}
+
+static void edev_unmap_channels(struct example_dev *edev)
+{
+	int k;
+
+	for (k = 0; k < edev->num_channels; k++) {
+		struct example_channel *ch = &edev->ch[k];
+
+		if (ch->desc_push_wc) {
+			if (ch->desc_push)
+				iounmap(ch->desc_push);
+			if (k > 0 && ch->hw_addr)
+				iounmap(ch->hw_addr);
+		}
+
+		ch->hw_addr = NULL;
+		ch->desc_push = NULL;
+		ch->desc_push_wc = false;
+	}
+}
+
 static struct pci_driver pci_driver = {
 	.name = DRIVER_NAME,
 	.id_table = pci_ids,
 	.probe = edev_probe,
 	.remove = edev_remove,
-	.shutdown = edev_shutdown
+	.shutdown = edev_shutdown,
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(4, 2, 0)
+	.driver = {
+		.probe_type = PROBE_PREFER_ASYNCHRONOUS,
+	},
+#endif
 };
 
 static int __init edev_init(void)
 {
+	int ret;
+
 	printk(KERN_INFO DRIVER_NAME " driver version %s\n", DRIVER_VERSION);
-	return pci_register_driver(&pci_driver);
+
+	edev_debugfs_init();
+
+	ret = pci_register_driver(&pci_driver);
+	if (ret)
+		edev_debugfs_exit();
+
+	return ret;
 }
 
 static void __exit edev_exit(void)
 {
 	pci_unregister_driver(&pci_driver);
+	edev_debugfs_exit();
 }
 
 module_init(edev_init);
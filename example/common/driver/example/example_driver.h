@@ -25,24 +25,660 @@
 #define EXAMPLE_DRIVER_H
 
 #include <linux/kernel.h>
+#include <linux/types.h>
+#include <linux/completion.h>
+#include <linux/kref.h>
+#include <linux/list.h>
+#include <linux/miscdevice.h>
+#include <linux/mutex.h>
+#include <linux/rwsem.h>
+#include <linux/scatterlist.h>
+#include <linux/wait.h>
+#include <linux/workqueue.h>
 
 #define DRIVER_NAME "edev"
 #define DRIVER_VERSION "0.1"
 
+// card DMA RAM size (dma_psdpram in example_core)
+#define EDEV_CARD_RAM_SIZE 16384
+
+// maximum DMA block length (DMA_LEN_WIDTH)
+#define EDEV_MAX_BLOCK_LEN 0xffff
+
+// DMA channels (one example_core register window each)
+#define EDEV_MAX_CHANNELS 8
+#define EDEV_CHANNEL_STRIDE 0x010000
+
+// free-running 64-bit core clock cycle counter
+#define EDEV_REG_CYCLE_COUNT 0x000010
+
+#define EDEV_REG_CHANNEL_INDEX 0x000030
+#define EDEV_REG_CHANNEL_COUNT 0x000034
+
+#define EDEV_REG_RX_CPL_STALL 0x000040
+#define EDEV_REG_RD_ERROR_COUNT 0x000044
+
+// DMA read completion credit limits (channel 0 only, 0 selects the
+// compile-time limit, which is also reported and never exceeded)
+#define EDEV_REG_CPLH_FC_LIMIT     0x000048
+#define EDEV_REG_CPLD_FC_LIMIT     0x00004c
+#define EDEV_REG_CPLH_FC_LIMIT_MAX 0x000050
+#define EDEV_REG_CPLD_FC_LIMIT_MAX 0x000054
+
+// core clock frequency in kHz (0 on older designs, measured instead)
+#define EDEV_REG_CLK_FREQ 0x000058
+
+#define EDEV_CLK_FREQ_CAL_MS 10
+#define EDEV_CLK_FREQ_TOLERANCE_PCT 10
+
+// register widths, used as the search range without a compile-time limit
+#define EDEV_CPLH_FC_LIMIT_MAX 0xfff
+#define EDEV_CPLD_FC_LIMIT_MAX 0xffff
+
+// interrupt moderation (prescale and min interval are used from channel 0 only)
+#define EDEV_REG_IRQ_PRESCALE     0x000060
+#define EDEV_REG_IRQ_MIN_INTERVAL 0x000064
+#define EDEV_REG_IRQ_MOD          0x000068 // + 4 * direction
+#define EDEV_REG_IRQ_EVENT_COUNT  0x000070 // + 8 * direction
+#define EDEV_REG_IRQ_COUNT        0x000074 // + 8 * direction
+
+#define EDEV_IRQ_MOD_MAX 0xffff
+
+// adaptive moderation: sample the event rate every interval and coalesce
+// enough events to keep each vector under the target interrupt rate
+#define EDEV_IRQ_MOD_ADAPT_INTERVAL_MS 100
+#define EDEV_IRQ_MOD_ADAPT_TARGET_RATE 20000
+#define EDEV_IRQ_MOD_ADAPT_MAX_COUNT   64
+#define EDEV_IRQ_MOD_ADAPT_TIME_US     50
+
+// block engines
+#define EDEV_REG_BLOCK_READ  0x001000
+#define EDEV_REG_BLOCK_WRITE 0x001100
+
+#define EDEV_BLOCK_REG_CYCLES    0x08
+#define EDEV_BLOCK_REG_LAT_COUNT 0x30
+#define EDEV_BLOCK_REG_LAT_MIN   0x34
+#define EDEV_BLOCK_REG_LAT_MAX   0x38
+#define EDEV_BLOCK_REG_LAT_SUM   0x40
+
+// block engine address patterns (0x001004, 0x001104)
+#define EDEV_BLOCK_MODE_LINEAR 0
+#define EDEV_BLOCK_MODE_RANDOM 1
+#define EDEV_BLOCK_MODE_LIST   2
+
+#define EDEV_BLOCK_MODE_LIST_ERROR 0x00010000
+
+// address lists are fetched in chunks of 8 entries, so need at least 8
+#define EDEV_BLOCK_LIST_MIN_LOG_SIZE 3
+#define EDEV_BLOCK_LIST_MAX_LOG_SIZE 16
+
+// DMA read statistics (channel 0 only)
+#define EDEV_REG_STATS 0x000400
+
+#define EDEV_STATS_REG_CTRL           0x00
+#define EDEV_STATS_REG_LAT_COUNT      0x04
+#define EDEV_STATS_REG_LAT_MIN        0x08
+#define EDEV_STATS_REG_LAT_MAX        0x0c
+#define EDEV_STATS_REG_LAT_SUM        0x10
+#define EDEV_STATS_REG_CYCLES         0x18
+#define EDEV_STATS_REG_TAG_SUM        0x20
+#define EDEV_STATS_REG_TAG_MAX        0x28
+#define EDEV_STATS_REG_OP_SUM         0x30
+#define EDEV_STATS_REG_OP_MAX         0x38
+#define EDEV_STATS_REG_NO_TAGS        0x40
+#define EDEV_STATS_REG_OP_TABLE_FULL  0x44
+#define EDEV_STATS_REG_CPLH_STALL     0x48
+#define EDEV_STATS_REG_CPLD_STALL     0x4c
+#define EDEV_STATS_REG_TX_LIMIT_STALL 0x50
+#define EDEV_STATS_REG_TX_STALL       0x54
+#define EDEV_STATS_REG_LAT_HIST       0x80
+
+#define EDEV_STATS_CTRL_PRESENT 0x00000001
+#define EDEV_STATS_CTRL_CLEAR   0x00000001
+
+// latency histogram bins (bin n counts [2^n, 2^(n+1)) cycles)
+#define EDEV_STATS_LAT_HIST_BINS 16
+
+// descriptor ring register blocks
+#define EDEV_REG_READ_RING  0x002000
+#define EDEV_REG_WRITE_RING 0x002100
+
+// descriptor push window (one 64 byte line of descriptor slots per ring)
+#define EDEV_REG_DESC_PUSH   0x003000
+#define EDEV_DESC_PUSH_READ  0x000
+#define EDEV_DESC_PUSH_WRITE 0x040
+#define EDEV_DESC_PUSH_SLOTS 4
+
+// descriptor ring registers
+#define EDEV_RING_REG_CTRL      0x00
+#define EDEV_RING_REG_BUF_SIZE  0x04
+#define EDEV_RING_REG_BASE_ADDR 0x08
+#define EDEV_RING_REG_LOG_SIZE  0x10
+#define EDEV_RING_REG_PROD_PTR  0x18
+#define EDEV_RING_REG_FETCH_PTR 0x1c
+#define EDEV_RING_REG_CPL_PTR   0x20
+
+#define EDEV_RING_CTRL_ENABLE 0x00000001
+#define EDEV_RING_CTRL_ACTIVE 0x00000100
+#define EDEV_RING_CTRL_ERROR  0x00010000
+
+#define EDEV_RING_PTR_MASK 0xffff
+#define EDEV_RING_MAX_LOG_SIZE 15
+
+// completion queue register block
+#define EDEV_REG_CPL_QUEUE 0x002200
+
+// completion queue registers
+#define EDEV_CQ_REG_CTRL      0x00
+#define EDEV_CQ_REG_FIFO_SIZE 0x04
+#define EDEV_CQ_REG_BASE_ADDR 0x08
+#define EDEV_CQ_REG_LOG_SIZE  0x10
+#define EDEV_CQ_REG_PROD_PTR  0x18
+#define EDEV_CQ_REG_CONS_PTR  0x1c
+
+#define EDEV_CQ_CTRL_ENABLE    0x00000001
+#define EDEV_CQ_CTRL_PENDING   0x00000100
+#define EDEV_CQ_CTRL_OVERFLOW  0x00010000
+#define EDEV_CQ_CTRL_SUPPORTED 0x80000000
+
+// completion record (one little endian dword per operation)
+#define EDEV_CQ_REC_TAG_MASK    0x000000ff
+#define EDEV_CQ_REC_ERROR_MASK  0x00000f00
+#define EDEV_CQ_REC_ERROR_SHIFT 8
+#define EDEV_CQ_REC_WRITE       0x00001000
+#define EDEV_CQ_REC_RING        0x00002000
+#define EDEV_CQ_REC_PHASE       0x00008000
+#define EDEV_CQ_REC_TS_SHIFT    16
+
+// records are polled for this long after each wake before sleeping again,
+// as the interrupt can overtake the record write
+#define EDEV_CQ_SPIN_US 20
+
+#define EDEV_DESC_FLAG_IMM 0x80
+
+// DMA descriptor, as fetched by the card
+struct example_desc {
+	__le64 dma_addr;
+	__le32 ram_addr;
+	__le16 len;
+	__u8 tag;
+	__u8 flags;
+};
+
+struct example_cq;
+
+struct example_ring {
+	u32 size;
+	u32 size_mask;
+	u32 prod_ptr;
+	u32 cpl_ptr;
+
+	// completions are tracked from records when cq is set
+	struct example_cq *cq;
+	bool cq_error;
+
+	size_t buf_size;
+	struct example_desc *buf;
+	dma_addr_t buf_dma_addr;
+
+	void __iomem *hw_addr;
+	void __iomem *push_addr;
+
+	// signalled from interrupt handler
+	struct completion *irq_cpl;
+};
+
+// host memory completion queue, written by the card
+struct example_cq {
+	u32 size;
+	u32 size_mask;
+	u32 log_size;
+	u32 cons_ptr;
+
+	size_t buf_size;
+	__le32 *buf;
+	dma_addr_t buf_dma_addr;
+
+	void __iomem *hw_addr;
+
+	// set once records have been dropped, completions are then read from the card
+	bool overflow;
+
+	// rings whose completions are reported here
+	struct example_ring *read_ring;
+	struct example_ring *write_ring;
+
+	// most recent single operation record per direction
+	u32 last_rec[2];
+	bool last_valid[2];
+};
+
+// pinned user buffer
+// largest user buffer that can be pinned, on kernels without
+// account_locked_vm this is the only limit
+#define EDEV_USER_BUF_MAX_LEN (256UL << 20)
+
+struct example_user_buf {
+	unsigned long addr;
+	size_t len;
+
+	struct page **pages;
+	unsigned long nr_pages;
+
+	// pinned pages are charged to this mm's locked_vm
+	struct mm_struct *mm;
+
+	struct sg_table sgt;
+	int nents;
+};
+
+// streaming read()/write() through card RAM, split into slots that move
+// through the pipeline in order: written by write() into the host bounce
+// buffer, DMA read into card RAM, DMA written back, and copied out by read()
+#define EDEV_STREAM_SLOTS 4
+#define EDEV_STREAM_SLOT_SIZE (EDEV_CARD_RAM_SIZE / EDEV_STREAM_SLOTS)
+#define EDEV_STREAM_TIMEOUT_MS 1000
+
+struct example_stream_slot {
+	u32 len;
+	u32 offset; // bytes already copied out by read()
+
+	// ring indices of the descriptors moving this slot to and from the card
+	u32 to_card_ptr;
+	u32 from_card_ptr;
+};
+
+struct example_stream {
+	struct example_channel *ch;
+
+	// host bounce buffers, to card (first half) and from card (second half)
+	size_t buf_size;
+	void *buf;
+	dma_addr_t buf_dma_addr;
+
+	// single producer (write) and single consumer (read); head and tail
+	// are free-running slot counters, slots in [tail, fetch) are on their
+	// way back from the card, slots in [fetch, head) are on their way to it
+	struct mutex write_lock;
+	struct mutex read_lock;
+	u32 head;
+	u32 fetch;
+	u32 tail;
+	struct example_stream_slot slot[EDEV_STREAM_SLOTS];
+
+	// woken when a slot is filled or freed, or the stream is stopped
+	wait_queue_head_t wait;
+	bool stopped;
+};
+
+// MMIO latency measurement modes
+#define EDEV_MMIO_LAT_READ        0 // ioread32
+#define EDEV_MMIO_LAT_WRITE       1 // posted iowrite32
+#define EDEV_MMIO_LAT_WRITE_FLUSH 2 // iowrite32 followed by read back
+
+#define EDEV_MMIO_LAT_MAX_SAMPLES (1 << 20)
+
+// log-linear histogram, 4 buckets per power of two, last bucket is overflow
+#define EDEV_MMIO_LAT_BUCKETS 96
+// percentiles reported, in units of 0.01%
+#define EDEV_MMIO_LAT_PCTLS 5
+// samples above this multiple of the median are counted as outliers
+#define EDEV_MMIO_LAT_OUTLIER_FACTOR 10
+// number of largest samples kept with their index
+#define EDEV_MMIO_LAT_TOP 8
+
+struct edev_mmio_lat_params {
+	u32 mode;
+	u32 bar;
+	u32 offset;
+	u32 samples;
+};
+
+struct edev_mmio_lat {
+	struct edev_mmio_lat_params params;
+	bool valid;
+
+	// TSC calibration
+	u32 tsc_khz;
+	u64 tsc_overhead;
+
+	u64 min_ns;
+	u64 mean_ns;
+	u64 max_ns;
+	u64 pctl_ns[EDEV_MMIO_LAT_PCTLS];
+
+	u64 outlier_threshold_ns;
+	u32 outlier_count;
+	u32 top_count;
+	struct {
+		u32 index;
+		u64 ns;
+	} top[EDEV_MMIO_LAT_TOP];
+
+	u32 hist[EDEV_MMIO_LAT_BUCKETS];
+};
+
+extern const u32 edev_mmio_lat_pctls[EDEV_MMIO_LAT_PCTLS];
+
+// concurrent MMIO benchmark modes
+#define EDEV_MMIO_MT_READ     0 // ioread32 of a shared register
+#define EDEV_MMIO_MT_WRITE    1 // posted iowrite32 to a shared register
+#define EDEV_MMIO_MT_DOORBELL 2 // posted iowrite32 to a 64 byte line per thread
+#define EDEV_MMIO_MT_MIXED    3 // threads take read, write and doorbell in turn
+
+#define EDEV_MMIO_MT_MAX_THREADS 64
+#define EDEV_MMIO_MT_MAX_OPS (1 << 24)
+#define EDEV_MMIO_MT_CPUS_LEN 64
+
+struct edev_mmio_mt_params {
+	u32 mode;
+	u32 bar;
+	u32 offset;
+	u32 ops; // per thread
+	char cpus[EDEV_MMIO_MT_CPUS_LEN]; // CPU list, one thread per CPU
+};
+
+// latency figures are histogram bucket lower bounds, except min and max
+struct edev_mmio_mt_stats {
+	u64 ops;
+	u64 ns;
+	u64 ops_per_sec;
+
+	u64 min_ns;
+	u64 mean_ns;
+	u64 p50_ns;
+	u64 p99_ns;
+	u64 max_ns;
+};
+
+struct edev_mmio_mt {
+	struct edev_mmio_mt_params params;
+	bool valid;
+
+	u32 tsc_khz;
+	u64 tsc_overhead;
+
+	// all threads, first start to last finish
+	struct edev_mmio_mt_stats total;
+
+	u32 num_threads;
+	struct {
+		u32 cpu;
+		u32 mode;
+		struct edev_mmio_mt_stats stats;
+	} thread[EDEV_MMIO_MT_MAX_THREADS];
+};
+
+struct edev_ioctl_bench;
+
+struct example_dev;
+
+// block operation completion wait policy
+#define EDEV_CPL_MODE_IRQ    0 // sleep on the interrupt
+#define EDEV_CPL_MODE_POLL   1 // poll the engine until done
+#define EDEV_CPL_MODE_HYBRID 2 // poll for the estimated transfer time, then sleep
+#define EDEV_CPL_MODE_COUNT  3
+
+#define EDEV_BLOCK_TIMEOUT_MS 20000
+
+// hybrid mode transfer time estimate (fixed latency plus size at a
+// conservative rate), polled for EDEV_CPL_POLL_SLACK times the estimate;
+// transfers estimated above EDEV_CPL_POLL_MAX_NS are not polled at all
+#define EDEV_CPL_EST_BASE_NS 1500
+#define EDEV_CPL_EST_MBPS    2000
+#define EDEV_CPL_POLL_SLACK  2
+#define EDEV_CPL_POLL_MAX_NS 20000
+
+extern const char *const edev_cpl_mode_str[EDEV_CPL_MODE_COUNT];
+
+// completion wait statistics, per direction
+struct example_cpl_stats {
+	u64 poll;     // completed while polling
+	u64 irq;      // polled, then slept on the interrupt
+	u64 irq_only; // slept on the interrupt without polling
+	u64 poll_ns;  // total time spent polling
+};
+
+// per-block latency of the last block engine run, in core clock cycles
+struct example_block_lat {
+	u32 count;
+	u32 min;
+	u32 max;
+	u64 sum;
+};
+
+// interrupt moderation for one vector: an interrupt is raised once count
+// events have accumulated or time_us after the first one (time 0 = every event)
+struct example_irq_mod {
+	u32 count;
+	u32 time_us;
+
+	// event counter at the last adaptive update
+	u32 last_events;
+};
+
+// DMA channel (block engines, descriptor rings and card RAM)
+struct example_channel {
+	struct example_dev *edev;
+	int index;
+
+	// register window and descriptor push window
+	// (write-combined when desc_push_wc is set)
+	void __iomem *hw_addr;
+	void __iomem *desc_push;
+	bool desc_push_wc;
+
+	// serializes use of the channel
+	struct mutex lock;
+
+	// descriptor rings
+	struct example_ring read_ring;
+	struct example_ring write_ring;
+
+	// completion queue (buf is NULL if the card does not support it)
+	struct example_cq cq;
+
+	// interrupts
+	int rd_irq;
+	int wr_irq;
+	struct completion dma_read_cpl;
+	struct completion dma_write_cpl;
+
+	// interrupt moderation (0 = read, 1 = write, under irq_mod_lock)
+	struct example_irq_mod irq_mod[2];
+
+	// interrupt enable shadow (0x000008) and block completion wait
+	// policy (0 = read, 1 = write, under lock)
+	u32 int_en;
+	u32 cpl_mode;
+	struct example_cpl_stats cpl_stats[2];
+};
+
 struct example_dev {
 	struct pci_dev *pdev;
 	struct device *dev;
 
+	// character device
+	struct miscdevice misc_dev;
+	char name[16];
+	int id;
+
+	// open files hold a reference, the structure outlives remove
+	struct kref kref;
+
+	// file operations run under remove_sem (read), remove sets removed
+	// under it (write) before the hardware goes away
+	struct rw_semaphore remove_sem;
+	bool removed;
+
+	// open files (under files_lock)
+	struct mutex files_lock;
+	struct list_head files;
+
 	// BAR pointers
 	void __iomem *bar[6];
 	resource_size_t bar_len[6];
+	resource_size_t bar_map_len[6];
+
+	// descriptor push pages mapped write-combined (cleared when BAR[0]
+	// has no room for them)
+	bool desc_push_wc;
+
+	// core clock frequency (reported by the card or measured at probe)
+	u32 clk_freq_khz;
 
 	// DMA buffer
 	size_t dma_region_len;
 	void *dma_region;
 	dma_addr_t dma_region_addr;
 
+	// serializes tests, benchmarks and MMIO measurements
+	// (taken before any channel lock)
+	struct mutex dma_lock;
+
+	// background self-test
+	struct work_struct test_work;
+
+	// DMA channels
+	struct example_channel ch[EDEV_MAX_CHANNELS];
+	int num_channels;
+
+	// character device read()/write() (on the last channel, which
+	// tests, benchmarks and user DMA refuse while data is in flight)
+	struct example_stream stream;
+
+	// interrupts
+	int num_irqs;
+	int num_irqs_used;
+
 	int irqcount;
+
+	// interrupt moderation
+	struct mutex irq_mod_lock;
+	struct delayed_work irq_mod_work;
+	bool irq_mod_adaptive;
+	u32 irq_min_interval_us;
+
+	// MMIO latency (debugfs parameters and last result, under dma_lock)
+	struct edev_mmio_lat_params mmio_lat_params;
+	struct edev_mmio_lat mmio_lat;
+
+	// concurrent MMIO benchmark (debugfs parameters and last result, under dma_lock)
+	struct edev_mmio_mt_params mmio_mt_params;
+	struct edev_mmio_mt mmio_mt;
+
+	struct dentry *debugfs_dir;
+
+	// DMA read statistics attributes registered
+	bool stats_sysfs;
+
+	// completion credit limits (under dma_lock, 0 is the compile-time limit)
+	u32 cplh_fc_limit;
+	u32 cpld_fc_limit;
+	bool cpl_budget_valid;
 };
 
+// per-file state
+struct example_file {
+	struct example_dev *edev;
+	struct file *file;
+	struct list_head list;
+
+	// serializes use of ubuf (taken before dma_lock and channel locks)
+	struct mutex lock;
+	struct example_user_buf *ubuf;
+};
+
+// example_driver.c
+void edev_put(struct example_dev *edev);
+u64 edev_read64(void __iomem *addr);
+int edev_run_tests(struct example_dev *edev, unsigned int flags);
+struct example_channel *edev_get_channel(struct example_dev *edev);
+void edev_set_cpl_fc_limits(struct example_dev *edev, u32 cplh, u32 cpld);
+void edev_set_irq_mod(struct example_channel *ch, int write, u32 count, u32 time_us);
+void edev_set_irq_min_interval(struct example_dev *edev, u32 time_us);
+void edev_set_irq_mod_adaptive(struct example_dev *edev, bool enable);
+int edev_cpl_budget_search(struct example_dev *edev);
+int dma_block_read(struct example_channel *ch,
+		dma_addr_t dma_addr, size_t dma_offset,
+		size_t dma_offset_mask, size_t dma_stride,
+		size_t ram_addr, size_t ram_offset,
+		size_t ram_offset_mask, size_t ram_stride,
+		size_t block_len, size_t block_count);
+int dma_block_write(struct example_channel *ch,
+		dma_addr_t dma_addr, size_t dma_offset,
+		size_t dma_offset_mask, size_t dma_stride,
+		size_t ram_addr, size_t ram_offset,
+		size_t ram_offset_mask, size_t ram_stride,
+		size_t block_len, size_t block_count);
+void dma_block_set_pattern(struct example_channel *ch, int write, u32 mode,
+		u32 seed, dma_addr_t list_addr, u32 list_log_size);
+u64 dma_block_cycles(struct example_channel *ch, int write);
+void dma_block_lat(struct example_channel *ch, int write, struct example_block_lat *lat);
+
+// example_dev.c
+extern const struct file_operations edev_fops;
+void edev_revoke_files(struct example_dev *edev);
+
+// example_bench.c
+u64 edev_cycles_to_ns(struct example_dev *edev, u64 cycles);
+int edev_bench(struct example_dev *edev, struct example_user_buf *ubuf,
+		struct edev_ioctl_bench *req);
+u64 edev_mmio_lat_bucket_ns(int idx);
+int edev_mmio_lat_run(struct example_dev *edev, const struct edev_mmio_lat_params *params,
+		struct edev_mmio_lat *lat);
+int edev_mmio_mt_run(struct example_dev *edev, const struct edev_mmio_mt_params *params,
+		struct edev_mmio_mt *mt);
+
+// example_debugfs.c
+void edev_debugfs_init(void);
+void edev_debugfs_exit(void);
+void edev_debugfs_create(struct example_dev *edev);
+void edev_debugfs_destroy(struct example_dev *edev);
+
+// example_sysfs.c
+void edev_sysfs_create(struct example_dev *edev);
+void edev_sysfs_destroy(struct example_dev *edev);
+
+// example_sg.c
+struct example_user_buf *edev_map_user_buf(struct example_dev *edev,
+		unsigned long addr, size_t len);
+void edev_unmap_user_buf(struct example_dev *edev, struct example_user_buf *ubuf);
+int edev_user_buf_dma(struct example_channel *ch, struct example_user_buf *ubuf,
+		int dir, u64 offset, u64 len, u32 block_len, u32 ram_addr, u64 *cycles);
+
+// example_stream.c
+int edev_create_stream(struct example_dev *edev, struct example_stream *stream,
+		struct example_channel *ch);
+void edev_destroy_stream(struct example_dev *edev, struct example_stream *stream);
+void edev_stop_stream(struct example_stream *stream);
+int edev_stream_check_idle(struct example_stream *stream, struct example_channel *ch);
+ssize_t edev_stream_read_iter(struct kiocb *iocb, struct iov_iter *to);
+ssize_t edev_stream_write_iter(struct kiocb *iocb, struct iov_iter *from);
+
+// example_ring.c
+int edev_create_ring(struct example_dev *edev, struct example_ring *ring,
+		int size, void __iomem *hw_addr, void __iomem *push_addr,
+		struct completion *irq_cpl);
+void edev_destroy_ring(struct example_dev *edev, struct example_ring *ring);
+int edev_ring_enqueue(struct example_ring *ring, dma_addr_t dma_addr,
+		u32 ram_addr, u16 len, u8 tag, u8 flags);
+void edev_ring_doorbell(struct example_ring *ring);
+int edev_ring_push(struct example_ring *ring, dma_addr_t dma_addr,
+		u32 ram_addr, u16 len, u8 tag, u8 flags);
+void edev_ring_push_flush(struct example_ring *ring);
+u32 edev_ring_update_cpl_ptr(struct example_ring *ring);
+int edev_ring_wait(struct example_dev *edev, struct example_ring *ring,
+		unsigned int timeout_ms);
+
+// example_cq.c
+int edev_create_cq(struct example_dev *edev, struct example_cq *cq, int size,
+		void __iomem *hw_addr, struct example_ring *read_ring,
+		struct example_ring *write_ring);
+void edev_destroy_cq(struct example_dev *edev, struct example_cq *cq);
+int edev_cq_poll(struct example_cq *cq);
+bool edev_cq_spin(struct example_cq *cq, unsigned int timeout_us);
+int edev_cq_wait_single(struct example_cq *cq, int write, u8 tag, u32 *rec,
+		unsigned int timeout_ms);
+
 #endif /* EXAMPLE_DRIVER_H */
@@ -0,0 +1,140 @@
+/* SPDX-License-Identifier: MIT */
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef EXAMPLE_IOCTL_H
+#define EXAMPLE_IOCTL_H
+
+#include <linux/types.h>
+
+#define EDEV_IOCTL_TYPE 0x88
+
+// mmap offsets
+#define EDEV_MMAP_BAR0_OFFSET 0x00000000
+#define EDEV_MMAP_BAR2_OFFSET 0x10000000
+#define EDEV_MMAP_DMA_OFFSET  0x20000000
+#define EDEV_MMAP_REGION_SIZE 0x10000000
+
+#define EDEV_IOCTL_INFO _IOR(EDEV_IOCTL_TYPE, 0xf0, struct edev_ioctl_info)
+#define EDEV_IOCTL_MAP_USER _IOW(EDEV_IOCTL_TYPE, 0x01, struct edev_ioctl_user_buf)
+#define EDEV_IOCTL_UNMAP_USER _IO(EDEV_IOCTL_TYPE, 0x02)
+#define EDEV_IOCTL_USER_DMA _IOWR(EDEV_IOCTL_TYPE, 0x03, struct edev_ioctl_user_dma)
+#define EDEV_IOCTL_BENCH _IOWR(EDEV_IOCTL_TYPE, 0x04, struct edev_ioctl_bench)
+#define EDEV_IOCTL_RUN_TESTS _IO(EDEV_IOCTL_TYPE, 0x05)
+
+// test selection
+#define EDEV_TEST_SELF       0x00000001
+#define EDEV_TEST_BENCH      0x00000002
+#define EDEV_TEST_CPL_BUDGET 0x00000004 // completion credit limit search
+
+// DMA directions
+#define EDEV_DMA_TO_CARD   0
+#define EDEV_DMA_FROM_CARD 1
+
+// benchmark buffer placement
+#define EDEV_BENCH_BUF_COHERENT 0
+#define EDEV_BENCH_BUF_USER     1
+#define EDEV_BENCH_BUF_LOCAL    2 // pages on the device NUMA node (up to 4 MiB)
+#define EDEV_BENCH_BUF_REMOTE   3 // pages on another NUMA node (up to 4 MiB)
+
+// benchmark address patterns (block engine address generation)
+#define EDEV_BENCH_PATTERN_LINEAR 0 // offset + n * stride
+#define EDEV_BENCH_PATTERN_RANDOM 1 // LFSR offsets aligned to stride
+#define EDEV_BENCH_PATTERN_LIST   2 // random offsets from a host memory list
+
+#define EDEV_BENCH_MAX_REPEAT 1024
+
+struct edev_ioctl_info {
+	__u64 bar0_len;
+	__u64 bar2_len;
+	__u64 dma_region_len;
+	__u64 dma_region_addr;
+	__u32 num_channels;
+	__u32 rsvd;
+};
+
+struct edev_ioctl_user_buf {
+	__u64 addr;
+	__u64 len;
+};
+
+struct edev_ioctl_user_dma {
+	__u32 dir;
+	__u32 block_len;
+	__u64 offset;
+	__u64 len;
+	__u32 ram_addr;
+	__u32 channel; // DMA channel used (output)
+	__u64 cycles;
+};
+
+struct edev_bench_result {
+	__u32 size;
+	__u32 stride;
+	__u32 count;
+	__u32 repeat;
+
+	// per-run duration
+	__u64 min_ns;
+	__u64 median_ns;
+	__u64 p99_ns;
+	__u64 max_ns;
+
+	// throughput (from min, median and p99 durations)
+	__u64 max_mbps;
+	__u64 median_mbps;
+	__u64 p99_mbps;
+
+	// PCIe TLP counts, summed over all runs
+	__u64 req_count;
+	__u64 cpl_count;
+
+	// per-block latency (descriptor issue to completion), over all runs
+	__u64 lat_min_ns;
+	__u64 lat_mean_ns;
+	__u64 lat_max_ns;
+};
+
+struct edev_ioctl_bench {
+	// parameters
+	__u32 dir;
+	__u32 buf;
+	__u64 offset;
+	__u64 region_len;
+	__u32 size_min;
+	__u32 size_max;
+	__u32 stride;
+	__u32 count;
+	__u32 repeat;
+
+	// results (array of num_results edev_bench_result, one per size)
+	__u32 num_results;
+	__u64 results;
+
+	// NUMA node of the benchmark buffer (-1 if unknown)
+	__s32 node;
+
+	// address pattern (random and list need a power of two stride)
+	__u32 pattern;
+};
+
+#endif /* EXAMPLE_IOCTL_H */
@@ -0,0 +1,228 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "example_driver.h"
+#include <linux/device.h>
+#include <linux/dma-mapping.h>
+#include <linux/io.h>
+#include <linux/jiffies.h>
+#include <linux/log2.h>
+
+int edev_create_ring(struct example_dev *edev, struct example_ring *ring,
+		int size, void __iomem *hw_addr, void __iomem *push_addr,
+		struct completion *irq_cpl)
+{
+	u32 log_size;
+
+	if (size < 2 || size > (1 << EDEV_RING_MAX_LOG_SIZE))
+		return -EINVAL;
+
+	log_size = ilog2(roundup_pow_of_two(size));
+
+	ring->size = 1 << log_size;
+	ring->size_mask = ring->size - 1;
+	ring->prod_ptr = 0;
+	ring->cpl_ptr = 0;
+	ring->cq = NULL;
+	ring->cq_error = false;
+
+	ring->hw_addr = hw_addr;
+	ring->push_addr = push_addr;
+	ring->irq_cpl = irq_cpl;
+
+	ring->buf_size = ring->size * sizeof(struct example_desc);
+	ring->buf = dma_alloc_coherent(edev->dev, ring->buf_size,
+			&ring->buf_dma_addr, GFP_KERNEL | __GFP_ZERO);
+	if (!ring->buf)
+		return -ENOMEM;
+
+	// disable ring while it is reconfigured
+	iowrite32(0, ring->hw_addr + EDEV_RING_REG_CTRL);
+	// base address
+	iowrite32(ring->buf_dma_addr & 0xffffffff, ring->hw_addr + EDEV_RING_REG_BASE_ADDR);
+	iowrite32((ring->buf_dma_addr >> 32) & 0xffffffff, ring->hw_addr + EDEV_RING_REG_BASE_ADDR + 4);
+	// size
+	iowrite32(log_size, ring->hw_addr + EDEV_RING_REG_LOG_SIZE);
+	// pointers
+	iowrite32(0, ring->hw_addr + EDEV_RING_REG_PROD_PTR);
+	iowrite32(0, ring->hw_addr + EDEV_RING_REG_FETCH_PTR);
+	iowrite32(0, ring->hw_addr + EDEV_RING_REG_CPL_PTR);
+	// enable
+	iowrite32(EDEV_RING_CTRL_ENABLE, ring->hw_addr + EDEV_RING_REG_CTRL);
+
+	dev_info(edev->dev, "Created descriptor ring at 0x%p, %d entries (card buffers %d)",
+			(void *)ring->buf_dma_addr, ring->size,
+			ioread32(ring->hw_addr + EDEV_RING_REG_BUF_SIZE));
+
+	return 0;
+}
+
+void edev_destroy_ring(struct example_dev *edev, struct example_ring *ring)
+{
+	if (!ring->buf)
+		return;
+
+	iowrite32(0, ring->hw_addr + EDEV_RING_REG_CTRL);
+
+	dma_free_coherent(edev->dev, ring->buf_size, ring->buf, ring->buf_dma_addr);
+	ring->buf = NULL;
+	ring->buf_dma_addr = 0;
+}
+
+u32 edev_ring_update_cpl_ptr(struct example_ring *ring)
+{
+	if (ring->cq && !ring->cq->overflow) {
+		// completion records advance cpl_ptr
+		edev_cq_poll(ring->cq);
+		return ring->cpl_ptr;
+	}
+
+	ring->cpl_ptr = ioread32(ring->hw_addr + EDEV_RING_REG_CPL_PTR) & EDEV_RING_PTR_MASK;
+	return ring->cpl_ptr;
+}
+
+static bool edev_ring_full(struct example_ring *ring)
+{
+	if (((ring->prod_ptr - ring->cpl_ptr) & EDEV_RING_PTR_MASK) >= ring->size) {
+		// ring looks full, check card for completions
+		edev_ring_update_cpl_ptr(ring);
+		if (((ring->prod_ptr - ring->cpl_ptr) & EDEV_RING_PTR_MASK) >= ring->size)
+			return true;
+	}
+
+	return false;
+}
+
+int edev_ring_enqueue(struct example_ring *ring, dma_addr_t dma_addr,
+		u32 ram_addr, u16 len, u8 tag, u8 flags)
+{
+	struct example_desc *desc;
+
+	if (edev_ring_full(ring))
+		return -EBUSY;
+
+	desc = ring->buf + (ring->prod_ptr & ring->size_mask);
+
+	desc->dma_addr = cpu_to_le64(dma_addr);
+	desc->ram_addr = cpu_to_le32(ram_addr);
+	desc->len = cpu_to_le16(len);
+	desc->tag = tag;
+	desc->flags = flags;
+
+	ring->prod_ptr = (ring->prod_ptr + 1) & EDEV_RING_PTR_MASK;
+
+	return 0;
+}
+
+void edev_ring_doorbell(struct example_ring *ring)
+{
+	// descriptors must be visible before the card fetches them
+	dma_wmb();
+	iowrite32(ring->prod_ptr, ring->hw_addr + EDEV_RING_REG_PROD_PTR);
+}
+
+// Write a descriptor directly into the card descriptor buffer through the
+// push window.  The card advances the producer and fetch pointers itself,
+// so no doorbell or descriptor fetch is needed.  With a write-combined
+// mapping, up to EDEV_DESC_PUSH_SLOTS descriptors go out as one TLP.
+int edev_ring_push(struct example_ring *ring, dma_addr_t dma_addr,
+		u32 ram_addr, u16 len, u8 tag, u8 flags)
+{
+	struct example_desc desc;
+	u32 slot = ring->prod_ptr & (EDEV_DESC_PUSH_SLOTS - 1);
+
+	if (edev_ring_full(ring))
+		return -EBUSY;
+
+	desc.dma_addr = cpu_to_le64(dma_addr);
+	desc.ram_addr = cpu_to_le32(ram_addr);
+	desc.len = cpu_to_le16(len);
+	desc.tag = tag;
+	desc.flags = flags;
+
+	__iowrite64_copy(ring->push_addr + slot * sizeof(desc), &desc, sizeof(desc) / 8);
+
+	ring->prod_ptr = (ring->prod_ptr + 1) & EDEV_RING_PTR_MASK;
+
+	// flush before reusing the line, otherwise the write-combining
+	// buffer would merge the next descriptor over an unsent one
+	if (slot == EDEV_DESC_PUSH_SLOTS - 1)
+		wmb();
+
+	return 0;
+}
+
+void edev_ring_push_flush(struct example_ring *ring)
+{
+	// drain write-combining buffer
+	wmb();
+}
+
+int edev_ring_wait(struct example_dev *edev, struct example_ring *ring,
+		unsigned int timeout_ms)
+{
+	struct example_cq *cq = ring->cq;
+	unsigned long t;
+	u32 ctrl;
+
+	ring->cq_error = false;
+
+	// wait for all posted descriptors to complete
+	// (card interrupts once the completion pointer catches up)
+	t = jiffies + msecs_to_jiffies(timeout_ms);
+	while (edev_ring_update_cpl_ptr(ring) != ring->prod_ptr) {
+		if (!time_before(jiffies, t))
+			break;
+		if (cq && !cq->overflow && edev_cq_spin(cq, EDEV_CQ_SPIN_US))
+			continue;
+		wait_for_completion_timeout(ring->irq_cpl, t - jiffies);
+	}
+
+	if (cq && !cq->overflow) {
+		if (ring->cpl_ptr == ring->prod_ptr && !ring->cq_error)
+			return 0;
+
+		// records may have been dropped, fall back to the card registers
+		ctrl = ioread32(cq->hw_addr + EDEV_CQ_REG_CTRL);
+		if (ctrl & EDEV_CQ_CTRL_OVERFLOW) {
+			dev_warn(edev->dev, "%s: completion queue overflow", __func__);
+			cq->overflow = true;
+		}
+		ring->cpl_ptr = ioread32(ring->hw_addr + EDEV_RING_REG_CPL_PTR) & EDEV_RING_PTR_MASK;
+	}
+
+	ctrl = ioread32(ring->hw_addr + EDEV_RING_REG_CTRL);
+
+	if (ctrl & EDEV_RING_CTRL_ERROR) {
+		dev_warn(edev->dev, "%s: descriptor ring error (ctrl 0x%08x)", __func__, ctrl);
+		return -EIO;
+	}
+
+	if (edev_ring_update_cpl_ptr(ring) != ring->prod_ptr) {
+		dev_warn(edev->dev, "%s: operation timed out (prod %d cpl %d)",
+				__func__, ring->prod_ptr, ring->cpl_ptr);
+		return -ETIMEDOUT;
+	}
+
+	return 0;
+}
@@ -0,0 +1,236 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "example_driver.h"
+#include "example_ioctl.h"
+#include <linux/dma-mapping.h>
+#include <linux/err.h>
+#include <linux/mm.h>
+#include <linux/sched/mm.h>
+#include <linux/slab.h>
+#include <linux/version.h>
+
+static void edev_release_user_pages(struct page **pages, unsigned long nr_pages)
+{
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+	unpin_user_pages_dirty_lock(pages, nr_pages, true);
+#else
+	unsigned long k;
+
+	for (k = 0; k < nr_pages; k++) {
+		set_page_dirty_lock(pages[k]);
+		put_page(pages[k]);
+	}
+#endif
+}
+
+struct example_user_buf *edev_map_user_buf(struct example_dev *edev,
+		unsigned long addr, size_t len)
+{
+	struct example_user_buf *ubuf;
+	long pinned;
+	int ret;
+
+	if (!len || len > EDEV_USER_BUF_MAX_LEN || addr + len < addr)
+		return ERR_PTR(-EINVAL);
+
+	ubuf = kzalloc(sizeof(*ubuf), GFP_KERNEL);
+	if (!ubuf)
+		return ERR_PTR(-ENOMEM);
+
+	ubuf->addr = addr;
+	ubuf->len = len;
+	ubuf->nr_pages = (offset_in_page(addr) + len + PAGE_SIZE - 1) >> PAGE_SHIFT;
+
+	// long term pins count against RLIMIT_MEMLOCK
+	ubuf->mm = current->mm;
+	mmgrab(ubuf->mm);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+	ret = account_locked_vm(ubuf->mm, ubuf->nr_pages, true);
+	if (ret)
+		goto fail_account;
+#endif
+
+	ubuf->pages = kvmalloc_array(ubuf->nr_pages, sizeof(struct page *), GFP_KERNEL);
+	if (!ubuf->pages) {
+		ret = -ENOMEM;
+		goto fail_pages;
+	}
+
+	// pin user pages
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 6, 0)
+	pinned = pin_user_pages_fast(addr & PAGE_MASK, ubuf->nr_pages,
+			FOLL_WRITE | FOLL_LONGTERM, ubuf->pages);
+#else
+	pinned = get_user_pages_fast(addr & PAGE_MASK, ubuf->nr_pages,
+			FOLL_WRITE, ubuf->pages);
+#endif
+	if (pinned < 0) {
+		ret = pinned;
+		goto fail_pin;
+	}
+
+	if (pinned != ubuf->nr_pages) {
+		edev_release_user_pages(ubuf->pages, pinned);
+		ret = -EFAULT;
+		goto fail_pin;
+	}
+
+	// build and map scatter-gather list
+	ret = sg_alloc_table_from_pages(&ubuf->sgt, ubuf->pages, ubuf->nr_pages,
+			offset_in_page(addr), len, GFP_KERNEL);
+	if (ret)
+		goto fail_sg;
+
+	ubuf->nents = dma_map_sg(edev->dev, ubuf->sgt.sgl, ubuf->sgt.orig_nents,
+			DMA_BIDIRECTIONAL);
+	if (!ubuf->nents) {
+		ret = -EIO;
+		goto fail_map;
+	}
+
+	dev_dbg(edev->dev, "%s: Mapped user buffer 0x%lx len %zu (%lu pages, %d segments)",
+			__func__, addr, len, ubuf->nr_pages, ubuf->nents);
+
+	return ubuf;
+
+fail_map:
+	sg_free_table(&ubuf->sgt);
+fail_sg:
+	edev_release_user_pages(ubuf->pages, ubuf->nr_pages);
+fail_pin:
+	kvfree(ubuf->pages);
+fail_pages:
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+	account_locked_vm(ubuf->mm, ubuf->nr_pages, false);
+fail_account:
+#endif
+	mmdrop(ubuf->mm);
+	kfree(ubuf);
+	return ERR_PTR(ret);
+}
+
+void edev_unmap_user_buf(struct example_dev *edev, struct example_user_buf *ubuf)
+{
+	dma_unmap_sg(edev->dev, ubuf->sgt.sgl, ubuf->sgt.orig_nents, DMA_BIDIRECTIONAL);
+	sg_free_table(&ubuf->sgt);
+	edev_release_user_pages(ubuf->pages, ubuf->nr_pages);
+	kvfree(ubuf->pages);
+#if LINUX_VERSION_CODE >= KERNEL_VERSION(5, 2, 0)
+	account_locked_vm(ubuf->mm, ubuf->nr_pages, false);
+#endif
+	mmdrop(ubuf->mm);
+	kfree(ubuf);
+}
+
+static int edev_block_op(struct example_channel *ch, int dir, dma_addr_t dma_addr,
+		u32 ram_addr, u32 ram_offset, u32 block_len, u32 block_count, u64 *cycles)
+{
+	int ret;
+
+	if (dir == EDEV_DMA_TO_CARD) {
+		ret = dma_block_read(ch, dma_addr, 0, ~(size_t)0, block_len,
+				ram_addr, ram_offset, EDEV_CARD_RAM_SIZE - 1, block_len,
+				block_len, block_count);
+		*cycles += dma_block_cycles(ch, 0);
+	} else {
+		ret = dma_block_write(ch, dma_addr, 0, ~(size_t)0, block_len,
+				ram_addr, ram_offset, EDEV_CARD_RAM_SIZE - 1, block_len,
+				block_len, block_count);
+		*cycles += dma_block_cycles(ch, 1);
+	}
+
+	return ret;
+}
+
+int edev_user_buf_dma(struct example_channel *ch, struct example_user_buf *ubuf,
+		int dir, u64 offset, u64 len, u32 block_len, u32 ram_addr, u64 *cycles)
+{
+	struct example_dev *edev = ch->edev;
+	struct scatterlist *sg;
+	u32 ram_offset = 0;
+	int ret = 0;
+	int k;
+
+	if (dir != EDEV_DMA_TO_CARD && dir != EDEV_DMA_FROM_CARD)
+		return -EINVAL;
+
+	if (!block_len || block_len > EDEV_MAX_BLOCK_LEN)
+		return -EINVAL;
+
+	if (offset > ubuf->len || len > ubuf->len - offset)
+		return -EINVAL;
+
+	*cycles = 0;
+
+	if (dir == EDEV_DMA_TO_CARD)
+		dma_sync_sg_for_device(edev->dev, ubuf->sgt.sgl, ubuf->sgt.orig_nents, DMA_BIDIRECTIONAL);
+
+	// run block engine over each mapped segment
+	for_each_sg(ubuf->sgt.sgl, sg, ubuf->nents, k) {
+		dma_addr_t seg_addr = sg_dma_address(sg);
+		u64 seg_len = sg_dma_len(sg);
+		u64 count;
+
+		if (!len)
+			break;
+
+		if (offset >= seg_len) {
+			offset -= seg_len;
+			continue;
+		}
+
+		seg_addr += offset;
+		seg_len = min(seg_len - offset, len);
+		offset = 0;
+		len -= seg_len;
+
+		// whole blocks
+		count = div_u64(seg_len, block_len);
+		if (count) {
+			ret = edev_block_op(ch, dir, seg_addr, ram_addr, ram_offset,
+					block_len, count, cycles);
+			if (ret)
+				break;
+
+			seg_addr += count * block_len;
+			seg_len -= count * block_len;
+			ram_offset = (ram_offset + count * block_len) & (EDEV_CARD_RAM_SIZE - 1);
+		}
+
+		// remainder
+		if (seg_len) {
+			ret = edev_block_op(ch, dir, seg_addr, ram_addr, ram_offset,
+					seg_len, 1, cycles);
+			if (ret)
+				break;
+
+			ram_offset = (ram_offset + seg_len) & (EDEV_CARD_RAM_SIZE - 1);
+		}
+	}
+
+	if (dir == EDEV_DMA_FROM_CARD)
+		dma_sync_sg_for_cpu(edev->dev, ubuf->sgt.sgl, ubuf->sgt.orig_nents, DMA_BIDIRECTIONAL);
+
+	return ret;
+}
@@ -0,0 +1,350 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "example_driver.h"
+#include <linux/dma-mapping.h>
+#include <linux/fs.h>
+#include <linux/jiffies.h>
+#include <linux/ktime.h>
+#include <linux/uio.h>
+#include <linux/wait.h>
+
+// The character device read() and write() stream data through card RAM.
+// write() copies each chunk into a host bounce slot and queues a DMA read
+// into the matching card RAM slot without waiting for it; read() queues the
+// DMA writes back for every slot that has reached the card, then copies
+// slots out in order as they arrive.  With several slots in flight, the copy
+// of one slot overlaps the DMA of the next, and when a reader and a writer
+// run concurrently the two DMA directions overlap as well.
+
+static void *edev_stream_tx_buf(struct example_stream *stream, u32 k)
+{
+	return stream->buf + k * EDEV_STREAM_SLOT_SIZE;
+}
+
+static void *edev_stream_rx_buf(struct example_stream *stream, u32 k)
+{
+	return stream->buf + EDEV_CARD_RAM_SIZE + k * EDEV_STREAM_SLOT_SIZE;
+}
+
+static bool edev_stream_desc_done(struct example_ring *ring, u32 ptr)
+{
+	// done once the completion pointer has moved past it
+	return ((ring->prod_ptr - ptr) & EDEV_RING_PTR_MASK) >
+			((ring->prod_ptr - ring->cpl_ptr) & EDEV_RING_PTR_MASK);
+}
+
+static int edev_stream_wait(struct example_stream *stream, struct example_ring *ring, u32 ptr)
+{
+	struct example_channel *ch = stream->ch;
+	unsigned long t = jiffies + msecs_to_jiffies(EDEV_STREAM_TIMEOUT_MS);
+	u64 spin = ktime_get_ns() + EDEV_CQ_SPIN_US * NSEC_PER_USEC;
+	bool done;
+
+	for (;;) {
+		// the channel lock is only held briefly, so the other direction
+		// can queue descriptors while this one waits
+		mutex_lock(&ch->lock);
+		edev_ring_update_cpl_ptr(ring);
+		done = edev_stream_desc_done(ring, ptr);
+		mutex_unlock(&ch->lock);
+
+		if (done)
+			return 0;
+
+		if (!time_before(jiffies, t)) {
+			dev_warn(ch->edev->dev, "%s: stream DMA timed out (prod %d cpl %d)",
+					__func__, ring->prod_ptr, ring->cpl_ptr);
+			return -ETIMEDOUT;
+		}
+
+		if (ring->cq && ktime_get_ns() < spin) {
+			cpu_relax();
+			continue;
+		}
+
+		// the card interrupts once the ring has caught up
+		wait_for_completion_timeout(ring->irq_cpl, t - jiffies);
+		spin = ktime_get_ns() + EDEV_CQ_SPIN_US * NSEC_PER_USEC;
+	}
+}
+
+// queue DMA writes back to the host for slots in [fetch, head) that have
+// reached card RAM
+static int edev_stream_fetch(struct example_stream *stream, u32 head)
+{
+	struct example_channel *ch = stream->ch;
+	struct example_stream_slot *slot;
+	int ret = 0;
+	int n = 0;
+	u32 k;
+
+	mutex_lock(&ch->lock);
+
+	edev_ring_update_cpl_ptr(&ch->read_ring);
+
+	while (stream->fetch != head) {
+		k = stream->fetch % EDEV_STREAM_SLOTS;
+		slot = &stream->slot[k];
+
+		if (!edev_stream_desc_done(&ch->read_ring, slot->to_card_ptr))
+			break;
+
+		slot->from_card_ptr = ch->write_ring.prod_ptr;
+		ret = edev_ring_enqueue(&ch->write_ring,
+				stream->buf_dma_addr + EDEV_CARD_RAM_SIZE + k * EDEV_STREAM_SLOT_SIZE,
+				k * EDEV_STREAM_SLOT_SIZE, slot->len, k, 0);
+		if (ret)
+			break;
+
+		stream->fetch++;
+		n++;
+	}
+
+	if (n)
+		edev_ring_doorbell(&ch->write_ring);
+
+	mutex_unlock(&ch->lock);
+
+	return ret;
+}
+
+static bool edev_stream_nonblock(struct kiocb *iocb)
+{
+	return (iocb->ki_filp->f_flags & O_NONBLOCK) || (iocb->ki_flags & IOCB_NOWAIT);
+}
+
+ssize_t edev_stream_read_iter(struct kiocb *iocb, struct iov_iter *to)
+{
+	struct example_file *efile = iocb->ki_filp->private_data;
+	struct example_stream *stream = &efile->edev->stream;
+	struct example_stream_slot *slot;
+	size_t done = 0;
+	ssize_t ret = 0;
+	size_t n;
+	u32 head;
+	u32 k;
+
+	if (mutex_lock_interruptible(&stream->read_lock))
+		return -ERESTARTSYS;
+
+	while (iov_iter_count(to)) {
+		head = smp_load_acquire(&stream->head);
+
+		if (stream->tail == head) {
+			// return what has been read so far once the writer falls behind
+			if (done)
+				break;
+
+			if (edev_stream_nonblock(iocb)) {
+				ret = -EAGAIN;
+				break;
+			}
+
+			ret = wait_event_interruptible(stream->wait,
+					smp_load_acquire(&stream->head) != stream->tail ||
+					READ_ONCE(stream->stopped));
+			if (ret)
+				break;
+			if (READ_ONCE(stream->stopped)) {
+				ret = -ENODEV;
+				break;
+			}
+			continue;
+		}
+
+		ret = edev_stream_fetch(stream, head);
+		if (ret)
+			break;
+
+		k = stream->tail % EDEV_STREAM_SLOTS;
+		slot = &stream->slot[k];
+
+		if (stream->fetch == stream->tail) {
+			// oldest slot still on its way to the card
+			ret = edev_stream_wait(stream, &stream->ch->read_ring, slot->to_card_ptr);
+			if (ret)
+				break;
+			continue;
+		}
+
+		if (!slot->offset) {
+			ret = edev_stream_wait(stream, &stream->ch->write_ring, slot->from_card_ptr);
+			if (ret)
+				break;
+
+			// completion is reported after the data has been written
+			dma_rmb();
+		}
+
+		n = copy_to_iter(edev_stream_rx_buf(stream, k) + slot->offset,
+				slot->len - slot->offset, to);
+		if (!n) {
+			ret = -EFAULT;
+			break;
+		}
+
+		slot->offset += n;
+		done += n;
+
+		if (slot->offset == slot->len) {
+			// hand the slot back to the writer
+			smp_store_release(&stream->tail, stream->tail + 1);
+			wake_up_interruptible(&stream->wait);
+		}
+	}
+
+	mutex_unlock(&stream->read_lock);
+
+	return done ? done : ret;
+}
+
+static bool edev_stream_space(struct example_stream *stream)
+{
+	return stream->head - smp_load_acquire(&stream->tail) < EDEV_STREAM_SLOTS;
+}
+
+ssize_t edev_stream_write_iter(struct kiocb *iocb, struct iov_iter *from)
+{
+	struct example_file *efile = iocb->ki_filp->private_data;
+	struct example_stream *stream = &efile->edev->stream;
+	struct example_channel *ch = stream->ch;
+	struct example_stream_slot *slot;
+	size_t done = 0;
+	ssize_t ret = 0;
+	size_t n;
+	u32 k;
+
+	if (mutex_lock_interruptible(&stream->write_lock))
+		return -ERESTARTSYS;
+
+	while (iov_iter_count(from)) {
+		if (!edev_stream_space(stream)) {
+			if (edev_stream_nonblock(iocb)) {
+				ret = -EAGAIN;
+				break;
+			}
+
+			// wait for the reader to drain a slot
+			ret = wait_event_interruptible(stream->wait,
+					edev_stream_space(stream) || READ_ONCE(stream->stopped));
+			if (ret)
+				break;
+			if (READ_ONCE(stream->stopped)) {
+				ret = -ENODEV;
+				break;
+			}
+			continue;
+		}
+
+		k = stream->head % EDEV_STREAM_SLOTS;
+		slot = &stream->slot[k];
+
+		n = copy_from_iter(edev_stream_tx_buf(stream, k),
+				min_t(size_t, iov_iter_count(from), EDEV_STREAM_SLOT_SIZE), from);
+		if (!n) {
+			ret = -EFAULT;
+			break;
+		}
+
+		slot->len = n;
+		slot->offset = 0;
+
+		// the previous slot may still be in flight, don't wait for it;
+		// head moves under the channel lock so that other users of the
+		// channel see the slot as soon as it is queued
+		mutex_lock(&ch->lock);
+		slot->to_card_ptr = ch->read_ring.prod_ptr;
+		ret = edev_ring_enqueue(&ch->read_ring,
+				stream->buf_dma_addr + k * EDEV_STREAM_SLOT_SIZE,
+				k * EDEV_STREAM_SLOT_SIZE, n, k, 0);
+		if (!ret) {
+			edev_ring_doorbell(&ch->read_ring);
+			smp_store_release(&stream->head, stream->head + 1);
+		}
+		mutex_unlock(&ch->lock);
+
+		if (ret) {
+			iov_iter_revert(from, n);
+			break;
+		}
+
+		wake_up_interruptible(&stream->wait);
+
+		done += n;
+	}
+
+	mutex_unlock(&stream->write_lock);
+
+	return done ? done : ret;
+}
+
+int edev_create_stream(struct example_dev *edev, struct example_stream *stream,
+		struct example_channel *ch)
+{
+	stream->ch = ch;
+	stream->head = 0;
+	stream->fetch = 0;
+	stream->tail = 0;
+	stream->stopped = false;
+
+	mutex_init(&stream->write_lock);
+	mutex_init(&stream->read_lock);
+	init_waitqueue_head(&stream->wait);
+
+	stream->buf_size = 2 * EDEV_CARD_RAM_SIZE;
+	stream->buf = dma_alloc_coherent(edev->dev, stream->buf_size,
+			&stream->buf_dma_addr, GFP_KERNEL);
+	if (!stream->buf)
+		return -ENOMEM;
+
+	return 0;
+}
+
+// Tests, benchmarks and user DMA use all of card RAM and share the rings,
+// so they are refused while stream data is in flight on their channel.
+// Called with ch->lock held.
+int edev_stream_check_idle(struct example_stream *stream, struct example_channel *ch)
+{
+	if (stream->ch == ch && stream->head != READ_ONCE(stream->tail))
+		return -EBUSY;
+
+	return 0;
+}
+
+// wake blocked readers and writers, which then fail with -ENODEV
+void edev_stop_stream(struct example_stream *stream)
+{
+	WRITE_ONCE(stream->stopped, true);
+	wake_up_interruptible(&stream->wait);
+}
+
+void edev_destroy_stream(struct example_dev *edev, struct example_stream *stream)
+{
+	if (!stream->buf)
+		return;
+
+	dma_free_coherent(edev->dev, stream->buf_size, stream->buf, stream->buf_dma_addr);
+	stream->buf = NULL;
+	stream->buf_dma_addr = 0;
+}
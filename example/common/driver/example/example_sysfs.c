@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: MIT
+/*
+ * Copyright (c) 2018-2021 Alex Forencich
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include "example_driver.h"
+#include <linux/device.h>
+#include <linux/io.h>
+#include <linux/math64.h>
+#include <linux/pci.h>
+#include <linux/sysfs.h>
+
+// DMA read statistics, collected by the card in channel 0
+// (cycle counts are converted to ns where it makes sense)
+
+static void __iomem *edev_stats_addr(struct device *dev)
+{
+	struct example_dev *edev = dev_get_drvdata(dev);
+
+	return edev->ch[0].hw_addr + EDEV_REG_STATS;
+}
+
+static u32 edev_stats_read32(struct device *dev, u32 reg)
+{
+	return ioread32(edev_stats_addr(dev) + reg);
+}
+
+static u64 edev_stats_read64(struct device *dev, u32 reg)
+{
+	return edev_read64(edev_stats_addr(dev) + reg);
+}
+
+// fixed point mean with two decimal places
+static ssize_t edev_stats_show_mean(char *buf, u64 sum, u64 count)
+{
+	u64 val;
+	u32 rem;
+
+	if (!count)
+		return sprintf(buf, "0.00\n");
+
+	val = div_u64_rem(div64_u64(sum * 100, count), 100, &rem);
+	return sprintf(buf, "%llu.%02u\n", val, rem);
+}
+
+static ssize_t rd_lat_count_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%u\n", edev_stats_read32(dev, EDEV_STATS_REG_LAT_COUNT));
+}
+static DEVICE_ATTR_RO(rd_lat_count);
+
+static ssize_t rd_lat_min_ns_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct example_dev *edev = dev_get_drvdata(dev);
+
+	if (!edev_stats_read32(dev, EDEV_STATS_REG_LAT_COUNT))
+		return sprintf(buf, "0\n");
+
+	return sprintf(buf, "%llu\n", edev_cycles_to_ns(edev,
+			edev_stats_read32(dev, EDEV_STATS_REG_LAT_MIN)));
+}
+static DEVICE_ATTR_RO(rd_lat_min_ns);
+
+static ssize_t rd_lat_max_ns_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct example_dev *edev = dev_get_drvdata(dev);
+
+	return sprintf(buf, "%llu\n", edev_cycles_to_ns(edev,
+			edev_stats_read32(dev, EDEV_STATS_REG_LAT_MAX)));
+}
+static DEVICE_ATTR_RO(rd_lat_max_ns);
+
+static ssize_t rd_lat_mean_ns_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct example_dev *edev = dev_get_drvdata(dev);
+	u64 sum = edev_stats_read64(dev, EDEV_STATS_REG_LAT_SUM);
+	u32 count = edev_stats_read32(dev, EDEV_STATS_REG_LAT_COUNT);
+
+	return sprintf(buf, "%llu\n", count ? div_u64(edev_cycles_to_ns(edev, sum), count) : 0);
+}
+static DEVICE_ATTR_RO(rd_lat_mean_ns);
+
+static ssize_t rd_lat_hist_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	struct example_dev *edev = dev_get_drvdata(dev);
+	ssize_t len = 0;
+	int k;
+
+	for (k = 0; k < EDEV_STATS_LAT_HIST_BINS; k++) {
+		u32 val = edev_stats_read32(dev, EDEV_STATS_REG_LAT_HIST + k * 4);
+		u64 lo = k ? edev_cycles_to_ns(edev, 1ULL << k) : 0;
+		u64 hi = edev_cycles_to_ns(edev, 2ULL << k) - 1;
+
+		len += scnprintf(buf + len, PAGE_SIZE - len, "%8llu-%-8llu ns: %u\n", lo, hi, val);
+	}
+
+	return len;
+}
+static DEVICE_ATTR_RO(rd_lat_hist);
+
+static ssize_t rd_tags_mean_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return edev_stats_show_mean(buf, edev_stats_read64(dev, EDEV_STATS_REG_TAG_SUM),
+			edev_stats_read64(dev, EDEV_STATS_REG_CYCLES));
+}
+static DEVICE_ATTR_RO(rd_tags_mean);
+
+static ssize_t rd_ops_mean_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return edev_stats_show_mean(buf, edev_stats_read64(dev, EDEV_STATS_REG_OP_SUM),
+			edev_stats_read64(dev, EDEV_STATS_REG_CYCLES));
+}
+static DEVICE_ATTR_RO(rd_ops_mean);
+
+static ssize_t window_cycles_show(struct device *dev,
+		struct device_attribute *attr, char *buf)
+{
+	return sprintf(buf, "%llu\n", edev_stats_read64(dev, EDEV_STATS_REG_CYCLES));
+}
+static DEVICE_ATTR_RO(window_cycles);
+
+// plain 32 bit counters
+#define EDEV_STATS_ATTR(_name, _reg) \
+static ssize_t _name##_show(struct device *dev, \
+		struct device_attribute *attr, char *buf) \
+{ \
+	return sprintf(buf, "%u\n", edev_stats_read32(dev, _reg)); \
+} \
+static DEVICE_ATTR_RO(_name)
+
+EDEV_STATS_ATTR(rd_tags_max, EDEV_STATS_REG_TAG_MAX);
+EDEV_STATS_ATTR(rd_ops_max, EDEV_STATS_REG_OP_MAX);
+EDEV_STATS_ATTR(rd_no_tags_cycles, EDEV_STATS_REG_NO_TAGS);
+EDEV_STATS_ATTR(rd_op_table_full_cycles, EDEV_STATS_REG_OP_TABLE_FULL);
+EDEV_STATS_ATTR(rd_cplh_stall_cycles, EDEV_STATS_REG_CPLH_STALL);
+EDEV_STATS_ATTR(rd_cpld_stall_cycles, EDEV_STATS_REG_CPLD_STALL);
+EDEV_STATS_ATTR(rd_tx_limit_stall_cycles, EDEV_STATS_REG_TX_LIMIT_STALL);
+EDEV_STATS_ATTR(rd_tx_stall_cycles, EDEV_STATS_REG_TX_STALL);
+
+static ssize_t clear_store(struct device *dev,
+		struct device_attribute *attr, const char *buf, size_t count)
+{
+	iowrite32(EDEV_STATS_CTRL_CLEAR, edev_stats_addr(dev) + EDEV_STATS_REG_CTRL);
+	return count;
+}
+static DEVICE_ATTR_WO(clear);
+
+static struct attribute *edev_stats_attrs[] = {
+	&dev_attr_rd_lat_count.attr,
+	&dev_attr_rd_lat_min_ns.attr,
+	&dev_attr_rd_lat_max_ns.attr,
+	&dev_attr_rd_lat_mean_ns.attr,
+	&dev_attr_rd_lat_hist.attr,
+	&dev_attr_rd_tags_mean.attr,
+	&dev_attr_rd_tags_max.attr,
+	&dev_attr_rd_ops_mean.attr,
+	&dev_attr_rd_ops_max.attr,
+	&dev_attr_rd_no_tags_cycles.attr,
+	&dev_attr_rd_op_table_full_cycles.attr,
+	&dev_attr_rd_cplh_stall_cycles.attr,
+	&dev_attr_rd_cpld_stall_cycles.attr,
+	&dev_attr_rd_tx_limit_stall_cycles.attr,
+	&dev_attr_rd_tx_stall_cycles.attr,
+	&dev_attr_window_cycles.attr,
+	&dev_attr_clear.attr,
+	NULL,
+};
+
+static const struct attribute_group edev_stats_group = {
+	.name = "dma_stats",
+	.attrs = edev_stats_attrs,
+};
+
+void edev_sysfs_create(struct example_dev *edev)
+{
+	if (!(ioread32(edev->ch[0].hw_addr + EDEV_REG_STATS + EDEV_STATS_REG_CTRL) & EDEV_STATS_CTRL_PRESENT)) {
+		dev_info(edev->dev, "DMA statistics not supported by design");
+		return;
+	}
+
+	// statistics are optional, carry on without them
+	if (sysfs_create_group(&edev->dev->kobj, &edev_stats_group)) {
+		dev_warn(edev->dev, "Failed to create DMA statistics attributes");
+		return;
+	}
+
+	edev->stats_sysfs = true;
+}
+
+void edev_sysfs_destroy(struct example_dev *edev)
+{
+	if (!edev->stats_sysfs)
+		return;
+
+	sysfs_remove_group(&edev->dev->kobj, &edev_stats_group);
+	edev->stats_sysfs = false;
+}
@@ -48,7 +48,7 @@ module example_core #
     // DMA Length field width
     parameter DMA_LEN_WIDTH = 16,
     // DMA Tag field width
-    parameter DMA_TAG_WIDTH = 8,
+    parameter DMA_TAG_WIDTH = 16,
     // RAM select width
     parameter RAM_SEL_WIDTH = 2,
     // RAM address width
@@ -62,7 +62,19 @@ module example_core #
     // RAM segment address width
     parameter RAM_SEG_ADDR_WIDTH = RAM_ADDR_WIDTH-$clog2(RAM_SEG_COUNT*RAM_SEG_BE_WIDTH),
     // Interrupt configuration
-    parameter IRQ_INDEX_WIDTH = 5
+    parameter IRQ_INDEX_WIDTH = 5,
+    // Descriptor buffer size (per ring, in descriptors)
+    parameter DESC_BUF_SIZE = 8,
+    // DMA channel index and count (reported to the driver)
+    parameter CHANNEL_INDEX = 0,
+    parameter CHANNEL_COUNT = 1,
+    // Collect DMA read statistics
+    parameter DMA_STATS_ENABLE = 1,
+    // Compile-time completion credit limits of the DMA read path (reported to the driver)
+    parameter DMA_CPLH_FC_LIMIT = 0,
+    parameter DMA_CPLD_FC_LIMIT = 0,
+    // Core clock frequency in kHz (reported to the driver)
+    parameter CLK_FREQ_KHZ = 250000
 )
 (
     input  wire                                         clk,
@@ -163,11 +175,179 @@ module example_core #
     input  wire                                         dma_rd_req,
     input  wire                                         dma_rd_cpl,
     input  wire                                         dma_wr_req,
-    output wire                                         rx_cpl_stall
+    output wire                                         rx_cpl_stall,
+    output wire [11:0]                                  dma_rd_cplh_fc_limit,
+    output wire [15:0]                                  dma_rd_cpld_fc_limit,
+    output wire [15:0]                                  irq_prescale,
+    output wire [15:0]                                  irq_min_interval,
+
+    /*
+     * DMA read statistics
+     */
+    input  wire [15:0]                                  dma_rd_lat,
+    input  wire                                         dma_rd_lat_valid,
+    input  wire [15:0]                                  dma_rd_active_tags,
+    input  wire [15:0]                                  dma_rd_active_ops,
+    input  wire                                         dma_rd_no_tags,
+    input  wire                                         dma_rd_op_table_full,
+    input  wire                                         dma_rd_cplh_stall,
+    input  wire                                         dma_rd_cpld_stall,
+    input  wire                                         dma_rd_tx_limit_stall,
+    input  wire                                         dma_rd_tx_stall
 );
 
 localparam RAM_ADDR_IMM_WIDTH = (DMA_IMM_ENABLE && (DMA_IMM_WIDTH > RAM_ADDR_WIDTH)) ? DMA_IMM_WIDTH : RAM_ADDR_WIDTH;
 
+localparam RAM_ROW_BYTES = RAM_SEG_COUNT*RAM_SEG_BE_WIDTH;
+
+// descriptor ring configuration
+// descriptor format (16 bytes, little endian):
+// [63:0] DMA address, [95:64] RAM address (or immediate), [111:96] length,
+// [119:112] tag, [127] immediate enable
+localparam DESC_SIZE = 16;
+localparam DESC_BUF_PTR_WIDTH = $clog2(DESC_BUF_SIZE)+1;
+localparam DESC_BUF_BYTES = 2*DESC_BUF_SIZE*DESC_SIZE;
+localparam RING_PTR_WIDTH = 16;
+
+// descriptor push window (0x3000, one 64 byte line per ring, 4 descriptor slots each)
+// a descriptor is committed to the ring once all four of its dwords are written,
+// so a single write-combined burst can carry up to four descriptors
+localparam DESC_PUSH_SLOTS = 4;
+
+// completion queue (0x2200)
+// one 4 byte record per single or ring operation, posted with an immediate write:
+// [7:0] tag, [11:8] error, [12] write, [13] ring, [15] phase, [31:16] timestamp
+// (cycle count [15:0]); records are staged in a small FIFO per direction
+localparam CQ_FIFO_SIZE = 16;
+localparam CQ_FIFO_PTR_WIDTH = $clog2(CQ_FIFO_SIZE)+1;
+
+// block engine address patterns (0x1004, 0x1104)
+// linear: base + ((offset + n*stride) & mask)
+// random: base + (lfsr & mask & ~(stride-1)), with a 32 bit LFSR seeded
+// from 0x1020 and advanced once per block (stride is the alignment)
+// list: base + (entry & mask), with 64 bit entries fetched from a host
+// memory list at 0x10a0 of 2**log_size entries, wrapping at the end;
+// the list must hold at least LIST_FETCH_SIZE entries
+localparam [1:0]
+    BLOCK_MODE_LINEAR = 2'd0,
+    BLOCK_MODE_RANDOM = 2'd1,
+    BLOCK_MODE_LIST = 2'd2;
+
+// per-block latency (0x1030, 0x1130): cycles from descriptor issue to
+// status, with the issue time kept in a table indexed by the low bits of
+// the block tag; blocks in flight are limited to the table size
+localparam BLOCK_LAT_TAG_WIDTH = DMA_TAG_WIDTH-2 < 8 ? DMA_TAG_WIDTH-2 : 8;
+localparam BLOCK_LAT_TABLE_SIZE = 2**BLOCK_LAT_TAG_WIDTH;
+
+localparam LIST_ENTRY_SIZE = 8;
+localparam LIST_BUF_SIZE = 16;
+localparam LIST_BUF_PTR_WIDTH = $clog2(LIST_BUF_SIZE)+1;
+localparam LIST_FETCH_SIZE = LIST_BUF_SIZE/2;
+localparam LIST_BUF_BYTES = 2*LIST_BUF_SIZE*LIST_ENTRY_SIZE;
+
+// descriptor buffer RAM holds both descriptor buffers, then both address lists
+localparam DESC_RAM_BYTES = DESC_BUF_BYTES + LIST_BUF_BYTES;
+
+// advance the x^32 + x^22 + x^2 + x + 1 LFSR by 32 steps, so consecutive
+// blocks get unrelated addresses
+function [31:0] lfsr_next(input [31:0] state);
+    integer b;
+    begin
+        lfsr_next = state;
+        for (b = 0; b < 32; b = b + 1) begin
+            lfsr_next = {lfsr_next[30:0], 1'b0} ^ (lfsr_next[31] ? 32'h00400007 : 32'h00000000);
+        end
+    end
+endfunction
+
+// DMA tag source (upper two bits of DMA tag)
+localparam [1:0]
+    TAG_SRC_REG = 2'd0,
+    TAG_SRC_RING = 2'd1,
+    TAG_SRC_FETCH = 2'd2,
+    TAG_SRC_BLOCK = 2'd3;
+
+// fetch tags: [1] 0 = descriptor ring, 1 = block address list, [0] 0 = read, 1 = write
+
+// descriptor fetches only use the read path, so the write path reuses the
+// fetch tag source for completion queue records
+localparam [1:0]
+    TAG_SRC_CPL = 2'd2;
+
+// check configuration
+initial begin
+    if (DMA_TAG_WIDTH < 10) begin
+        $error("Error: DMA tag width must be at least 10 (instance %m)");
+        $finish;
+    end
+
+    if (RAM_SEL_WIDTH < 2) begin
+        $error("Error: RAM select width must be at least 2 (instance %m)");
+        $finish;
+    end
+
+    if (2**$clog2(DESC_BUF_SIZE) != DESC_BUF_SIZE) begin
+        $error("Error: Descriptor buffer size must be a power of 2 (instance %m)");
+        $finish;
+    end
+
+    if (DMA_IMM_ENABLE && DMA_IMM_WIDTH < 32) begin
+        $error("Error: Immediate width must be at least 32 for completion records (instance %m)");
+        $finish;
+    end
+end
+
+// RAM write demux (select MSB: 0 = data RAM, 1 = descriptor buffer and address lists)
+wire [RAM_SEG_COUNT*RAM_SEG_BE_WIDTH-1:0]    data_ram_wr_cmd_be;
+wire [RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH-1:0]  data_ram_wr_cmd_addr;
+wire [RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH-1:0]  data_ram_wr_cmd_data;
+wire [RAM_SEG_COUNT-1:0]                     data_ram_wr_cmd_valid;
+wire [RAM_SEG_COUNT-1:0]                     data_ram_wr_cmd_ready;
+wire [RAM_SEG_COUNT-1:0]                     data_ram_wr_done;
+
+wire [RAM_SEG_COUNT*RAM_SEG_BE_WIDTH-1:0]    desc_ram_wr_cmd_be;
+wire [RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH-1:0]  desc_ram_wr_cmd_addr;
+wire [RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH-1:0]  desc_ram_wr_cmd_data;
+wire [RAM_SEG_COUNT-1:0]                     desc_ram_wr_cmd_valid;
+wire [RAM_SEG_COUNT-1:0]                     desc_ram_wr_cmd_ready;
+wire [RAM_SEG_COUNT-1:0]                     desc_ram_wr_done;
+
+dma_ram_demux_wr #(
+    .PORTS(2),
+    .SEG_COUNT(RAM_SEG_COUNT),
+    .SEG_DATA_WIDTH(RAM_SEG_DATA_WIDTH),
+    .SEG_BE_WIDTH(RAM_SEG_BE_WIDTH),
+    .SEG_ADDR_WIDTH(RAM_SEG_ADDR_WIDTH),
+    .S_RAM_SEL_WIDTH(RAM_SEL_WIDTH-1),
+    .M_RAM_SEL_WIDTH(RAM_SEL_WIDTH)
+)
+dma_ram_demux_wr_inst (
+    .clk(clk),
+    .rst(rst),
+
+    /*
+     * RAM interface (from DMA interface)
+     */
+    .ctrl_wr_cmd_sel(ram_wr_cmd_sel),
+    .ctrl_wr_cmd_be(ram_wr_cmd_be),
+    .ctrl_wr_cmd_addr(ram_wr_cmd_addr),
+    .ctrl_wr_cmd_data(ram_wr_cmd_data),
+    .ctrl_wr_cmd_valid(ram_wr_cmd_valid),
+    .ctrl_wr_cmd_ready(ram_wr_cmd_ready),
+    .ctrl_wr_done(ram_wr_done),
+
+    /*
+     * RAM interface (towards RAM)
+     */
+    .ram_wr_cmd_sel(),
+    .ram_wr_cmd_be({desc_ram_wr_cmd_be, data_ram_wr_cmd_be}),
+    .ram_wr_cmd_addr({desc_ram_wr_cmd_addr, data_ram_wr_cmd_addr}),
+    .ram_wr_cmd_data({desc_ram_wr_cmd_data, data_ram_wr_cmd_data}),
+    .ram_wr_cmd_valid({desc_ram_wr_cmd_valid, data_ram_wr_cmd_valid}),
+    .ram_wr_cmd_ready({desc_ram_wr_cmd_ready, data_ram_wr_cmd_ready}),
+    .ram_wr_done({desc_ram_wr_done, data_ram_wr_done})
+);
+
 dma_psdpram #(
     .SIZE(16384),
     .SEG_COUNT(RAM_SEG_COUNT),
@@ -183,12 +363,12 @@ dma_ram_inst (
     /*
      * Write port
      */
-    .wr_cmd_be(ram_wr_cmd_be),
-    .wr_cmd_addr(ram_wr_cmd_addr),
-    .wr_cmd_data(ram_wr_cmd_data),
-    .wr_cmd_valid(ram_wr_cmd_valid),
-    .wr_cmd_ready(ram_wr_cmd_ready),
-    .wr_done(ram_wr_done),
+    .wr_cmd_be(data_ram_wr_cmd_be),
+    .wr_cmd_addr(data_ram_wr_cmd_addr),
+    .wr_cmd_data(data_ram_wr_cmd_data),
+    .wr_cmd_valid(data_ram_wr_cmd_valid),
+    .wr_cmd_ready(data_ram_wr_cmd_ready),
+    .wr_done(data_ram_wr_done),
 
     /*
      * Read port
@@ -201,6 +381,42 @@ dma_ram_inst (
     .rd_resp_ready(ram_rd_resp_ready)
 );
 
+// descriptor buffer and block address lists
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [7:0] desc_buf_reg[DESC_RAM_BYTES-1:0];
+
+// descriptor push write port
+reg [DESC_BUF_PTR_WIDTH-1:0] desc_push_index_reg = 0, desc_push_index_next;
+reg [DESC_SIZE*8-1:0] desc_push_data_reg = 0, desc_push_data_next;
+reg desc_push_valid_reg = 1'b0, desc_push_valid_next;
+
+reg [RAM_SEG_COUNT-1:0] desc_ram_wr_done_reg = 0;
+
+assign desc_ram_wr_cmd_ready = {RAM_SEG_COUNT{1'b1}};
+assign desc_ram_wr_done = desc_ram_wr_done_reg;
+
+integer k;
+
+always @(posedge clk) begin
+    for (k = 0; k < DESC_RAM_BYTES; k = k + 1) begin
+        if (desc_ram_wr_cmd_valid[(k % RAM_ROW_BYTES) / RAM_SEG_BE_WIDTH]
+                && desc_ram_wr_cmd_addr[((k % RAM_ROW_BYTES) / RAM_SEG_BE_WIDTH)*RAM_SEG_ADDR_WIDTH +: RAM_SEG_ADDR_WIDTH] == k / RAM_ROW_BYTES
+                && desc_ram_wr_cmd_be[k % RAM_ROW_BYTES]) begin
+            desc_buf_reg[k] <= desc_ram_wr_cmd_data[(k % RAM_ROW_BYTES)*8 +: 8];
+        end
+
+        if (desc_push_valid_reg && k / DESC_SIZE == desc_push_index_reg) begin
+            desc_buf_reg[k] <= desc_push_data_reg[(k % DESC_SIZE)*8 +: 8];
+        end
+    end
+
+    desc_ram_wr_done_reg <= desc_ram_wr_cmd_valid;
+
+    if (rst) begin
+        desc_ram_wr_done_reg <= 0;
+    end
+end
+
 // control registers
 reg axil_ctrl_awready_reg = 1'b0, axil_ctrl_awready_next;
 reg axil_ctrl_wready_reg = 1'b0, axil_ctrl_wready_next;
@@ -217,8 +433,43 @@ reg [15:0] dma_write_active_count_reg = 0;
 reg [31:0] dma_rd_req_count_reg = 0;
 reg [31:0] dma_rd_cpl_count_reg = 0;
 reg [31:0] dma_wr_req_count_reg = 0;
+reg [31:0] dma_rd_error_count_reg = 0;
+
+// runtime completion credit limits (0 selects the compile-time limit)
+reg [11:0] dma_rd_cplh_fc_limit_reg = 0, dma_rd_cplh_fc_limit_next;
+reg [15:0] dma_rd_cpld_fc_limit_reg = 0, dma_rd_cpld_fc_limit_next;
+
+// DMA read statistics (0x0400)
+// latency is per read request, in clock cycles, with a log2 histogram
+// (bin n counts latencies in [2^n, 2^(n+1)), bin 0 also counts zero);
+// the DMA interface saturates latency at 16'hffff, so max and the top bin
+// read as "at least 65535 cycles" rather than wrapping to a small value;
+// occupancy is summed every cycle, stalls count cycles
+localparam STAT_HIST_BINS = 16;
+
+reg dma_stats_clear_reg = 1'b0, dma_stats_clear_next;
+
+reg [63:0] stat_window_cycles_reg = 0;
+reg [31:0] stat_rd_lat_count_reg = 0;
+reg [15:0] stat_rd_lat_min_reg = 16'hffff;
+reg [15:0] stat_rd_lat_max_reg = 0;
+reg [63:0] stat_rd_lat_sum_reg = 0;
+reg [31:0] stat_rd_lat_hist_reg[STAT_HIST_BINS-1:0];
+reg [63:0] stat_rd_tag_sum_reg = 0;
+reg [15:0] stat_rd_tag_max_reg = 0;
+reg [63:0] stat_rd_op_sum_reg = 0;
+reg [15:0] stat_rd_op_max_reg = 0;
+reg [31:0] stat_rd_no_tags_count_reg = 0;
+reg [31:0] stat_rd_op_table_full_count_reg = 0;
+reg [31:0] stat_rd_cplh_stall_count_reg = 0;
+reg [31:0] stat_rd_cpld_stall_count_reg = 0;
+reg [31:0] stat_rd_tx_limit_stall_count_reg = 0;
+reg [31:0] stat_rd_tx_stall_count_reg = 0;
+
+reg [3:0] stat_rd_lat_bin;
 
 reg [DMA_ADDR_WIDTH-1:0] dma_read_desc_dma_addr_reg = 0, dma_read_desc_dma_addr_next;
+reg [RAM_SEL_WIDTH-1:0] dma_read_desc_ram_sel_reg = 0, dma_read_desc_ram_sel_next;
 reg [RAM_ADDR_WIDTH-1:0] dma_read_desc_ram_addr_reg = 0, dma_read_desc_ram_addr_next;
 reg [DMA_LEN_WIDTH-1:0] dma_read_desc_len_reg = 0, dma_read_desc_len_next;
 reg [DMA_TAG_WIDTH-1:0] dma_read_desc_tag_reg = 0, dma_read_desc_tag_next;
@@ -242,6 +493,40 @@ reg dma_write_desc_status_valid_reg = 0, dma_write_desc_status_valid_next;
 reg dma_enable_reg = 0, dma_enable_next;
 reg dma_rd_int_en_reg = 0, dma_rd_int_en_next;
 reg dma_wr_int_en_reg = 0, dma_wr_int_en_next;
+reg [IRQ_INDEX_WIDTH-1:0] dma_rd_irq_index_reg = 0, dma_rd_irq_index_next;
+reg [IRQ_INDEX_WIDTH-1:0] dma_wr_irq_index_reg = 0, dma_wr_irq_index_next;
+reg dma_rd_irq_pending_reg = 1'b0, dma_rd_irq_pending_next;
+reg dma_wr_irq_pending_reg = 1'b0, dma_wr_irq_pending_next;
+
+// interrupt moderation
+// an interrupt is raised once count events have accumulated, or time ticks
+// after the first event (tick period is prescale+1 cycles); the default of
+// zero raises one interrupt per event
+reg [15:0] irq_prescale_reg = 0, irq_prescale_next;
+reg [15:0] irq_min_interval_reg = 0, irq_min_interval_next;
+reg [15:0] irq_prescale_count_reg = 0;
+reg irq_tick_reg = 1'b0;
+
+reg [15:0] dma_rd_irq_mod_count_reg = 0, dma_rd_irq_mod_count_next;
+reg [15:0] dma_rd_irq_mod_time_reg = 0, dma_rd_irq_mod_time_next;
+reg [15:0] dma_rd_irq_event_count_reg = 0, dma_rd_irq_event_count_next;
+reg [15:0] dma_rd_irq_timer_reg = 0, dma_rd_irq_timer_next;
+reg [15:0] dma_wr_irq_mod_count_reg = 0, dma_wr_irq_mod_count_next;
+reg [15:0] dma_wr_irq_mod_time_reg = 0, dma_wr_irq_mod_time_next;
+reg [15:0] dma_wr_irq_event_count_reg = 0, dma_wr_irq_event_count_next;
+reg [15:0] dma_wr_irq_timer_reg = 0, dma_wr_irq_timer_next;
+
+reg dma_rd_irq_event;
+reg dma_wr_irq_event;
+reg dma_rd_irq_issue;
+reg dma_wr_irq_issue;
+
+reg [31:0] dma_rd_event_count_reg = 0;
+reg [31:0] dma_rd_irq_count_reg = 0;
+reg [31:0] dma_wr_event_count_reg = 0;
+reg [31:0] dma_wr_irq_count_reg = 0;
+
+reg [IRQ_INDEX_WIDTH-1:0] irq_index_reg = 0, irq_index_next;
 reg irq_valid_reg = 1'b0, irq_valid_next;
 
 reg rx_cpl_stall_reg = 1'b0, rx_cpl_stall_next;
@@ -273,6 +558,229 @@ reg [RAM_ADDR_WIDTH-1:0] dma_write_block_ram_offset_reg = 0, dma_write_block_ram
 reg [RAM_ADDR_WIDTH-1:0] dma_write_block_ram_offset_mask_reg = 0, dma_write_block_ram_offset_mask_next;
 reg [RAM_ADDR_WIDTH-1:0] dma_write_block_ram_stride_reg = 0, dma_write_block_ram_stride_next;
 
+reg [1:0] dma_read_block_mode_reg = BLOCK_MODE_LINEAR, dma_read_block_mode_next;
+reg [31:0] dma_read_block_lfsr_reg = 0, dma_read_block_lfsr_next;
+reg [DMA_ADDR_WIDTH-1:0] dma_read_block_list_base_addr_reg = 0, dma_read_block_list_base_addr_next;
+reg [4:0] dma_read_block_list_log_size_reg = 0, dma_read_block_list_log_size_next;
+reg [31:0] dma_read_block_list_fetch_ptr_reg = 0, dma_read_block_list_fetch_ptr_next;
+reg [LIST_BUF_PTR_WIDTH-1:0] dma_read_block_list_wr_ptr_reg = 0, dma_read_block_list_wr_ptr_next;
+reg [LIST_BUF_PTR_WIDTH-1:0] dma_read_block_list_rd_ptr_reg = 0, dma_read_block_list_rd_ptr_next;
+reg dma_read_block_list_fetch_active_reg = 1'b0, dma_read_block_list_fetch_active_next;
+reg dma_read_block_list_error_reg = 1'b0, dma_read_block_list_error_next;
+
+reg [1:0] dma_write_block_mode_reg = BLOCK_MODE_LINEAR, dma_write_block_mode_next;
+reg [31:0] dma_write_block_lfsr_reg = 0, dma_write_block_lfsr_next;
+reg [DMA_ADDR_WIDTH-1:0] dma_write_block_list_base_addr_reg = 0, dma_write_block_list_base_addr_next;
+reg [4:0] dma_write_block_list_log_size_reg = 0, dma_write_block_list_log_size_next;
+reg [31:0] dma_write_block_list_fetch_ptr_reg = 0, dma_write_block_list_fetch_ptr_next;
+reg [LIST_BUF_PTR_WIDTH-1:0] dma_write_block_list_wr_ptr_reg = 0, dma_write_block_list_wr_ptr_next;
+reg [LIST_BUF_PTR_WIDTH-1:0] dma_write_block_list_rd_ptr_reg = 0, dma_write_block_list_rd_ptr_next;
+reg dma_write_block_list_fetch_active_reg = 1'b0, dma_write_block_list_fetch_active_next;
+reg dma_write_block_list_error_reg = 1'b0, dma_write_block_list_error_next;
+
+reg [BLOCK_LAT_TAG_WIDTH:0] dma_read_block_active_reg = 0, dma_read_block_active_next;
+reg dma_read_block_lat_clear_reg = 1'b0, dma_read_block_lat_clear_next;
+reg [31:0] dma_read_block_lat_count_reg = 0;
+reg [31:0] dma_read_block_lat_min_reg = 32'hffffffff;
+reg [31:0] dma_read_block_lat_max_reg = 0;
+reg [63:0] dma_read_block_lat_sum_reg = 0;
+
+reg [BLOCK_LAT_TAG_WIDTH:0] dma_write_block_active_reg = 0, dma_write_block_active_next;
+reg dma_write_block_lat_clear_reg = 1'b0, dma_write_block_lat_clear_next;
+reg [31:0] dma_write_block_lat_count_reg = 0;
+reg [31:0] dma_write_block_lat_min_reg = 32'hffffffff;
+reg [31:0] dma_write_block_lat_max_reg = 0;
+reg [63:0] dma_write_block_lat_sum_reg = 0;
+
+// block issue times (0 = read, 1 = write)
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [31:0] block_start_mem[2*BLOCK_LAT_TABLE_SIZE-1:0];
+
+reg dma_read_block_start_we;
+reg dma_write_block_start_we;
+
+reg dma_read_ring_enable_reg = 1'b0, dma_read_ring_enable_next;
+reg dma_read_ring_error_reg = 1'b0, dma_read_ring_error_next;
+reg [DMA_ADDR_WIDTH-1:0] dma_read_ring_base_addr_reg = 0, dma_read_ring_base_addr_next;
+reg [3:0] dma_read_ring_log_size_reg = 0, dma_read_ring_log_size_next;
+reg [RING_PTR_WIDTH-1:0] dma_read_ring_prod_ptr_reg = 0, dma_read_ring_prod_ptr_next;
+reg [RING_PTR_WIDTH-1:0] dma_read_ring_fetch_ptr_reg = 0, dma_read_ring_fetch_ptr_next;
+reg [RING_PTR_WIDTH-1:0] dma_read_ring_cpl_ptr_reg = 0, dma_read_ring_cpl_ptr_next;
+reg [DESC_BUF_PTR_WIDTH-1:0] dma_read_ring_buf_wr_ptr_reg = 0, dma_read_ring_buf_wr_ptr_next;
+reg [DESC_BUF_PTR_WIDTH-1:0] dma_read_ring_buf_rd_ptr_reg = 0, dma_read_ring_buf_rd_ptr_next;
+
+reg dma_write_ring_enable_reg = 1'b0, dma_write_ring_enable_next;
+reg dma_write_ring_error_reg = 1'b0, dma_write_ring_error_next;
+reg [DMA_ADDR_WIDTH-1:0] dma_write_ring_base_addr_reg = 0, dma_write_ring_base_addr_next;
+reg [3:0] dma_write_ring_log_size_reg = 0, dma_write_ring_log_size_next;
+reg [RING_PTR_WIDTH-1:0] dma_write_ring_prod_ptr_reg = 0, dma_write_ring_prod_ptr_next;
+reg [RING_PTR_WIDTH-1:0] dma_write_ring_fetch_ptr_reg = 0, dma_write_ring_fetch_ptr_next;
+reg [RING_PTR_WIDTH-1:0] dma_write_ring_cpl_ptr_reg = 0, dma_write_ring_cpl_ptr_next;
+reg [DESC_BUF_PTR_WIDTH-1:0] dma_write_ring_buf_wr_ptr_reg = 0, dma_write_ring_buf_wr_ptr_next;
+reg [DESC_BUF_PTR_WIDTH-1:0] dma_write_ring_buf_rd_ptr_reg = 0, dma_write_ring_buf_rd_ptr_next;
+
+reg desc_fetch_active_reg = 1'b0, desc_fetch_active_next;
+reg desc_fetch_ring_reg = 1'b0, desc_fetch_ring_next;
+reg [DESC_BUF_PTR_WIDTH-1:0] desc_fetch_count_reg = 0, desc_fetch_count_next;
+
+reg [2*DESC_PUSH_SLOTS*DESC_SIZE*8-1:0] desc_push_stage_reg = 0, desc_push_stage_next;
+reg [2*DESC_PUSH_SLOTS*4-1:0] desc_push_mask_reg = 0, desc_push_mask_next;
+
+reg cq_enable_reg = 1'b0, cq_enable_next;
+reg cq_overflow_reg = 1'b0, cq_overflow_next;
+reg [DMA_ADDR_WIDTH-1:0] cq_base_addr_reg = 0, cq_base_addr_next;
+reg [3:0] cq_log_size_reg = 0, cq_log_size_next;
+reg [RING_PTR_WIDTH-1:0] cq_prod_ptr_reg = 0, cq_prod_ptr_next;
+reg [RING_PTR_WIDTH-1:0] cq_cons_ptr_reg = 0, cq_cons_ptr_next;
+reg cq_arb_reg = 1'b0, cq_arb_next;
+
+// completion record FIFOs (0 = read, 1 = write)
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [31:0] cq_fifo_mem[2*CQ_FIFO_SIZE-1:0];
+
+reg [CQ_FIFO_PTR_WIDTH-1:0] cq_rd_fifo_wr_ptr_reg = 0, cq_rd_fifo_wr_ptr_next;
+reg [CQ_FIFO_PTR_WIDTH-1:0] cq_rd_fifo_rd_ptr_reg = 0, cq_rd_fifo_rd_ptr_next;
+reg [CQ_FIFO_PTR_WIDTH-1:0] cq_wr_fifo_wr_ptr_reg = 0, cq_wr_fifo_wr_ptr_next;
+reg [CQ_FIFO_PTR_WIDTH-1:0] cq_wr_fifo_rd_ptr_reg = 0, cq_wr_fifo_rd_ptr_next;
+
+reg cq_rd_fifo_we;
+reg [31:0] cq_rd_fifo_wr_data;
+reg cq_wr_fifo_we;
+reg [31:0] cq_wr_fifo_wr_data;
+
+// descriptor ring fetch sizing
+wire [RING_PTR_WIDTH:0] dma_read_ring_size = {{RING_PTR_WIDTH{1'b0}}, 1'b1} << dma_read_ring_log_size_reg;
+wire [RING_PTR_WIDTH-1:0] dma_read_ring_avail = dma_read_ring_prod_ptr_reg - dma_read_ring_fetch_ptr_reg;
+wire [RING_PTR_WIDTH:0] dma_read_ring_contig = dma_read_ring_size - (dma_read_ring_fetch_ptr_reg & (dma_read_ring_size-1));
+wire [DESC_BUF_PTR_WIDTH-1:0] dma_read_ring_buf_free = DESC_BUF_SIZE - (dma_read_ring_buf_wr_ptr_reg - dma_read_ring_buf_rd_ptr_reg);
+wire [DESC_BUF_PTR_WIDTH-1:0] dma_read_ring_buf_contig = DESC_BUF_SIZE - dma_read_ring_buf_wr_ptr_reg[DESC_BUF_PTR_WIDTH-2:0];
+reg [DESC_BUF_PTR_WIDTH-1:0] dma_read_ring_fetch_count;
+
+wire [RING_PTR_WIDTH:0] dma_write_ring_size = {{RING_PTR_WIDTH{1'b0}}, 1'b1} << dma_write_ring_log_size_reg;
+wire [RING_PTR_WIDTH-1:0] dma_write_ring_avail = dma_write_ring_prod_ptr_reg - dma_write_ring_fetch_ptr_reg;
+wire [RING_PTR_WIDTH:0] dma_write_ring_contig = dma_write_ring_size - (dma_write_ring_fetch_ptr_reg & (dma_write_ring_size-1));
+wire [DESC_BUF_PTR_WIDTH-1:0] dma_write_ring_buf_free = DESC_BUF_SIZE - (dma_write_ring_buf_wr_ptr_reg - dma_write_ring_buf_rd_ptr_reg);
+wire [DESC_BUF_PTR_WIDTH-1:0] dma_write_ring_buf_contig = DESC_BUF_SIZE - dma_write_ring_buf_wr_ptr_reg[DESC_BUF_PTR_WIDTH-2:0];
+reg [DESC_BUF_PTR_WIDTH-1:0] dma_write_ring_fetch_count;
+
+// block address list buffer levels
+wire [31:0] dma_read_block_list_size_mask = ({32{1'b1}} << dma_read_block_list_log_size_reg) ^ {32{1'b1}};
+wire [LIST_BUF_PTR_WIDTH-1:0] dma_read_block_list_level = dma_read_block_list_wr_ptr_reg - dma_read_block_list_rd_ptr_reg;
+wire dma_read_block_list_fetch = dma_read_block_run_reg && dma_read_block_mode_reg == BLOCK_MODE_LIST
+    && !dma_read_block_list_fetch_active_reg && !dma_read_block_list_error_reg
+    && LIST_BUF_SIZE - dma_read_block_list_level >= LIST_FETCH_SIZE && dma_read_block_list_level < dma_read_block_count_reg;
+
+wire [31:0] dma_write_block_list_size_mask = ({32{1'b1}} << dma_write_block_list_log_size_reg) ^ {32{1'b1}};
+wire [LIST_BUF_PTR_WIDTH-1:0] dma_write_block_list_level = dma_write_block_list_wr_ptr_reg - dma_write_block_list_rd_ptr_reg;
+wire dma_write_block_list_fetch = dma_write_block_run_reg && dma_write_block_mode_reg == BLOCK_MODE_LIST
+    && !dma_write_block_list_fetch_active_reg && !dma_write_block_list_error_reg
+    && LIST_BUF_SIZE - dma_write_block_list_level >= LIST_FETCH_SIZE && dma_write_block_list_level < dma_write_block_count_reg;
+
+// block latency, valid with the block status
+wire [BLOCK_LAT_TAG_WIDTH-1:0] dma_read_block_start_index = dma_read_block_count_reg[BLOCK_LAT_TAG_WIDTH-1:0];
+wire [BLOCK_LAT_TAG_WIDTH-1:0] dma_write_block_start_index = dma_write_block_count_reg[BLOCK_LAT_TAG_WIDTH-1:0];
+wire [31:0] dma_read_block_lat = cycle_count_reg[31:0] - block_start_mem[s_axis_dma_read_desc_status_tag[BLOCK_LAT_TAG_WIDTH-1:0]];
+wire [31:0] dma_write_block_lat = cycle_count_reg[31:0] - block_start_mem[BLOCK_LAT_TABLE_SIZE + s_axis_dma_write_desc_status_tag[BLOCK_LAT_TAG_WIDTH-1:0]];
+wire dma_read_block_lat_valid = s_axis_dma_read_desc_status_valid && s_axis_dma_read_desc_status_tag[DMA_TAG_WIDTH-1 -: 2] == TAG_SRC_BLOCK;
+wire dma_write_block_lat_valid = s_axis_dma_write_desc_status_valid && s_axis_dma_write_desc_status_tag[DMA_TAG_WIDTH-1 -: 2] == TAG_SRC_BLOCK;
+
+always @(posedge clk) begin
+    if (dma_read_block_start_we) begin
+        block_start_mem[dma_read_block_start_index] <= cycle_count_reg[31:0];
+    end
+    if (dma_write_block_start_we) begin
+        block_start_mem[BLOCK_LAT_TABLE_SIZE + dma_write_block_start_index] <= cycle_count_reg[31:0];
+    end
+end
+
+// completion queue sizing
+wire cq_supported = DMA_IMM_ENABLE;
+wire [RING_PTR_WIDTH:0] cq_size = {{RING_PTR_WIDTH{1'b0}}, 1'b1} << cq_log_size_reg;
+wire cq_space = ((cq_prod_ptr_reg - cq_cons_ptr_reg) & {RING_PTR_WIDTH{1'b1}}) < cq_size;
+wire cq_rd_fifo_empty = cq_rd_fifo_wr_ptr_reg == cq_rd_fifo_rd_ptr_reg;
+wire cq_rd_fifo_full = cq_rd_fifo_wr_ptr_reg == (cq_rd_fifo_rd_ptr_reg ^ {1'b1, {CQ_FIFO_PTR_WIDTH-1{1'b0}}});
+wire cq_wr_fifo_empty = cq_wr_fifo_wr_ptr_reg == cq_wr_fifo_rd_ptr_reg;
+wire cq_wr_fifo_full = cq_wr_fifo_wr_ptr_reg == (cq_wr_fifo_rd_ptr_reg ^ {1'b1, {CQ_FIFO_PTR_WIDTH-1{1'b0}}});
+wire [31:0] cq_rd_fifo_rd_data = cq_fifo_mem[cq_rd_fifo_rd_ptr_reg[CQ_FIFO_PTR_WIDTH-2:0]];
+wire [31:0] cq_wr_fifo_rd_data = cq_fifo_mem[CQ_FIFO_SIZE + cq_wr_fifo_rd_ptr_reg[CQ_FIFO_PTR_WIDTH-2:0]];
+
+// phase bit flips on each pass through the queue, starting at 1
+wire cq_phase = !((cq_prod_ptr_reg >> cq_log_size_reg) & 1);
+
+always @(posedge clk) begin
+    if (cq_rd_fifo_we) begin
+        cq_fifo_mem[cq_rd_fifo_wr_ptr_reg[CQ_FIFO_PTR_WIDTH-2:0]] <= cq_rd_fifo_wr_data;
+    end
+    if (cq_wr_fifo_we) begin
+        cq_fifo_mem[CQ_FIFO_SIZE + cq_wr_fifo_wr_ptr_reg[CQ_FIFO_PTR_WIDTH-2:0]] <= cq_wr_fifo_wr_data;
+    end
+end
+
+// descriptor push decode
+wire desc_push_sel = {s_axil_ctrl_awaddr[15:7], 7'd0} == 16'h3000;
+wire desc_push_ring = s_axil_ctrl_awaddr[6];
+wire [2:0] desc_push_slot = s_axil_ctrl_awaddr[6:4];
+wire [1:0] desc_push_dword = s_axil_ctrl_awaddr[3:2];
+wire desc_push_commit = desc_push_sel && (desc_push_mask_reg[desc_push_slot*4 +: 4] | (4'b0001 << desc_push_dword)) == 4'b1111;
+
+// pushed descriptors go straight into the descriptor buffer, so the ring must
+// not have a fetch outstanding or any descriptors waiting to be fetched
+wire dma_read_ring_push_ready = !dma_read_ring_enable_reg || (dma_read_ring_buf_free != 0
+    && dma_read_ring_avail == 0 && !(desc_fetch_active_reg && !desc_fetch_ring_reg) && !desc_push_valid_reg);
+wire dma_write_ring_push_ready = !dma_write_ring_enable_reg || (dma_write_ring_buf_free != 0
+    && dma_write_ring_avail == 0 && !(desc_fetch_active_reg && desc_fetch_ring_reg) && !desc_push_valid_reg);
+
+// hold off the write until the descriptor can be accepted
+wire desc_push_stall = desc_push_commit && (desc_push_ring ? !dma_write_ring_push_ready : !dma_read_ring_push_ready);
+
+always @* begin
+    dma_read_ring_fetch_count = dma_read_ring_buf_contig;
+    if (dma_read_ring_buf_free < dma_read_ring_fetch_count) begin
+        dma_read_ring_fetch_count = dma_read_ring_buf_free;
+    end
+    if (dma_read_ring_avail < dma_read_ring_fetch_count) begin
+        dma_read_ring_fetch_count = dma_read_ring_avail;
+    end
+    if (dma_read_ring_contig < dma_read_ring_fetch_count) begin
+        dma_read_ring_fetch_count = dma_read_ring_contig;
+    end
+
+    dma_write_ring_fetch_count = dma_write_ring_buf_contig;
+    if (dma_write_ring_buf_free < dma_write_ring_fetch_count) begin
+        dma_write_ring_fetch_count = dma_write_ring_buf_free;
+    end
+    if (dma_write_ring_avail < dma_write_ring_fetch_count) begin
+        dma_write_ring_fetch_count = dma_write_ring_avail;
+    end
+    if (dma_write_ring_contig < dma_write_ring_fetch_count) begin
+        dma_write_ring_fetch_count = dma_write_ring_contig;
+    end
+end
+
+// descriptors at head of descriptor buffers
+wire [DESC_SIZE*8-1:0] dma_read_ring_desc;
+wire [DESC_SIZE*8-1:0] dma_write_ring_desc;
+
+// entries at head of block address lists
+wire [LIST_ENTRY_SIZE*8-1:0] dma_read_block_list_entry;
+wire [LIST_ENTRY_SIZE*8-1:0] dma_write_block_list_entry;
+
+generate
+
+genvar n;
+
+for (n = 0; n < DESC_SIZE; n = n + 1) begin : desc_out
+    assign dma_read_ring_desc[n*8 +: 8] = desc_buf_reg[dma_read_ring_buf_rd_ptr_reg[DESC_BUF_PTR_WIDTH-2:0]*DESC_SIZE + n];
+    assign dma_write_ring_desc[n*8 +: 8] = desc_buf_reg[(DESC_BUF_SIZE + dma_write_ring_buf_rd_ptr_reg[DESC_BUF_PTR_WIDTH-2:0])*DESC_SIZE + n];
+end
+
+for (n = 0; n < LIST_ENTRY_SIZE; n = n + 1) begin : list_out
+    assign dma_read_block_list_entry[n*8 +: 8] = desc_buf_reg[DESC_BUF_BYTES + dma_read_block_list_rd_ptr_reg[LIST_BUF_PTR_WIDTH-2:0]*LIST_ENTRY_SIZE + n];
+    assign dma_write_block_list_entry[n*8 +: 8] = desc_buf_reg[DESC_BUF_BYTES + (LIST_BUF_SIZE + dma_write_block_list_rd_ptr_reg[LIST_BUF_PTR_WIDTH-2:0])*LIST_ENTRY_SIZE + n];
+end
+
+endgenerate
+
 assign s_axil_ctrl_awready = axil_ctrl_awready_reg;
 assign s_axil_ctrl_wready = axil_ctrl_wready_reg;
 assign s_axil_ctrl_bresp = axil_ctrl_bresp_reg;
@@ -283,7 +791,7 @@ assign s_axil_ctrl_rresp = axil_ctrl_rresp_reg;
 assign s_axil_ctrl_rvalid = axil_ctrl_rvalid_reg;
 
 assign m_axis_dma_read_desc_dma_addr = dma_read_desc_dma_addr_reg;
-assign m_axis_dma_read_desc_ram_sel = 0;
+assign m_axis_dma_read_desc_ram_sel = dma_read_desc_ram_sel_reg;
 assign m_axis_dma_read_desc_ram_addr = dma_read_desc_ram_addr_reg;
 assign m_axis_dma_read_desc_len = dma_read_desc_len_reg;
 assign m_axis_dma_read_desc_tag = dma_read_desc_tag_reg;
@@ -298,11 +806,15 @@ assign m_axis_dma_write_desc_len = dma_write_desc_len_reg;
 assign m_axis_dma_write_desc_tag = dma_write_desc_tag_reg;
 assign m_axis_dma_write_desc_valid = dma_write_desc_valid_reg;
 
-assign irq_index = 0;
+assign irq_index = irq_index_reg;
 assign irq_valid = irq_valid_reg;
 
 assign dma_enable = dma_enable_reg;
 assign rx_cpl_stall = rx_cpl_stall_reg;
+assign dma_rd_cplh_fc_limit = dma_rd_cplh_fc_limit_reg;
+assign dma_rd_cpld_fc_limit = dma_rd_cpld_fc_limit_reg;
+assign irq_prescale = irq_prescale_reg;
+assign irq_min_interval = irq_min_interval_reg;
 
 always @* begin
     axil_ctrl_awready_next = 1'b0;
@@ -315,6 +827,7 @@ always @* begin
     axil_ctrl_rvalid_next = axil_ctrl_rvalid_reg && !s_axil_ctrl_rready;
 
     dma_read_desc_dma_addr_next = dma_read_desc_dma_addr_reg;
+    dma_read_desc_ram_sel_next = dma_read_desc_ram_sel_reg;
     dma_read_desc_ram_addr_next = dma_read_desc_ram_addr_reg;
     dma_read_desc_len_next = dma_read_desc_len_reg;
     dma_read_desc_tag_next = dma_read_desc_tag_reg;
@@ -340,11 +853,39 @@ always @* begin
     dma_rd_int_en_next = dma_rd_int_en_reg;
     dma_wr_int_en_next = dma_wr_int_en_reg;
 
+    dma_rd_irq_index_next = dma_rd_irq_index_reg;
+    dma_wr_irq_index_next = dma_wr_irq_index_reg;
+    dma_rd_irq_pending_next = dma_rd_irq_pending_reg;
+    dma_wr_irq_pending_next = dma_wr_irq_pending_reg;
+
+    irq_prescale_next = irq_prescale_reg;
+    irq_min_interval_next = irq_min_interval_reg;
+
+    dma_rd_irq_mod_count_next = dma_rd_irq_mod_count_reg;
+    dma_rd_irq_mod_time_next = dma_rd_irq_mod_time_reg;
+    dma_rd_irq_event_count_next = dma_rd_irq_event_count_reg;
+    dma_rd_irq_timer_next = dma_rd_irq_timer_reg;
+    dma_wr_irq_mod_count_next = dma_wr_irq_mod_count_reg;
+    dma_wr_irq_mod_time_next = dma_wr_irq_mod_time_reg;
+    dma_wr_irq_event_count_next = dma_wr_irq_event_count_reg;
+    dma_wr_irq_timer_next = dma_wr_irq_timer_reg;
+
+    dma_rd_irq_event = 1'b0;
+    dma_wr_irq_event = 1'b0;
+    dma_rd_irq_issue = 1'b0;
+    dma_wr_irq_issue = 1'b0;
+
+    irq_index_next = irq_index_reg;
     irq_valid_next = irq_valid_reg && !irq_ready;
 
     rx_cpl_stall_next = 1'b0;
     rx_cpl_stall_count_next = rx_cpl_stall_count_reg;
 
+    dma_rd_cplh_fc_limit_next = dma_rd_cplh_fc_limit_reg;
+    dma_rd_cpld_fc_limit_next = dma_rd_cpld_fc_limit_reg;
+
+    dma_stats_clear_next = 1'b0;
+
     dma_read_block_run_next = dma_read_block_run_reg;
     dma_read_block_len_next = dma_read_block_len_reg;
     dma_read_block_count_next = dma_read_block_count_reg;
@@ -371,12 +912,88 @@ always @* begin
     dma_write_block_ram_offset_mask_next = dma_write_block_ram_offset_mask_reg;
     dma_write_block_ram_stride_next = dma_write_block_ram_stride_reg;
 
+    dma_read_block_mode_next = dma_read_block_mode_reg;
+    dma_read_block_lfsr_next = dma_read_block_lfsr_reg;
+    dma_read_block_list_base_addr_next = dma_read_block_list_base_addr_reg;
+    dma_read_block_list_log_size_next = dma_read_block_list_log_size_reg;
+    dma_read_block_list_fetch_ptr_next = dma_read_block_list_fetch_ptr_reg;
+    dma_read_block_list_wr_ptr_next = dma_read_block_list_wr_ptr_reg;
+    dma_read_block_list_rd_ptr_next = dma_read_block_list_rd_ptr_reg;
+    dma_read_block_list_fetch_active_next = dma_read_block_list_fetch_active_reg;
+    dma_read_block_list_error_next = dma_read_block_list_error_reg;
+
+    dma_write_block_mode_next = dma_write_block_mode_reg;
+    dma_write_block_lfsr_next = dma_write_block_lfsr_reg;
+    dma_write_block_list_base_addr_next = dma_write_block_list_base_addr_reg;
+    dma_write_block_list_log_size_next = dma_write_block_list_log_size_reg;
+    dma_write_block_list_fetch_ptr_next = dma_write_block_list_fetch_ptr_reg;
+    dma_write_block_list_wr_ptr_next = dma_write_block_list_wr_ptr_reg;
+    dma_write_block_list_rd_ptr_next = dma_write_block_list_rd_ptr_reg;
+    dma_write_block_list_fetch_active_next = dma_write_block_list_fetch_active_reg;
+    dma_write_block_list_error_next = dma_write_block_list_error_reg;
+
+    dma_read_block_active_next = dma_read_block_active_reg;
+    dma_read_block_lat_clear_next = 1'b0;
+    dma_write_block_active_next = dma_write_block_active_reg;
+    dma_write_block_lat_clear_next = 1'b0;
+
+    dma_read_block_start_we = 1'b0;
+    dma_write_block_start_we = 1'b0;
+
+    dma_read_ring_enable_next = dma_read_ring_enable_reg;
+    dma_read_ring_error_next = dma_read_ring_error_reg;
+    dma_read_ring_base_addr_next = dma_read_ring_base_addr_reg;
+    dma_read_ring_log_size_next = dma_read_ring_log_size_reg;
+    dma_read_ring_prod_ptr_next = dma_read_ring_prod_ptr_reg;
+    dma_read_ring_fetch_ptr_next = dma_read_ring_fetch_ptr_reg;
+    dma_read_ring_cpl_ptr_next = dma_read_ring_cpl_ptr_reg;
+    dma_read_ring_buf_wr_ptr_next = dma_read_ring_buf_wr_ptr_reg;
+    dma_read_ring_buf_rd_ptr_next = dma_read_ring_buf_rd_ptr_reg;
+
+    dma_write_ring_enable_next = dma_write_ring_enable_reg;
+    dma_write_ring_error_next = dma_write_ring_error_reg;
+    dma_write_ring_base_addr_next = dma_write_ring_base_addr_reg;
+    dma_write_ring_log_size_next = dma_write_ring_log_size_reg;
+    dma_write_ring_prod_ptr_next = dma_write_ring_prod_ptr_reg;
+    dma_write_ring_fetch_ptr_next = dma_write_ring_fetch_ptr_reg;
+    dma_write_ring_cpl_ptr_next = dma_write_ring_cpl_ptr_reg;
+    dma_write_ring_buf_wr_ptr_next = dma_write_ring_buf_wr_ptr_reg;
+    dma_write_ring_buf_rd_ptr_next = dma_write_ring_buf_rd_ptr_reg;
+
+    desc_fetch_active_next = desc_fetch_active_reg;
+    desc_fetch_ring_next = desc_fetch_ring_reg;
+    desc_fetch_count_next = desc_fetch_count_reg;
+
+    cq_enable_next = cq_enable_reg;
+    cq_overflow_next = cq_overflow_reg;
+    cq_base_addr_next = cq_base_addr_reg;
+    cq_log_size_next = cq_log_size_reg;
+    cq_prod_ptr_next = cq_prod_ptr_reg;
+    cq_cons_ptr_next = cq_cons_ptr_reg;
+    cq_arb_next = cq_arb_reg;
+
+    cq_rd_fifo_wr_ptr_next = cq_rd_fifo_wr_ptr_reg;
+    cq_rd_fifo_rd_ptr_next = cq_rd_fifo_rd_ptr_reg;
+    cq_wr_fifo_wr_ptr_next = cq_wr_fifo_wr_ptr_reg;
+    cq_wr_fifo_rd_ptr_next = cq_wr_fifo_rd_ptr_reg;
+
+    cq_rd_fifo_we = 1'b0;
+    cq_rd_fifo_wr_data = 0;
+    cq_wr_fifo_we = 1'b0;
+    cq_wr_fifo_wr_data = 0;
+
+    desc_push_stage_next = desc_push_stage_reg;
+    desc_push_mask_next = desc_push_mask_reg;
+    desc_push_index_next = desc_push_index_reg;
+    desc_push_data_next = desc_push_data_reg;
+    desc_push_valid_next = 1'b0;
+
     if (rx_cpl_stall_count_reg) begin
         rx_cpl_stall_count_next = rx_cpl_stall_count_reg - 1;
         rx_cpl_stall_next = 1'b1;
     end
 
-    if (s_axil_ctrl_awvalid && s_axil_ctrl_wvalid && !axil_ctrl_bvalid_reg) begin
+    if (s_axil_ctrl_awvalid && s_axil_ctrl_wvalid && !axil_ctrl_bvalid_reg && !desc_push_stall) begin
         // write operation
         axil_ctrl_awready_next = 1'b1;
         axil_ctrl_wready_next = 1'b1;
@@ -392,14 +1009,32 @@ always @* begin
                 dma_rd_int_en_next = s_axil_ctrl_wdata[0];
                 dma_wr_int_en_next = s_axil_ctrl_wdata[1];
             end
+            16'h000c: begin
+                dma_rd_irq_index_next = s_axil_ctrl_wdata[7:0];
+                dma_wr_irq_index_next = s_axil_ctrl_wdata[15:8];
+            end
             16'h0040: rx_cpl_stall_count_next = s_axil_ctrl_wdata;
+            16'h0048: dma_rd_cplh_fc_limit_next = s_axil_ctrl_wdata;
+            16'h004c: dma_rd_cpld_fc_limit_next = s_axil_ctrl_wdata;
+            // interrupt moderation
+            16'h0060: irq_prescale_next = s_axil_ctrl_wdata;
+            16'h0064: irq_min_interval_next = s_axil_ctrl_wdata;
+            16'h0068: begin
+                dma_rd_irq_mod_count_next = s_axil_ctrl_wdata[15:0];
+                dma_rd_irq_mod_time_next = s_axil_ctrl_wdata[31:16];
+            end
+            16'h006c: begin
+                dma_wr_irq_mod_count_next = s_axil_ctrl_wdata[15:0];
+                dma_wr_irq_mod_time_next = s_axil_ctrl_wdata[31:16];
+            end
             // single read
             16'h0100: dma_read_desc_dma_addr_next[31:0] = s_axil_ctrl_wdata;
             16'h0104: dma_read_desc_dma_addr_next[63:32] = s_axil_ctrl_wdata;
             16'h0108: dma_read_desc_ram_addr_next = s_axil_ctrl_wdata;
             16'h0110: dma_read_desc_len_next = s_axil_ctrl_wdata;
             16'h0114: begin
-                dma_read_desc_tag_next = s_axil_ctrl_wdata;
+                dma_read_desc_ram_sel_next = 0;
+                dma_read_desc_tag_next = s_axil_ctrl_wdata[DMA_TAG_WIDTH-3:0];
                 dma_read_desc_valid_next = 1'b1;
             end
             // single write
@@ -408,18 +1043,30 @@ always @* begin
             16'h0208: dma_write_desc_ram_addr_imm_next = s_axil_ctrl_wdata;
             16'h0210: dma_write_desc_len_next = s_axil_ctrl_wdata;
             16'h0214: begin
-                dma_write_desc_tag_next = s_axil_ctrl_wdata[23:0];
+                dma_write_desc_tag_next = s_axil_ctrl_wdata[DMA_TAG_WIDTH-3:0];
                 dma_write_desc_imm_en_next = s_axil_ctrl_wdata[31];
                 dma_write_desc_valid_next = 1'b1;
             end
+            // DMA read statistics
+            16'h0400: dma_stats_clear_next = s_axil_ctrl_wdata[0];
             // block read
             16'h1000: begin
                 dma_read_block_run_next = s_axil_ctrl_wdata[0];
+                dma_read_block_lat_clear_next = s_axil_ctrl_wdata[0];
+                if (s_axil_ctrl_wdata[0] && !dma_read_block_list_fetch_active_reg) begin
+                    // restart from the head of the address list
+                    dma_read_block_list_fetch_ptr_next = 0;
+                    dma_read_block_list_wr_ptr_next = 0;
+                    dma_read_block_list_rd_ptr_next = 0;
+                    dma_read_block_list_error_next = 1'b0;
+                end
             end
+            16'h1004: dma_read_block_mode_next = s_axil_ctrl_wdata[1:0];
             16'h1008: dma_read_block_cycle_count_next[31:0] = s_axil_ctrl_wdata;
             16'h100c: dma_read_block_cycle_count_next[63:32] = s_axil_ctrl_wdata;
             16'h1010: dma_read_block_len_next = s_axil_ctrl_wdata;
             16'h1018: dma_read_block_count_next[31:0] = s_axil_ctrl_wdata;
+            16'h1020: dma_read_block_lfsr_next = s_axil_ctrl_wdata;
             16'h1080: dma_read_block_dma_base_addr_next[31:0] = s_axil_ctrl_wdata;
             16'h1084: dma_read_block_dma_base_addr_next[63:32] = s_axil_ctrl_wdata;
             16'h1088: dma_read_block_dma_offset_next[31:0] = s_axil_ctrl_wdata;
@@ -428,6 +1075,9 @@ always @* begin
             16'h1094: dma_read_block_dma_offset_mask_next[63:32] = s_axil_ctrl_wdata;
             16'h1098: dma_read_block_dma_stride_next[31:0] = s_axil_ctrl_wdata;
             16'h109c: dma_read_block_dma_stride_next[63:32] = s_axil_ctrl_wdata;
+            16'h10a0: dma_read_block_list_base_addr_next[31:0] = s_axil_ctrl_wdata;
+            16'h10a4: dma_read_block_list_base_addr_next[63:32] = s_axil_ctrl_wdata;
+            16'h10a8: dma_read_block_list_log_size_next = s_axil_ctrl_wdata;
             16'h10c0: dma_read_block_ram_base_addr_next = s_axil_ctrl_wdata;
             16'h10c8: dma_read_block_ram_offset_next = s_axil_ctrl_wdata;
             16'h10d0: dma_read_block_ram_offset_mask_next = s_axil_ctrl_wdata;
@@ -435,11 +1085,21 @@ always @* begin
             // block write
             16'h1100: begin
                 dma_write_block_run_next = s_axil_ctrl_wdata[0];
+                dma_write_block_lat_clear_next = s_axil_ctrl_wdata[0];
+                if (s_axil_ctrl_wdata[0] && !dma_write_block_list_fetch_active_reg) begin
+                    // restart from the head of the address list
+                    dma_write_block_list_fetch_ptr_next = 0;
+                    dma_write_block_list_wr_ptr_next = 0;
+                    dma_write_block_list_rd_ptr_next = 0;
+                    dma_write_block_list_error_next = 1'b0;
+                end
             end
+            16'h1104: dma_write_block_mode_next = s_axil_ctrl_wdata[1:0];
             16'h1108: dma_write_block_cycle_count_next[31:0] = s_axil_ctrl_wdata;
             16'h110c: dma_write_block_cycle_count_next[63:32] = s_axil_ctrl_wdata;
             16'h1110: dma_write_block_len_next = s_axil_ctrl_wdata;
             16'h1118: dma_write_block_count_next[31:0] = s_axil_ctrl_wdata;
+            16'h1120: dma_write_block_lfsr_next = s_axil_ctrl_wdata;
             16'h1180: dma_write_block_dma_base_addr_next[31:0] = s_axil_ctrl_wdata;
             16'h1184: dma_write_block_dma_base_addr_next[63:32] = s_axil_ctrl_wdata;
             16'h1188: dma_write_block_dma_offset_next[31:0] = s_axil_ctrl_wdata;
@@ -448,11 +1108,102 @@ always @* begin
             16'h1194: dma_write_block_dma_offset_mask_next[63:32] = s_axil_ctrl_wdata;
             16'h1198: dma_write_block_dma_stride_next[31:0] = s_axil_ctrl_wdata;
             16'h119c: dma_write_block_dma_stride_next[63:32] = s_axil_ctrl_wdata;
+            16'h11a0: dma_write_block_list_base_addr_next[31:0] = s_axil_ctrl_wdata;
+            16'h11a4: dma_write_block_list_base_addr_next[63:32] = s_axil_ctrl_wdata;
+            16'h11a8: dma_write_block_list_log_size_next = s_axil_ctrl_wdata;
             16'h11c0: dma_write_block_ram_base_addr_next = s_axil_ctrl_wdata;
             16'h11c8: dma_write_block_ram_offset_next = s_axil_ctrl_wdata;
             16'h11d0: dma_write_block_ram_offset_mask_next = s_axil_ctrl_wdata;
             16'h11d8: dma_write_block_ram_stride_next = s_axil_ctrl_wdata;
+            // descriptor ring (read)
+            16'h2000: begin
+                dma_read_ring_enable_next = s_axil_ctrl_wdata[0];
+                dma_read_ring_error_next = 1'b0;
+            end
+            16'h2008: dma_read_ring_base_addr_next[31:0] = s_axil_ctrl_wdata;
+            16'h200c: dma_read_ring_base_addr_next[63:32] = s_axil_ctrl_wdata;
+            16'h2010: dma_read_ring_log_size_next = s_axil_ctrl_wdata[3:0];
+            16'h2018: dma_read_ring_prod_ptr_next = s_axil_ctrl_wdata;
+            16'h201c: begin
+                if (!dma_read_ring_enable_reg) begin
+                    dma_read_ring_fetch_ptr_next = s_axil_ctrl_wdata;
+                    dma_read_ring_buf_rd_ptr_next = dma_read_ring_buf_wr_ptr_reg;
+                end
+            end
+            16'h2020: begin
+                if (!dma_read_ring_enable_reg) begin
+                    dma_read_ring_cpl_ptr_next = s_axil_ctrl_wdata;
+                end
+            end
+            // descriptor ring (write)
+            16'h2100: begin
+                dma_write_ring_enable_next = s_axil_ctrl_wdata[0];
+                dma_write_ring_error_next = 1'b0;
+            end
+            16'h2108: dma_write_ring_base_addr_next[31:0] = s_axil_ctrl_wdata;
+            16'h210c: dma_write_ring_base_addr_next[63:32] = s_axil_ctrl_wdata;
+            16'h2110: dma_write_ring_log_size_next = s_axil_ctrl_wdata[3:0];
+            16'h2118: dma_write_ring_prod_ptr_next = s_axil_ctrl_wdata;
+            16'h211c: begin
+                if (!dma_write_ring_enable_reg) begin
+                    dma_write_ring_fetch_ptr_next = s_axil_ctrl_wdata;
+                    dma_write_ring_buf_rd_ptr_next = dma_write_ring_buf_wr_ptr_reg;
+                end
+            end
+            16'h2120: begin
+                if (!dma_write_ring_enable_reg) begin
+                    dma_write_ring_cpl_ptr_next = s_axil_ctrl_wdata;
+                end
+            end
+            // completion queue
+            16'h2200: begin
+                cq_enable_next = cq_supported && s_axil_ctrl_wdata[0];
+                cq_overflow_next = 1'b0;
+            end
+            16'h2208: cq_base_addr_next[31:0] = s_axil_ctrl_wdata;
+            16'h220c: cq_base_addr_next[63:32] = s_axil_ctrl_wdata;
+            16'h2210: cq_log_size_next = s_axil_ctrl_wdata[3:0];
+            16'h2218: begin
+                if (!cq_enable_reg) begin
+                    // reset queue, dropping any staged records
+                    cq_prod_ptr_next = s_axil_ctrl_wdata;
+                    cq_rd_fifo_rd_ptr_next = cq_rd_fifo_wr_ptr_reg;
+                    cq_wr_fifo_rd_ptr_next = cq_wr_fifo_wr_ptr_reg;
+                end
+            end
+            16'h221c: cq_cons_ptr_next = s_axil_ctrl_wdata;
         endcase
+
+        if (desc_push_sel) begin
+            // descriptor push window
+            desc_push_stage_next[(desc_push_slot*4 + desc_push_dword)*32 +: 32] = s_axil_ctrl_wdata;
+            desc_push_mask_next[desc_push_slot*4 + desc_push_dword] = 1'b1;
+
+            if (desc_push_commit) begin
+                desc_push_mask_next[desc_push_slot*4 +: 4] = 4'b0000;
+                desc_push_data_next = desc_push_stage_next[desc_push_slot*DESC_SIZE*8 +: DESC_SIZE*8];
+
+                if (desc_push_ring) begin
+                    if (dma_write_ring_enable_reg) begin
+                        desc_push_index_next = {1'b1, dma_write_ring_buf_wr_ptr_reg[DESC_BUF_PTR_WIDTH-2:0]};
+                        desc_push_valid_next = 1'b1;
+                        dma_write_ring_prod_ptr_next = dma_write_ring_prod_ptr_reg + 1;
+                        dma_write_ring_fetch_ptr_next = dma_write_ring_fetch_ptr_reg + 1;
+                    end else begin
+                        dma_write_ring_error_next = 1'b1;
+                    end
+                end else begin
+                    if (dma_read_ring_enable_reg) begin
+                        desc_push_index_next = {1'b0, dma_read_ring_buf_wr_ptr_reg[DESC_BUF_PTR_WIDTH-2:0]};
+                        desc_push_valid_next = 1'b1;
+                        dma_read_ring_prod_ptr_next = dma_read_ring_prod_ptr_reg + 1;
+                        dma_read_ring_fetch_ptr_next = dma_read_ring_fetch_ptr_reg + 1;
+                    end else begin
+                        dma_read_ring_error_next = 1'b1;
+                    end
+                end
+            end
+        end
     end
 
     if (s_axil_ctrl_arvalid && !axil_ctrl_rvalid_reg) begin
@@ -473,6 +1224,10 @@ always @* begin
                 axil_ctrl_rdata_next[0] = dma_rd_int_en_reg;
                 axil_ctrl_rdata_next[1] = dma_wr_int_en_reg;
             end
+            16'h000c: begin
+                axil_ctrl_rdata_next[7:0] = dma_rd_irq_index_reg;
+                axil_ctrl_rdata_next[15:8] = dma_wr_irq_index_reg;
+            end
             16'h0010: axil_ctrl_rdata_next = cycle_count_reg;
             16'h0014: axil_ctrl_rdata_next = cycle_count_reg >> 32;
             16'h0018: axil_ctrl_rdata_next = dma_read_active_count_reg;
@@ -480,7 +1235,30 @@ always @* begin
             16'h0020: axil_ctrl_rdata_next = dma_rd_req_count_reg;
             16'h0024: axil_ctrl_rdata_next = dma_rd_cpl_count_reg;
             16'h0028: axil_ctrl_rdata_next = dma_wr_req_count_reg;
+            16'h0030: axil_ctrl_rdata_next = CHANNEL_INDEX;
+            16'h0034: axil_ctrl_rdata_next = CHANNEL_COUNT;
             16'h0040: axil_ctrl_rdata_next = rx_cpl_stall_count_reg;
+            16'h0044: axil_ctrl_rdata_next = dma_rd_error_count_reg;
+            16'h0048: axil_ctrl_rdata_next = dma_rd_cplh_fc_limit_reg;
+            16'h004c: axil_ctrl_rdata_next = dma_rd_cpld_fc_limit_reg;
+            16'h0050: axil_ctrl_rdata_next = DMA_CPLH_FC_LIMIT;
+            16'h0054: axil_ctrl_rdata_next = DMA_CPLD_FC_LIMIT;
+            16'h0058: axil_ctrl_rdata_next = CLK_FREQ_KHZ;
+            // interrupt moderation
+            16'h0060: axil_ctrl_rdata_next = irq_prescale_reg;
+            16'h0064: axil_ctrl_rdata_next = irq_min_interval_reg;
+            16'h0068: begin
+                axil_ctrl_rdata_next[15:0] = dma_rd_irq_mod_count_reg;
+                axil_ctrl_rdata_next[31:16] = dma_rd_irq_mod_time_reg;
+            end
+            16'h006c: begin
+                axil_ctrl_rdata_next[15:0] = dma_wr_irq_mod_count_reg;
+                axil_ctrl_rdata_next[31:16] = dma_wr_irq_mod_time_reg;
+            end
+            16'h0070: axil_ctrl_rdata_next = dma_rd_event_count_reg;
+            16'h0074: axil_ctrl_rdata_next = dma_rd_irq_count_reg;
+            16'h0078: axil_ctrl_rdata_next = dma_wr_event_count_reg;
+            16'h007c: axil_ctrl_rdata_next = dma_wr_irq_count_reg;
             // single read
             16'h0100: axil_ctrl_rdata_next = dma_read_desc_dma_addr_reg;
             16'h0104: axil_ctrl_rdata_next = dma_read_desc_dma_addr_reg >> 32;
@@ -510,15 +1288,46 @@ always @* begin
                 axil_ctrl_rdata_next[31] = dma_write_desc_status_valid_reg;
                 dma_write_desc_status_valid_next = 1'b0;
             end
+            // DMA read statistics
+            16'h0400: axil_ctrl_rdata_next[0] = DMA_STATS_ENABLE;
+            16'h0404: axil_ctrl_rdata_next = stat_rd_lat_count_reg;
+            16'h0408: axil_ctrl_rdata_next = stat_rd_lat_min_reg;
+            16'h040c: axil_ctrl_rdata_next = stat_rd_lat_max_reg;
+            16'h0410: axil_ctrl_rdata_next = stat_rd_lat_sum_reg;
+            16'h0414: axil_ctrl_rdata_next = stat_rd_lat_sum_reg >> 32;
+            16'h0418: axil_ctrl_rdata_next = stat_window_cycles_reg;
+            16'h041c: axil_ctrl_rdata_next = stat_window_cycles_reg >> 32;
+            16'h0420: axil_ctrl_rdata_next = stat_rd_tag_sum_reg;
+            16'h0424: axil_ctrl_rdata_next = stat_rd_tag_sum_reg >> 32;
+            16'h0428: axil_ctrl_rdata_next = stat_rd_tag_max_reg;
+            16'h0430: axil_ctrl_rdata_next = stat_rd_op_sum_reg;
+            16'h0434: axil_ctrl_rdata_next = stat_rd_op_sum_reg >> 32;
+            16'h0438: axil_ctrl_rdata_next = stat_rd_op_max_reg;
+            16'h0440: axil_ctrl_rdata_next = stat_rd_no_tags_count_reg;
+            16'h0444: axil_ctrl_rdata_next = stat_rd_op_table_full_count_reg;
+            16'h0448: axil_ctrl_rdata_next = stat_rd_cplh_stall_count_reg;
+            16'h044c: axil_ctrl_rdata_next = stat_rd_cpld_stall_count_reg;
+            16'h0450: axil_ctrl_rdata_next = stat_rd_tx_limit_stall_count_reg;
+            16'h0454: axil_ctrl_rdata_next = stat_rd_tx_stall_count_reg;
             // block read
             16'h1000: begin
                 axil_ctrl_rdata_next[0] = dma_read_block_run_reg;
             end
+            16'h1004: begin
+                axil_ctrl_rdata_next[1:0] = dma_read_block_mode_reg;
+                axil_ctrl_rdata_next[16] = dma_read_block_list_error_reg;
+            end
             16'h1008: axil_ctrl_rdata_next = dma_read_block_cycle_count_reg;
             16'h100c: axil_ctrl_rdata_next = dma_read_block_cycle_count_reg >> 32;
             16'h1010: axil_ctrl_rdata_next = dma_read_block_len_reg;
             16'h1018: axil_ctrl_rdata_next = dma_read_block_count_reg;
             16'h101c: axil_ctrl_rdata_next = dma_read_block_count_reg >> 32;
+            16'h1020: axil_ctrl_rdata_next = dma_read_block_lfsr_reg;
+            16'h1030: axil_ctrl_rdata_next = dma_read_block_lat_count_reg;
+            16'h1034: axil_ctrl_rdata_next = dma_read_block_lat_min_reg;
+            16'h1038: axil_ctrl_rdata_next = dma_read_block_lat_max_reg;
+            16'h1040: axil_ctrl_rdata_next = dma_read_block_lat_sum_reg;
+            16'h1044: axil_ctrl_rdata_next = dma_read_block_lat_sum_reg >> 32;
             16'h1080: axil_ctrl_rdata_next = dma_read_block_dma_base_addr_reg;
             16'h1084: axil_ctrl_rdata_next = dma_read_block_dma_base_addr_reg >> 32;
             16'h1088: axil_ctrl_rdata_next = dma_read_block_dma_offset_reg;
@@ -527,6 +1336,9 @@ always @* begin
             16'h1094: axil_ctrl_rdata_next = dma_read_block_dma_offset_mask_reg >> 32;
             16'h1098: axil_ctrl_rdata_next = dma_read_block_dma_stride_reg;
             16'h109c: axil_ctrl_rdata_next = dma_read_block_dma_stride_reg >> 32;
+            16'h10a0: axil_ctrl_rdata_next = dma_read_block_list_base_addr_reg;
+            16'h10a4: axil_ctrl_rdata_next = dma_read_block_list_base_addr_reg >> 32;
+            16'h10a8: axil_ctrl_rdata_next = dma_read_block_list_log_size_reg;
             16'h10c0: axil_ctrl_rdata_next = dma_read_block_ram_base_addr_reg;
             16'h10c4: axil_ctrl_rdata_next = dma_read_block_ram_base_addr_reg >> 32;
             16'h10c8: axil_ctrl_rdata_next = dma_read_block_ram_offset_reg;
@@ -539,11 +1351,21 @@ always @* begin
             16'h1100: begin
                 axil_ctrl_rdata_next[0] = dma_write_block_run_reg;
             end
+            16'h1104: begin
+                axil_ctrl_rdata_next[1:0] = dma_write_block_mode_reg;
+                axil_ctrl_rdata_next[16] = dma_write_block_list_error_reg;
+            end
             16'h1108: axil_ctrl_rdata_next = dma_write_block_cycle_count_reg;
             16'h110c: axil_ctrl_rdata_next = dma_write_block_cycle_count_reg >> 32;
             16'h1110: axil_ctrl_rdata_next = dma_write_block_len_reg;
             16'h1118: axil_ctrl_rdata_next = dma_write_block_count_reg;
             16'h111c: axil_ctrl_rdata_next = dma_write_block_count_reg >> 32;
+            16'h1120: axil_ctrl_rdata_next = dma_write_block_lfsr_reg;
+            16'h1130: axil_ctrl_rdata_next = dma_write_block_lat_count_reg;
+            16'h1134: axil_ctrl_rdata_next = dma_write_block_lat_min_reg;
+            16'h1138: axil_ctrl_rdata_next = dma_write_block_lat_max_reg;
+            16'h1140: axil_ctrl_rdata_next = dma_write_block_lat_sum_reg;
+            16'h1144: axil_ctrl_rdata_next = dma_write_block_lat_sum_reg >> 32;
             16'h1180: axil_ctrl_rdata_next = dma_write_block_dma_base_addr_reg;
             16'h1184: axil_ctrl_rdata_next = dma_write_block_dma_base_addr_reg >> 32;
             16'h1188: axil_ctrl_rdata_next = dma_write_block_dma_offset_reg;
@@ -552,6 +1374,9 @@ always @* begin
             16'h1194: axil_ctrl_rdata_next = dma_write_block_dma_offset_mask_reg >> 32;
             16'h1198: axil_ctrl_rdata_next = dma_write_block_dma_stride_reg;
             16'h119c: axil_ctrl_rdata_next = dma_write_block_dma_stride_reg >> 32;
+            16'h11a0: axil_ctrl_rdata_next = dma_write_block_list_base_addr_reg;
+            16'h11a4: axil_ctrl_rdata_next = dma_write_block_list_base_addr_reg >> 32;
+            16'h11a8: axil_ctrl_rdata_next = dma_write_block_list_log_size_reg;
             16'h11c0: axil_ctrl_rdata_next = dma_write_block_ram_base_addr_reg;
             16'h11c4: axil_ctrl_rdata_next = dma_write_block_ram_base_addr_reg >> 32;
             16'h11c8: axil_ctrl_rdata_next = dma_write_block_ram_offset_reg;
@@ -560,28 +1385,247 @@ always @* begin
             16'h11d4: axil_ctrl_rdata_next = dma_write_block_ram_offset_mask_reg >> 32;
             16'h11d8: axil_ctrl_rdata_next = dma_write_block_ram_stride_reg;
             16'h11dc: axil_ctrl_rdata_next = dma_write_block_ram_stride_reg >> 32;
+            // descriptor ring (read)
+            16'h2000: begin
+                axil_ctrl_rdata_next[0] = dma_read_ring_enable_reg;
+                axil_ctrl_rdata_next[8] = dma_read_ring_cpl_ptr_reg != dma_read_ring_fetch_ptr_reg;
+                axil_ctrl_rdata_next[16] = dma_read_ring_error_reg;
+            end
+            16'h2004: axil_ctrl_rdata_next = DESC_BUF_SIZE;
+            16'h2008: axil_ctrl_rdata_next = dma_read_ring_base_addr_reg;
+            16'h200c: axil_ctrl_rdata_next = dma_read_ring_base_addr_reg >> 32;
+            16'h2010: axil_ctrl_rdata_next = dma_read_ring_log_size_reg;
+            16'h2018: axil_ctrl_rdata_next = dma_read_ring_prod_ptr_reg;
+            16'h201c: axil_ctrl_rdata_next = dma_read_ring_fetch_ptr_reg;
+            16'h2020: axil_ctrl_rdata_next = dma_read_ring_cpl_ptr_reg;
+            // descriptor ring (write)
+            16'h2100: begin
+                axil_ctrl_rdata_next[0] = dma_write_ring_enable_reg;
+                axil_ctrl_rdata_next[8] = dma_write_ring_cpl_ptr_reg != dma_write_ring_fetch_ptr_reg;
+                axil_ctrl_rdata_next[16] = dma_write_ring_error_reg;
+            end
+            16'h2104: axil_ctrl_rdata_next = DESC_BUF_SIZE;
+            16'h2108: axil_ctrl_rdata_next = dma_write_ring_base_addr_reg;
+            16'h210c: axil_ctrl_rdata_next = dma_write_ring_base_addr_reg >> 32;
+            16'h2110: axil_ctrl_rdata_next = dma_write_ring_log_size_reg;
+            16'h2118: axil_ctrl_rdata_next = dma_write_ring_prod_ptr_reg;
+            16'h211c: axil_ctrl_rdata_next = dma_write_ring_fetch_ptr_reg;
+            16'h2120: axil_ctrl_rdata_next = dma_write_ring_cpl_ptr_reg;
+            // completion queue
+            16'h2200: begin
+                axil_ctrl_rdata_next[0] = cq_enable_reg;
+                axil_ctrl_rdata_next[8] = !cq_rd_fifo_empty || !cq_wr_fifo_empty;
+                axil_ctrl_rdata_next[16] = cq_overflow_reg;
+                axil_ctrl_rdata_next[31] = cq_supported;
+            end
+            16'h2204: axil_ctrl_rdata_next = CQ_FIFO_SIZE;
+            16'h2208: axil_ctrl_rdata_next = cq_base_addr_reg;
+            16'h220c: axil_ctrl_rdata_next = cq_base_addr_reg >> 32;
+            16'h2210: axil_ctrl_rdata_next = cq_log_size_reg;
+            16'h2218: axil_ctrl_rdata_next = cq_prod_ptr_reg;
+            16'h221c: axil_ctrl_rdata_next = cq_cons_ptr_reg;
         endcase
+
+        // DMA read latency histogram
+        if ({s_axil_ctrl_araddr[15:6], 6'd0} == 16'h0480) begin
+            axil_ctrl_rdata_next = stat_rd_lat_hist_reg[s_axil_ctrl_araddr[5:2]];
+        end
     end
 
     // store read response
     if (s_axis_dma_read_desc_status_valid) begin
-        dma_read_desc_status_tag_next = s_axis_dma_read_desc_status_tag;
-        dma_read_desc_status_error_next = s_axis_dma_read_desc_status_error;
-        dma_read_desc_status_valid_next = s_axis_dma_read_desc_status_valid;
+        case (s_axis_dma_read_desc_status_tag[DMA_TAG_WIDTH-1 -: 2])
+            TAG_SRC_REG: begin
+                dma_read_desc_status_tag_next = s_axis_dma_read_desc_status_tag;
+                dma_read_desc_status_error_next = s_axis_dma_read_desc_status_error;
+                dma_read_desc_status_valid_next = s_axis_dma_read_desc_status_valid;
+
+                cq_rd_fifo_we = cq_enable_reg;
+                cq_rd_fifo_wr_data[7:0] = s_axis_dma_read_desc_status_tag;
+                cq_rd_fifo_wr_data[11:8] = s_axis_dma_read_desc_status_error;
+                cq_rd_fifo_wr_data[31:16] = cycle_count_reg;
+
+                if (dma_rd_int_en_reg) begin
+                    dma_rd_irq_event = 1'b1;
+                end
+            end
+            TAG_SRC_BLOCK: begin
+                // block operations interrupt on completion of the whole block
+                dma_read_desc_status_tag_next = s_axis_dma_read_desc_status_tag;
+                dma_read_desc_status_error_next = s_axis_dma_read_desc_status_error;
+                dma_read_desc_status_valid_next = s_axis_dma_read_desc_status_valid;
 
-        if (dma_rd_int_en_reg) begin
-            irq_valid_next = 1'b1;
-        end
+                dma_read_block_active_next = dma_read_block_active_reg - 1;
+            end
+            TAG_SRC_RING: begin
+                // operation from read descriptor ring complete
+                dma_read_ring_cpl_ptr_next = dma_read_ring_cpl_ptr_reg + 1;
+                if (s_axis_dma_read_desc_status_error != 0) begin
+                    dma_read_ring_error_next = 1'b1;
+                end
+
+                cq_rd_fifo_we = cq_enable_reg;
+                cq_rd_fifo_wr_data[7:0] = s_axis_dma_read_desc_status_tag;
+                cq_rd_fifo_wr_data[11:8] = s_axis_dma_read_desc_status_error;
+                cq_rd_fifo_wr_data[13] = 1'b1;
+                cq_rd_fifo_wr_data[31:16] = cycle_count_reg;
+
+                // interrupt when ring has caught up
+                if (dma_rd_int_en_reg && dma_read_ring_cpl_ptr_next == dma_read_ring_prod_ptr_reg) begin
+                    dma_rd_irq_event = 1'b1;
+                end
+            end
+            TAG_SRC_FETCH: begin
+                if (s_axis_dma_read_desc_status_tag[1]) begin
+                    // block address list fetch complete
+                    if (s_axis_dma_read_desc_status_tag[0]) begin
+                        dma_write_block_list_fetch_active_next = 1'b0;
+                        if (s_axis_dma_read_desc_status_error == 0) begin
+                            dma_write_block_list_wr_ptr_next = dma_write_block_list_wr_ptr_reg + LIST_FETCH_SIZE;
+                        end else begin
+                            dma_write_block_list_error_next = 1'b1;
+                        end
+                    end else begin
+                        dma_read_block_list_fetch_active_next = 1'b0;
+                        if (s_axis_dma_read_desc_status_error == 0) begin
+                            dma_read_block_list_wr_ptr_next = dma_read_block_list_wr_ptr_reg + LIST_FETCH_SIZE;
+                        end else begin
+                            dma_read_block_list_error_next = 1'b1;
+                        end
+                    end
+                end else begin
+                    // descriptor fetch complete
+                    desc_fetch_active_next = 1'b0;
+                    if (s_axis_dma_read_desc_status_tag[0]) begin
+                        if (s_axis_dma_read_desc_status_error == 0) begin
+                            dma_write_ring_buf_wr_ptr_next = dma_write_ring_buf_wr_ptr_reg + desc_fetch_count_reg;
+                        end else begin
+                            // rewind and stop ring
+                            dma_write_ring_fetch_ptr_next = dma_write_ring_fetch_ptr_reg - desc_fetch_count_reg;
+                            dma_write_ring_enable_next = 1'b0;
+                            dma_write_ring_error_next = 1'b1;
+                        end
+                    end else begin
+                        if (s_axis_dma_read_desc_status_error == 0) begin
+                            dma_read_ring_buf_wr_ptr_next = dma_read_ring_buf_wr_ptr_reg + desc_fetch_count_reg;
+                        end else begin
+                            // rewind and stop ring
+                            dma_read_ring_fetch_ptr_next = dma_read_ring_fetch_ptr_reg - desc_fetch_count_reg;
+                            dma_read_ring_enable_next = 1'b0;
+                            dma_read_ring_error_next = 1'b1;
+                        end
+                    end
+                end
+            end
+        endcase
     end
 
     // store write response
     if (s_axis_dma_write_desc_status_valid) begin
-        dma_write_desc_status_tag_next = s_axis_dma_write_desc_status_tag;
-        dma_write_desc_status_error_next = s_axis_dma_write_desc_status_error;
-        dma_write_desc_status_valid_next = s_axis_dma_write_desc_status_valid;
+        case (s_axis_dma_write_desc_status_tag[DMA_TAG_WIDTH-1 -: 2])
+            TAG_SRC_REG: begin
+                dma_write_desc_status_tag_next = s_axis_dma_write_desc_status_tag;
+                dma_write_desc_status_error_next = s_axis_dma_write_desc_status_error;
+                dma_write_desc_status_valid_next = s_axis_dma_write_desc_status_valid;
+
+                cq_wr_fifo_we = cq_enable_reg;
+                cq_wr_fifo_wr_data[7:0] = s_axis_dma_write_desc_status_tag;
+                cq_wr_fifo_wr_data[11:8] = s_axis_dma_write_desc_status_error;
+                cq_wr_fifo_wr_data[12] = 1'b1;
+                cq_wr_fifo_wr_data[31:16] = cycle_count_reg;
+
+                if (dma_wr_int_en_reg) begin
+                    dma_wr_irq_event = 1'b1;
+                end
+            end
+            TAG_SRC_BLOCK: begin
+                // block operations interrupt on completion of the whole block
+                dma_write_desc_status_tag_next = s_axis_dma_write_desc_status_tag;
+                dma_write_desc_status_error_next = s_axis_dma_write_desc_status_error;
+                dma_write_desc_status_valid_next = s_axis_dma_write_desc_status_valid;
 
-        if (dma_wr_int_en_reg) begin
-            irq_valid_next = 1'b1;
+                dma_write_block_active_next = dma_write_block_active_reg - 1;
+            end
+            TAG_SRC_RING: begin
+                // operation from write descriptor ring complete
+                dma_write_ring_cpl_ptr_next = dma_write_ring_cpl_ptr_reg + 1;
+                if (s_axis_dma_write_desc_status_error != 0) begin
+                    dma_write_ring_error_next = 1'b1;
+                end
+
+                cq_wr_fifo_we = cq_enable_reg;
+                cq_wr_fifo_wr_data[7:0] = s_axis_dma_write_desc_status_tag;
+                cq_wr_fifo_wr_data[11:8] = s_axis_dma_write_desc_status_error;
+                cq_wr_fifo_wr_data[12] = 1'b1;
+                cq_wr_fifo_wr_data[13] = 1'b1;
+                cq_wr_fifo_wr_data[31:16] = cycle_count_reg;
+
+                // interrupt when ring has caught up
+                if (dma_wr_int_en_reg && dma_write_ring_cpl_ptr_next == dma_write_ring_prod_ptr_reg) begin
+                    dma_wr_irq_event = 1'b1;
+                end
+            end
+            TAG_SRC_CPL: begin
+                // completion record written
+            end
+        endcase
+    end
+
+    // stage completion records, dropping them if the FIFO is full
+    if (cq_rd_fifo_we) begin
+        if (cq_rd_fifo_full) begin
+            cq_rd_fifo_we = 1'b0;
+            cq_overflow_next = 1'b1;
+        end else begin
+            cq_rd_fifo_wr_ptr_next = cq_rd_fifo_wr_ptr_reg + 1;
+        end
+    end
+
+    if (cq_wr_fifo_we) begin
+        if (cq_wr_fifo_full) begin
+            cq_wr_fifo_we = 1'b0;
+            cq_overflow_next = 1'b1;
+        end else begin
+            cq_wr_fifo_wr_ptr_next = cq_wr_fifo_wr_ptr_reg + 1;
+        end
+    end
+
+    // descriptor push (buffer entry is written this cycle)
+    if (desc_push_valid_reg) begin
+        if (desc_push_index_reg[DESC_BUF_PTR_WIDTH-1]) begin
+            dma_write_ring_buf_wr_ptr_next = dma_write_ring_buf_wr_ptr_reg + 1;
+        end else begin
+            dma_read_ring_buf_wr_ptr_next = dma_read_ring_buf_wr_ptr_reg + 1;
+        end
+    end
+
+    // block address list fetch (ahead of the block engines, which would
+    // otherwise keep the read descriptor busy while the list drains)
+    if (!dma_read_desc_valid_next) begin
+        if (dma_read_block_list_fetch) begin
+            dma_read_desc_dma_addr_next = dma_read_block_list_base_addr_reg + (dma_read_block_list_fetch_ptr_reg & dma_read_block_list_size_mask)*LIST_ENTRY_SIZE;
+            dma_read_desc_ram_sel_next = 1 << (RAM_SEL_WIDTH-1);
+            dma_read_desc_ram_addr_next = DESC_BUF_BYTES + dma_read_block_list_wr_ptr_reg[LIST_BUF_PTR_WIDTH-2:0]*LIST_ENTRY_SIZE;
+            dma_read_desc_len_next = LIST_FETCH_SIZE*LIST_ENTRY_SIZE;
+            dma_read_desc_tag_next = 0;
+            dma_read_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_FETCH;
+            dma_read_desc_tag_next[1:0] = 2'b10;
+            dma_read_desc_valid_next = 1'b1;
+
+            dma_read_block_list_fetch_ptr_next = dma_read_block_list_fetch_ptr_reg + LIST_FETCH_SIZE;
+            dma_read_block_list_fetch_active_next = 1'b1;
+        end else if (dma_write_block_list_fetch) begin
+            dma_read_desc_dma_addr_next = dma_write_block_list_base_addr_reg + (dma_write_block_list_fetch_ptr_reg & dma_write_block_list_size_mask)*LIST_ENTRY_SIZE;
+            dma_read_desc_ram_sel_next = 1 << (RAM_SEL_WIDTH-1);
+            dma_read_desc_ram_addr_next = DESC_BUF_BYTES + (LIST_BUF_SIZE + dma_write_block_list_wr_ptr_reg[LIST_BUF_PTR_WIDTH-2:0])*LIST_ENTRY_SIZE;
+            dma_read_desc_len_next = LIST_FETCH_SIZE*LIST_ENTRY_SIZE;
+            dma_read_desc_tag_next = 0;
+            dma_read_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_FETCH;
+            dma_read_desc_tag_next[1:0] = 2'b11;
+            dma_read_desc_valid_next = 1'b1;
+
+            dma_write_block_list_fetch_ptr_next = dma_write_block_list_fetch_ptr_reg + LIST_FETCH_SIZE;
+            dma_write_block_list_fetch_active_next = 1'b1;
         end
     end
 
@@ -589,20 +1633,42 @@ always @* begin
     if (dma_read_block_run_reg) begin
         dma_read_block_cycle_count_next = dma_read_block_cycle_count_reg + 1;
 
-        if (dma_read_block_count_reg == 0) begin
+        if (dma_read_block_count_reg == 0 || dma_read_block_list_error_reg) begin
+            // done (or address list fetch failed), wait for outstanding operations
             if (dma_read_active_count_reg == 0) begin
                 dma_read_block_run_next = 1'b0;
+
+                if (dma_rd_int_en_reg) begin
+                    dma_rd_irq_event = 1'b1;
+                end
             end
-        end else begin
-            if (!dma_read_desc_valid_reg || m_axis_dma_read_desc_ready) begin
+        end else if (dma_read_block_mode_reg != BLOCK_MODE_LIST || dma_read_block_list_level != 0) begin
+            if (!dma_read_desc_valid_next && dma_read_block_active_reg < BLOCK_LAT_TABLE_SIZE) begin
                 dma_read_block_dma_offset_next = dma_read_block_dma_offset_reg + dma_read_block_dma_stride_reg;
-                dma_read_desc_dma_addr_next = dma_read_block_dma_base_addr_reg + (dma_read_block_dma_offset_reg & dma_read_block_dma_offset_mask_reg);
+                case (dma_read_block_mode_reg)
+                    BLOCK_MODE_RANDOM: begin
+                        dma_read_desc_dma_addr_next = dma_read_block_dma_base_addr_reg + (dma_read_block_lfsr_reg & dma_read_block_dma_offset_mask_reg & ~(dma_read_block_dma_stride_reg - 1));
+                        dma_read_block_lfsr_next = lfsr_next(dma_read_block_lfsr_reg);
+                    end
+                    BLOCK_MODE_LIST: begin
+                        dma_read_desc_dma_addr_next = dma_read_block_dma_base_addr_reg + (dma_read_block_list_entry & dma_read_block_dma_offset_mask_reg);
+                        dma_read_block_list_rd_ptr_next = dma_read_block_list_rd_ptr_reg + 1;
+                    end
+                    default: begin
+                        dma_read_desc_dma_addr_next = dma_read_block_dma_base_addr_reg + (dma_read_block_dma_offset_reg & dma_read_block_dma_offset_mask_reg);
+                    end
+                endcase
                 dma_read_block_ram_offset_next = dma_read_block_ram_offset_reg + dma_read_block_ram_stride_reg;
                 dma_read_desc_ram_addr_next = dma_read_block_ram_base_addr_reg + (dma_read_block_ram_offset_reg & dma_read_block_ram_offset_mask_reg);
+                dma_read_desc_ram_sel_next = 0;
                 dma_read_desc_len_next = dma_read_block_len_reg;
                 dma_read_block_count_next = dma_read_block_count_reg - 1;
-                dma_read_desc_tag_next = dma_read_block_count_reg;
+                dma_read_desc_tag_next = dma_read_block_count_reg[DMA_TAG_WIDTH-3:0];
+                dma_read_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_BLOCK;
                 dma_read_desc_valid_next = 1'b1;
+
+                dma_read_block_active_next = dma_read_block_active_next + 1;
+                dma_read_block_start_we = 1'b1;
             end
         end
     end
@@ -611,24 +1677,183 @@ always @* begin
     if (dma_write_block_run_reg) begin
         dma_write_block_cycle_count_next = dma_write_block_cycle_count_reg + 1;
 
-        if (dma_write_block_count_reg == 0) begin
+        if (dma_write_block_count_reg == 0 || dma_write_block_list_error_reg) begin
+            // done (or address list fetch failed), wait for outstanding operations
             if (dma_write_active_count_reg == 0) begin
                 dma_write_block_run_next = 1'b0;
+
+                if (dma_wr_int_en_reg) begin
+                    dma_wr_irq_event = 1'b1;
+                end
             end
-        end else begin
-            if (!dma_write_desc_valid_reg || m_axis_dma_write_desc_ready) begin
+        end else if (dma_write_block_mode_reg != BLOCK_MODE_LIST || dma_write_block_list_level != 0) begin
+            if (!dma_write_desc_valid_next && dma_write_block_active_reg < BLOCK_LAT_TABLE_SIZE) begin
                 dma_write_block_dma_offset_next = dma_write_block_dma_offset_reg + dma_write_block_dma_stride_reg;
-                dma_write_desc_dma_addr_next = dma_write_block_dma_base_addr_reg + (dma_write_block_dma_offset_reg & dma_write_block_dma_offset_mask_reg);
+                case (dma_write_block_mode_reg)
+                    BLOCK_MODE_RANDOM: begin
+                        dma_write_desc_dma_addr_next = dma_write_block_dma_base_addr_reg + (dma_write_block_lfsr_reg & dma_write_block_dma_offset_mask_reg & ~(dma_write_block_dma_stride_reg - 1));
+                        dma_write_block_lfsr_next = lfsr_next(dma_write_block_lfsr_reg);
+                    end
+                    BLOCK_MODE_LIST: begin
+                        dma_write_desc_dma_addr_next = dma_write_block_dma_base_addr_reg + (dma_write_block_list_entry & dma_write_block_dma_offset_mask_reg);
+                        dma_write_block_list_rd_ptr_next = dma_write_block_list_rd_ptr_reg + 1;
+                    end
+                    default: begin
+                        dma_write_desc_dma_addr_next = dma_write_block_dma_base_addr_reg + (dma_write_block_dma_offset_reg & dma_write_block_dma_offset_mask_reg);
+                    end
+                endcase
                 dma_write_block_ram_offset_next = dma_write_block_ram_offset_reg + dma_write_block_ram_stride_reg;
                 dma_write_desc_ram_addr_imm_next = dma_write_block_ram_base_addr_reg + (dma_write_block_ram_offset_reg & dma_write_block_ram_offset_mask_reg);
                 dma_write_desc_imm_en_next = 1'b0;
                 dma_write_desc_len_next = dma_write_block_len_reg;
                 dma_write_block_count_next = dma_write_block_count_reg - 1;
-                dma_write_desc_tag_next = dma_write_block_count_reg;
+                dma_write_desc_tag_next = dma_write_block_count_reg[DMA_TAG_WIDTH-3:0];
+                dma_write_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_BLOCK;
                 dma_write_desc_valid_next = 1'b1;
+
+                dma_write_block_active_next = dma_write_block_active_next + 1;
+                dma_write_block_start_we = 1'b1;
             end
         end
     end
+
+    // descriptor ring (read)
+    if (dma_read_ring_enable_reg && dma_read_ring_buf_rd_ptr_reg != dma_read_ring_buf_wr_ptr_reg && !dma_read_desc_valid_next) begin
+        dma_read_desc_dma_addr_next = dma_read_ring_desc[63:0];
+        dma_read_desc_ram_sel_next = 0;
+        dma_read_desc_ram_addr_next = dma_read_ring_desc[95:64];
+        dma_read_desc_len_next = dma_read_ring_desc[111:96];
+        dma_read_desc_tag_next = 0;
+        dma_read_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_RING;
+        dma_read_desc_tag_next[7:0] = dma_read_ring_desc[119:112];
+        dma_read_desc_valid_next = 1'b1;
+        dma_read_ring_buf_rd_ptr_next = dma_read_ring_buf_rd_ptr_reg + 1;
+    end
+
+    // completion queue records (alternate between read and write FIFOs)
+    if (cq_enable_reg && cq_space && (!cq_rd_fifo_empty || !cq_wr_fifo_empty) && !dma_write_desc_valid_next) begin
+        dma_write_desc_dma_addr_next = cq_base_addr_reg + (cq_prod_ptr_reg & (cq_size-1))*4;
+        dma_write_desc_imm_en_next = 1'b1;
+        dma_write_desc_len_next = 4;
+        dma_write_desc_tag_next = 0;
+        dma_write_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_CPL;
+        dma_write_desc_valid_next = 1'b1;
+
+        if (!cq_rd_fifo_empty && (cq_arb_reg || cq_wr_fifo_empty)) begin
+            dma_write_desc_ram_addr_imm_next = cq_rd_fifo_rd_data | (cq_phase << 15);
+            cq_rd_fifo_rd_ptr_next = cq_rd_fifo_rd_ptr_reg + 1;
+            cq_arb_next = 1'b0;
+        end else begin
+            dma_write_desc_ram_addr_imm_next = cq_wr_fifo_rd_data | (cq_phase << 15);
+            cq_wr_fifo_rd_ptr_next = cq_wr_fifo_rd_ptr_reg + 1;
+            cq_arb_next = 1'b1;
+        end
+
+        cq_prod_ptr_next = cq_prod_ptr_reg + 1;
+    end
+
+    // descriptor ring (write)
+    if (dma_write_ring_enable_reg && dma_write_ring_buf_rd_ptr_reg != dma_write_ring_buf_wr_ptr_reg && !dma_write_desc_valid_next) begin
+        dma_write_desc_dma_addr_next = dma_write_ring_desc[63:0];
+        dma_write_desc_ram_addr_imm_next = dma_write_ring_desc[95:64];
+        dma_write_desc_imm_en_next = DMA_IMM_ENABLE && dma_write_ring_desc[127];
+        dma_write_desc_len_next = dma_write_ring_desc[111:96];
+        dma_write_desc_tag_next = 0;
+        dma_write_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_RING;
+        dma_write_desc_tag_next[7:0] = dma_write_ring_desc[119:112];
+        dma_write_desc_valid_next = 1'b1;
+        dma_write_ring_buf_rd_ptr_next = dma_write_ring_buf_rd_ptr_reg + 1;
+    end
+
+    // descriptor fetch
+    if (!desc_fetch_active_reg && !dma_read_desc_valid_next) begin
+        if (dma_read_ring_enable_reg && dma_read_ring_fetch_count != 0
+                && (desc_fetch_ring_reg || !dma_write_ring_enable_reg || dma_write_ring_fetch_count == 0)) begin
+            // fetch from read descriptor ring
+            dma_read_desc_dma_addr_next = dma_read_ring_base_addr_reg + (dma_read_ring_fetch_ptr_reg & (dma_read_ring_size-1))*DESC_SIZE;
+            dma_read_desc_ram_sel_next = 1 << (RAM_SEL_WIDTH-1);
+            dma_read_desc_ram_addr_next = dma_read_ring_buf_wr_ptr_reg[DESC_BUF_PTR_WIDTH-2:0]*DESC_SIZE;
+            dma_read_desc_len_next = dma_read_ring_fetch_count*DESC_SIZE;
+            dma_read_desc_tag_next = 0;
+            dma_read_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_FETCH;
+            dma_read_desc_tag_next[0] = 1'b0;
+            dma_read_desc_valid_next = 1'b1;
+
+            dma_read_ring_fetch_ptr_next = dma_read_ring_fetch_ptr_reg + dma_read_ring_fetch_count;
+
+            desc_fetch_active_next = 1'b1;
+            desc_fetch_ring_next = 1'b0;
+            desc_fetch_count_next = dma_read_ring_fetch_count;
+        end else if (dma_write_ring_enable_reg && dma_write_ring_fetch_count != 0) begin
+            // fetch from write descriptor ring
+            dma_read_desc_dma_addr_next = dma_write_ring_base_addr_reg + (dma_write_ring_fetch_ptr_reg & (dma_write_ring_size-1))*DESC_SIZE;
+            dma_read_desc_ram_sel_next = 1 << (RAM_SEL_WIDTH-1);
+            dma_read_desc_ram_addr_next = (DESC_BUF_SIZE + dma_write_ring_buf_wr_ptr_reg[DESC_BUF_PTR_WIDTH-2:0])*DESC_SIZE;
+            dma_read_desc_len_next = dma_write_ring_fetch_count*DESC_SIZE;
+            dma_read_desc_tag_next = 0;
+            dma_read_desc_tag_next[DMA_TAG_WIDTH-1 -: 2] = TAG_SRC_FETCH;
+            dma_read_desc_tag_next[0] = 1'b1;
+            dma_read_desc_valid_next = 1'b1;
+
+            dma_write_ring_fetch_ptr_next = dma_write_ring_fetch_ptr_reg + dma_write_ring_fetch_count;
+
+            desc_fetch_active_next = 1'b1;
+            desc_fetch_ring_next = 1'b1;
+            desc_fetch_count_next = dma_write_ring_fetch_count;
+        end
+    end
+
+    // interrupt moderation
+    if (irq_tick_reg && dma_rd_irq_timer_reg != 0) begin
+        dma_rd_irq_timer_next = dma_rd_irq_timer_reg - 1;
+    end
+
+    if (dma_rd_irq_event) begin
+        if (dma_rd_irq_event_count_reg == 0) begin
+            dma_rd_irq_timer_next = dma_rd_irq_mod_time_reg;
+        end
+        if (dma_rd_irq_event_count_reg != 16'hffff) begin
+            dma_rd_irq_event_count_next = dma_rd_irq_event_count_reg + 1;
+        end
+    end
+
+    if (dma_rd_irq_event_count_next != 0 && (dma_rd_irq_event_count_next >= dma_rd_irq_mod_count_reg || dma_rd_irq_timer_next == 0)) begin
+        dma_rd_irq_event_count_next = 0;
+        dma_rd_irq_pending_next = 1'b1;
+    end
+
+    if (irq_tick_reg && dma_wr_irq_timer_reg != 0) begin
+        dma_wr_irq_timer_next = dma_wr_irq_timer_reg - 1;
+    end
+
+    if (dma_wr_irq_event) begin
+        if (dma_wr_irq_event_count_reg == 0) begin
+            dma_wr_irq_timer_next = dma_wr_irq_mod_time_reg;
+        end
+        if (dma_wr_irq_event_count_reg != 16'hffff) begin
+            dma_wr_irq_event_count_next = dma_wr_irq_event_count_reg + 1;
+        end
+    end
+
+    if (dma_wr_irq_event_count_next != 0 && (dma_wr_irq_event_count_next >= dma_wr_irq_mod_count_reg || dma_wr_irq_timer_next == 0)) begin
+        dma_wr_irq_event_count_next = 0;
+        dma_wr_irq_pending_next = 1'b1;
+    end
+
+    // generate interrupts
+    if (!irq_valid_next) begin
+        if (dma_rd_irq_pending_next) begin
+            irq_index_next = dma_rd_irq_index_reg;
+            irq_valid_next = 1'b1;
+            dma_rd_irq_pending_next = 1'b0;
+            dma_rd_irq_issue = 1'b1;
+        end else if (dma_wr_irq_pending_next) begin
+            irq_index_next = dma_wr_irq_index_reg;
+            irq_valid_next = 1'b1;
+            dma_wr_irq_pending_next = 1'b0;
+            dma_wr_irq_issue = 1'b1;
+        end
+    end
 end
 
 always @(posedge clk) begin
@@ -653,8 +1878,11 @@ always @(posedge clk) begin
     dma_rd_req_count_reg <= dma_rd_req_count_reg + dma_rd_req;
     dma_rd_cpl_count_reg <= dma_rd_cpl_count_reg + dma_rd_cpl;
     dma_wr_req_count_reg <= dma_wr_req_count_reg + dma_wr_req;
+    dma_rd_error_count_reg <= dma_rd_error_count_reg
+        + (s_axis_dma_read_desc_status_valid && s_axis_dma_read_desc_status_error != 0);
 
     dma_read_desc_dma_addr_reg <= dma_read_desc_dma_addr_next;
+    dma_read_desc_ram_sel_reg <= dma_read_desc_ram_sel_next;
     dma_read_desc_ram_addr_reg <= dma_read_desc_ram_addr_next;
     dma_read_desc_len_reg <= dma_read_desc_len_next;
     dma_read_desc_tag_reg <= dma_read_desc_tag_next;
@@ -680,11 +1908,53 @@ always @(posedge clk) begin
     dma_rd_int_en_reg <= dma_rd_int_en_next;
     dma_wr_int_en_reg <= dma_wr_int_en_next;
 
+    dma_rd_irq_index_reg <= dma_rd_irq_index_next;
+    dma_wr_irq_index_reg <= dma_wr_irq_index_next;
+    dma_rd_irq_pending_reg <= dma_rd_irq_pending_next;
+    dma_wr_irq_pending_reg <= dma_wr_irq_pending_next;
+
+    irq_prescale_reg <= irq_prescale_next;
+    irq_min_interval_reg <= irq_min_interval_next;
+
+    if (irq_prescale_count_reg != 0) begin
+        irq_prescale_count_reg <= irq_prescale_count_reg - 1;
+        irq_tick_reg <= 1'b0;
+    end else begin
+        irq_prescale_count_reg <= irq_prescale_reg;
+        irq_tick_reg <= 1'b1;
+    end
+
+    dma_rd_irq_mod_count_reg <= dma_rd_irq_mod_count_next;
+    dma_rd_irq_mod_time_reg <= dma_rd_irq_mod_time_next;
+    dma_rd_irq_event_count_reg <= dma_rd_irq_event_count_next;
+    dma_rd_irq_timer_reg <= dma_rd_irq_timer_next;
+    dma_wr_irq_mod_count_reg <= dma_wr_irq_mod_count_next;
+    dma_wr_irq_mod_time_reg <= dma_wr_irq_mod_time_next;
+    dma_wr_irq_event_count_reg <= dma_wr_irq_event_count_next;
+    dma_wr_irq_timer_reg <= dma_wr_irq_timer_next;
+
+    if (dma_rd_irq_event) begin
+        dma_rd_event_count_reg <= dma_rd_event_count_reg + 1;
+    end
+    if (dma_rd_irq_issue) begin
+        dma_rd_irq_count_reg <= dma_rd_irq_count_reg + 1;
+    end
+    if (dma_wr_irq_event) begin
+        dma_wr_event_count_reg <= dma_wr_event_count_reg + 1;
+    end
+    if (dma_wr_irq_issue) begin
+        dma_wr_irq_count_reg <= dma_wr_irq_count_reg + 1;
+    end
+
+    irq_index_reg <= irq_index_next;
     irq_valid_reg <= irq_valid_next;
 
     rx_cpl_stall_reg <= rx_cpl_stall_next;
     rx_cpl_stall_count_reg <= rx_cpl_stall_count_next;
 
+    dma_rd_cplh_fc_limit_reg <= dma_rd_cplh_fc_limit_next;
+    dma_rd_cpld_fc_limit_reg <= dma_rd_cpld_fc_limit_next;
+
     dma_read_block_run_reg <= dma_read_block_run_next;
     dma_read_block_len_reg <= dma_read_block_len_next;
     dma_read_block_count_reg <= dma_read_block_count_next;
@@ -711,6 +1981,75 @@ always @(posedge clk) begin
     dma_write_block_ram_offset_mask_reg <= dma_write_block_ram_offset_mask_next;
     dma_write_block_ram_stride_reg <= dma_write_block_ram_stride_next;
 
+    dma_read_block_mode_reg <= dma_read_block_mode_next;
+    dma_read_block_lfsr_reg <= dma_read_block_lfsr_next;
+    dma_read_block_list_base_addr_reg <= dma_read_block_list_base_addr_next;
+    dma_read_block_list_log_size_reg <= dma_read_block_list_log_size_next;
+    dma_read_block_list_fetch_ptr_reg <= dma_read_block_list_fetch_ptr_next;
+    dma_read_block_list_wr_ptr_reg <= dma_read_block_list_wr_ptr_next;
+    dma_read_block_list_rd_ptr_reg <= dma_read_block_list_rd_ptr_next;
+    dma_read_block_list_fetch_active_reg <= dma_read_block_list_fetch_active_next;
+    dma_read_block_list_error_reg <= dma_read_block_list_error_next;
+
+    dma_write_block_mode_reg <= dma_write_block_mode_next;
+    dma_write_block_lfsr_reg <= dma_write_block_lfsr_next;
+    dma_write_block_list_base_addr_reg <= dma_write_block_list_base_addr_next;
+    dma_write_block_list_log_size_reg <= dma_write_block_list_log_size_next;
+    dma_write_block_list_fetch_ptr_reg <= dma_write_block_list_fetch_ptr_next;
+    dma_write_block_list_wr_ptr_reg <= dma_write_block_list_wr_ptr_next;
+    dma_write_block_list_rd_ptr_reg <= dma_write_block_list_rd_ptr_next;
+    dma_write_block_list_fetch_active_reg <= dma_write_block_list_fetch_active_next;
+    dma_write_block_list_error_reg <= dma_write_block_list_error_next;
+
+    dma_read_block_active_reg <= dma_read_block_active_next;
+    dma_read_block_lat_clear_reg <= dma_read_block_lat_clear_next;
+    dma_write_block_active_reg <= dma_write_block_active_next;
+    dma_write_block_lat_clear_reg <= dma_write_block_lat_clear_next;
+
+    dma_read_ring_enable_reg <= dma_read_ring_enable_next;
+    dma_read_ring_error_reg <= dma_read_ring_error_next;
+    dma_read_ring_base_addr_reg <= dma_read_ring_base_addr_next;
+    dma_read_ring_log_size_reg <= dma_read_ring_log_size_next;
+    dma_read_ring_prod_ptr_reg <= dma_read_ring_prod_ptr_next;
+    dma_read_ring_fetch_ptr_reg <= dma_read_ring_fetch_ptr_next;
+    dma_read_ring_cpl_ptr_reg <= dma_read_ring_cpl_ptr_next;
+    dma_read_ring_buf_wr_ptr_reg <= dma_read_ring_buf_wr_ptr_next;
+    dma_read_ring_buf_rd_ptr_reg <= dma_read_ring_buf_rd_ptr_next;
+
+    dma_write_ring_enable_reg <= dma_write_ring_enable_next;
+    dma_write_ring_error_reg <= dma_write_ring_error_next;
+    dma_write_ring_base_addr_reg <= dma_write_ring_base_addr_next;
+    dma_write_ring_log_size_reg <= dma_write_ring_log_size_next;
+    dma_write_ring_prod_ptr_reg <= dma_write_ring_prod_ptr_next;
+    dma_write_ring_fetch_ptr_reg <= dma_write_ring_fetch_ptr_next;
+    dma_write_ring_cpl_ptr_reg <= dma_write_ring_cpl_ptr_next;
+    dma_write_ring_buf_wr_ptr_reg <= dma_write_ring_buf_wr_ptr_next;
+    dma_write_ring_buf_rd_ptr_reg <= dma_write_ring_buf_rd_ptr_next;
+
+    desc_fetch_active_reg <= desc_fetch_active_next;
+    desc_fetch_ring_reg <= desc_fetch_ring_next;
+    desc_fetch_count_reg <= desc_fetch_count_next;
+
+    desc_push_stage_reg <= desc_push_stage_next;
+    desc_push_mask_reg <= desc_push_mask_next;
+    desc_push_index_reg <= desc_push_index_next;
+    desc_push_data_reg <= desc_push_data_next;
+    desc_push_valid_reg <= desc_push_valid_next;
+
+    cq_enable_reg <= cq_enable_next;
+    cq_overflow_reg <= cq_overflow_next;
+    cq_base_addr_reg <= cq_base_addr_next;
+    cq_log_size_reg <= cq_log_size_next;
+    cq_prod_ptr_reg <= cq_prod_ptr_next;
+    cq_cons_ptr_reg <= cq_cons_ptr_next;
+    cq_arb_reg <= cq_arb_next;
+    cq_rd_fifo_wr_ptr_reg <= cq_rd_fifo_wr_ptr_next;
+    cq_rd_fifo_rd_ptr_reg <= cq_rd_fifo_rd_ptr_next;
+    cq_wr_fifo_wr_ptr_reg <= cq_wr_fifo_wr_ptr_next;
+    cq_wr_fifo_rd_ptr_reg <= cq_wr_fifo_rd_ptr_next;
+
+    dma_stats_clear_reg <= dma_stats_clear_next;
+
     if (rst) begin
         axil_ctrl_awready_reg <= 1'b0;
         axil_ctrl_wready_reg <= 1'b0;
@@ -724,6 +2063,7 @@ always @(posedge clk) begin
         dma_rd_req_count_reg <= 0;
         dma_rd_cpl_count_reg <= 0;
         dma_wr_req_count_reg <= 0;
+        dma_rd_error_count_reg <= 0;
 
         dma_read_desc_valid_reg <= 1'b0;
         dma_read_desc_status_valid_reg <= 1'b0;
@@ -732,11 +2072,178 @@ always @(posedge clk) begin
         dma_enable_reg <= 1'b0;
         dma_rd_int_en_reg <= 1'b0;
         dma_wr_int_en_reg <= 1'b0;
+        dma_rd_irq_pending_reg <= 1'b0;
+        dma_wr_irq_pending_reg <= 1'b0;
+        irq_prescale_reg <= 0;
+        irq_min_interval_reg <= 0;
+        irq_prescale_count_reg <= 0;
+        irq_tick_reg <= 1'b0;
+        dma_rd_irq_mod_count_reg <= 0;
+        dma_rd_irq_mod_time_reg <= 0;
+        dma_rd_irq_event_count_reg <= 0;
+        dma_rd_irq_timer_reg <= 0;
+        dma_wr_irq_mod_count_reg <= 0;
+        dma_wr_irq_mod_time_reg <= 0;
+        dma_wr_irq_event_count_reg <= 0;
+        dma_wr_irq_timer_reg <= 0;
+        dma_rd_event_count_reg <= 0;
+        dma_rd_irq_count_reg <= 0;
+        dma_wr_event_count_reg <= 0;
+        dma_wr_irq_count_reg <= 0;
         irq_valid_reg <= 1'b0;
         rx_cpl_stall_reg <= 1'b0;
         rx_cpl_stall_count_reg <= 0;
+        dma_rd_cplh_fc_limit_reg <= 0;
+        dma_rd_cpld_fc_limit_reg <= 0;
         dma_read_block_run_reg <= 1'b0;
         dma_write_block_run_reg <= 1'b0;
+        dma_read_block_mode_reg <= BLOCK_MODE_LINEAR;
+        dma_read_block_list_wr_ptr_reg <= 0;
+        dma_read_block_list_rd_ptr_reg <= 0;
+        dma_read_block_list_fetch_active_reg <= 1'b0;
+        dma_read_block_list_error_reg <= 1'b0;
+        dma_write_block_mode_reg <= BLOCK_MODE_LINEAR;
+        dma_write_block_list_wr_ptr_reg <= 0;
+        dma_write_block_list_rd_ptr_reg <= 0;
+        dma_write_block_list_fetch_active_reg <= 1'b0;
+        dma_write_block_list_error_reg <= 1'b0;
+        dma_read_block_active_reg <= 0;
+        dma_read_block_lat_clear_reg <= 1'b0;
+        dma_write_block_active_reg <= 0;
+        dma_write_block_lat_clear_reg <= 1'b0;
+        dma_read_ring_enable_reg <= 1'b0;
+        dma_read_ring_error_reg <= 1'b0;
+        dma_read_ring_prod_ptr_reg <= 0;
+        dma_read_ring_fetch_ptr_reg <= 0;
+        dma_read_ring_cpl_ptr_reg <= 0;
+        dma_read_ring_buf_wr_ptr_reg <= 0;
+        dma_read_ring_buf_rd_ptr_reg <= 0;
+        dma_write_ring_enable_reg <= 1'b0;
+        dma_write_ring_error_reg <= 1'b0;
+        dma_write_ring_prod_ptr_reg <= 0;
+        dma_write_ring_fetch_ptr_reg <= 0;
+        dma_write_ring_cpl_ptr_reg <= 0;
+        dma_write_ring_buf_wr_ptr_reg <= 0;
+        dma_write_ring_buf_rd_ptr_reg <= 0;
+        desc_fetch_active_reg <= 1'b0;
+        desc_push_mask_reg <= 0;
+        desc_push_valid_reg <= 1'b0;
+        cq_enable_reg <= 1'b0;
+        cq_overflow_reg <= 1'b0;
+        cq_prod_ptr_reg <= 0;
+        cq_cons_ptr_reg <= 0;
+        cq_arb_reg <= 1'b0;
+        cq_rd_fifo_wr_ptr_reg <= 0;
+        cq_rd_fifo_rd_ptr_reg <= 0;
+        cq_wr_fifo_wr_ptr_reg <= 0;
+        cq_wr_fifo_rd_ptr_reg <= 0;
+        dma_stats_clear_reg <= 1'b0;
+    end
+end
+
+// block latency, cleared when the block engine is started
+always @(posedge clk) begin
+    if (dma_read_block_lat_valid) begin
+        dma_read_block_lat_count_reg <= dma_read_block_lat_count_reg + 1;
+        dma_read_block_lat_sum_reg <= dma_read_block_lat_sum_reg + dma_read_block_lat;
+        if (dma_read_block_lat < dma_read_block_lat_min_reg) begin
+            dma_read_block_lat_min_reg <= dma_read_block_lat;
+        end
+        if (dma_read_block_lat > dma_read_block_lat_max_reg) begin
+            dma_read_block_lat_max_reg <= dma_read_block_lat;
+        end
+    end
+
+    if (dma_write_block_lat_valid) begin
+        dma_write_block_lat_count_reg <= dma_write_block_lat_count_reg + 1;
+        dma_write_block_lat_sum_reg <= dma_write_block_lat_sum_reg + dma_write_block_lat;
+        if (dma_write_block_lat < dma_write_block_lat_min_reg) begin
+            dma_write_block_lat_min_reg <= dma_write_block_lat;
+        end
+        if (dma_write_block_lat > dma_write_block_lat_max_reg) begin
+            dma_write_block_lat_max_reg <= dma_write_block_lat;
+        end
+    end
+
+    if (rst || dma_read_block_lat_clear_reg) begin
+        dma_read_block_lat_count_reg <= 0;
+        dma_read_block_lat_min_reg <= 32'hffffffff;
+        dma_read_block_lat_max_reg <= 0;
+        dma_read_block_lat_sum_reg <= 0;
+    end
+
+    if (rst || dma_write_block_lat_clear_reg) begin
+        dma_write_block_lat_count_reg <= 0;
+        dma_write_block_lat_min_reg <= 32'hffffffff;
+        dma_write_block_lat_max_reg <= 0;
+        dma_write_block_lat_sum_reg <= 0;
+    end
+end
+
+// DMA read statistics
+integer i, j;
+
+always @* begin
+    stat_rd_lat_bin = 0;
+    for (i = 1; i < STAT_HIST_BINS; i = i + 1) begin
+        if (dma_rd_lat[i]) begin
+            stat_rd_lat_bin = i;
+        end
+    end
+end
+
+always @(posedge clk) begin
+    if (DMA_STATS_ENABLE) begin
+        stat_window_cycles_reg <= stat_window_cycles_reg + 1;
+
+        if (dma_rd_lat_valid) begin
+            stat_rd_lat_count_reg <= stat_rd_lat_count_reg + 1;
+            stat_rd_lat_sum_reg <= stat_rd_lat_sum_reg + dma_rd_lat;
+            if (dma_rd_lat < stat_rd_lat_min_reg) begin
+                stat_rd_lat_min_reg <= dma_rd_lat;
+            end
+            if (dma_rd_lat > stat_rd_lat_max_reg) begin
+                stat_rd_lat_max_reg <= dma_rd_lat;
+            end
+            stat_rd_lat_hist_reg[stat_rd_lat_bin] <= stat_rd_lat_hist_reg[stat_rd_lat_bin] + 1;
+        end
+
+        stat_rd_tag_sum_reg <= stat_rd_tag_sum_reg + dma_rd_active_tags;
+        if (dma_rd_active_tags > stat_rd_tag_max_reg) begin
+            stat_rd_tag_max_reg <= dma_rd_active_tags;
+        end
+        stat_rd_op_sum_reg <= stat_rd_op_sum_reg + dma_rd_active_ops;
+        if (dma_rd_active_ops > stat_rd_op_max_reg) begin
+            stat_rd_op_max_reg <= dma_rd_active_ops;
+        end
+
+        stat_rd_no_tags_count_reg <= stat_rd_no_tags_count_reg + dma_rd_no_tags;
+        stat_rd_op_table_full_count_reg <= stat_rd_op_table_full_count_reg + dma_rd_op_table_full;
+        stat_rd_cplh_stall_count_reg <= stat_rd_cplh_stall_count_reg + dma_rd_cplh_stall;
+        stat_rd_cpld_stall_count_reg <= stat_rd_cpld_stall_count_reg + dma_rd_cpld_stall;
+        stat_rd_tx_limit_stall_count_reg <= stat_rd_tx_limit_stall_count_reg + dma_rd_tx_limit_stall;
+        stat_rd_tx_stall_count_reg <= stat_rd_tx_stall_count_reg + dma_rd_tx_stall;
+    end
+
+    if (rst || dma_stats_clear_reg) begin
+        stat_window_cycles_reg <= 0;
+        stat_rd_lat_count_reg <= 0;
+        stat_rd_lat_min_reg <= 16'hffff;
+        stat_rd_lat_max_reg <= 0;
+        stat_rd_lat_sum_reg <= 0;
+        for (j = 0; j < STAT_HIST_BINS; j = j + 1) begin
+            stat_rd_lat_hist_reg[j] <= 0;
+        end
+        stat_rd_tag_sum_reg <= 0;
+        stat_rd_tag_max_reg <= 0;
+        stat_rd_op_sum_reg <= 0;
+        stat_rd_op_max_reg <= 0;
+        stat_rd_no_tags_count_reg <= 0;
+        stat_rd_op_table_full_count_reg <= 0;
+        stat_rd_cplh_stall_count_reg <= 0;
+        stat_rd_cpld_stall_count_reg <= 0;
+        stat_rd_tx_limit_stall_count_reg <= 0;
+        stat_rd_tx_stall_count_reg <= 0;
     end
 end
 
@@ -74,7 +74,11 @@ module example_core_pcie #
     // BAR2 aperture (log2 size)
     parameter BAR2_APERTURE = 24,
     // BAR4 aperture (log2 size)
-    parameter BAR4_APERTURE = 16
+    parameter BAR4_APERTURE = 16,
+    // Number of DMA channels (each with a 64 KB register window in BAR0)
+    parameter DMA_CHANNELS = 1,
+    // Core clock frequency in kHz (reported to the driver)
+    parameter CLK_FREQ_KHZ = 250000
 )
 (
     input  wire                                          clk,
@@ -162,6 +166,7 @@ module example_core_pcie #
      */
     input  wire [7:0]                                    bus_num,
     input  wire                                          ext_tag_enable,
+    input  wire                                          ten_bit_tag_enable,
     input  wire                                          rcb_128b,
     input  wire [2:0]                                    max_read_request_size,
     input  wire [2:0]                                    max_payload_size,
@@ -202,10 +207,30 @@ parameter RAM_SEG_ADDR_WIDTH = RAM_ADDR_WIDTH-$clog2(RAM_SEG_COUNT*RAM_SEG_BE_WI
 
 parameter PCIE_ADDR_WIDTH = 64;
 parameter DMA_LEN_WIDTH = 16;
-parameter DMA_TAG_WIDTH = 8;
+parameter DMA_TAG_WIDTH = 16;
 
 parameter IRQ_INDEX_WIDTH = 5;
 
+// DMA channels
+// channel index is carried in the MSBs of the DMA tag and RAM select
+parameter CL_DMA_CHANNELS = $clog2(DMA_CHANNELS);
+parameter DMA_CH_SEL_WIDTH = CL_DMA_CHANNELS > 0 ? CL_DMA_CHANNELS : 1;
+parameter IF_RAM_SEL_WIDTH = RAM_SEL_WIDTH+CL_DMA_CHANNELS;
+parameter IF_DMA_TAG_WIDTH = DMA_TAG_WIDTH+CL_DMA_CHANNELS;
+
+// check configuration
+initial begin
+    if (DMA_CHANNELS < 1) begin
+        $error("Error: At least one DMA channel required (instance %m)");
+        $finish;
+    end
+
+    if (BAR0_APERTURE < 16+CL_DMA_CHANNELS) begin
+        $error("Error: BAR0 aperture too small for DMA channel count (instance %m)");
+        $finish;
+    end
+end
+
 wire [AXIL_CTRL_ADDR_WIDTH-1:0]  axil_ctrl_awaddr;
 wire [2:0]                       axil_ctrl_awprot;
 wire                             axil_ctrl_awvalid;
@@ -247,39 +272,39 @@ wire                             axil_msix_rvalid;
 wire                             axil_msix_rready;
 
 wire [PCIE_ADDR_WIDTH-1:0]  axis_dma_read_desc_dma_addr;
-wire [RAM_SEL_WIDTH-1:0]    axis_dma_read_desc_ram_sel;
+wire [IF_RAM_SEL_WIDTH-1:0] axis_dma_read_desc_ram_sel;
 wire [RAM_ADDR_WIDTH-1:0]   axis_dma_read_desc_ram_addr;
 wire [DMA_LEN_WIDTH-1:0]    axis_dma_read_desc_len;
-wire [DMA_TAG_WIDTH-1:0]    axis_dma_read_desc_tag;
+wire [IF_DMA_TAG_WIDTH-1:0] axis_dma_read_desc_tag;
 wire                        axis_dma_read_desc_valid;
 wire                        axis_dma_read_desc_ready;
 
-wire [DMA_TAG_WIDTH-1:0]    axis_dma_read_desc_status_tag;
+wire [IF_DMA_TAG_WIDTH-1:0] axis_dma_read_desc_status_tag;
 wire [3:0]                  axis_dma_read_desc_status_error;
 wire                        axis_dma_read_desc_status_valid;
 
 wire [PCIE_ADDR_WIDTH-1:0]  axis_dma_write_desc_dma_addr;
-wire [RAM_SEL_WIDTH-1:0]    axis_dma_write_desc_ram_sel;
+wire [IF_RAM_SEL_WIDTH-1:0] axis_dma_write_desc_ram_sel;
 wire [RAM_ADDR_WIDTH-1:0]   axis_dma_write_desc_ram_addr;
 wire [IMM_WIDTH-1:0]        axis_dma_write_desc_imm;
 wire                        axis_dma_write_desc_imm_en;
 wire [DMA_LEN_WIDTH-1:0]    axis_dma_write_desc_len;
-wire [DMA_TAG_WIDTH-1:0]    axis_dma_write_desc_tag;
+wire [IF_DMA_TAG_WIDTH-1:0] axis_dma_write_desc_tag;
 wire                        axis_dma_write_desc_valid;
 wire                        axis_dma_write_desc_ready;
 
-wire [DMA_TAG_WIDTH-1:0]    axis_dma_write_desc_status_tag;
+wire [IF_DMA_TAG_WIDTH-1:0] axis_dma_write_desc_status_tag;
 wire [3:0]                  axis_dma_write_desc_status_error;
 wire                        axis_dma_write_desc_status_valid;
 
-wire [RAM_SEG_COUNT*RAM_SEL_WIDTH-1:0]       ram_rd_cmd_sel;
+wire [RAM_SEG_COUNT*IF_RAM_SEL_WIDTH-1:0]    ram_rd_cmd_sel;
 wire [RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH-1:0]  ram_rd_cmd_addr;
 wire [RAM_SEG_COUNT-1:0]                     ram_rd_cmd_valid;
 wire [RAM_SEG_COUNT-1:0]                     ram_rd_cmd_ready;
 wire [RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH-1:0]  ram_rd_resp_data;
 wire [RAM_SEG_COUNT-1:0]                     ram_rd_resp_valid;
 wire [RAM_SEG_COUNT-1:0]                     ram_rd_resp_ready;
-wire [RAM_SEG_COUNT*RAM_SEL_WIDTH-1:0]       ram_wr_cmd_sel;
+wire [RAM_SEG_COUNT*IF_RAM_SEL_WIDTH-1:0]    ram_wr_cmd_sel;
 wire [RAM_SEG_COUNT*RAM_SEG_BE_WIDTH-1:0]    ram_wr_cmd_be;
 wire [RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH-1:0]  ram_wr_cmd_addr;
 wire [RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH-1:0]  ram_wr_cmd_data;
@@ -287,6 +312,74 @@ wire [RAM_SEG_COUNT-1:0]                     ram_wr_cmd_valid;
 wire [RAM_SEG_COUNT-1:0]                     ram_wr_cmd_ready;
 wire [RAM_SEG_COUNT-1:0]                     ram_wr_done;
 
+// DMA channel connections
+wire [DMA_CHANNELS*AXIL_CTRL_DATA_WIDTH-1:0]  ch_axil_ctrl_wdata;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_awvalid;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_awready;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_wvalid;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_wready;
+wire [DMA_CHANNELS*2-1:0]                     ch_axil_ctrl_bresp;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_bvalid;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_bready;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_arvalid;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_arready;
+wire [DMA_CHANNELS*AXIL_CTRL_DATA_WIDTH-1:0]  ch_axil_ctrl_rdata;
+wire [DMA_CHANNELS*2-1:0]                     ch_axil_ctrl_rresp;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_rvalid;
+wire [DMA_CHANNELS-1:0]                       ch_axil_ctrl_rready;
+
+wire [DMA_CHANNELS*PCIE_ADDR_WIDTH-1:0]  ch_axis_dma_read_desc_dma_addr;
+wire [DMA_CHANNELS*RAM_SEL_WIDTH-1:0]    ch_axis_dma_read_desc_ram_sel;
+wire [DMA_CHANNELS*RAM_ADDR_WIDTH-1:0]   ch_axis_dma_read_desc_ram_addr;
+wire [DMA_CHANNELS*DMA_LEN_WIDTH-1:0]    ch_axis_dma_read_desc_len;
+wire [DMA_CHANNELS*DMA_TAG_WIDTH-1:0]    ch_axis_dma_read_desc_tag;
+wire [DMA_CHANNELS-1:0]                  ch_axis_dma_read_desc_valid;
+wire [DMA_CHANNELS-1:0]                  ch_axis_dma_read_desc_ready;
+
+wire [DMA_CHANNELS*DMA_TAG_WIDTH-1:0]    ch_axis_dma_read_desc_status_tag;
+wire [DMA_CHANNELS*4-1:0]                ch_axis_dma_read_desc_status_error;
+wire [DMA_CHANNELS-1:0]                  ch_axis_dma_read_desc_status_valid;
+
+wire [DMA_CHANNELS*PCIE_ADDR_WIDTH-1:0]  ch_axis_dma_write_desc_dma_addr;
+wire [DMA_CHANNELS*RAM_SEL_WIDTH-1:0]    ch_axis_dma_write_desc_ram_sel;
+wire [DMA_CHANNELS*RAM_ADDR_WIDTH-1:0]   ch_axis_dma_write_desc_ram_addr;
+wire [DMA_CHANNELS*IMM_WIDTH-1:0]        ch_axis_dma_write_desc_imm;
+wire [DMA_CHANNELS-1:0]                  ch_axis_dma_write_desc_imm_en;
+wire [DMA_CHANNELS*DMA_LEN_WIDTH-1:0]    ch_axis_dma_write_desc_len;
+wire [DMA_CHANNELS*DMA_TAG_WIDTH-1:0]    ch_axis_dma_write_desc_tag;
+wire [DMA_CHANNELS-1:0]                  ch_axis_dma_write_desc_valid;
+wire [DMA_CHANNELS-1:0]                  ch_axis_dma_write_desc_ready;
+
+wire [DMA_CHANNELS*DMA_TAG_WIDTH-1:0]    ch_axis_dma_write_desc_status_tag;
+wire [DMA_CHANNELS*4-1:0]                ch_axis_dma_write_desc_status_error;
+wire [DMA_CHANNELS-1:0]                  ch_axis_dma_write_desc_status_valid;
+
+wire [DMA_CHANNELS*RAM_SEG_COUNT*RAM_SEL_WIDTH-1:0]       ch_ram_rd_cmd_sel;
+wire [DMA_CHANNELS*RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH-1:0]  ch_ram_rd_cmd_addr;
+wire [DMA_CHANNELS*RAM_SEG_COUNT-1:0]                     ch_ram_rd_cmd_valid;
+wire [DMA_CHANNELS*RAM_SEG_COUNT-1:0]                     ch_ram_rd_cmd_ready;
+wire [DMA_CHANNELS*RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH-1:0]  ch_ram_rd_resp_data;
+wire [DMA_CHANNELS*RAM_SEG_COUNT-1:0]                     ch_ram_rd_resp_valid;
+wire [DMA_CHANNELS*RAM_SEG_COUNT-1:0]                     ch_ram_rd_resp_ready;
+wire [DMA_CHANNELS*RAM_SEG_COUNT*RAM_SEL_WIDTH-1:0]       ch_ram_wr_cmd_sel;
+wire [DMA_CHANNELS*RAM_SEG_COUNT*RAM_SEG_BE_WIDTH-1:0]    ch_ram_wr_cmd_be;
+wire [DMA_CHANNELS*RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH-1:0]  ch_ram_wr_cmd_addr;
+wire [DMA_CHANNELS*RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH-1:0]  ch_ram_wr_cmd_data;
+wire [DMA_CHANNELS*RAM_SEG_COUNT-1:0]                     ch_ram_wr_cmd_valid;
+wire [DMA_CHANNELS*RAM_SEG_COUNT-1:0]                     ch_ram_wr_cmd_ready;
+wire [DMA_CHANNELS*RAM_SEG_COUNT-1:0]                     ch_ram_wr_done;
+
+wire [DMA_CHANNELS*IRQ_INDEX_WIDTH-1:0]  ch_irq_index;
+wire [DMA_CHANNELS-1:0]                  ch_irq_valid;
+wire [DMA_CHANNELS-1:0]                  ch_irq_ready;
+
+wire [DMA_CHANNELS-1:0]                  ch_dma_enable;
+wire [DMA_CHANNELS-1:0]                  ch_rx_cpl_stall;
+wire [DMA_CHANNELS*12-1:0]               ch_dma_rd_cplh_fc_limit;
+wire [DMA_CHANNELS*16-1:0]               ch_dma_rd_cpld_fc_limit;
+wire [DMA_CHANNELS*16-1:0]               ch_irq_prescale;
+wire [DMA_CHANNELS*16-1:0]               ch_irq_min_interval;
+
 wire [3:0] status_error_cor_int;
 wire [3:0] status_error_uncor_int;
 
@@ -346,6 +439,10 @@ wire [TLP_SEG_COUNT-1:0]                msix_tx_cpl_tlp_eop;
 wire                                    msix_tx_cpl_tlp_ready;
 
 // Interrupts
+wire [IRQ_INDEX_WIDTH-1:0]  core_irq_index;
+wire                        core_irq_valid;
+wire                        core_irq_ready;
+
 wire [IRQ_INDEX_WIDTH-1:0]  irq_index;
 wire                        irq_valid;
 wire                        irq_ready;
@@ -355,6 +452,18 @@ wire dma_enable;
 wire dma_rd_busy;
 wire dma_wr_busy;
 
+// DMA read statistics
+wire [15:0]                          stat_rd_req_finish_latency;
+wire                                 stat_rd_req_finish_valid;
+wire [$clog2(PCIE_TAG_COUNT):0]      stat_rd_active_tags;
+wire [$clog2(READ_OP_TABLE_SIZE):0]  stat_rd_active_ops;
+wire                                 stat_rd_op_table_full;
+wire                                 stat_rd_no_tags;
+wire                                 stat_rd_tx_stall;
+wire                                 stat_rd_cplh_stall;
+wire                                 stat_rd_cpld_stall;
+wire                                 stat_rd_tx_limit_stall;
+
 pcie_tlp_demux_bar #(
     .PORTS(3),
     .TLP_DATA_WIDTH(TLP_DATA_WIDTH),
@@ -785,7 +894,7 @@ dma_if_pcie #(
     .TX_SEQ_NUM_COUNT(TX_SEQ_NUM_COUNT),
     .TX_SEQ_NUM_WIDTH(TX_SEQ_NUM_WIDTH),
     .TX_SEQ_NUM_ENABLE(TX_SEQ_NUM_ENABLE),
-    .RAM_SEL_WIDTH(RAM_SEL_WIDTH),
+    .RAM_SEL_WIDTH(IF_RAM_SEL_WIDTH),
     .RAM_ADDR_WIDTH(RAM_ADDR_WIDTH),
     .RAM_SEG_COUNT(RAM_SEG_COUNT),
     .RAM_SEG_DATA_WIDTH(RAM_SEG_DATA_WIDTH),
@@ -796,7 +905,7 @@ dma_if_pcie #(
     .IMM_ENABLE(IMM_ENABLE),
     .IMM_WIDTH(IMM_WIDTH),
     .LEN_WIDTH(DMA_LEN_WIDTH),
-    .TAG_WIDTH(DMA_TAG_WIDTH),
+    .TAG_WIDTH(IF_DMA_TAG_WIDTH),
     .READ_OP_TABLE_SIZE(READ_OP_TABLE_SIZE),
     .READ_TX_LIMIT(READ_TX_LIMIT),
     .READ_CPLH_FC_LIMIT(READ_CPLH_FC_LIMIT),
@@ -913,10 +1022,14 @@ dma_if_pcie_inst (
     .read_enable(dma_enable),
     .write_enable(dma_enable),
     .ext_tag_enable(ext_tag_enable),
+    .ten_bit_tag_enable(ten_bit_tag_enable),
     .rcb_128b(rcb_128b),
     .requester_id({bus_num, 5'd0, 3'd0}),
     .max_read_request_size(max_read_request_size),
     .max_payload_size(max_payload_size),
+    // read completion credit limits are set through channel 0
+    .read_cplh_fc_limit(ch_dma_rd_cplh_fc_limit[11:0]),
+    .read_cpld_fc_limit(ch_dma_rd_cpld_fc_limit[15:0]),
 
     /*
      * Status
@@ -924,7 +1037,78 @@ dma_if_pcie_inst (
     .status_rd_busy(dma_rd_busy),
     .status_wr_busy(dma_wr_busy),
     .status_error_cor(status_error_cor_int[3]),
-    .status_error_uncor(status_error_uncor_int[3])
+    .status_error_uncor(status_error_uncor_int[3]),
+
+    /*
+     * Statistics
+     */
+    .stat_rd_op_start_tag(),
+    .stat_rd_op_start_len(),
+    .stat_rd_op_start_valid(),
+    .stat_rd_op_finish_tag(),
+    .stat_rd_op_finish_status(),
+    .stat_rd_op_finish_valid(),
+    .stat_rd_req_start_tag(),
+    .stat_rd_req_start_len(),
+    .stat_rd_req_start_valid(),
+    .stat_rd_req_finish_tag(),
+    .stat_rd_req_finish_status(),
+    .stat_rd_req_finish_latency(stat_rd_req_finish_latency),
+    .stat_rd_req_finish_valid(stat_rd_req_finish_valid),
+    .stat_rd_req_timeout(),
+    .stat_rd_op_table_full(stat_rd_op_table_full),
+    .stat_rd_no_tags(stat_rd_no_tags),
+    .stat_rd_tx_limit(),
+    .stat_rd_tx_stall(stat_rd_tx_stall),
+    .stat_rd_active_tags(stat_rd_active_tags),
+    .stat_rd_active_ops(stat_rd_active_ops),
+    .stat_rd_cplh_stall(stat_rd_cplh_stall),
+    .stat_rd_cpld_stall(stat_rd_cpld_stall),
+    .stat_rd_tx_limit_stall(stat_rd_tx_limit_stall),
+    .stat_wr_op_start_tag(),
+    .stat_wr_op_start_len(),
+    .stat_wr_op_start_valid(),
+    .stat_wr_op_finish_tag(),
+    .stat_wr_op_finish_status(),
+    .stat_wr_op_finish_valid(),
+    .stat_wr_req_start_tag(),
+    .stat_wr_req_start_len(),
+    .stat_wr_req_start_valid(),
+    .stat_wr_req_finish_tag(),
+    .stat_wr_req_finish_status(),
+    .stat_wr_req_finish_valid(),
+    .stat_wr_op_table_full(),
+    .stat_wr_tx_limit(),
+    .stat_wr_tx_stall()
+);
+
+// per-vector minimum interrupt interval (set from channel 0)
+irq_rate_limit #(
+    .IRQ_INDEX_WIDTH(IRQ_INDEX_WIDTH)
+)
+irq_rate_limit_inst (
+    .clk(clk),
+    .rst(rst),
+
+    /*
+     * Interrupt request input
+     */
+    .in_irq_index(core_irq_index),
+    .in_irq_valid(core_irq_valid),
+    .in_irq_ready(core_irq_ready),
+
+    /*
+     * Interrupt request output
+     */
+    .out_irq_index(irq_index),
+    .out_irq_valid(irq_valid),
+    .out_irq_ready(irq_ready),
+
+    /*
+     * Configuration
+     */
+    .prescale(ch_irq_prescale[15:0]),
+    .min_interval(ch_irq_min_interval[15:0])
 );
 
 pcie_msix #(
@@ -1014,124 +1198,454 @@ status_error_uncor_pm_inst (
     .pulse_out(status_error_uncor)
 );
 
-example_core #(
-    .AXIL_DATA_WIDTH(AXIL_CTRL_DATA_WIDTH),
-    .AXIL_ADDR_WIDTH(AXIL_CTRL_ADDR_WIDTH),
-    .AXIL_STRB_WIDTH(AXIL_CTRL_STRB_WIDTH),
-    .DMA_ADDR_WIDTH(PCIE_ADDR_WIDTH),
-    .DMA_IMM_ENABLE(IMM_ENABLE),
-    .DMA_IMM_WIDTH(IMM_WIDTH),
-    .DMA_LEN_WIDTH(DMA_LEN_WIDTH),
-    .DMA_TAG_WIDTH(DMA_TAG_WIDTH),
-    .RAM_SEL_WIDTH(RAM_SEL_WIDTH),
-    .RAM_ADDR_WIDTH(RAM_ADDR_WIDTH),
-    .RAM_SEG_COUNT(RAM_SEG_COUNT),
-    .RAM_SEG_DATA_WIDTH(RAM_SEG_DATA_WIDTH),
-    .RAM_SEG_BE_WIDTH(RAM_SEG_BE_WIDTH),
-    .RAM_SEG_ADDR_WIDTH(RAM_SEG_ADDR_WIDTH),
-    .IRQ_INDEX_WIDTH(IRQ_INDEX_WIDTH)
-)
-core_inst (
-    .clk(clk),
-    .rst(rst),
-
-    /*
-     * AXI Lite control interface
-     */
-    .s_axil_ctrl_awaddr(axil_ctrl_awaddr),
-    .s_axil_ctrl_awprot(axil_ctrl_awprot),
-    .s_axil_ctrl_awvalid(axil_ctrl_awvalid),
-    .s_axil_ctrl_awready(axil_ctrl_awready),
-    .s_axil_ctrl_wdata(axil_ctrl_wdata),
-    .s_axil_ctrl_wstrb(axil_ctrl_wstrb),
-    .s_axil_ctrl_wvalid(axil_ctrl_wvalid),
-    .s_axil_ctrl_wready(axil_ctrl_wready),
-    .s_axil_ctrl_bresp(axil_ctrl_bresp),
-    .s_axil_ctrl_bvalid(axil_ctrl_bvalid),
-    .s_axil_ctrl_bready(axil_ctrl_bready),
-    .s_axil_ctrl_araddr(axil_ctrl_araddr),
-    .s_axil_ctrl_arprot(axil_ctrl_arprot),
-    .s_axil_ctrl_arvalid(axil_ctrl_arvalid),
-    .s_axil_ctrl_arready(axil_ctrl_arready),
-    .s_axil_ctrl_rdata(axil_ctrl_rdata),
-    .s_axil_ctrl_rresp(axil_ctrl_rresp),
-    .s_axil_ctrl_rvalid(axil_ctrl_rvalid),
-    .s_axil_ctrl_rready(axil_ctrl_rready),
-
-    /*
-     * AXI read descriptor output
-     */
-    .m_axis_dma_read_desc_dma_addr(axis_dma_read_desc_dma_addr),
-    .m_axis_dma_read_desc_ram_sel(axis_dma_read_desc_ram_sel),
-    .m_axis_dma_read_desc_ram_addr(axis_dma_read_desc_ram_addr),
-    .m_axis_dma_read_desc_len(axis_dma_read_desc_len),
-    .m_axis_dma_read_desc_tag(axis_dma_read_desc_tag),
-    .m_axis_dma_read_desc_valid(axis_dma_read_desc_valid),
-    .m_axis_dma_read_desc_ready(axis_dma_read_desc_ready),
-
-    /*
-     * AXI read descriptor status input
-     */
-    .s_axis_dma_read_desc_status_tag(axis_dma_read_desc_status_tag),
-    .s_axis_dma_read_desc_status_error(axis_dma_read_desc_status_error),
-    .s_axis_dma_read_desc_status_valid(axis_dma_read_desc_status_valid),
-
-    /*
-     * AXI write descriptor output
-     */
-    .m_axis_dma_write_desc_dma_addr(axis_dma_write_desc_dma_addr),
-    .m_axis_dma_write_desc_ram_sel(axis_dma_write_desc_ram_sel),
-    .m_axis_dma_write_desc_ram_addr(axis_dma_write_desc_ram_addr),
-    .m_axis_dma_write_desc_imm(axis_dma_write_desc_imm),
-    .m_axis_dma_write_desc_imm_en(axis_dma_write_desc_imm_en),
-    .m_axis_dma_write_desc_len(axis_dma_write_desc_len),
-    .m_axis_dma_write_desc_tag(axis_dma_write_desc_tag),
-    .m_axis_dma_write_desc_valid(axis_dma_write_desc_valid),
-    .m_axis_dma_write_desc_ready(axis_dma_write_desc_ready),
-
-    /*
-     * AXI write descriptor status input
-     */
-    .s_axis_dma_write_desc_status_tag(axis_dma_write_desc_status_tag),
-    .s_axis_dma_write_desc_status_error(axis_dma_write_desc_status_error),
-    .s_axis_dma_write_desc_status_valid(axis_dma_write_desc_status_valid),
-
-    /*
-     * RAM interface
-     */
-    .ram_rd_cmd_sel(ram_rd_cmd_sel),
-    .ram_rd_cmd_addr(ram_rd_cmd_addr),
-    .ram_rd_cmd_valid(ram_rd_cmd_valid),
-    .ram_rd_cmd_ready(ram_rd_cmd_ready),
-    .ram_rd_resp_data(ram_rd_resp_data),
-    .ram_rd_resp_valid(ram_rd_resp_valid),
-    .ram_rd_resp_ready(ram_rd_resp_ready),
-    .ram_wr_cmd_sel(ram_wr_cmd_sel),
-    .ram_wr_cmd_be(ram_wr_cmd_be),
-    .ram_wr_cmd_addr(ram_wr_cmd_addr),
-    .ram_wr_cmd_data(ram_wr_cmd_data),
-    .ram_wr_cmd_valid(ram_wr_cmd_valid),
-    .ram_wr_cmd_ready(ram_wr_cmd_ready),
-    .ram_wr_done(ram_wr_done),
-
-    /*
-     * Interrupt request output
-     */
-    .irq_index(irq_index),
-    .irq_valid(irq_valid),
-    .irq_ready(irq_ready),
-
-    /*
-     * Control and status
-     */
-    .dma_enable(dma_enable),
-    .dma_rd_busy(dma_rd_busy),
-    .dma_wr_busy(dma_wr_busy),
-    .dma_rd_req(tx_rd_req_tlp_valid && tx_rd_req_tlp_sop && tx_rd_req_tlp_ready),
-    .dma_rd_cpl(rx_cpl_tlp_valid && rx_cpl_tlp_sop && rx_cpl_tlp_ready),
-    .dma_wr_req(tx_wr_req_tlp_valid && tx_wr_req_tlp_sop && tx_wr_req_tlp_ready),
-    .rx_cpl_stall(rx_cpl_stall)
-);
+assign dma_enable = |ch_dma_enable;
+assign rx_cpl_stall = |ch_rx_cpl_stall;
+
+// BAR0 channel demux (one 64 KB register window per channel)
+// The select is latched when the address is accepted and held until the
+// response completes, so only one operation per direction is outstanding
+reg axil_ctrl_wr_active_reg = 1'b0;
+reg [DMA_CH_SEL_WIDTH-1:0] axil_ctrl_wr_sel_reg = 0;
+reg axil_ctrl_rd_active_reg = 1'b0;
+reg [DMA_CH_SEL_WIDTH-1:0] axil_ctrl_rd_sel_reg = 0;
+
+wire [DMA_CH_SEL_WIDTH-1:0] axil_ctrl_awaddr_sel;
+wire [DMA_CH_SEL_WIDTH-1:0] axil_ctrl_araddr_sel;
+
+generate
+
+if (DMA_CHANNELS > 1) begin
+    // windows above the channel count alias channel 0
+    assign axil_ctrl_awaddr_sel = axil_ctrl_awaddr[16 +: CL_DMA_CHANNELS] < DMA_CHANNELS ? axil_ctrl_awaddr[16 +: CL_DMA_CHANNELS] : 0;
+    assign axil_ctrl_araddr_sel = axil_ctrl_araddr[16 +: CL_DMA_CHANNELS] < DMA_CHANNELS ? axil_ctrl_araddr[16 +: CL_DMA_CHANNELS] : 0;
+end else begin
+    assign axil_ctrl_awaddr_sel = 0;
+    assign axil_ctrl_araddr_sel = 0;
+end
+
+endgenerate
+
+wire [DMA_CH_SEL_WIDTH-1:0] axil_ctrl_wr_sel = axil_ctrl_wr_active_reg ? axil_ctrl_wr_sel_reg : axil_ctrl_awaddr_sel;
+wire [DMA_CH_SEL_WIDTH-1:0] axil_ctrl_rd_sel = axil_ctrl_rd_active_reg ? axil_ctrl_rd_sel_reg : axil_ctrl_araddr_sel;
+
+assign ch_axil_ctrl_wdata = {DMA_CHANNELS{axil_ctrl_wdata}};
+assign ch_axil_ctrl_awvalid = (axil_ctrl_awvalid && !axil_ctrl_wr_active_reg) << axil_ctrl_wr_sel;
+assign axil_ctrl_awready = ch_axil_ctrl_awready[axil_ctrl_wr_sel] && !axil_ctrl_wr_active_reg;
+assign ch_axil_ctrl_wvalid = axil_ctrl_wvalid << axil_ctrl_wr_sel;
+assign axil_ctrl_wready = ch_axil_ctrl_wready[axil_ctrl_wr_sel];
+assign axil_ctrl_bresp = ch_axil_ctrl_bresp[axil_ctrl_wr_sel*2 +: 2];
+assign axil_ctrl_bvalid = ch_axil_ctrl_bvalid[axil_ctrl_wr_sel];
+assign ch_axil_ctrl_bready = axil_ctrl_bready << axil_ctrl_wr_sel;
+
+assign ch_axil_ctrl_arvalid = (axil_ctrl_arvalid && !axil_ctrl_rd_active_reg) << axil_ctrl_rd_sel;
+assign axil_ctrl_arready = ch_axil_ctrl_arready[axil_ctrl_rd_sel] && !axil_ctrl_rd_active_reg;
+assign axil_ctrl_rdata = ch_axil_ctrl_rdata[axil_ctrl_rd_sel*AXIL_CTRL_DATA_WIDTH +: AXIL_CTRL_DATA_WIDTH];
+assign axil_ctrl_rresp = ch_axil_ctrl_rresp[axil_ctrl_rd_sel*2 +: 2];
+assign axil_ctrl_rvalid = ch_axil_ctrl_rvalid[axil_ctrl_rd_sel];
+assign ch_axil_ctrl_rready = axil_ctrl_rready << axil_ctrl_rd_sel;
+
+always @(posedge clk) begin
+    if (axil_ctrl_awvalid && axil_ctrl_awready) begin
+        axil_ctrl_wr_active_reg <= 1'b1;
+        axil_ctrl_wr_sel_reg <= axil_ctrl_wr_sel;
+    end
+    if (axil_ctrl_bvalid && axil_ctrl_bready) begin
+        axil_ctrl_wr_active_reg <= 1'b0;
+    end
+
+    if (axil_ctrl_arvalid && axil_ctrl_arready) begin
+        axil_ctrl_rd_active_reg <= 1'b1;
+        axil_ctrl_rd_sel_reg <= axil_ctrl_rd_sel;
+    end
+    if (axil_ctrl_rvalid && axil_ctrl_rready) begin
+        axil_ctrl_rd_active_reg <= 1'b0;
+    end
+
+    if (rst) begin
+        axil_ctrl_wr_active_reg <= 1'b0;
+        axil_ctrl_rd_active_reg <= 1'b0;
+    end
+end
+
+generate
+
+genvar n;
+
+if (DMA_CHANNELS > 1) begin : ch_mux
+
+    dma_if_mux #(
+        .PORTS(DMA_CHANNELS),
+        .SEG_COUNT(RAM_SEG_COUNT),
+        .SEG_DATA_WIDTH(RAM_SEG_DATA_WIDTH),
+        .SEG_ADDR_WIDTH(RAM_SEG_ADDR_WIDTH),
+        .SEG_BE_WIDTH(RAM_SEG_BE_WIDTH),
+        .S_RAM_SEL_WIDTH(RAM_SEL_WIDTH),
+        .M_RAM_SEL_WIDTH(IF_RAM_SEL_WIDTH),
+        .RAM_ADDR_WIDTH(RAM_ADDR_WIDTH),
+        .DMA_ADDR_WIDTH(PCIE_ADDR_WIDTH),
+        .IMM_ENABLE(IMM_ENABLE),
+        .IMM_WIDTH(IMM_WIDTH),
+        .LEN_WIDTH(DMA_LEN_WIDTH),
+        .S_TAG_WIDTH(DMA_TAG_WIDTH),
+        .M_TAG_WIDTH(IF_DMA_TAG_WIDTH),
+        .ARB_TYPE_ROUND_ROBIN(1),
+        .ARB_LSB_HIGH_PRIORITY(1)
+    )
+    dma_if_mux_inst (
+        .clk(clk),
+        .rst(rst),
+
+        /*
+         * Read descriptor output (to DMA interface)
+         */
+        .m_axis_read_desc_dma_addr(axis_dma_read_desc_dma_addr),
+        .m_axis_read_desc_ram_sel(axis_dma_read_desc_ram_sel),
+        .m_axis_read_desc_ram_addr(axis_dma_read_desc_ram_addr),
+        .m_axis_read_desc_len(axis_dma_read_desc_len),
+        .m_axis_read_desc_tag(axis_dma_read_desc_tag),
+        .m_axis_read_desc_valid(axis_dma_read_desc_valid),
+        .m_axis_read_desc_ready(axis_dma_read_desc_ready),
+
+        /*
+         * Read descriptor status input (from DMA interface)
+         */
+        .s_axis_read_desc_status_tag(axis_dma_read_desc_status_tag),
+        .s_axis_read_desc_status_error(axis_dma_read_desc_status_error),
+        .s_axis_read_desc_status_valid(axis_dma_read_desc_status_valid),
+
+        /*
+         * Write descriptor output (to DMA interface)
+         */
+        .m_axis_write_desc_dma_addr(axis_dma_write_desc_dma_addr),
+        .m_axis_write_desc_ram_sel(axis_dma_write_desc_ram_sel),
+        .m_axis_write_desc_ram_addr(axis_dma_write_desc_ram_addr),
+        .m_axis_write_desc_imm(axis_dma_write_desc_imm),
+        .m_axis_write_desc_imm_en(axis_dma_write_desc_imm_en),
+        .m_axis_write_desc_len(axis_dma_write_desc_len),
+        .m_axis_write_desc_tag(axis_dma_write_desc_tag),
+        .m_axis_write_desc_valid(axis_dma_write_desc_valid),
+        .m_axis_write_desc_ready(axis_dma_write_desc_ready),
+
+        /*
+         * Write descriptor status input (from DMA interface)
+         */
+        .s_axis_write_desc_status_tag(axis_dma_write_desc_status_tag),
+        .s_axis_write_desc_status_error(axis_dma_write_desc_status_error),
+        .s_axis_write_desc_status_valid(axis_dma_write_desc_status_valid),
+
+        /*
+         * Read descriptor input
+         */
+        .s_axis_read_desc_dma_addr(ch_axis_dma_read_desc_dma_addr),
+        .s_axis_read_desc_ram_sel(ch_axis_dma_read_desc_ram_sel),
+        .s_axis_read_desc_ram_addr(ch_axis_dma_read_desc_ram_addr),
+        .s_axis_read_desc_len(ch_axis_dma_read_desc_len),
+        .s_axis_read_desc_tag(ch_axis_dma_read_desc_tag),
+        .s_axis_read_desc_valid(ch_axis_dma_read_desc_valid),
+        .s_axis_read_desc_ready(ch_axis_dma_read_desc_ready),
+
+        /*
+         * Read descriptor status output
+         */
+        .m_axis_read_desc_status_tag(ch_axis_dma_read_desc_status_tag),
+        .m_axis_read_desc_status_error(ch_axis_dma_read_desc_status_error),
+        .m_axis_read_desc_status_valid(ch_axis_dma_read_desc_status_valid),
+
+        /*
+         * Write descriptor input
+         */
+        .s_axis_write_desc_dma_addr(ch_axis_dma_write_desc_dma_addr),
+        .s_axis_write_desc_ram_sel(ch_axis_dma_write_desc_ram_sel),
+        .s_axis_write_desc_ram_addr(ch_axis_dma_write_desc_ram_addr),
+        .s_axis_write_desc_imm(ch_axis_dma_write_desc_imm),
+        .s_axis_write_desc_imm_en(ch_axis_dma_write_desc_imm_en),
+        .s_axis_write_desc_len(ch_axis_dma_write_desc_len),
+        .s_axis_write_desc_tag(ch_axis_dma_write_desc_tag),
+        .s_axis_write_desc_valid(ch_axis_dma_write_desc_valid),
+        .s_axis_write_desc_ready(ch_axis_dma_write_desc_ready),
+
+        /*
+         * Write descriptor status output
+         */
+        .m_axis_write_desc_status_tag(ch_axis_dma_write_desc_status_tag),
+        .m_axis_write_desc_status_error(ch_axis_dma_write_desc_status_error),
+        .m_axis_write_desc_status_valid(ch_axis_dma_write_desc_status_valid),
+
+        /*
+         * RAM interface (from DMA interface)
+         */
+        .if_ram_wr_cmd_sel(ram_wr_cmd_sel),
+        .if_ram_wr_cmd_be(ram_wr_cmd_be),
+        .if_ram_wr_cmd_addr(ram_wr_cmd_addr),
+        .if_ram_wr_cmd_data(ram_wr_cmd_data),
+        .if_ram_wr_cmd_valid(ram_wr_cmd_valid),
+        .if_ram_wr_cmd_ready(ram_wr_cmd_ready),
+        .if_ram_wr_done(ram_wr_done),
+        .if_ram_rd_cmd_sel(ram_rd_cmd_sel),
+        .if_ram_rd_cmd_addr(ram_rd_cmd_addr),
+        .if_ram_rd_cmd_valid(ram_rd_cmd_valid),
+        .if_ram_rd_cmd_ready(ram_rd_cmd_ready),
+        .if_ram_rd_resp_data(ram_rd_resp_data),
+        .if_ram_rd_resp_valid(ram_rd_resp_valid),
+        .if_ram_rd_resp_ready(ram_rd_resp_ready),
+
+        /*
+         * RAM interface (towards RAM)
+         */
+        .ram_wr_cmd_sel(ch_ram_wr_cmd_sel),
+        .ram_wr_cmd_be(ch_ram_wr_cmd_be),
+        .ram_wr_cmd_addr(ch_ram_wr_cmd_addr),
+        .ram_wr_cmd_data(ch_ram_wr_cmd_data),
+        .ram_wr_cmd_valid(ch_ram_wr_cmd_valid),
+        .ram_wr_cmd_ready(ch_ram_wr_cmd_ready),
+        .ram_wr_done(ch_ram_wr_done),
+        .ram_rd_cmd_sel(ch_ram_rd_cmd_sel),
+        .ram_rd_cmd_addr(ch_ram_rd_cmd_addr),
+        .ram_rd_cmd_valid(ch_ram_rd_cmd_valid),
+        .ram_rd_cmd_ready(ch_ram_rd_cmd_ready),
+        .ram_rd_resp_data(ch_ram_rd_resp_data),
+        .ram_rd_resp_valid(ch_ram_rd_resp_valid),
+        .ram_rd_resp_ready(ch_ram_rd_resp_ready)
+    );
+
+    axis_arb_mux #(
+        .S_COUNT(DMA_CHANNELS),
+        .DATA_WIDTH(IRQ_INDEX_WIDTH),
+        .KEEP_ENABLE(0),
+        .ID_ENABLE(0),
+        .DEST_ENABLE(0),
+        .USER_ENABLE(0),
+        .LAST_ENABLE(0),
+        .ARB_TYPE_ROUND_ROBIN(1),
+        .ARB_LSB_HIGH_PRIORITY(1)
+    )
+    irq_mux_inst (
+        .clk(clk),
+        .rst(rst),
+
+        /*
+         * AXI Stream inputs
+         */
+        .s_axis_tdata(ch_irq_index),
+        .s_axis_tkeep(0),
+        .s_axis_tvalid(ch_irq_valid),
+        .s_axis_tready(ch_irq_ready),
+        .s_axis_tlast(0),
+        .s_axis_tid(0),
+        .s_axis_tdest(0),
+        .s_axis_tuser(0),
+
+        /*
+         * AXI Stream output
+         */
+        .m_axis_tdata(core_irq_index),
+        .m_axis_tkeep(),
+        .m_axis_tvalid(core_irq_valid),
+        .m_axis_tready(core_irq_ready),
+        .m_axis_tlast(),
+        .m_axis_tid(),
+        .m_axis_tdest(),
+        .m_axis_tuser()
+    );
+
+end else begin
+
+    assign axis_dma_read_desc_dma_addr = ch_axis_dma_read_desc_dma_addr;
+    assign axis_dma_read_desc_ram_sel = ch_axis_dma_read_desc_ram_sel;
+    assign axis_dma_read_desc_ram_addr = ch_axis_dma_read_desc_ram_addr;
+    assign axis_dma_read_desc_len = ch_axis_dma_read_desc_len;
+    assign axis_dma_read_desc_tag = ch_axis_dma_read_desc_tag;
+    assign axis_dma_read_desc_valid = ch_axis_dma_read_desc_valid;
+    assign ch_axis_dma_read_desc_ready = axis_dma_read_desc_ready;
+
+    assign ch_axis_dma_read_desc_status_tag = axis_dma_read_desc_status_tag;
+    assign ch_axis_dma_read_desc_status_error = axis_dma_read_desc_status_error;
+    assign ch_axis_dma_read_desc_status_valid = axis_dma_read_desc_status_valid;
+
+    assign axis_dma_write_desc_dma_addr = ch_axis_dma_write_desc_dma_addr;
+    assign axis_dma_write_desc_ram_sel = ch_axis_dma_write_desc_ram_sel;
+    assign axis_dma_write_desc_ram_addr = ch_axis_dma_write_desc_ram_addr;
+    assign axis_dma_write_desc_imm = ch_axis_dma_write_desc_imm;
+    assign axis_dma_write_desc_imm_en = ch_axis_dma_write_desc_imm_en;
+    assign axis_dma_write_desc_len = ch_axis_dma_write_desc_len;
+    assign axis_dma_write_desc_tag = ch_axis_dma_write_desc_tag;
+    assign axis_dma_write_desc_valid = ch_axis_dma_write_desc_valid;
+    assign ch_axis_dma_write_desc_ready = axis_dma_write_desc_ready;
+
+    assign ch_axis_dma_write_desc_status_tag = axis_dma_write_desc_status_tag;
+    assign ch_axis_dma_write_desc_status_error = axis_dma_write_desc_status_error;
+    assign ch_axis_dma_write_desc_status_valid = axis_dma_write_desc_status_valid;
+
+    assign ch_ram_rd_cmd_sel = ram_rd_cmd_sel;
+    assign ch_ram_rd_cmd_addr = ram_rd_cmd_addr;
+    assign ch_ram_rd_cmd_valid = ram_rd_cmd_valid;
+    assign ram_rd_cmd_ready = ch_ram_rd_cmd_ready;
+    assign ram_rd_resp_data = ch_ram_rd_resp_data;
+    assign ram_rd_resp_valid = ch_ram_rd_resp_valid;
+    assign ch_ram_rd_resp_ready = ram_rd_resp_ready;
+    assign ch_ram_wr_cmd_sel = ram_wr_cmd_sel;
+    assign ch_ram_wr_cmd_be = ram_wr_cmd_be;
+    assign ch_ram_wr_cmd_addr = ram_wr_cmd_addr;
+    assign ch_ram_wr_cmd_data = ram_wr_cmd_data;
+    assign ch_ram_wr_cmd_valid = ram_wr_cmd_valid;
+    assign ram_wr_cmd_ready = ch_ram_wr_cmd_ready;
+    assign ram_wr_done = ch_ram_wr_done;
+
+    assign core_irq_index = ch_irq_index;
+    assign core_irq_valid = ch_irq_valid;
+    assign ch_irq_ready = core_irq_ready;
+
+end
+
+for (n = 0; n < DMA_CHANNELS; n = n + 1) begin : dma_ch
+
+    example_core #(
+        .AXIL_DATA_WIDTH(AXIL_CTRL_DATA_WIDTH),
+        .AXIL_ADDR_WIDTH(AXIL_CTRL_ADDR_WIDTH),
+        .AXIL_STRB_WIDTH(AXIL_CTRL_STRB_WIDTH),
+        .DMA_ADDR_WIDTH(PCIE_ADDR_WIDTH),
+        .DMA_IMM_ENABLE(IMM_ENABLE),
+        .DMA_IMM_WIDTH(IMM_WIDTH),
+        .DMA_LEN_WIDTH(DMA_LEN_WIDTH),
+        .DMA_TAG_WIDTH(DMA_TAG_WIDTH),
+        .RAM_SEL_WIDTH(RAM_SEL_WIDTH),
+        .RAM_ADDR_WIDTH(RAM_ADDR_WIDTH),
+        .RAM_SEG_COUNT(RAM_SEG_COUNT),
+        .RAM_SEG_DATA_WIDTH(RAM_SEG_DATA_WIDTH),
+        .RAM_SEG_BE_WIDTH(RAM_SEG_BE_WIDTH),
+        .RAM_SEG_ADDR_WIDTH(RAM_SEG_ADDR_WIDTH),
+        .IRQ_INDEX_WIDTH(IRQ_INDEX_WIDTH),
+        .CHANNEL_INDEX(n),
+        .CHANNEL_COUNT(DMA_CHANNELS),
+        // DMA interface is shared, so only channel 0 collects statistics
+        .DMA_STATS_ENABLE(n == 0),
+        .DMA_CPLH_FC_LIMIT(READ_CPLH_FC_LIMIT),
+        .DMA_CPLD_FC_LIMIT(READ_CPLD_FC_LIMIT),
+        .CLK_FREQ_KHZ(CLK_FREQ_KHZ)
+    )
+    core_inst (
+        .clk(clk),
+        .rst(rst),
+
+        /*
+         * AXI Lite control interface
+         */
+        .s_axil_ctrl_awaddr(axil_ctrl_awaddr),
+        .s_axil_ctrl_awprot(axil_ctrl_awprot),
+        .s_axil_ctrl_awvalid(ch_axil_ctrl_awvalid[n]),
+        .s_axil_ctrl_awready(ch_axil_ctrl_awready[n]),
+        .s_axil_ctrl_wdata(ch_axil_ctrl_wdata[n*AXIL_CTRL_DATA_WIDTH +: AXIL_CTRL_DATA_WIDTH]),
+        .s_axil_ctrl_wstrb(axil_ctrl_wstrb),
+        .s_axil_ctrl_wvalid(ch_axil_ctrl_wvalid[n]),
+        .s_axil_ctrl_wready(ch_axil_ctrl_wready[n]),
+        .s_axil_ctrl_bresp(ch_axil_ctrl_bresp[n*2 +: 2]),
+        .s_axil_ctrl_bvalid(ch_axil_ctrl_bvalid[n]),
+        .s_axil_ctrl_bready(ch_axil_ctrl_bready[n]),
+        .s_axil_ctrl_araddr(axil_ctrl_araddr),
+        .s_axil_ctrl_arprot(axil_ctrl_arprot),
+        .s_axil_ctrl_arvalid(ch_axil_ctrl_arvalid[n]),
+        .s_axil_ctrl_arready(ch_axil_ctrl_arready[n]),
+        .s_axil_ctrl_rdata(ch_axil_ctrl_rdata[n*AXIL_CTRL_DATA_WIDTH +: AXIL_CTRL_DATA_WIDTH]),
+        .s_axil_ctrl_rresp(ch_axil_ctrl_rresp[n*2 +: 2]),
+        .s_axil_ctrl_rvalid(ch_axil_ctrl_rvalid[n]),
+        .s_axil_ctrl_rready(ch_axil_ctrl_rready[n]),
+
+        /*
+         * AXI read descriptor output
+         */
+        .m_axis_dma_read_desc_dma_addr(ch_axis_dma_read_desc_dma_addr[n*PCIE_ADDR_WIDTH +: PCIE_ADDR_WIDTH]),
+        .m_axis_dma_read_desc_ram_sel(ch_axis_dma_read_desc_ram_sel[n*RAM_SEL_WIDTH +: RAM_SEL_WIDTH]),
+        .m_axis_dma_read_desc_ram_addr(ch_axis_dma_read_desc_ram_addr[n*RAM_ADDR_WIDTH +: RAM_ADDR_WIDTH]),
+        .m_axis_dma_read_desc_len(ch_axis_dma_read_desc_len[n*DMA_LEN_WIDTH +: DMA_LEN_WIDTH]),
+        .m_axis_dma_read_desc_tag(ch_axis_dma_read_desc_tag[n*DMA_TAG_WIDTH +: DMA_TAG_WIDTH]),
+        .m_axis_dma_read_desc_valid(ch_axis_dma_read_desc_valid[n]),
+        .m_axis_dma_read_desc_ready(ch_axis_dma_read_desc_ready[n]),
+
+        /*
+         * AXI read descriptor status input
+         */
+        .s_axis_dma_read_desc_status_tag(ch_axis_dma_read_desc_status_tag[n*DMA_TAG_WIDTH +: DMA_TAG_WIDTH]),
+        .s_axis_dma_read_desc_status_error(ch_axis_dma_read_desc_status_error[n*4 +: 4]),
+        .s_axis_dma_read_desc_status_valid(ch_axis_dma_read_desc_status_valid[n]),
+
+        /*
+         * AXI write descriptor output
+         */
+        .m_axis_dma_write_desc_dma_addr(ch_axis_dma_write_desc_dma_addr[n*PCIE_ADDR_WIDTH +: PCIE_ADDR_WIDTH]),
+        .m_axis_dma_write_desc_ram_sel(ch_axis_dma_write_desc_ram_sel[n*RAM_SEL_WIDTH +: RAM_SEL_WIDTH]),
+        .m_axis_dma_write_desc_ram_addr(ch_axis_dma_write_desc_ram_addr[n*RAM_ADDR_WIDTH +: RAM_ADDR_WIDTH]),
+        .m_axis_dma_write_desc_imm(ch_axis_dma_write_desc_imm[n*IMM_WIDTH +: IMM_WIDTH]),
+        .m_axis_dma_write_desc_imm_en(ch_axis_dma_write_desc_imm_en[n]),
+        .m_axis_dma_write_desc_len(ch_axis_dma_write_desc_len[n*DMA_LEN_WIDTH +: DMA_LEN_WIDTH]),
+        .m_axis_dma_write_desc_tag(ch_axis_dma_write_desc_tag[n*DMA_TAG_WIDTH +: DMA_TAG_WIDTH]),
+        .m_axis_dma_write_desc_valid(ch_axis_dma_write_desc_valid[n]),
+        .m_axis_dma_write_desc_ready(ch_axis_dma_write_desc_ready[n]),
+
+        /*
+         * AXI write descriptor status input
+         */
+        .s_axis_dma_write_desc_status_tag(ch_axis_dma_write_desc_status_tag[n*DMA_TAG_WIDTH +: DMA_TAG_WIDTH]),
+        .s_axis_dma_write_desc_status_error(ch_axis_dma_write_desc_status_error[n*4 +: 4]),
+        .s_axis_dma_write_desc_status_valid(ch_axis_dma_write_desc_status_valid[n]),
+
+        /*
+         * RAM interface
+         */
+        .ram_rd_cmd_sel(ch_ram_rd_cmd_sel[n*RAM_SEG_COUNT*RAM_SEL_WIDTH +: RAM_SEG_COUNT*RAM_SEL_WIDTH]),
+        .ram_rd_cmd_addr(ch_ram_rd_cmd_addr[n*RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH +: RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH]),
+        .ram_rd_cmd_valid(ch_ram_rd_cmd_valid[n*RAM_SEG_COUNT +: RAM_SEG_COUNT]),
+        .ram_rd_cmd_ready(ch_ram_rd_cmd_ready[n*RAM_SEG_COUNT +: RAM_SEG_COUNT]),
+        .ram_rd_resp_data(ch_ram_rd_resp_data[n*RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH +: RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH]),
+        .ram_rd_resp_valid(ch_ram_rd_resp_valid[n*RAM_SEG_COUNT +: RAM_SEG_COUNT]),
+        .ram_rd_resp_ready(ch_ram_rd_resp_ready[n*RAM_SEG_COUNT +: RAM_SEG_COUNT]),
+        .ram_wr_cmd_sel(ch_ram_wr_cmd_sel[n*RAM_SEG_COUNT*RAM_SEL_WIDTH +: RAM_SEG_COUNT*RAM_SEL_WIDTH]),
+        .ram_wr_cmd_be(ch_ram_wr_cmd_be[n*RAM_SEG_COUNT*RAM_SEG_BE_WIDTH +: RAM_SEG_COUNT*RAM_SEG_BE_WIDTH]),
+        .ram_wr_cmd_addr(ch_ram_wr_cmd_addr[n*RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH +: RAM_SEG_COUNT*RAM_SEG_ADDR_WIDTH]),
+        .ram_wr_cmd_data(ch_ram_wr_cmd_data[n*RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH +: RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH]),
+        .ram_wr_cmd_valid(ch_ram_wr_cmd_valid[n*RAM_SEG_COUNT +: RAM_SEG_COUNT]),
+        .ram_wr_cmd_ready(ch_ram_wr_cmd_ready[n*RAM_SEG_COUNT +: RAM_SEG_COUNT]),
+        .ram_wr_done(ch_ram_wr_done[n*RAM_SEG_COUNT +: RAM_SEG_COUNT]),
+
+        /*
+         * Interrupt request output
+         */
+        .irq_index(ch_irq_index[n*IRQ_INDEX_WIDTH +: IRQ_INDEX_WIDTH]),
+        .irq_valid(ch_irq_valid[n]),
+        .irq_ready(ch_irq_ready[n]),
+
+        /*
+         * Control and status
+         */
+        .dma_enable(ch_dma_enable[n]),
+        .dma_rd_busy(dma_rd_busy),
+        .dma_wr_busy(dma_wr_busy),
+        .dma_rd_req(tx_rd_req_tlp_valid && tx_rd_req_tlp_sop && tx_rd_req_tlp_ready),
+        .dma_rd_cpl(rx_cpl_tlp_valid && rx_cpl_tlp_sop && rx_cpl_tlp_ready),
+        .dma_wr_req(tx_wr_req_tlp_valid && tx_wr_req_tlp_sop && tx_wr_req_tlp_ready),
+        .rx_cpl_stall(ch_rx_cpl_stall[n]),
+        .dma_rd_cplh_fc_limit(ch_dma_rd_cplh_fc_limit[n*12 +: 12]),
+        .dma_rd_cpld_fc_limit(ch_dma_rd_cpld_fc_limit[n*16 +: 16]),
+        .irq_prescale(ch_irq_prescale[n*16 +: 16]),
+        .irq_min_interval(ch_irq_min_interval[n*16 +: 16]),
+
+        /*
+         * DMA read statistics
+         */
+        .dma_rd_lat(stat_rd_req_finish_latency),
+        .dma_rd_lat_valid(stat_rd_req_finish_valid),
+        .dma_rd_active_tags(stat_rd_active_tags),
+        .dma_rd_active_ops(stat_rd_active_ops),
+        .dma_rd_no_tags(stat_rd_no_tags),
+        .dma_rd_op_table_full(stat_rd_op_table_full),
+        .dma_rd_cplh_stall(stat_rd_cplh_stall),
+        .dma_rd_cpld_stall(stat_rd_cpld_stall),
+        .dma_rd_tx_limit_stall(stat_rd_tx_limit_stall),
+        .dma_rd_tx_stall(stat_rd_tx_stall)
+    );
+
+end
+
+endgenerate
 
 endmodule
 
@@ -68,7 +68,11 @@ module example_core_pcie_s10 #
     // BAR2 aperture (log2 size)
     parameter BAR2_APERTURE = 24,
     // BAR4 aperture (log2 size)
-    parameter BAR4_APERTURE = 16
+    parameter BAR4_APERTURE = 16,
+    // Number of DMA channels (each with a 64 KB register window in BAR0)
+    parameter DMA_CHANNELS = 1,
+    // Core clock frequency in kHz (reported to the driver)
+    parameter CLK_FREQ_KHZ = 250000
 )
 (
     input  wire                                  clk,
@@ -403,7 +407,9 @@ example_core_pcie #(
     .CHECK_BUS_NUMBER(1),
     .BAR0_APERTURE(BAR0_APERTURE),
     .BAR2_APERTURE(BAR2_APERTURE),
-    .BAR4_APERTURE(BAR4_APERTURE)
+    .BAR4_APERTURE(BAR4_APERTURE),
+    .DMA_CHANNELS(DMA_CHANNELS),
+    .CLK_FREQ_KHZ(CLK_FREQ_KHZ)
 )
 core_pcie_inst (
     .clk(clk),
@@ -491,6 +497,7 @@ core_pcie_inst (
      */
     .bus_num(bus_num),
     .ext_tag_enable(ext_tag_enable),
+    .ten_bit_tag_enable(1'b0),
     .rcb_128b(rcb_128b),
     .max_read_request_size(max_read_request_size),
     .max_payload_size(max_payload_size),
@@ -80,7 +80,11 @@ module example_core_pcie_us #
     // BAR2 aperture (log2 size)
     parameter BAR2_APERTURE = 24,
     // BAR4 aperture (log2 size)
-    parameter BAR4_APERTURE = 16
+    parameter BAR4_APERTURE = 16,
+    // Number of DMA channels (each with a 64 KB register window in BAR0)
+    parameter DMA_CHANNELS = 1,
+    // Core clock frequency in kHz (reported to the driver)
+    parameter CLK_FREQ_KHZ = 250000
 )
 (
     input  wire                                clk,
@@ -534,7 +538,9 @@ example_core_pcie #(
     .CHECK_BUS_NUMBER(0),
     .BAR0_APERTURE(BAR0_APERTURE),
     .BAR2_APERTURE(BAR2_APERTURE),
-    .BAR4_APERTURE(BAR4_APERTURE)
+    .BAR4_APERTURE(BAR4_APERTURE),
+    .DMA_CHANNELS(DMA_CHANNELS),
+    .CLK_FREQ_KHZ(CLK_FREQ_KHZ)
 )
 core_pcie_inst (
     .clk(clk),
@@ -622,6 +628,7 @@ core_pcie_inst (
      */
     .bus_num(8'd0),
     .ext_tag_enable(ext_tag_enable),
+    .ten_bit_tag_enable(1'b0),
     .rcb_128b(cfg_rcb_status[0]),
     .max_read_request_size(cfg_max_read_req),
     .max_payload_size(cfg_max_payload),
@@ -133,6 +133,7 @@ class TB(object):
         self.dev.functions[0].configure_bar(4, 2**len(dut.axil_msix_awaddr))
 
         dut.bus_num.setimmediatevalue(0)
+        dut.ten_bit_tag_enable.setimmediatevalue(int(os.getenv("PARAM_PCIE_TAG_COUNT", "256")) > 256)
 
         dut.msix_enable.setimmediatevalue(0)
         dut.msix_mask.setimmediatevalue(0)
@@ -388,6 +389,364 @@ async def run_test(dut):
 
     assert mem[src_offset:src_offset+region_len] == mem[dest_offset:dest_offset+region_len]
 
+    tb.log.info("Test DMA block latency")
+
+    assert await dev_pf0_bar0.read_dword(0x000058) == 250000
+
+    for base in [0x001000, 0x001100]:
+        lat_count = await dev_pf0_bar0.read_dword(base+0x30)
+        lat_min = await dev_pf0_bar0.read_dword(base+0x34)
+        lat_max = await dev_pf0_bar0.read_dword(base+0x38)
+        lat_sum = await dev_pf0_bar0.read_dword(base+0x40)
+        lat_sum |= await dev_pf0_bar0.read_dword(base+0x44) << 32
+        cycles = await dev_pf0_bar0.read_dword(base+0x08)
+        cycles |= await dev_pf0_bar0.read_dword(base+0x0c) << 32
+        tb.log.info("Block latency (0x%04x): count %d min %d max %d sum %d, %d cycles",
+            base, lat_count, lat_min, lat_max, lat_sum, cycles)
+
+        assert lat_count == block_count
+        assert 0 < lat_min <= lat_max < cycles
+        assert lat_min*lat_count <= lat_sum <= lat_max*lat_count
+
+    tb.log.info("Test DMA read statistics")
+
+    val = await dev_pf0_bar0.read_dword(0x000400)
+    assert val & 1
+
+    lat_count = await dev_pf0_bar0.read_dword(0x000404)
+    lat_min = await dev_pf0_bar0.read_dword(0x000408)
+    lat_max = await dev_pf0_bar0.read_dword(0x00040c)
+    lat_sum = await dev_pf0_bar0.read_dword(0x000410)
+    lat_sum |= await dev_pf0_bar0.read_dword(0x000414) << 32
+    tb.log.info("Read latency: count %d min %d max %d sum %d", lat_count, lat_min, lat_max, lat_sum)
+
+    hist = [await dev_pf0_bar0.read_dword(0x000480+k*4) for k in range(16)]
+    tb.log.info("Read latency histogram: %s", hist)
+
+    tag_max = await dev_pf0_bar0.read_dword(0x000428)
+    op_max = await dev_pf0_bar0.read_dword(0x000438)
+    tb.log.info("Max active tags %d, max active ops %d", tag_max, op_max)
+
+    assert lat_count > 0
+    assert 0 < lat_min <= lat_max
+    assert lat_min*lat_count <= lat_sum <= lat_max*lat_count
+    assert sum(hist) == lat_count
+    assert tag_max > 0
+    assert op_max > 0
+
+    # clear
+    await dev_pf0_bar0.write_dword(0x000400, 1)
+
+    val = await dev_pf0_bar0.read_dword(0x000404)
+    assert val == 0
+    val = await dev_pf0_bar0.read_dword(0x000480)
+    assert val == 0
+
+    tb.log.info("Test runtime completion credit limits")
+
+    # no compile-time limit
+    assert await dev_pf0_bar0.read_dword(0x000050) == 0
+    assert await dev_pf0_bar0.read_dword(0x000054) == 0
+
+    await dev_pf0_bar0.write_dword(0x000048, 8)
+    await dev_pf0_bar0.write_dword(0x00004c, 32)
+    assert await dev_pf0_bar0.read_dword(0x000048) == 8
+    assert await dev_pf0_bar0.read_dword(0x00004c) == 32
+
+    # repeat block read with limits in place
+    await dev_pf0_bar0.write_dword(0x001008, 0)
+    await dev_pf0_bar0.write_dword(0x00100c, 0)
+    await dev_pf0_bar0.write_dword(0x001000, 1)
+
+    for k in range(10):
+        await Timer(1000, 'ns')
+        run = await dev_pf0_bar0.read_dword(0x001000)
+        if run == 0:
+            break
+
+    assert run == 0
+    assert await dev_pf0_bar0.read_dword(0x000044) == 0
+
+    # every request holds at least one header credit
+    tag_max = await dev_pf0_bar0.read_dword(0x000428)
+    tb.log.info("Max active tags with CPLH limit 8: %d", tag_max)
+    assert 0 < tag_max <= 8
+
+    await dev_pf0_bar0.write_dword(0x000048, 0)
+    await dev_pf0_bar0.write_dword(0x00004c, 0)
+
+    tb.log.info("Test full-duplex DMA block operations")
+
+    duplex_src_offset = 0x8000
+    duplex_dest_offset = 0xc000
+
+    mem[duplex_src_offset:duplex_src_offset+region_len] = bytearray([(x*7) % 256 for x in range(region_len)])
+    mem[dest_offset:dest_offset+region_len] = bytearray(region_len)
+
+    # read new data into the upper half of RAM while writing out the lower half
+    await dev_pf0_bar0.write_dword(0x001080, (mem_base+duplex_src_offset) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x001084, (mem_base+duplex_src_offset >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x0010c0, region_len)
+    await dev_pf0_bar0.write_dword(0x001008, 0)
+    await dev_pf0_bar0.write_dword(0x00100c, 0)
+    await dev_pf0_bar0.write_dword(0x001108, 0)
+    await dev_pf0_bar0.write_dword(0x00110c, 0)
+
+    rd_req = await dev_pf0_bar0.read_dword(0x000020)
+    wr_req = await dev_pf0_bar0.read_dword(0x000028)
+
+    # start both engines
+    await dev_pf0_bar0.write_dword(0x001000, 1)
+    await dev_pf0_bar0.write_dword(0x001100, 1)
+
+    for k in range(20):
+        await Timer(1000, 'ns')
+        run = await dev_pf0_bar0.read_dword(0x001000) | await dev_pf0_bar0.read_dword(0x001100)
+        if run == 0:
+            break
+
+    assert run == 0
+
+    status = await dev_pf0_bar0.read_dword(0x000000)
+    tb.log.info("DMA Status: 0x%x", status)
+    assert status & 0x300 == 0
+
+    rd_req = (await dev_pf0_bar0.read_dword(0x000020) - rd_req) & 0xffffffff
+    wr_req = (await dev_pf0_bar0.read_dword(0x000028) - wr_req) & 0xffffffff
+    rd_cycles = await dev_pf0_bar0.read_dword(0x001008)
+    wr_cycles = await dev_pf0_bar0.read_dword(0x001108)
+    tb.log.info("Read %d cycles %d req, write %d cycles %d req", rd_cycles, rd_req, wr_cycles, wr_req)
+
+    assert rd_req >= block_count
+    assert wr_req >= block_count
+    assert mem[dest_offset:dest_offset+region_len] == mem[src_offset:src_offset+region_len]
+
+    # write back the upper half of RAM to check the reads
+    await dev_pf0_bar0.write_dword(0x001180, (mem_base+duplex_dest_offset) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x001184, (mem_base+duplex_dest_offset >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x0011c0, region_len)
+    await dev_pf0_bar0.write_dword(0x001100, 1)
+
+    for k in range(10):
+        await Timer(1000, 'ns')
+        run = await dev_pf0_bar0.read_dword(0x001100)
+        if run == 0:
+            break
+
+    assert run == 0
+    assert mem[duplex_dest_offset:duplex_dest_offset+region_len] == mem[duplex_src_offset:duplex_src_offset+region_len]
+
+    tb.log.info("Test DMA block address list (gather/scatter)")
+
+    gather_src_offset = 0x18000
+    gather_dest_offset = 0x14000
+    list_offset = 0x1c000
+    list_count = 16
+
+    mem[gather_src_offset:gather_src_offset+region_len] = bytearray([(x*3 + (x >> 8)*5) % 256 for x in range(region_len)])
+    mem[gather_dest_offset:gather_dest_offset+region_len] = bytearray(region_len)
+
+    slots = [(k*11) % (region_len // block_size) for k in range(list_count)]
+    for k, slot in enumerate(slots):
+        mem[list_offset+k*8:list_offset+k*8+8] = (slot*block_size).to_bytes(8, 'little')
+
+    # gather listed blocks into RAM
+    await dev_pf0_bar0.write_dword(0x001080, (mem_base+gather_src_offset) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x001084, (mem_base+gather_src_offset >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x0010a0, (mem_base+list_offset) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x0010a4, (mem_base+list_offset >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x0010a8, 4)
+    await dev_pf0_bar0.write_dword(0x001004, 2)
+    await dev_pf0_bar0.write_dword(0x0010c0, 0)
+    await dev_pf0_bar0.write_dword(0x0010c8, 0)
+    await dev_pf0_bar0.write_dword(0x001018, list_count)
+    await dev_pf0_bar0.write_dword(0x001000, 1)
+
+    for k in range(10):
+        await Timer(1000, 'ns')
+        run = await dev_pf0_bar0.read_dword(0x001000)
+        if run == 0:
+            break
+
+    assert run == 0
+    assert await dev_pf0_bar0.read_dword(0x001004) == 2
+
+    # scatter them back out to the same offsets
+    await dev_pf0_bar0.write_dword(0x001180, (mem_base+gather_dest_offset) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x001184, (mem_base+gather_dest_offset >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x0011a0, (mem_base+list_offset) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x0011a4, (mem_base+list_offset >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x0011a8, 4)
+    await dev_pf0_bar0.write_dword(0x001104, 2)
+    await dev_pf0_bar0.write_dword(0x0011c0, 0)
+    await dev_pf0_bar0.write_dword(0x0011c8, 0)
+    await dev_pf0_bar0.write_dword(0x001118, list_count)
+    await dev_pf0_bar0.write_dword(0x001100, 1)
+
+    for k in range(10):
+        await Timer(1000, 'ns')
+        run = await dev_pf0_bar0.read_dword(0x001100)
+        if run == 0:
+            break
+
+    assert run == 0
+    assert await dev_pf0_bar0.read_dword(0x001104) == 2
+
+    status = await dev_pf0_bar0.read_dword(0x000000)
+    tb.log.info("DMA Status: 0x%x", status)
+    assert status & 0x300 == 0
+
+    for k in range(region_len // block_size):
+        dest = mem[gather_dest_offset+k*block_size:gather_dest_offset+(k+1)*block_size]
+        if k in slots:
+            assert dest == mem[gather_src_offset+k*block_size:gather_src_offset+(k+1)*block_size]
+        else:
+            assert dest == bytearray(block_size)
+
+    tb.log.info("Test DMA block random addresses")
+
+    await dev_pf0_bar0.write_dword(0x001004, 1)
+    await dev_pf0_bar0.write_dword(0x001020, 0x12345678)
+    await dev_pf0_bar0.write_dword(0x001018, block_count)
+
+    rd_req = await dev_pf0_bar0.read_dword(0x000020)
+
+    await dev_pf0_bar0.write_dword(0x001000, 1)
+
+    for k in range(10):
+        await Timer(1000, 'ns')
+        run = await dev_pf0_bar0.read_dword(0x001000)
+        if run == 0:
+            break
+
+    assert run == 0
+
+    rd_req = (await dev_pf0_bar0.read_dword(0x000020) - rd_req) & 0xffffffff
+    lfsr = await dev_pf0_bar0.read_dword(0x001020)
+    tb.log.info("Read %d req, LFSR 0x%08x", rd_req, lfsr)
+
+    assert rd_req >= block_count
+    assert lfsr not in (0, 0x12345678)
+
+    # back to linear addressing
+    await dev_pf0_bar0.write_dword(0x001004, 0)
+    await dev_pf0_bar0.write_dword(0x001104, 0)
+
+    tb.log.info("Test completion queue")
+
+    cq_offset = 0x10000
+    mem[cq_offset:cq_offset+64] = bytearray(64)
+
+    val = await dev_pf0_bar0.read_dword(0x002200)
+    assert val & 0x80000000
+
+    await dev_pf0_bar0.write_dword(0x002208, (mem_base+cq_offset) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x00220c, (mem_base+cq_offset >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x002210, 2)
+    await dev_pf0_bar0.write_dword(0x002218, 0)
+    await dev_pf0_bar0.write_dword(0x00221c, 0)
+    await dev_pf0_bar0.write_dword(0x002200, 1)
+
+    # single read and immediate write
+    await dev_pf0_bar0.write_dword(0x000100, (mem_base+0x0000) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x000104, (mem_base+0x0000 >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x000108, 0x100)
+    await dev_pf0_bar0.write_dword(0x000110, 0x400)
+    await dev_pf0_bar0.write_dword(0x000114, 0x33)
+
+    await dev_pf0_bar0.write_dword(0x000200, (mem_base+0x1000) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x000204, (mem_base+0x1000 >> 32) & 0xffffffff)
+    await dev_pf0_bar0.write_dword(0x000208, 0x44332211)
+    await dev_pf0_bar0.write_dword(0x000210, 0x4)
+    await dev_pf0_bar0.write_dword(0x000214, 0x800000BB)
+
+    await Timer(2000, 'ns')
+
+    tb.log.info("%s", mem.hexdump_str(cq_offset, 16))
+
+    assert await dev_pf0_bar0.read_dword(0x002218) == 2
+
+    records = [int.from_bytes(mem[cq_offset+k*4:cq_offset+k*4+4], 'little') for k in range(4)]
+    tb.log.info("Records: %s", [hex(r) for r in records])
+
+    # tag, direction and phase (timestamp in upper half)
+    assert sorted(r & 0xffff for r in records[0:2]) == [0x8033, 0x90bb]
+    assert records[2] == 0
+
+    # full queue holds records back until consumed
+    for k in range(4):
+        await dev_pf0_bar0.write_dword(0x000214, 0x80000000 | k)
+
+    await Timer(2000, 'ns')
+
+    assert await dev_pf0_bar0.read_dword(0x002218) == 4
+    val = await dev_pf0_bar0.read_dword(0x002200)
+    assert val & 0x100
+
+    await dev_pf0_bar0.write_dword(0x00221c, 4)
+
+    await Timer(2000, 'ns')
+
+    assert await dev_pf0_bar0.read_dword(0x002218) == 6
+
+    # second pass through the queue clears the phase bit
+    val = int.from_bytes(mem[cq_offset:cq_offset+4], 'little')
+    tb.log.info("Record: 0x%08x", val)
+    assert val & 0xffff == 0x1002
+
+    val = await dev_pf0_bar0.read_dword(0x002200)
+    assert val & 0x10000 == 0
+
+    await dev_pf0_bar0.write_dword(0x002200, 0)
+
+    tb.log.info("Test interrupt moderation")
+
+    async def single_read(tag):
+        await dev_pf0_bar0.write_dword(0x000100, (mem_base+0x0000) & 0xffffffff)
+        await dev_pf0_bar0.write_dword(0x000104, (mem_base+0x0000 >> 32) & 0xffffffff)
+        await dev_pf0_bar0.write_dword(0x000108, 0x100)
+        await dev_pf0_bar0.write_dword(0x000110, 0x40)
+        await dev_pf0_bar0.write_dword(0x000114, tag)
+        await Timer(1000, 'ns')
+
+    # one interrupt per 4 events, long timeout
+    await dev_pf0_bar0.write_dword(0x000060, 0)
+    await dev_pf0_bar0.write_dword(0x000068, (0xffff << 16) | 4)
+
+    events = await dev_pf0_bar0.read_dword(0x000070)
+    irqs = await dev_pf0_bar0.read_dword(0x000074)
+
+    for k in range(3):
+        await single_read(0x10+k)
+
+    assert await dev_pf0_bar0.read_dword(0x000070) == events+3
+    assert await dev_pf0_bar0.read_dword(0x000074) == irqs
+
+    await single_read(0x13)
+
+    assert await dev_pf0_bar0.read_dword(0x000070) == events+4
+    assert await dev_pf0_bar0.read_dword(0x000074) == irqs+1
+
+    # timeout raises the interrupt for a partial batch
+    await dev_pf0_bar0.write_dword(0x000068, (16 << 16) | 4)
+
+    await single_read(0x14)
+
+    assert await dev_pf0_bar0.read_dword(0x000074) == irqs+2
+
+    # rate limiter merges interrupts without stalling the core
+    await dev_pf0_bar0.write_dword(0x000068, 0)
+    await dev_pf0_bar0.write_dword(0x000060, 99)
+    await dev_pf0_bar0.write_dword(0x000064, 100)
+
+    for k in range(4):
+        await single_read(0x20+k)
+
+    assert await dev_pf0_bar0.read_dword(0x000074) == irqs+6
+
+    await dev_pf0_bar0.write_dword(0x000060, 0)
+    await dev_pf0_bar0.write_dword(0x000064, 0)
+
     await RisingEdge(dut.clk)
     await RisingEdge(dut.clk)
 
@@ -399,8 +758,8 @@ rtl_dir = os.path.abspath(os.path.join(tests_dir, '..', '..', 'rtl'))
 pcie_rtl_dir = os.path.abspath(os.path.join(tests_dir, '..', '..', '..', '..', 'rtl'))
 
 
-@pytest.mark.parametrize("pcie_data_width", [64, 128, 256, 512])
-def test_example_core_pcie(request, pcie_data_width):
+@pytest.mark.parametrize(("pcie_data_width", "pcie_tag_count"), [(64, 256), (128, 256), (256, 256), (512, 256), (512, 1024)])
+def test_example_core_pcie(request, pcie_data_width, pcie_tag_count):
     dut = "example_core_pcie"
     module = os.path.splitext(os.path.basename(__file__))[0]
     toplevel = dut
@@ -417,10 +776,19 @@ def test_example_core_pcie(request, pcie_data_width):
         os.path.join(pcie_rtl_dir, "pcie_tlp_demux.v"),
         os.path.join(pcie_rtl_dir, "pcie_tlp_mux.v"),
         os.path.join(pcie_rtl_dir, "pcie_msix.v"),
+        os.path.join(pcie_rtl_dir, "irq_rate_limit.v"),
         os.path.join(pcie_rtl_dir, "dma_if_pcie.v"),
         os.path.join(pcie_rtl_dir, "dma_if_pcie_rd.v"),
         os.path.join(pcie_rtl_dir, "dma_if_pcie_wr.v"),
+        os.path.join(pcie_rtl_dir, "dma_if_mux.v"),
+        os.path.join(pcie_rtl_dir, "dma_if_mux_rd.v"),
+        os.path.join(pcie_rtl_dir, "dma_if_mux_wr.v"),
+        os.path.join(pcie_rtl_dir, "dma_if_desc_mux.v"),
         os.path.join(pcie_rtl_dir, "dma_psdpram.v"),
+        os.path.join(pcie_rtl_dir, "dma_ram_demux_rd.v"),
+        os.path.join(pcie_rtl_dir, "dma_ram_demux_wr.v"),
+        os.path.join(pcie_rtl_dir, "axis_arb_mux.v"),
+        os.path.join(pcie_rtl_dir, "arbiter.v"),
         os.path.join(pcie_rtl_dir, "priority_encoder.v"),
         os.path.join(pcie_rtl_dir, "pulse_merge.v"),
     ]
@@ -434,7 +802,7 @@ def test_example_core_pcie(request, pcie_data_width):
     parameters['TX_SEQ_NUM_COUNT'] = 1
     parameters['TX_SEQ_NUM_WIDTH'] = 6
     parameters['TX_SEQ_NUM_ENABLE'] = 1
-    parameters['PCIE_TAG_COUNT'] = 256
+    parameters['PCIE_TAG_COUNT'] = pcie_tag_count
     parameters['IMM_ENABLE'] = 1
     parameters['IMM_WIDTH'] = 32
     parameters['READ_OP_TABLE_SIZE'] = parameters['PCIE_TAG_COUNT']
@@ -448,6 +816,7 @@ def test_example_core_pcie(request, pcie_data_width):
     parameters['BAR0_APERTURE'] = 24
     parameters['BAR2_APERTURE'] = 24
     parameters['BAR4_APERTURE'] = 16
+    parameters['DMA_CHANNELS'] = 1
 
     extra_env = {f'PARAM_{k}': str(v) for k, v in parameters.items()}
 
@@ -24,6 +24,7 @@ THE SOFTWARE.
 
 import logging
 import os
+import struct
 
 import cocotb_test.simulator
 import pytest
@@ -504,6 +505,67 @@ async def dma_cpl_buf_test(tb, dev, addr, mask, size, stride, count, stall):
     assert status & 0x300 == 0
 
 
+async def dma_ring_submit(tb, dev, mem, ring_reg, ring_offset, ring_size, ptr, descs):
+    dev_pf0_bar0 = dev.bar_window[0]
+
+    # write descriptors into ring
+    for dma_addr, ram_addr, length, tag, flags in descs:
+        index = ptr & (ring_size-1)
+        mem[ring_offset+index*16:ring_offset+(index+1)*16] = struct.pack('<QIHBB', dma_addr, ram_addr, length, tag, flags)
+        ptr = (ptr + 1) & 0xffff
+
+    # ring doorbell
+    await dev_pf0_bar0.write_dword(ring_reg+0x18, ptr)
+
+    for k in range(1000):
+        await Timer(1000, 'ns')
+        cpl_ptr = await dev_pf0_bar0.read_dword(ring_reg+0x20)
+        if cpl_ptr == ptr:
+            break
+
+    ctrl = await dev_pf0_bar0.read_dword(ring_reg+0x00)
+
+    tb.log.info("ring 0x%x: ctrl 0x%08x prod %d cpl %d", ring_reg, ctrl, ptr, cpl_ptr)
+
+    if cpl_ptr != ptr:
+        tb.log.warning("Operation timed out")
+
+    assert cpl_ptr == ptr
+    assert ctrl & 0x10000 == 0
+
+    return ptr
+
+
+async def dma_ring_push(tb, dev, ring_reg, push_reg, ptr, descs):
+    dev_pf0_bar0 = dev.bar_window[0]
+
+    # write descriptors through push window, up to 4 per 64 byte write
+    for k in range(0, len(descs), 4):
+        data = bytearray()
+        for dma_addr, ram_addr, length, tag, flags in descs[k:k+4]:
+            data.extend(struct.pack('<QIHBB', dma_addr, ram_addr, length, tag, flags))
+            ptr = (ptr + 1) & 0xffff
+        await dev_pf0_bar0.write(push_reg, data)
+
+    for k in range(1000):
+        await Timer(1000, 'ns')
+        cpl_ptr = await dev_pf0_bar0.read_dword(ring_reg+0x20)
+        if cpl_ptr == ptr:
+            break
+
+    ctrl = await dev_pf0_bar0.read_dword(ring_reg+0x00)
+
+    tb.log.info("ring 0x%x (push): ctrl 0x%08x prod %d cpl %d", ring_reg, ctrl, ptr, cpl_ptr)
+
+    if cpl_ptr != ptr:
+        tb.log.warning("Operation timed out")
+
+    assert cpl_ptr == ptr
+    assert ctrl & 0x10000 == 0
+
+    return ptr
+
+
 @cocotb.test()
 async def run_test(dut):
 
@@ -619,6 +681,105 @@ async def run_test(dut):
 
     assert mem[src_offset:src_offset+region_len] == mem[dest_offset:dest_offset+region_len]
 
+    tb.log.info("Test descriptor rings")
+
+    ring_size = 16
+    rd_ring_offset = 0x8000
+    wr_ring_offset = 0x9000
+    dest_offset = 0x6000
+
+    # configure rings
+    for ring_reg, ring_offset in [(0x002000, rd_ring_offset), (0x002100, wr_ring_offset)]:
+        await dev_pf0_bar0.write_dword(ring_reg+0x00, 0)
+        await dev_pf0_bar0.write_dword(ring_reg+0x08, (mem_base+ring_offset) & 0xffffffff)
+        await dev_pf0_bar0.write_dword(ring_reg+0x0c, (mem_base+ring_offset >> 32) & 0xffffffff)
+        await dev_pf0_bar0.write_dword(ring_reg+0x10, ring_size.bit_length()-1)
+        await dev_pf0_bar0.write_dword(ring_reg+0x18, 0)
+        await dev_pf0_bar0.write_dword(ring_reg+0x1c, 0)
+        await dev_pf0_bar0.write_dword(ring_reg+0x20, 0)
+        await dev_pf0_bar0.write_dword(ring_reg+0x00, 1)
+
+    rd_ptr = 0
+    wr_ptr = 0
+    block_size = 256
+
+    # submit in batches, wrapping around the rings
+    for offset in range(0, region_len, block_size*8):
+        descs = [(mem_base+src_offset+offset+k, offset+k, block_size, k // block_size, 0)
+            for k in range(0, block_size*8, block_size)]
+        rd_ptr = await dma_ring_submit(tb, dev, mem, 0x002000, rd_ring_offset, ring_size, rd_ptr, descs)
+
+        descs = [(mem_base+dest_offset+offset+k, offset+k, block_size, k // block_size, 0)
+            for k in range(0, block_size*8, block_size)]
+        wr_ptr = await dma_ring_submit(tb, dev, mem, 0x002100, wr_ring_offset, ring_size, wr_ptr, descs)
+
+    tb.log.info("%s", mem.hexdump_str(dest_offset, 64))
+
+    assert mem[src_offset:src_offset+region_len] == mem[dest_offset:dest_offset+region_len]
+
+    tb.log.info("Test descriptor push")
+
+    dest_offset = 0xa000
+
+    # submit in batches through the push window, bypassing descriptor fetch
+    for offset in range(0, region_len, block_size*8):
+        descs = [(mem_base+src_offset+offset+k, offset+k, block_size, k // block_size, 0)
+            for k in range(0, block_size*8, block_size)]
+        rd_ptr = await dma_ring_push(tb, dev, 0x002000, 0x003000, rd_ptr, descs)
+
+        descs = [(mem_base+dest_offset+offset+k, offset+k, block_size, k // block_size, 0)
+            for k in range(0, block_size*8, block_size)]
+        wr_ptr = await dma_ring_push(tb, dev, 0x002100, 0x003040, wr_ptr, descs)
+
+    tb.log.info("%s", mem.hexdump_str(dest_offset, 64))
+
+    assert mem[src_offset:src_offset+region_len] == mem[dest_offset:dest_offset+region_len]
+
+    tb.log.info("Test DMA channels")
+
+    channels = await dev_pf0_bar0.read_dword(0x000034)
+    tb.log.info("DMA channels: %d", channels)
+
+    for ch in range(channels):
+        val = await dev_pf0_bar0.read_dword(ch*0x10000+0x000030)
+        assert val == ch
+
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000000, 1)
+
+    # start a read on every channel (same card RAM address, separate RAMs)
+    for ch in range(channels):
+        mem[0xc000+ch*0x400:0xc000+(ch+1)*0x400] = bytearray([(x+ch*7) % 256 for x in range(1024)])
+
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000100, (mem_base+0xc000+ch*0x400) & 0xffffffff)
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000104, (mem_base+0xc000+ch*0x400 >> 32) & 0xffffffff)
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000108, 0x100)
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000110, 0x400)
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000114, 0x10+ch)
+
+    await Timer(2000, 'ns')
+
+    for ch in range(channels):
+        val = await dev_pf0_bar0.read_dword(ch*0x10000+0x000118)
+        tb.log.info("Channel %d read status: 0x%x", ch, val)
+        assert val == 0x80000010+ch
+
+    # write back from every channel
+    for ch in range(channels):
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000200, (mem_base+0xe000+ch*0x400) & 0xffffffff)
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000204, (mem_base+0xe000+ch*0x400 >> 32) & 0xffffffff)
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000208, 0x100)
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000210, 0x400)
+        await dev_pf0_bar0.write_dword(ch*0x10000+0x000214, 0x20+ch)
+
+    await Timer(2000, 'ns')
+
+    for ch in range(channels):
+        val = await dev_pf0_bar0.read_dword(ch*0x10000+0x000218)
+        tb.log.info("Channel %d write status: 0x%x", ch, val)
+        assert val == 0x80000020+ch
+
+        assert mem[0xc000+ch*0x400:0xc000+(ch+1)*0x400] == mem[0xe000+ch*0x400:0xe000+(ch+1)*0x400]
+
     tb.log.info("Test RX completion buffer (CPLH, 8)")
 
     tb.rc.split_on_all_rcb = True
@@ -704,10 +865,19 @@ def test_example_core_pcie_us(request, axis_pcie_data_width, straddle):
         os.path.join(pcie_rtl_dir, "pcie_tlp_fifo.v"),
         os.path.join(pcie_rtl_dir, "pcie_tlp_fifo_raw.v"),
         os.path.join(pcie_rtl_dir, "pcie_msix.v"),
+        os.path.join(pcie_rtl_dir, "irq_rate_limit.v"),
         os.path.join(pcie_rtl_dir, "dma_if_pcie.v"),
         os.path.join(pcie_rtl_dir, "dma_if_pcie_rd.v"),
         os.path.join(pcie_rtl_dir, "dma_if_pcie_wr.v"),
+        os.path.join(pcie_rtl_dir, "dma_if_mux.v"),
+        os.path.join(pcie_rtl_dir, "dma_if_mux_rd.v"),
+        os.path.join(pcie_rtl_dir, "dma_if_mux_wr.v"),
+        os.path.join(pcie_rtl_dir, "dma_if_desc_mux.v"),
         os.path.join(pcie_rtl_dir, "dma_psdpram.v"),
+        os.path.join(pcie_rtl_dir, "dma_ram_demux_rd.v"),
+        os.path.join(pcie_rtl_dir, "dma_ram_demux_wr.v"),
+        os.path.join(pcie_rtl_dir, "axis_arb_mux.v"),
+        os.path.join(pcie_rtl_dir, "arbiter.v"),
         os.path.join(pcie_rtl_dir, "priority_encoder.v"),
         os.path.join(pcie_rtl_dir, "pulse_merge.v"),
     ]
@@ -738,6 +908,7 @@ def test_example_core_pcie_us(request, axis_pcie_data_width, straddle):
     parameters['BAR0_APERTURE'] = 24
     parameters['BAR2_APERTURE'] = 24
     parameters['BAR4_APERTURE'] = 16
+    parameters['DMA_CHANNELS'] = 2
 
     extra_env = {f'PARAM_{k}': str(v) for k, v in parameters.items()}
 
@@ -83,6 +83,14 @@ module dma_if_pcie #
     parameter WRITE_OP_TABLE_SIZE = 2**TX_SEQ_NUM_WIDTH,
     // In-flight transmit limit (write)
     parameter WRITE_TX_LIMIT = 2**TX_SEQ_NUM_WIDTH,
+    // Descriptor coalescing (write)
+    parameter WRITE_COALESCE_ENABLE = 0,
+    // Coalescing timeout in cycles (write)
+    parameter WRITE_COALESCE_TIMEOUT = 16,
+    // Request merging (read)
+    parameter READ_MERGE_ENABLE = 0,
+    // Merging timeout in cycles (read)
+    parameter READ_MERGE_TIMEOUT = 16,
     // Force 64 bit address
     parameter TLP_FORCE_64_BIT_ADDR = 0,
     // Requester ID mash
@@ -195,10 +203,13 @@ module dma_if_pcie #
     input  wire                                          read_enable,
     input  wire                                          write_enable,
     input  wire                                          ext_tag_enable,
+    input  wire                                          ten_bit_tag_enable,
     input  wire                                          rcb_128b,
     input  wire [15:0]                                   requester_id,
     input  wire [2:0]                                    max_read_request_size,
     input  wire [2:0]                                    max_payload_size,
+    input  wire [11:0]                                   read_cplh_fc_limit,
+    input  wire [15:0]                                   read_cpld_fc_limit,
 
     /*
      * Status
@@ -222,12 +233,18 @@ module dma_if_pcie #
     output wire                                          stat_rd_req_start_valid,
     output wire [$clog2(PCIE_TAG_COUNT)-1:0]             stat_rd_req_finish_tag,
     output wire [3:0]                                    stat_rd_req_finish_status,
+    output wire [15:0]                                   stat_rd_req_finish_latency,
     output wire                                          stat_rd_req_finish_valid,
     output wire                                          stat_rd_req_timeout,
     output wire                                          stat_rd_op_table_full,
     output wire                                          stat_rd_no_tags,
     output wire                                          stat_rd_tx_limit,
     output wire                                          stat_rd_tx_stall,
+    output wire [$clog2(PCIE_TAG_COUNT):0]               stat_rd_active_tags,
+    output wire [$clog2(READ_OP_TABLE_SIZE):0]           stat_rd_active_ops,
+    output wire                                          stat_rd_cplh_stall,
+    output wire                                          stat_rd_cpld_stall,
+    output wire                                          stat_rd_tx_limit_stall,
     output wire [$clog2(WRITE_OP_TABLE_SIZE)-1:0]        stat_wr_op_start_tag,
     output wire [LEN_WIDTH-1:0]                          stat_wr_op_start_len,
     output wire                                          stat_wr_op_start_valid,
@@ -267,7 +284,9 @@ dma_if_pcie_rd #(
     .CPLH_FC_LIMIT(READ_CPLH_FC_LIMIT),
     .CPLD_FC_LIMIT(READ_CPLD_FC_LIMIT),
     .TLP_FORCE_64_BIT_ADDR(TLP_FORCE_64_BIT_ADDR),
-    .CHECK_BUS_NUMBER(CHECK_BUS_NUMBER)
+    .CHECK_BUS_NUMBER(CHECK_BUS_NUMBER),
+    .MERGE_ENABLE(READ_MERGE_ENABLE),
+    .MERGE_TIMEOUT(READ_MERGE_TIMEOUT)
 )
 dma_if_pcie_rd_inst (
     .clk(clk),
@@ -334,9 +353,12 @@ dma_if_pcie_rd_inst (
      */
     .enable(read_enable),
     .ext_tag_enable(ext_tag_enable),
+    .ten_bit_tag_enable(ten_bit_tag_enable),
     .rcb_128b(rcb_128b),
     .requester_id(requester_id),
     .max_read_request_size(max_read_request_size),
+    .cplh_fc_limit(read_cplh_fc_limit),
+    .cpld_fc_limit(read_cpld_fc_limit),
 
     /*
      * Status
@@ -359,12 +381,18 @@ dma_if_pcie_rd_inst (
     .stat_rd_req_start_valid(stat_rd_req_start_valid),
     .stat_rd_req_finish_tag(stat_rd_req_finish_tag),
     .stat_rd_req_finish_status(stat_rd_req_finish_status),
+    .stat_rd_req_finish_latency(stat_rd_req_finish_latency),
     .stat_rd_req_finish_valid(stat_rd_req_finish_valid),
     .stat_rd_req_timeout(stat_rd_req_timeout),
     .stat_rd_op_table_full(stat_rd_op_table_full),
     .stat_rd_no_tags(stat_rd_no_tags),
     .stat_rd_tx_limit(stat_rd_tx_limit),
-    .stat_rd_tx_stall(stat_rd_tx_stall)
+    .stat_rd_tx_stall(stat_rd_tx_stall),
+    .stat_rd_active_tags(stat_rd_active_tags),
+    .stat_rd_active_ops(stat_rd_active_ops),
+    .stat_rd_cplh_stall(stat_rd_cplh_stall),
+    .stat_rd_cpld_stall(stat_rd_cpld_stall),
+    .stat_rd_tx_limit_stall(stat_rd_tx_limit_stall)
 );
 
 dma_if_pcie_wr #(
@@ -388,7 +416,9 @@ dma_if_pcie_wr #(
     .TAG_WIDTH(TAG_WIDTH),
     .OP_TABLE_SIZE(WRITE_OP_TABLE_SIZE),
     .TX_LIMIT(WRITE_TX_LIMIT),
-    .TLP_FORCE_64_BIT_ADDR(TLP_FORCE_64_BIT_ADDR)
+    .TLP_FORCE_64_BIT_ADDR(TLP_FORCE_64_BIT_ADDR),
+    .COALESCE_ENABLE(WRITE_COALESCE_ENABLE),
+    .COALESCE_TIMEOUT(WRITE_COALESCE_TIMEOUT)
 )
 dma_if_pcie_wr_inst (
     .clk(clk),
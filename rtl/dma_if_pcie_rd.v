@@ -76,7 +76,13 @@ module dma_if_pcie_rd #
     // Force 64 bit address
     parameter TLP_FORCE_64_BIT_ADDR = 0,
     // Requester ID mash
-    parameter CHECK_BUS_NUMBER = 1
+    parameter CHECK_BUS_NUMBER = 1,
+    // Merge adjacent read descriptors into max read request size requests
+    parameter MERGE_ENABLE = 0,
+    // Cycles to hold an open merge group before sending it
+    parameter MERGE_TIMEOUT = 16,
+    // Maximum number of descriptors merged into one operation
+    parameter MERGE_MAX_COUNT = 4
 )
 (
     input  wire                                          clk,
@@ -143,9 +149,12 @@ module dma_if_pcie_rd #
      */
     input  wire                                          enable,
     input  wire                                          ext_tag_enable,
+    input  wire                                          ten_bit_tag_enable,
     input  wire                                          rcb_128b,
     input  wire [15:0]                                   requester_id,
     input  wire [2:0]                                    max_read_request_size,
+    input  wire [11:0]                                   cplh_fc_limit,
+    input  wire [15:0]                                   cpld_fc_limit,
 
     /*
      * Status
@@ -168,12 +177,18 @@ module dma_if_pcie_rd #
     output wire                                          stat_rd_req_start_valid,
     output wire [$clog2(PCIE_TAG_COUNT)-1:0]             stat_rd_req_finish_tag,
     output wire [3:0]                                    stat_rd_req_finish_status,
+    output wire [15:0]                                   stat_rd_req_finish_latency,
     output wire                                          stat_rd_req_finish_valid,
     output wire                                          stat_rd_req_timeout,
     output wire                                          stat_rd_op_table_full,
     output wire                                          stat_rd_no_tags,
     output wire                                          stat_rd_tx_limit,
-    output wire                                          stat_rd_tx_stall
+    output wire                                          stat_rd_tx_stall,
+    output wire [$clog2(PCIE_TAG_COUNT):0]               stat_rd_active_tags,
+    output wire [$clog2(OP_TABLE_SIZE):0]                stat_rd_active_ops,
+    output wire                                          stat_rd_cplh_stall,
+    output wire                                          stat_rd_cpld_stall,
+    output wire                                          stat_rd_tx_limit_stall
 );
 
 parameter RAM_DATA_WIDTH = RAM_SEG_COUNT*RAM_SEG_DATA_WIDTH;
@@ -189,22 +204,33 @@ parameter RAM_OFFSET_WIDTH = $clog2(RAM_DATA_WIDTH/8);
 parameter PCIE_TAG_WIDTH = $clog2(PCIE_TAG_COUNT);
 parameter PCIE_TAG_COUNT_1 = 2**PCIE_TAG_WIDTH > 32 ? 32 : 2**PCIE_TAG_WIDTH;
 parameter PCIE_TAG_WIDTH_1 = $clog2(PCIE_TAG_COUNT_1);
-parameter PCIE_TAG_COUNT_2 = 2**PCIE_TAG_WIDTH > 32 ? 2**PCIE_TAG_WIDTH-32 : 0;
+parameter PCIE_TAG_COUNT_2 = 2**PCIE_TAG_WIDTH > 32 ? (2**PCIE_TAG_WIDTH > 256 ? 256 : 2**PCIE_TAG_WIDTH)-32 : 0;
 parameter PCIE_TAG_WIDTH_2 = $clog2(PCIE_TAG_COUNT_2);
+parameter PCIE_TAG_COUNT_3 = 2**PCIE_TAG_WIDTH > 256 ? 2**PCIE_TAG_WIDTH-256 : 0;
+parameter PCIE_TAG_WIDTH_3 = $clog2(PCIE_TAG_COUNT_3);
 
 parameter OP_TAG_WIDTH = $clog2(OP_TABLE_SIZE);
+
+parameter MERGE_IN_FIFO_ADDR_WIDTH = 2;
+parameter MERGE_STATUS_FIFO_ADDR_WIDTH = 3;
+parameter MERGE_COUNT_WIDTH = $clog2(MERGE_MAX_COUNT+1);
 parameter OP_TABLE_READ_COUNT_WIDTH = PCIE_TAG_WIDTH+1;
 
 parameter TX_COUNT_WIDTH = $clog2(TX_LIMIT+1);
 
-parameter CL_CPLH_FC_LIMIT = $clog2(CPLH_FC_LIMIT);
-parameter CL_CPLD_FC_LIMIT = $clog2(CPLD_FC_LIMIT);
+// counters wide enough for runtime limits when there is no compile-time limit
+parameter CL_CPLH_FC_LIMIT = CPLH_FC_LIMIT ? $clog2(CPLH_FC_LIMIT) : 12;
+parameter CL_CPLD_FC_LIMIT = CPLD_FC_LIMIT ? $clog2(CPLD_FC_LIMIT) : 16;
 
 parameter STATUS_FIFO_ADDR_WIDTH = 5;
 parameter OUTPUT_FIFO_ADDR_WIDTH = 5;
 
 parameter INIT_COUNT_WIDTH = PCIE_TAG_WIDTH > OP_TAG_WIDTH ? PCIE_TAG_WIDTH : OP_TAG_WIDTH;
 
+// request latency timestamp, wider than the latency output so that long
+// latencies saturate at 16'hffff instead of wrapping
+parameter STAT_TIME_WIDTH = 24;
+
 // bus width assertions
 initial begin
     if (TLP_SEG_COUNT != 1) begin
@@ -247,8 +273,13 @@ initial begin
         $finish;
     end
 
-    if (PCIE_TAG_COUNT < 1 || PCIE_TAG_COUNT > 256) begin
-        $error("Error: PCIe tag count must be between 1 and 256 (instance %m)");
+    if (PCIE_TAG_COUNT < 1 || PCIE_TAG_COUNT > 1024) begin
+        $error("Error: PCIe tag count must be between 1 and 1024 (instance %m)");
+        $finish;
+    end
+
+    if (MERGE_ENABLE && (MERGE_MAX_COUNT < 1 || TAG_WIDTH < MERGE_COUNT_WIDTH)) begin
+        $error("Error: Tag width too narrow for merge count (instance %m)");
         $finish;
     end
 end
@@ -422,6 +453,9 @@ reg [OP_TAG_WIDTH+1-1:0] active_op_count_reg = 0;
 reg inc_active_op;
 reg dec_active_op;
 
+reg [CL_CPLH_FC_LIMIT+1-1:0] cplh_fc_limit_reg = CPLH_FC_LIMIT;
+reg [CL_CPLD_FC_LIMIT+1-1:0] cpld_fc_limit_reg = CPLD_FC_LIMIT;
+
 reg [CL_CPLH_FC_LIMIT+1-1:0] active_cplh_fc_count_reg = 0, active_cplh_fc_count_next;
 reg active_cplh_fc_av_reg = 1'b1, active_cplh_fc_av_next;
 reg [6:0] inc_active_cplh_fc_count;
@@ -444,6 +478,69 @@ reg [3:0] m_axis_read_desc_status_error_reg = 4'd0, m_axis_read_desc_status_erro
 reg m_axis_read_desc_status_valid_reg = 1'b0, m_axis_read_desc_status_valid_next;
 
 reg status_busy_reg = 1'b0;
+
+// read request merging
+reg [MERGE_IN_FIFO_ADDR_WIDTH+1-1:0] merge_in_fifo_wr_ptr_reg = 0, merge_in_fifo_wr_ptr_next;
+reg [MERGE_IN_FIFO_ADDR_WIDTH+1-1:0] merge_in_fifo_rd_ptr_reg = 0, merge_in_fifo_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [PCIE_ADDR_WIDTH-1:0] merge_in_fifo_pcie_addr[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [RAM_SEL_WIDTH-1:0] merge_in_fifo_ram_sel[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [RAM_ADDR_WIDTH-1:0] merge_in_fifo_ram_addr[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [LEN_WIDTH-1:0] merge_in_fifo_len[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [TAG_WIDTH-1:0] merge_in_fifo_tag[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+reg merge_in_fifo_ready_reg = 1'b0, merge_in_fifo_ready_next;
+
+wire merge_in_fifo_empty = merge_in_fifo_wr_ptr_reg == merge_in_fifo_rd_ptr_reg;
+
+wire [PCIE_ADDR_WIDTH-1:0] merge_in_pcie_addr = merge_in_fifo_pcie_addr[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [RAM_SEL_WIDTH-1:0] merge_in_ram_sel = merge_in_fifo_ram_sel[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [RAM_ADDR_WIDTH-1:0] merge_in_ram_addr = merge_in_fifo_ram_addr[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [LEN_WIDTH-1:0] merge_in_len = merge_in_fifo_len[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [TAG_WIDTH-1:0] merge_in_tag = merge_in_fifo_tag[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+
+reg [PCIE_ADDR_WIDTH-1:0] merge_pcie_addr_reg = {PCIE_ADDR_WIDTH{1'b0}}, merge_pcie_addr_next;
+reg [RAM_SEL_WIDTH-1:0] merge_ram_sel_reg = {RAM_SEL_WIDTH{1'b0}}, merge_ram_sel_next;
+reg [RAM_ADDR_WIDTH-1:0] merge_ram_addr_reg = {RAM_ADDR_WIDTH{1'b0}}, merge_ram_addr_next;
+reg [LEN_WIDTH-1:0] merge_len_reg = {LEN_WIDTH{1'b0}}, merge_len_next;
+reg [MERGE_MAX_COUNT*TAG_WIDTH-1:0] merge_tags_reg = {MERGE_MAX_COUNT*TAG_WIDTH{1'b0}}, merge_tags_next;
+reg [MERGE_COUNT_WIDTH-1:0] merge_count_reg = 0, merge_count_next;
+reg [15:0] merge_timer_reg = 16'd0, merge_timer_next;
+reg merge_flush_reg = 1'b0, merge_flush_next;
+reg merge_valid_reg = 1'b0, merge_valid_next;
+
+// original descriptor tags of each operation, for status expansion
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [MERGE_MAX_COUNT*TAG_WIDTH-1:0] merge_op_tags[2**OP_TAG_WIDTH-1:0];
+
+reg [MERGE_STATUS_FIFO_ADDR_WIDTH+1-1:0] merge_status_fifo_wr_ptr_reg = 0;
+reg [MERGE_STATUS_FIFO_ADDR_WIDTH+1-1:0] merge_status_fifo_rd_ptr_reg = 0, merge_status_fifo_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [MERGE_MAX_COUNT*TAG_WIDTH-1:0] merge_status_fifo_tags[(2**MERGE_STATUS_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [MERGE_COUNT_WIDTH-1:0] merge_status_fifo_count[(2**MERGE_STATUS_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [3:0] merge_status_fifo_error[(2**MERGE_STATUS_FIFO_ADDR_WIDTH)-1:0];
+reg merge_status_fifo_we;
+
+wire merge_status_fifo_empty = merge_status_fifo_wr_ptr_reg == merge_status_fifo_rd_ptr_reg;
+wire merge_status_fifo_full = merge_status_fifo_wr_ptr_reg == (merge_status_fifo_rd_ptr_reg ^ (1 << MERGE_STATUS_FIFO_ADDR_WIDTH));
+
+reg [MERGE_COUNT_WIDTH-1:0] merge_status_index_reg = 0, merge_status_index_next;
+reg [TAG_WIDTH-1:0] merge_status_tag_reg = {TAG_WIDTH{1'b0}}, merge_status_tag_next;
+reg [3:0] merge_status_error_reg = 4'd0, merge_status_error_next;
+reg merge_status_valid_reg = 1'b0, merge_status_valid_next;
+
+// descriptor input to request generation
+wire [PCIE_ADDR_WIDTH-1:0] desc_pcie_addr = MERGE_ENABLE ? merge_pcie_addr_reg : s_axis_read_desc_pcie_addr;
+wire [RAM_SEL_WIDTH-1:0] desc_ram_sel = MERGE_ENABLE ? merge_ram_sel_reg : s_axis_read_desc_ram_sel;
+wire [RAM_ADDR_WIDTH-1:0] desc_ram_addr = MERGE_ENABLE ? merge_ram_addr_reg : s_axis_read_desc_ram_addr;
+wire [LEN_WIDTH-1:0] desc_len = MERGE_ENABLE ? merge_len_reg : s_axis_read_desc_len;
+wire [TAG_WIDTH-1:0] desc_tag = MERGE_ENABLE ? merge_count_reg : s_axis_read_desc_tag;
+wire desc_valid = MERGE_ENABLE ? merge_valid_reg && merge_flush_reg : s_axis_read_desc_valid;
 reg status_error_cor_reg = 1'b0, status_error_cor_next;
 reg status_error_uncor_reg = 1'b0, status_error_uncor_next;
 
@@ -458,12 +555,20 @@ reg [12:0] stat_rd_req_start_len_reg = 13'd0, stat_rd_req_start_len_next;
 reg stat_rd_req_start_valid_reg = 1'b0, stat_rd_req_start_valid_next;
 reg [PCIE_TAG_WIDTH-1:0] stat_rd_req_finish_tag_reg = 0, stat_rd_req_finish_tag_next;
 reg [3:0] stat_rd_req_finish_status_reg = 4'd0, stat_rd_req_finish_status_next;
+reg [15:0] stat_rd_req_finish_latency_reg = 16'd0, stat_rd_req_finish_latency_next;
 reg stat_rd_req_finish_valid_reg = 1'b0, stat_rd_req_finish_valid_next;
 reg stat_rd_req_timeout_reg = 1'b0, stat_rd_req_timeout_next;
 reg stat_rd_op_table_full_reg = 1'b0, stat_rd_op_table_full_next;
 reg stat_rd_no_tags_reg = 1'b0, stat_rd_no_tags_next;
 reg stat_rd_tx_limit_reg = 1'b0, stat_rd_tx_limit_next;
 reg stat_rd_tx_stall_reg = 1'b0, stat_rd_tx_stall_next;
+reg stat_rd_cplh_stall_reg = 1'b0, stat_rd_cplh_stall_next;
+reg stat_rd_cpld_stall_reg = 1'b0, stat_rd_cpld_stall_next;
+reg stat_rd_tx_limit_stall_reg = 1'b0, stat_rd_tx_limit_stall_next;
+
+// free-running timestamp for request latency measurement
+reg [STAT_TIME_WIDTH-1:0] stat_time_reg = {STAT_TIME_WIDTH{1'b0}};
+reg [STAT_TIME_WIDTH-1:0] stat_lat;
 
 // internal datapath
 reg  [RAM_SEG_COUNT*RAM_SEL_WIDTH-1:0]      ram_wr_cmd_sel_int = 0;
@@ -484,11 +589,11 @@ assign tx_rd_req_tlp_valid = tx_rd_req_tlp_valid_reg;
 assign tx_rd_req_tlp_sop = 1'b1;
 assign tx_rd_req_tlp_eop = 1'b1;
 
-assign s_axis_read_desc_ready = s_axis_read_desc_ready_reg;
+assign s_axis_read_desc_ready = MERGE_ENABLE ? merge_in_fifo_ready_reg : s_axis_read_desc_ready_reg;
 
-assign m_axis_read_desc_status_tag = m_axis_read_desc_status_tag_reg;
-assign m_axis_read_desc_status_error = m_axis_read_desc_status_error_reg;
-assign m_axis_read_desc_status_valid = m_axis_read_desc_status_valid_reg;
+assign m_axis_read_desc_status_tag = MERGE_ENABLE ? merge_status_tag_reg : m_axis_read_desc_status_tag_reg;
+assign m_axis_read_desc_status_error = MERGE_ENABLE ? merge_status_error_reg : m_axis_read_desc_status_error_reg;
+assign m_axis_read_desc_status_valid = MERGE_ENABLE ? merge_status_valid_reg : m_axis_read_desc_status_valid_reg;
 
 assign status_busy = status_busy_reg;
 assign status_error_cor = status_error_cor_reg;
@@ -505,12 +610,18 @@ assign stat_rd_req_start_len = stat_rd_req_start_len_reg;
 assign stat_rd_req_start_valid = stat_rd_req_start_valid_reg;
 assign stat_rd_req_finish_tag = stat_rd_req_finish_tag_reg;
 assign stat_rd_req_finish_status = stat_rd_req_finish_status_reg;
+assign stat_rd_req_finish_latency = stat_rd_req_finish_latency_reg;
 assign stat_rd_req_finish_valid = stat_rd_req_finish_valid_reg;
 assign stat_rd_req_timeout = stat_rd_req_timeout_reg;
 assign stat_rd_op_table_full = stat_rd_op_table_full_reg;
 assign stat_rd_no_tags = stat_rd_no_tags_reg;
 assign stat_rd_tx_limit = stat_rd_tx_limit_reg;
 assign stat_rd_tx_stall = stat_rd_tx_stall_reg;
+assign stat_rd_active_tags = active_tag_count_reg;
+assign stat_rd_active_ops = active_op_count_reg;
+assign stat_rd_cplh_stall = stat_rd_cplh_stall_reg;
+assign stat_rd_cpld_stall = stat_rd_cpld_stall_reg;
+assign stat_rd_tx_limit_stall = stat_rd_tx_limit_stall_reg;
 
 // PCIe tag management
 reg [PCIE_TAG_WIDTH-1:0] pcie_tag_table_start_ptr_reg = 0, pcie_tag_table_start_ptr_next;
@@ -537,6 +648,8 @@ reg [8:0] pcie_tag_table_cpld_fc[(2**PCIE_TAG_WIDTH)-1:0];
 (* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
 reg pcie_tag_table_zero_len[(2**PCIE_TAG_WIDTH)-1:0];
 (* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [STAT_TIME_WIDTH-1:0] pcie_tag_table_start_time[(2**PCIE_TAG_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
 reg pcie_tag_table_active_a[(2**PCIE_TAG_WIDTH)-1:0];
 (* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
 reg pcie_tag_table_active_b[(2**PCIE_TAG_WIDTH)-1:0];
@@ -555,6 +668,12 @@ reg [PCIE_TAG_WIDTH_2+1-1:0] pcie_tag_fifo_2_rd_ptr_reg = 0, pcie_tag_fifo_2_rd_
 reg [PCIE_TAG_WIDTH-1:0] pcie_tag_fifo_2_mem [2**PCIE_TAG_WIDTH_2-1:0];
 reg pcie_tag_fifo_2_we;
 
+reg [PCIE_TAG_WIDTH_3+1-1:0] pcie_tag_fifo_3_wr_ptr_reg = 0;
+reg [PCIE_TAG_WIDTH_3+1-1:0] pcie_tag_fifo_3_rd_ptr_reg = 0, pcie_tag_fifo_3_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [PCIE_TAG_WIDTH-1:0] pcie_tag_fifo_3_mem [2**PCIE_TAG_WIDTH_3-1:0];
+reg pcie_tag_fifo_3_we;
+
 // operation tag management
 reg [OP_TAG_WIDTH-1:0] op_table_start_ptr;
 reg [TAG_WIDTH-1:0] op_table_start_tag;
@@ -619,6 +738,162 @@ initial begin
     end
 end
 
+// Read request merging
+//
+// Incoming descriptors are queued in a small FIFO and merged into a group
+// while each one reads the host memory directly following the previous one
+// into the RAM directly following the previous one, and the group still fits
+// in a single max read request size request.  Completion data is then
+// written to the original RAM destinations by the normal completion path.
+// A group is sent to request generation when the next descriptor cannot be
+// merged, when it is full, or MERGE_TIMEOUT cycles after it was opened.
+// The tags of the merged descriptors are stored per operation, and one
+// status is returned for each of them when the operation completes.
+// Only exactly adjacent descriptors are merged.  Descriptors with a gap or
+// an overlap in host memory are issued separately: each operation writes its
+// completion data to one contiguous RAM range, so merging them would require
+// splitting the completions back into skipped or duplicated RAM writes.
+wire merge_in_fifo_we = merge_in_fifo_ready_reg && s_axis_read_desc_valid;
+
+wire merge_merge = merge_in_len != 0 && merge_in_len <= {max_read_request_size_dw_reg, 2'b00}
+    && merge_in_ram_sel == merge_ram_sel_reg
+    && merge_in_pcie_addr == merge_pcie_addr_reg + merge_len_reg
+    && merge_in_ram_addr == merge_ram_addr_reg + merge_len_reg
+    && merge_len_reg + merge_in_len <= {max_read_request_size_dw_reg, 2'b00};
+
+wire [MERGE_MAX_COUNT*TAG_WIDTH-1:0] merge_status_tags = merge_status_fifo_tags[merge_status_fifo_rd_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]];
+
+always @* begin
+    merge_in_fifo_wr_ptr_next = merge_in_fifo_wr_ptr_reg;
+    merge_in_fifo_rd_ptr_next = merge_in_fifo_rd_ptr_reg;
+
+    merge_pcie_addr_next = merge_pcie_addr_reg;
+    merge_ram_sel_next = merge_ram_sel_reg;
+    merge_ram_addr_next = merge_ram_addr_reg;
+    merge_len_next = merge_len_reg;
+    merge_tags_next = merge_tags_reg;
+    merge_count_next = merge_count_reg;
+    merge_timer_next = merge_timer_reg;
+    merge_flush_next = merge_flush_reg;
+    merge_valid_next = merge_valid_reg;
+
+    merge_status_fifo_rd_ptr_next = merge_status_fifo_rd_ptr_reg;
+    merge_status_index_next = merge_status_index_reg;
+    merge_status_tag_next = merge_status_tag_reg;
+    merge_status_error_next = merge_status_error_reg;
+    merge_status_valid_next = 1'b0;
+
+    if (merge_in_fifo_we) begin
+        merge_in_fifo_wr_ptr_next = merge_in_fifo_wr_ptr_reg + 1;
+    end
+
+    if (s_axis_read_desc_ready_reg && desc_valid) begin
+        // group accepted by request generation
+        merge_valid_next = 1'b0;
+    end else if (merge_valid_reg && !merge_flush_reg) begin
+        // send open group on timeout
+        if (merge_timer_reg != 0) begin
+            merge_timer_next = merge_timer_reg - 1;
+        end else begin
+            merge_flush_next = 1'b1;
+        end
+    end
+
+    if (!merge_in_fifo_empty) begin
+        if (!merge_valid_next) begin
+            // start new group
+            merge_pcie_addr_next = merge_in_pcie_addr;
+            merge_ram_sel_next = merge_in_ram_sel;
+            merge_ram_addr_next = merge_in_ram_addr;
+            merge_len_next = merge_in_len;
+            merge_tags_next = merge_in_tag;
+            merge_count_next = 1;
+            merge_timer_next = MERGE_TIMEOUT;
+            merge_flush_next = merge_in_len == 0 || merge_in_len >= {max_read_request_size_dw_reg, 2'b00} || MERGE_MAX_COUNT == 1;
+            merge_valid_next = 1'b1;
+            merge_in_fifo_rd_ptr_next = merge_in_fifo_rd_ptr_reg + 1;
+        end else if (!merge_flush_reg && merge_merge) begin
+            // adjacent, extend group
+            merge_len_next = merge_len_reg + merge_in_len;
+            merge_tags_next[merge_count_reg*TAG_WIDTH +: TAG_WIDTH] = merge_in_tag;
+            merge_count_next = merge_count_reg + 1;
+            merge_flush_next = merge_flush_next || merge_len_next >= {max_read_request_size_dw_reg, 2'b00} || merge_count_next == MERGE_MAX_COUNT;
+            merge_in_fifo_rd_ptr_next = merge_in_fifo_rd_ptr_reg + 1;
+        end else begin
+            // not adjacent, send group
+            merge_flush_next = 1'b1;
+        end
+    end
+
+    // one status per original descriptor
+    if (!merge_status_fifo_empty) begin
+        merge_status_tag_next = merge_status_tags[merge_status_index_reg*TAG_WIDTH +: TAG_WIDTH];
+        merge_status_error_next = merge_status_fifo_error[merge_status_fifo_rd_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]];
+        merge_status_valid_next = 1'b1;
+        if (merge_status_index_reg + 1 >= merge_status_fifo_count[merge_status_fifo_rd_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]]) begin
+            merge_status_index_next = 0;
+            merge_status_fifo_rd_ptr_next = merge_status_fifo_rd_ptr_reg + 1;
+        end else begin
+            merge_status_index_next = merge_status_index_reg + 1;
+        end
+    end
+
+    merge_in_fifo_ready_next = merge_in_fifo_wr_ptr_next != (merge_in_fifo_rd_ptr_next ^ (1 << MERGE_IN_FIFO_ADDR_WIDTH));
+end
+
+always @(posedge clk) begin
+    merge_in_fifo_wr_ptr_reg <= merge_in_fifo_wr_ptr_next;
+    merge_in_fifo_rd_ptr_reg <= merge_in_fifo_rd_ptr_next;
+    merge_in_fifo_ready_reg <= MERGE_ENABLE && merge_in_fifo_ready_next;
+
+    merge_pcie_addr_reg <= merge_pcie_addr_next;
+    merge_ram_sel_reg <= merge_ram_sel_next;
+    merge_ram_addr_reg <= merge_ram_addr_next;
+    merge_len_reg <= merge_len_next;
+    merge_tags_reg <= merge_tags_next;
+    merge_count_reg <= merge_count_next;
+    merge_timer_reg <= merge_timer_next;
+    merge_flush_reg <= merge_flush_next;
+    merge_valid_reg <= merge_valid_next;
+
+    merge_status_fifo_rd_ptr_reg <= merge_status_fifo_rd_ptr_next;
+    merge_status_index_reg <= merge_status_index_next;
+    merge_status_tag_reg <= merge_status_tag_next;
+    merge_status_error_reg <= merge_status_error_next;
+    merge_status_valid_reg <= merge_status_valid_next;
+
+    if (merge_in_fifo_we) begin
+        merge_in_fifo_pcie_addr[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_pcie_addr;
+        merge_in_fifo_ram_sel[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_ram_sel;
+        merge_in_fifo_ram_addr[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_ram_addr;
+        merge_in_fifo_len[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_len;
+        merge_in_fifo_tag[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_tag;
+    end
+
+    if (op_table_start_en) begin
+        merge_op_tags[op_table_start_ptr] <= merge_tags_reg;
+    end
+
+    if (merge_status_fifo_we) begin
+        merge_status_fifo_tags[merge_status_fifo_wr_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]] <= merge_op_tags[status_fifo_rd_op_tag_reg];
+        merge_status_fifo_count[merge_status_fifo_wr_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]] <= op_table_tag[status_fifo_rd_op_tag_reg];
+        merge_status_fifo_error[merge_status_fifo_wr_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]] <= m_axis_read_desc_status_error_next;
+        merge_status_fifo_wr_ptr_reg <= merge_status_fifo_wr_ptr_reg + 1;
+    end
+
+    if (rst) begin
+        merge_in_fifo_wr_ptr_reg <= 0;
+        merge_in_fifo_rd_ptr_reg <= 0;
+        merge_in_fifo_ready_reg <= 1'b0;
+        merge_flush_reg <= 1'b0;
+        merge_valid_reg <= 1'b0;
+        merge_status_fifo_wr_ptr_reg <= 0;
+        merge_status_fifo_rd_ptr_reg <= 0;
+        merge_status_index_reg <= 0;
+        merge_status_valid_reg <= 1'b0;
+    end
+end
+
 always @* begin
     req_state_next = REQ_STATE_IDLE;
 
@@ -634,6 +909,10 @@ always @* begin
     stat_rd_no_tags_next = !req_pcie_tag_valid_reg;
     stat_rd_tx_limit_next = (TX_SEQ_NUM_ENABLE && !active_tx_count_av_reg) || !active_cplh_fc_av_reg || !active_cpld_fc_av_reg;
     stat_rd_tx_stall_next = tx_rd_req_tlp_valid_reg && !tx_rd_req_tlp_ready;
+    // request ready to go out, but held by flow control or in-flight limits
+    stat_rd_cplh_stall_next = req_state_reg == REQ_STATE_START && !active_cplh_fc_av_reg;
+    stat_rd_cpld_stall_next = req_state_reg == REQ_STATE_START && !active_cpld_fc_av_reg;
+    stat_rd_tx_limit_stall_next = req_state_reg == REQ_STATE_START && TX_SEQ_NUM_ENABLE && !active_tx_count_av_reg;
 
     req_pcie_addr_next = req_pcie_addr_reg;
     req_ram_sel_next = req_ram_sel_reg;
@@ -652,7 +931,7 @@ always @* begin
     inc_active_cpld_fc_count = 0;
 
     op_table_start_ptr = req_op_tag_reg;
-    op_table_start_tag = s_axis_read_desc_tag;
+    op_table_start_tag = desc_tag;
     op_table_start_en = 1'b0;
 
     op_table_read_start_ptr = req_op_tag_reg;
@@ -754,9 +1033,9 @@ always @* begin
         tlp_hdr[127:125] = TLP_FMT_3DW; // fmt - 3DW without data
     end
     tlp_hdr[124:120] = 5'b00000; // type - read
-    tlp_hdr[119] = 1'b0; // T9
+    tlp_hdr[119] = PCIE_TAG_WIDTH > 9 && req_pcie_tag_reg[PCIE_TAG_WIDTH > 9 ? 9 : 0]; // T9
     tlp_hdr[118:116] = 3'b000; // TC
-    tlp_hdr[115] = 1'b0; // T8
+    tlp_hdr[115] = PCIE_TAG_WIDTH > 8 && req_pcie_tag_reg[PCIE_TAG_WIDTH > 8 ? 8 : 0]; // T8
     tlp_hdr[114] = 1'b0; // attr
     tlp_hdr[113] = 1'b0; // LN
     tlp_hdr[112] = 1'b0; // TH
@@ -787,25 +1066,25 @@ always @* begin
         REQ_STATE_IDLE: begin
             s_axis_read_desc_ready_next = init_done_reg && enable && req_op_tag_valid_reg;
 
-            if (s_axis_read_desc_ready && s_axis_read_desc_valid) begin
+            if (s_axis_read_desc_ready_reg && desc_valid) begin
                 s_axis_read_desc_ready_next = 1'b0;
-                req_ram_sel_next = s_axis_read_desc_ram_sel;
-                req_pcie_addr_next = s_axis_read_desc_pcie_addr;
-                req_ram_addr_next = s_axis_read_desc_ram_addr;
-                if (s_axis_read_desc_len == 0) begin
+                req_ram_sel_next = desc_ram_sel;
+                req_pcie_addr_next = desc_pcie_addr;
+                req_ram_addr_next = desc_ram_addr;
+                if (desc_len == 0) begin
                     // zero-length operation
                     req_op_count_next = 1;
                     req_zero_len_next = 1'b1;
                 end else begin
-                    req_op_count_next = s_axis_read_desc_len;
+                    req_op_count_next = desc_len;
                     req_zero_len_next = 1'b0;
                 end
                 op_table_start_ptr = req_op_tag_reg;
-                op_table_start_tag = s_axis_read_desc_tag;
+                op_table_start_tag = desc_tag;
                 op_table_start_en = 1'b1;
                 inc_active_op = 1'b1;
                 stat_rd_op_start_tag_next = req_op_tag_reg;
-                stat_rd_op_start_len_next = s_axis_read_desc_len;
+                stat_rd_op_start_len_next = desc_len;
                 stat_rd_op_start_valid_next = 1'b1;
                 req_state_next = REQ_STATE_START;
             end else begin
@@ -873,6 +1152,7 @@ always @* begin
 
     pcie_tag_fifo_1_rd_ptr_next = pcie_tag_fifo_1_rd_ptr_reg;
     pcie_tag_fifo_2_rd_ptr_next = pcie_tag_fifo_2_rd_ptr_reg;
+    pcie_tag_fifo_3_rd_ptr_next = pcie_tag_fifo_3_rd_ptr_reg;
 
     if (!req_pcie_tag_valid_next) begin
         if (pcie_tag_fifo_1_rd_ptr_reg != pcie_tag_fifo_1_wr_ptr_reg) begin
@@ -883,6 +1163,11 @@ always @* begin
             req_pcie_tag_next = pcie_tag_fifo_2_mem[pcie_tag_fifo_2_rd_ptr_reg[PCIE_TAG_WIDTH_2-1:0]];
             req_pcie_tag_valid_next = 1'b1;
             pcie_tag_fifo_2_rd_ptr_next = pcie_tag_fifo_2_rd_ptr_reg + 1;
+        end else if (PCIE_TAG_COUNT_3 > 0 && ten_bit_tag_enable && pcie_tag_fifo_3_rd_ptr_reg != pcie_tag_fifo_3_wr_ptr_reg) begin
+            // 10-bit tags (T9:T8 nonzero)
+            req_pcie_tag_next = pcie_tag_fifo_3_mem[pcie_tag_fifo_3_rd_ptr_reg[PCIE_TAG_WIDTH_3-1:0]];
+            req_pcie_tag_valid_next = 1'b1;
+            pcie_tag_fifo_3_rd_ptr_next = pcie_tag_fifo_3_rd_ptr_reg + 1;
         end
     end
 end
@@ -899,6 +1184,8 @@ always @* begin
     stat_rd_op_finish_valid_next = 1'b0;
     stat_rd_req_finish_tag_next = stat_rd_req_finish_tag_reg;
     stat_rd_req_finish_status_next = stat_rd_req_finish_status_reg;
+    stat_rd_req_finish_latency_next = stat_rd_req_finish_latency_reg;
+    stat_lat = {STAT_TIME_WIDTH{1'b0}};
     stat_rd_req_finish_valid_next = 1'b0;
     stat_rd_req_timeout_next = 1'b0;
 
@@ -1133,6 +1420,8 @@ always @* begin
                     status_fifo_wr_en_next = 1'b1;
 
                     stat_rd_req_finish_tag_next = pcie_tag_next;
+                    stat_lat = stat_time_reg - pcie_tag_table_start_time[pcie_tag_next];
+                    stat_rd_req_finish_latency_next = stat_lat >> 16 != 0 ? 16'hffff : stat_lat[15:0];
                     stat_rd_req_finish_status_next = status_fifo_error_next;
                     stat_rd_req_finish_valid_next = 1'b1;
 
@@ -1159,6 +1448,8 @@ always @* begin
                     end
 
                     stat_rd_req_finish_tag_next = pcie_tag_next;
+                    stat_lat = stat_time_reg - pcie_tag_table_start_time[pcie_tag_next];
+                    stat_rd_req_finish_latency_next = stat_lat >> 16 != 0 ? 16'hffff : stat_lat[15:0];
                     stat_rd_req_finish_status_next = DMA_ERROR_NONE;
 
                     if (last_cycle) begin
@@ -1222,6 +1513,8 @@ always @* begin
                 status_fifo_wr_en_next = 1'b1;
 
                 stat_rd_req_finish_tag_next = pcie_tag_next;
+                stat_lat = stat_time_reg - pcie_tag_table_start_time[pcie_tag_next];
+                stat_rd_req_finish_latency_next = stat_lat >> 16 != 0 ? 16'hffff : stat_lat[15:0];
                 stat_rd_req_finish_status_next = DMA_ERROR_NONE;
 
                 if (last_cycle || rx_cpl_tlp_eop) begin
@@ -1270,14 +1563,17 @@ always @* begin
     pcie_tag_fifo_wr_tag = pcie_tag_reg;
     pcie_tag_fifo_1_we = 1'b0;
     pcie_tag_fifo_2_we = 1'b0;
+    pcie_tag_fifo_3_we = 1'b0;
 
     if (init_pcie_tag_reg) begin
         // initialize FIFO
         pcie_tag_fifo_wr_tag = init_count_reg;
         if (pcie_tag_fifo_wr_tag < PCIE_TAG_COUNT_1 || !PCIE_TAG_COUNT_2) begin
             pcie_tag_fifo_1_we = 1'b1;
-        end else if (pcie_tag_fifo_wr_tag) begin
+        end else if (pcie_tag_fifo_wr_tag < 256 || !PCIE_TAG_COUNT_3) begin
             pcie_tag_fifo_2_we = 1'b1;
+        end else begin
+            pcie_tag_fifo_3_we = 1'b1;
         end
     end else if (finish_tag_reg) begin
         pcie_tag_table_finish_ptr = pcie_tag_reg;
@@ -1289,8 +1585,10 @@ always @* begin
         pcie_tag_fifo_wr_tag = pcie_tag_reg;
         if (pcie_tag_fifo_wr_tag < PCIE_TAG_COUNT_1 || !PCIE_TAG_COUNT_2) begin
             pcie_tag_fifo_1_we = 1'b1;
-        end else begin
+        end else if (pcie_tag_fifo_wr_tag < 256 || !PCIE_TAG_COUNT_3) begin
             pcie_tag_fifo_2_we = 1'b1;
+        end else begin
+            pcie_tag_fifo_3_we = 1'b1;
         end
     end
 
@@ -1327,13 +1625,15 @@ always @* begin
     op_tag_fifo_wr_tag = status_fifo_rd_op_tag_reg;
     op_tag_fifo_we = 1'b0;
 
+    merge_status_fifo_we = 1'b0;
+
     stat_rd_op_finish_tag_next = status_fifo_rd_op_tag_reg;
 
     if (init_op_tag_reg) begin
         // initialize FIFO
         op_tag_fifo_wr_tag = init_count_reg;
         op_tag_fifo_we = 1'b1;
-    end else if (status_fifo_rd_valid_reg && (status_fifo_rd_mask_reg & ~out_done) == 0) begin
+    end else if (status_fifo_rd_valid_reg && (status_fifo_rd_mask_reg & ~out_done) == 0 && (!MERGE_ENABLE || !merge_status_fifo_full)) begin
         // got write completion, pop and return status
         status_fifo_rd_valid_next = 1'b0;
         op_table_update_status_en = 1'b1;
@@ -1350,7 +1650,12 @@ always @* begin
                 op_tag_fifo_we = 1'b1;
                 dec_active_op = 1'b1;
                 stat_rd_op_finish_valid_next = 1'b1;
-                m_axis_read_desc_status_valid_next = 1'b1;
+                if (MERGE_ENABLE) begin
+                    // expand to one status per merged descriptor
+                    merge_status_fifo_we = 1'b1;
+                end else begin
+                    m_axis_read_desc_status_valid_next = 1'b1;
+                end
             end
         end
     end
@@ -1385,10 +1690,10 @@ always @* begin
     active_tx_count_av_next = active_tx_count_next < TX_LIMIT;
 
     active_cplh_fc_count_next = active_cplh_fc_count_reg + inc_active_cplh_fc_count - dec_active_cplh_fc_count;
-    active_cplh_fc_av_next = !CPLH_FC_LIMIT || active_cplh_fc_count_next < CPLH_FC_LIMIT;
+    active_cplh_fc_av_next = !cplh_fc_limit_reg || active_cplh_fc_count_next < cplh_fc_limit_reg;
 
     active_cpld_fc_count_next = active_cpld_fc_count_reg + inc_active_cpld_fc_count - dec_active_cpld_fc_count;
-    active_cpld_fc_av_next = !CPLD_FC_LIMIT || active_cpld_fc_count_next < CPLD_FC_LIMIT;
+    active_cpld_fc_av_next = !cpld_fc_limit_reg || active_cpld_fc_count_next < cpld_fc_limit_reg;
 end
 
 always @(posedge clk) begin
@@ -1452,7 +1757,8 @@ always @(posedge clk) begin
     m_axis_read_desc_status_error_reg <= m_axis_read_desc_status_error_next;
     m_axis_read_desc_status_valid_reg <= m_axis_read_desc_status_valid_next;
 
-    status_busy_reg <= active_op_count_reg != 0 || active_tx_count_reg != 0;
+    status_busy_reg <= active_op_count_reg != 0 || active_tx_count_reg != 0
+        || (MERGE_ENABLE && (!merge_in_fifo_empty || merge_valid_reg || !merge_status_fifo_empty));
     status_error_cor_reg <= status_error_cor_next;
     status_error_uncor_reg <= status_error_uncor_next;
 
@@ -1467,12 +1773,18 @@ always @(posedge clk) begin
     stat_rd_req_start_valid_reg <= stat_rd_req_start_valid_next;
     stat_rd_req_finish_tag_reg <= stat_rd_req_finish_tag_next;
     stat_rd_req_finish_status_reg <= stat_rd_req_finish_status_next;
+    stat_rd_req_finish_latency_reg <= stat_rd_req_finish_latency_next;
     stat_rd_req_finish_valid_reg <= stat_rd_req_finish_valid_next;
     stat_rd_req_timeout_reg <= stat_rd_req_timeout_next;
     stat_rd_op_table_full_reg <= stat_rd_op_table_full_next;
     stat_rd_no_tags_reg <= stat_rd_no_tags_next;
     stat_rd_tx_limit_reg <= stat_rd_tx_limit_next;
     stat_rd_tx_stall_reg <= stat_rd_tx_stall_next;
+    stat_rd_cplh_stall_reg <= stat_rd_cplh_stall_next;
+    stat_rd_cpld_stall_reg <= stat_rd_cpld_stall_next;
+    stat_rd_tx_limit_stall_reg <= stat_rd_tx_limit_stall_next;
+
+    stat_time_reg <= stat_time_reg + 1;
 
     max_read_request_size_dw_reg <= 11'd32 << (max_read_request_size > 5 ? 5 : max_read_request_size);
     rcb_128b_reg <= rcb_128b;
@@ -1508,6 +1820,18 @@ always @(posedge clk) begin
     active_tag_count_reg <= active_tag_count_reg + inc_active_tag - dec_active_tag;
     active_op_count_reg <= active_op_count_reg + inc_active_op - dec_active_op;
 
+    // runtime limits (zero selects the compile-time limit, which is never exceeded)
+    if (cplh_fc_limit && (!CPLH_FC_LIMIT || cplh_fc_limit < CPLH_FC_LIMIT)) begin
+        cplh_fc_limit_reg <= cplh_fc_limit;
+    end else begin
+        cplh_fc_limit_reg <= CPLH_FC_LIMIT;
+    end
+    if (cpld_fc_limit && (!CPLD_FC_LIMIT || cpld_fc_limit < CPLD_FC_LIMIT)) begin
+        cpld_fc_limit_reg <= cpld_fc_limit;
+    end else begin
+        cpld_fc_limit_reg <= CPLD_FC_LIMIT;
+    end
+
     active_cplh_fc_count_reg <= active_cplh_fc_count_next;
     active_cplh_fc_av_reg <= active_cplh_fc_av_next;
 
@@ -1532,6 +1856,7 @@ always @(posedge clk) begin
         pcie_tag_table_cplh_fc[pcie_tag_table_start_ptr_reg] <= pcie_tag_table_start_cplh_fc_reg;
         pcie_tag_table_cpld_fc[pcie_tag_table_start_ptr_reg] <= pcie_tag_table_start_cpld_fc_reg;
         pcie_tag_table_zero_len[pcie_tag_table_start_ptr_reg] <= pcie_tag_table_start_zero_len_reg;
+        pcie_tag_table_start_time[pcie_tag_table_start_ptr_reg] <= stat_time_reg;
         pcie_tag_table_active_a[pcie_tag_table_start_ptr_reg] <= !pcie_tag_table_active_b[pcie_tag_table_start_ptr_reg];
     end
 
@@ -1553,6 +1878,13 @@ always @(posedge clk) begin
         end
         pcie_tag_fifo_2_rd_ptr_reg <= pcie_tag_fifo_2_rd_ptr_next;
     end
+    if (PCIE_TAG_COUNT_3) begin
+        if (pcie_tag_fifo_3_we) begin
+            pcie_tag_fifo_3_mem[pcie_tag_fifo_3_wr_ptr_reg[PCIE_TAG_WIDTH_3-1:0]] <= pcie_tag_fifo_wr_tag;
+            pcie_tag_fifo_3_wr_ptr_reg <= pcie_tag_fifo_3_wr_ptr_reg + 1;
+        end
+        pcie_tag_fifo_3_rd_ptr_reg <= pcie_tag_fifo_3_rd_ptr_next;
+    end
 
     if (init_op_tag_reg) begin
         op_table_read_init_a[init_count_reg] <= 1'b0;
@@ -1634,6 +1966,9 @@ always @(posedge clk) begin
         stat_rd_no_tags_reg <= 1'b0;
         stat_rd_tx_limit_reg <= 1'b0;
         stat_rd_tx_stall_reg <= 1'b0;
+        stat_rd_cplh_stall_reg <= 1'b0;
+        stat_rd_cpld_stall_reg <= 1'b0;
+        stat_rd_tx_limit_stall_reg <= 1'b0;
 
         status_fifo_wr_ptr_reg <= 0;
         status_fifo_rd_ptr_reg <= 0;
@@ -1646,6 +1981,9 @@ always @(posedge clk) begin
         active_tag_count_reg <= 0;
         active_op_count_reg <= 0;
 
+        cplh_fc_limit_reg <= CPLH_FC_LIMIT;
+        cpld_fc_limit_reg <= CPLD_FC_LIMIT;
+
         active_cplh_fc_count_reg <= 0;
         active_cplh_fc_av_reg <= 1'b1;
 
@@ -1658,6 +1996,8 @@ always @(posedge clk) begin
         pcie_tag_fifo_1_rd_ptr_reg <= 0;
         pcie_tag_fifo_2_wr_ptr_reg <= 0;
         pcie_tag_fifo_2_rd_ptr_reg <= 0;
+        pcie_tag_fifo_3_wr_ptr_reg <= 0;
+        pcie_tag_fifo_3_rd_ptr_reg <= 0;
 
         op_tag_fifo_wr_ptr_reg <= 0;
         op_tag_fifo_rd_ptr_reg <= 0;
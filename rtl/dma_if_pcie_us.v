@@ -76,7 +76,15 @@ module dma_if_pcie_us #
     // In-flight transmit limit (write)
     parameter WRITE_TX_LIMIT = 2**(RQ_SEQ_NUM_WIDTH-1),
     // Transmit flow control (write)
-    parameter WRITE_TX_FC_ENABLE = 0
+    parameter WRITE_TX_FC_ENABLE = 0,
+    // Descriptor coalescing (write)
+    parameter WRITE_COALESCE_ENABLE = 0,
+    // Coalescing timeout in cycles (write)
+    parameter WRITE_COALESCE_TIMEOUT = 16,
+    // Request merging (read)
+    parameter READ_MERGE_ENABLE = 0,
+    // Merging timeout in cycles (read)
+    parameter READ_MERGE_TIMEOUT = 16
 )
 (
     input  wire                                 clk,
@@ -188,7 +196,19 @@ module dma_if_pcie_us #
     output wire                                 status_rd_busy,
     output wire                                 status_wr_busy,
     output wire                                 status_error_cor,
-    output wire                                 status_error_uncor
+    output wire                                 status_error_uncor,
+
+    /*
+     * Statistics
+     */
+    output wire [$clog2(PCIE_TAG_COUNT)-1:0]    stat_rd_req_finish_tag,
+    output wire [15:0]                          stat_rd_req_finish_latency,
+    output wire                                 stat_rd_req_finish_valid,
+    output wire [$clog2(PCIE_TAG_COUNT):0]      stat_rd_active_tags,
+    output wire [$clog2(READ_OP_TABLE_SIZE):0]  stat_rd_active_ops,
+    output wire                                 stat_rd_no_tags,
+    output wire                                 stat_rd_fc_stall,
+    output wire                                 stat_rd_tx_limit_stall
 );
 
 wire [AXIS_PCIE_DATA_WIDTH-1:0]    axis_rq_tdata_read;
@@ -222,7 +242,9 @@ dma_if_pcie_us_rd #(
     .TAG_WIDTH(TAG_WIDTH),
     .OP_TABLE_SIZE(READ_OP_TABLE_SIZE),
     .TX_LIMIT(READ_TX_LIMIT),
-    .TX_FC_ENABLE(READ_TX_FC_ENABLE)
+    .TX_FC_ENABLE(READ_TX_FC_ENABLE),
+    .MERGE_ENABLE(READ_MERGE_ENABLE),
+    .MERGE_TIMEOUT(READ_MERGE_TIMEOUT)
 )
 dma_if_pcie_us_rd_inst (
     .clk(clk),
@@ -304,7 +326,19 @@ dma_if_pcie_us_rd_inst (
      */
     .status_busy(status_rd_busy),
     .status_error_cor(status_error_cor),
-    .status_error_uncor(status_error_uncor)
+    .status_error_uncor(status_error_uncor),
+
+    /*
+     * Statistics
+     */
+    .stat_rd_req_finish_tag(stat_rd_req_finish_tag),
+    .stat_rd_req_finish_latency(stat_rd_req_finish_latency),
+    .stat_rd_req_finish_valid(stat_rd_req_finish_valid),
+    .stat_rd_active_tags(stat_rd_active_tags),
+    .stat_rd_active_ops(stat_rd_active_ops),
+    .stat_rd_no_tags(stat_rd_no_tags),
+    .stat_rd_fc_stall(stat_rd_fc_stall),
+    .stat_rd_tx_limit_stall(stat_rd_tx_limit_stall)
 );
 
 dma_if_pcie_us_wr #(
@@ -324,7 +358,9 @@ dma_if_pcie_us_wr #(
     .TAG_WIDTH(TAG_WIDTH),
     .OP_TABLE_SIZE(WRITE_OP_TABLE_SIZE),
     .TX_LIMIT(WRITE_TX_LIMIT),
-    .TX_FC_ENABLE(WRITE_TX_FC_ENABLE)
+    .TX_FC_ENABLE(WRITE_TX_FC_ENABLE),
+    .COALESCE_ENABLE(WRITE_COALESCE_ENABLE),
+    .COALESCE_TIMEOUT(WRITE_COALESCE_TIMEOUT)
 )
 dma_if_pcie_us_wr_inst (
     .clk(clk),
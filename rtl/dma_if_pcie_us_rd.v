@@ -70,7 +70,13 @@ module dma_if_pcie_us_rd #
     // In-flight transmit limit
     parameter TX_LIMIT = 2**(RQ_SEQ_NUM_WIDTH-1),
     // Transmit flow control
-    parameter TX_FC_ENABLE = 0
+    parameter TX_FC_ENABLE = 0,
+    // Merge adjacent read descriptors into max read request size requests
+    parameter MERGE_ENABLE = 0,
+    // Cycles to hold an open merge group before sending it
+    parameter MERGE_TIMEOUT = 16,
+    // Maximum number of descriptors merged into one operation
+    parameter MERGE_MAX_COUNT = 4
 )
 (
     input  wire                                 clk,
@@ -152,7 +158,19 @@ module dma_if_pcie_us_rd #
      */
     output wire                                 status_busy,
     output wire                                 status_error_cor,
-    output wire                                 status_error_uncor
+    output wire                                 status_error_uncor,
+
+    /*
+     * Statistics
+     */
+    output wire [$clog2(PCIE_TAG_COUNT)-1:0]    stat_rd_req_finish_tag,
+    output wire [15:0]                          stat_rd_req_finish_latency,
+    output wire                                 stat_rd_req_finish_valid,
+    output wire [$clog2(PCIE_TAG_COUNT):0]      stat_rd_active_tags,
+    output wire [$clog2(OP_TABLE_SIZE):0]       stat_rd_active_ops,
+    output wire                                 stat_rd_no_tags,
+    output wire                                 stat_rd_fc_stall,
+    output wire                                 stat_rd_tx_limit_stall
 );
 
 parameter RAM_WORD_WIDTH = SEG_BE_WIDTH;
@@ -171,6 +189,10 @@ parameter PCIE_TAG_COUNT_2 = 2**PCIE_TAG_WIDTH > 32 ? 2**PCIE_TAG_WIDTH-32 : 0;
 parameter PCIE_TAG_WIDTH_2 = $clog2(PCIE_TAG_COUNT_2);
 
 parameter OP_TAG_WIDTH = $clog2(OP_TABLE_SIZE);
+
+parameter MERGE_IN_FIFO_ADDR_WIDTH = 2;
+parameter MERGE_STATUS_FIFO_ADDR_WIDTH = 3;
+parameter MERGE_COUNT_WIDTH = $clog2(MERGE_MAX_COUNT+1);
 parameter OP_TABLE_READ_COUNT_WIDTH = PCIE_TAG_WIDTH+1;
 
 parameter STATUS_FIFO_ADDR_WIDTH = 5;
@@ -178,6 +200,10 @@ parameter OUTPUT_FIFO_ADDR_WIDTH = 5;
 
 parameter INIT_COUNT_WIDTH = PCIE_TAG_WIDTH > OP_TAG_WIDTH ? PCIE_TAG_WIDTH : OP_TAG_WIDTH;
 
+// request latency timestamp, wider than the latency output so that long
+// latencies saturate at 16'hffff instead of wrapping
+parameter STAT_TIME_WIDTH = 24;
+
 // bus width assertions
 initial begin
     if (AXIS_PCIE_DATA_WIDTH != 64 && AXIS_PCIE_DATA_WIDTH != 128 && AXIS_PCIE_DATA_WIDTH != 256 && AXIS_PCIE_DATA_WIDTH != 512) begin
@@ -268,6 +294,11 @@ initial begin
         $error("Error: PCIe tag count must be between 1 and 256 (instance %m)");
         $finish;
     end
+
+    if (MERGE_ENABLE && (MERGE_MAX_COUNT < 1 || TAG_WIDTH < MERGE_COUNT_WIDTH)) begin
+        $error("Error: Tag width too narrow for merge count (instance %m)");
+        $finish;
+    end
 end
 
 localparam [3:0]
@@ -438,9 +469,83 @@ reg [3:0] m_axis_read_desc_status_error_reg = 4'd0, m_axis_read_desc_status_erro
 reg m_axis_read_desc_status_valid_reg = 1'b0, m_axis_read_desc_status_valid_next;
 
 reg status_busy_reg = 1'b0;
+
+// read request merging
+reg [MERGE_IN_FIFO_ADDR_WIDTH+1-1:0] merge_in_fifo_wr_ptr_reg = 0, merge_in_fifo_wr_ptr_next;
+reg [MERGE_IN_FIFO_ADDR_WIDTH+1-1:0] merge_in_fifo_rd_ptr_reg = 0, merge_in_fifo_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [PCIE_ADDR_WIDTH-1:0] merge_in_fifo_pcie_addr[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [RAM_SEL_WIDTH-1:0] merge_in_fifo_ram_sel[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [RAM_ADDR_WIDTH-1:0] merge_in_fifo_ram_addr[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [LEN_WIDTH-1:0] merge_in_fifo_len[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [TAG_WIDTH-1:0] merge_in_fifo_tag[(2**MERGE_IN_FIFO_ADDR_WIDTH)-1:0];
+reg merge_in_fifo_ready_reg = 1'b0, merge_in_fifo_ready_next;
+
+wire merge_in_fifo_empty = merge_in_fifo_wr_ptr_reg == merge_in_fifo_rd_ptr_reg;
+
+wire [PCIE_ADDR_WIDTH-1:0] merge_in_pcie_addr = merge_in_fifo_pcie_addr[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [RAM_SEL_WIDTH-1:0] merge_in_ram_sel = merge_in_fifo_ram_sel[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [RAM_ADDR_WIDTH-1:0] merge_in_ram_addr = merge_in_fifo_ram_addr[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [LEN_WIDTH-1:0] merge_in_len = merge_in_fifo_len[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [TAG_WIDTH-1:0] merge_in_tag = merge_in_fifo_tag[merge_in_fifo_rd_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]];
+
+reg [PCIE_ADDR_WIDTH-1:0] merge_pcie_addr_reg = {PCIE_ADDR_WIDTH{1'b0}}, merge_pcie_addr_next;
+reg [RAM_SEL_WIDTH-1:0] merge_ram_sel_reg = {RAM_SEL_WIDTH{1'b0}}, merge_ram_sel_next;
+reg [RAM_ADDR_WIDTH-1:0] merge_ram_addr_reg = {RAM_ADDR_WIDTH{1'b0}}, merge_ram_addr_next;
+reg [LEN_WIDTH-1:0] merge_len_reg = {LEN_WIDTH{1'b0}}, merge_len_next;
+reg [MERGE_MAX_COUNT*TAG_WIDTH-1:0] merge_tags_reg = {MERGE_MAX_COUNT*TAG_WIDTH{1'b0}}, merge_tags_next;
+reg [MERGE_COUNT_WIDTH-1:0] merge_count_reg = 0, merge_count_next;
+reg [15:0] merge_timer_reg = 16'd0, merge_timer_next;
+reg merge_flush_reg = 1'b0, merge_flush_next;
+reg merge_valid_reg = 1'b0, merge_valid_next;
+
+// original descriptor tags of each operation, for status expansion
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [MERGE_MAX_COUNT*TAG_WIDTH-1:0] merge_op_tags[2**OP_TAG_WIDTH-1:0];
+
+reg [MERGE_STATUS_FIFO_ADDR_WIDTH+1-1:0] merge_status_fifo_wr_ptr_reg = 0;
+reg [MERGE_STATUS_FIFO_ADDR_WIDTH+1-1:0] merge_status_fifo_rd_ptr_reg = 0, merge_status_fifo_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [MERGE_MAX_COUNT*TAG_WIDTH-1:0] merge_status_fifo_tags[(2**MERGE_STATUS_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [MERGE_COUNT_WIDTH-1:0] merge_status_fifo_count[(2**MERGE_STATUS_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [3:0] merge_status_fifo_error[(2**MERGE_STATUS_FIFO_ADDR_WIDTH)-1:0];
+reg merge_status_fifo_we;
+
+wire merge_status_fifo_empty = merge_status_fifo_wr_ptr_reg == merge_status_fifo_rd_ptr_reg;
+wire merge_status_fifo_full = merge_status_fifo_wr_ptr_reg == (merge_status_fifo_rd_ptr_reg ^ (1 << MERGE_STATUS_FIFO_ADDR_WIDTH));
+
+reg [MERGE_COUNT_WIDTH-1:0] merge_status_index_reg = 0, merge_status_index_next;
+reg [TAG_WIDTH-1:0] merge_status_tag_reg = {TAG_WIDTH{1'b0}}, merge_status_tag_next;
+reg [3:0] merge_status_error_reg = 4'd0, merge_status_error_next;
+reg merge_status_valid_reg = 1'b0, merge_status_valid_next;
+
+// descriptor input to request generation
+wire [PCIE_ADDR_WIDTH-1:0] desc_pcie_addr = MERGE_ENABLE ? merge_pcie_addr_reg : s_axis_read_desc_pcie_addr;
+wire [RAM_SEL_WIDTH-1:0] desc_ram_sel = MERGE_ENABLE ? merge_ram_sel_reg : s_axis_read_desc_ram_sel;
+wire [RAM_ADDR_WIDTH-1:0] desc_ram_addr = MERGE_ENABLE ? merge_ram_addr_reg : s_axis_read_desc_ram_addr;
+wire [LEN_WIDTH-1:0] desc_len = MERGE_ENABLE ? merge_len_reg : s_axis_read_desc_len;
+wire [TAG_WIDTH-1:0] desc_tag = MERGE_ENABLE ? merge_count_reg : s_axis_read_desc_tag;
+wire desc_valid = MERGE_ENABLE ? merge_valid_reg && merge_flush_reg : s_axis_read_desc_valid;
 reg status_error_cor_reg = 1'b0, status_error_cor_next;
 reg status_error_uncor_reg = 1'b0, status_error_uncor_next;
 
+reg [PCIE_TAG_WIDTH-1:0] stat_rd_req_finish_tag_reg = 0, stat_rd_req_finish_tag_next;
+reg [15:0] stat_rd_req_finish_latency_reg = 16'd0, stat_rd_req_finish_latency_next;
+reg stat_rd_req_finish_valid_reg = 1'b0, stat_rd_req_finish_valid_next;
+reg stat_rd_no_tags_reg = 1'b0, stat_rd_no_tags_next;
+reg stat_rd_fc_stall_reg = 1'b0, stat_rd_fc_stall_next;
+reg stat_rd_tx_limit_stall_reg = 1'b0, stat_rd_tx_limit_stall_next;
+
+// free-running timestamp for request latency measurement
+reg [STAT_TIME_WIDTH-1:0] stat_time_reg = {STAT_TIME_WIDTH{1'b0}};
+reg [STAT_TIME_WIDTH-1:0] stat_lat;
+
 // internal datapath
 reg  [AXIS_PCIE_DATA_WIDTH-1:0]    m_axis_rq_tdata_int;
 reg  [AXIS_PCIE_KEEP_WIDTH-1:0]    m_axis_rq_tkeep_int;
@@ -461,16 +566,25 @@ wire [SEG_COUNT-1:0] out_done;
 reg [SEG_COUNT-1:0] out_done_ack;
 
 assign s_axis_rc_tready = s_axis_rc_tready_reg;
-assign s_axis_read_desc_ready = s_axis_read_desc_ready_reg;
+assign s_axis_read_desc_ready = MERGE_ENABLE ? merge_in_fifo_ready_reg : s_axis_read_desc_ready_reg;
 
-assign m_axis_read_desc_status_tag = m_axis_read_desc_status_tag_reg;
-assign m_axis_read_desc_status_error = m_axis_read_desc_status_error_reg;
-assign m_axis_read_desc_status_valid = m_axis_read_desc_status_valid_reg;
+assign m_axis_read_desc_status_tag = MERGE_ENABLE ? merge_status_tag_reg : m_axis_read_desc_status_tag_reg;
+assign m_axis_read_desc_status_error = MERGE_ENABLE ? merge_status_error_reg : m_axis_read_desc_status_error_reg;
+assign m_axis_read_desc_status_valid = MERGE_ENABLE ? merge_status_valid_reg : m_axis_read_desc_status_valid_reg;
 
 assign status_busy = status_busy_reg;
 assign status_error_cor = status_error_cor_reg;
 assign status_error_uncor = status_error_uncor_reg;
 
+assign stat_rd_req_finish_tag = stat_rd_req_finish_tag_reg;
+assign stat_rd_req_finish_latency = stat_rd_req_finish_latency_reg;
+assign stat_rd_req_finish_valid = stat_rd_req_finish_valid_reg;
+assign stat_rd_active_tags = active_tag_count_reg;
+assign stat_rd_active_ops = active_op_count_reg;
+assign stat_rd_no_tags = stat_rd_no_tags_reg;
+assign stat_rd_fc_stall = stat_rd_fc_stall_reg;
+assign stat_rd_tx_limit_stall = stat_rd_tx_limit_stall_reg;
+
 // PCIe tag management
 reg [PCIE_TAG_WIDTH-1:0] pcie_tag_table_start_ptr_reg = 0, pcie_tag_table_start_ptr_next;
 reg [RAM_SEL_WIDTH-1:0] pcie_tag_table_start_ram_sel_reg = 0, pcie_tag_table_start_ram_sel_next;
@@ -490,6 +604,8 @@ reg [OP_TAG_WIDTH-1:0] pcie_tag_table_op_tag[(2**PCIE_TAG_WIDTH)-1:0];
 (* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
 reg pcie_tag_table_zero_len[(2**PCIE_TAG_WIDTH)-1:0];
 (* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [STAT_TIME_WIDTH-1:0] pcie_tag_table_start_time[(2**PCIE_TAG_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
 reg pcie_tag_table_active_a[(2**PCIE_TAG_WIDTH)-1:0];
 (* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
 reg pcie_tag_table_active_b[(2**PCIE_TAG_WIDTH)-1:0];
@@ -572,11 +688,172 @@ initial begin
     end
 end
 
+// Read request merging
+//
+// Incoming descriptors are queued in a small FIFO and merged into a group
+// while each one reads the host memory directly following the previous one
+// into the RAM directly following the previous one, and the group still fits
+// in a single max read request size request.  Completion data is then
+// written to the original RAM destinations by the normal completion path.
+// A group is sent to request generation when the next descriptor cannot be
+// merged, when it is full, or MERGE_TIMEOUT cycles after it was opened.
+// The tags of the merged descriptors are stored per operation, and one
+// status is returned for each of them when the operation completes.
+// Only exactly adjacent descriptors are merged.  Descriptors with a gap or
+// an overlap in host memory are issued separately: each operation writes its
+// completion data to one contiguous RAM range, so merging them would require
+// splitting the completions back into skipped or duplicated RAM writes.
+wire merge_in_fifo_we = merge_in_fifo_ready_reg && s_axis_read_desc_valid;
+
+wire merge_merge = merge_in_len != 0 && merge_in_len <= {max_read_request_size_dw_reg, 2'b00}
+    && merge_in_ram_sel == merge_ram_sel_reg
+    && merge_in_pcie_addr == merge_pcie_addr_reg + merge_len_reg
+    && merge_in_ram_addr == merge_ram_addr_reg + merge_len_reg
+    && merge_len_reg + merge_in_len <= {max_read_request_size_dw_reg, 2'b00};
+
+wire [MERGE_MAX_COUNT*TAG_WIDTH-1:0] merge_status_tags = merge_status_fifo_tags[merge_status_fifo_rd_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]];
+
+always @* begin
+    merge_in_fifo_wr_ptr_next = merge_in_fifo_wr_ptr_reg;
+    merge_in_fifo_rd_ptr_next = merge_in_fifo_rd_ptr_reg;
+
+    merge_pcie_addr_next = merge_pcie_addr_reg;
+    merge_ram_sel_next = merge_ram_sel_reg;
+    merge_ram_addr_next = merge_ram_addr_reg;
+    merge_len_next = merge_len_reg;
+    merge_tags_next = merge_tags_reg;
+    merge_count_next = merge_count_reg;
+    merge_timer_next = merge_timer_reg;
+    merge_flush_next = merge_flush_reg;
+    merge_valid_next = merge_valid_reg;
+
+    merge_status_fifo_rd_ptr_next = merge_status_fifo_rd_ptr_reg;
+    merge_status_index_next = merge_status_index_reg;
+    merge_status_tag_next = merge_status_tag_reg;
+    merge_status_error_next = merge_status_error_reg;
+    merge_status_valid_next = 1'b0;
+
+    if (merge_in_fifo_we) begin
+        merge_in_fifo_wr_ptr_next = merge_in_fifo_wr_ptr_reg + 1;
+    end
+
+    if (s_axis_read_desc_ready_reg && desc_valid) begin
+        // group accepted by request generation
+        merge_valid_next = 1'b0;
+    end else if (merge_valid_reg && !merge_flush_reg) begin
+        // send open group on timeout
+        if (merge_timer_reg != 0) begin
+            merge_timer_next = merge_timer_reg - 1;
+        end else begin
+            merge_flush_next = 1'b1;
+        end
+    end
+
+    if (!merge_in_fifo_empty) begin
+        if (!merge_valid_next) begin
+            // start new group
+            merge_pcie_addr_next = merge_in_pcie_addr;
+            merge_ram_sel_next = merge_in_ram_sel;
+            merge_ram_addr_next = merge_in_ram_addr;
+            merge_len_next = merge_in_len;
+            merge_tags_next = merge_in_tag;
+            merge_count_next = 1;
+            merge_timer_next = MERGE_TIMEOUT;
+            merge_flush_next = merge_in_len == 0 || merge_in_len >= {max_read_request_size_dw_reg, 2'b00} || MERGE_MAX_COUNT == 1;
+            merge_valid_next = 1'b1;
+            merge_in_fifo_rd_ptr_next = merge_in_fifo_rd_ptr_reg + 1;
+        end else if (!merge_flush_reg && merge_merge) begin
+            // adjacent, extend group
+            merge_len_next = merge_len_reg + merge_in_len;
+            merge_tags_next[merge_count_reg*TAG_WIDTH +: TAG_WIDTH] = merge_in_tag;
+            merge_count_next = merge_count_reg + 1;
+            merge_flush_next = merge_flush_next || merge_len_next >= {max_read_request_size_dw_reg, 2'b00} || merge_count_next == MERGE_MAX_COUNT;
+            merge_in_fifo_rd_ptr_next = merge_in_fifo_rd_ptr_reg + 1;
+        end else begin
+            // not adjacent, send group
+            merge_flush_next = 1'b1;
+        end
+    end
+
+    // one status per original descriptor
+    if (!merge_status_fifo_empty) begin
+        merge_status_tag_next = merge_status_tags[merge_status_index_reg*TAG_WIDTH +: TAG_WIDTH];
+        merge_status_error_next = merge_status_fifo_error[merge_status_fifo_rd_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]];
+        merge_status_valid_next = 1'b1;
+        if (merge_status_index_reg + 1 >= merge_status_fifo_count[merge_status_fifo_rd_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]]) begin
+            merge_status_index_next = 0;
+            merge_status_fifo_rd_ptr_next = merge_status_fifo_rd_ptr_reg + 1;
+        end else begin
+            merge_status_index_next = merge_status_index_reg + 1;
+        end
+    end
+
+    merge_in_fifo_ready_next = merge_in_fifo_wr_ptr_next != (merge_in_fifo_rd_ptr_next ^ (1 << MERGE_IN_FIFO_ADDR_WIDTH));
+end
+
+always @(posedge clk) begin
+    merge_in_fifo_wr_ptr_reg <= merge_in_fifo_wr_ptr_next;
+    merge_in_fifo_rd_ptr_reg <= merge_in_fifo_rd_ptr_next;
+    merge_in_fifo_ready_reg <= MERGE_ENABLE && merge_in_fifo_ready_next;
+
+    merge_pcie_addr_reg <= merge_pcie_addr_next;
+    merge_ram_sel_reg <= merge_ram_sel_next;
+    merge_ram_addr_reg <= merge_ram_addr_next;
+    merge_len_reg <= merge_len_next;
+    merge_tags_reg <= merge_tags_next;
+    merge_count_reg <= merge_count_next;
+    merge_timer_reg <= merge_timer_next;
+    merge_flush_reg <= merge_flush_next;
+    merge_valid_reg <= merge_valid_next;
+
+    merge_status_fifo_rd_ptr_reg <= merge_status_fifo_rd_ptr_next;
+    merge_status_index_reg <= merge_status_index_next;
+    merge_status_tag_reg <= merge_status_tag_next;
+    merge_status_error_reg <= merge_status_error_next;
+    merge_status_valid_reg <= merge_status_valid_next;
+
+    if (merge_in_fifo_we) begin
+        merge_in_fifo_pcie_addr[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_pcie_addr;
+        merge_in_fifo_ram_sel[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_ram_sel;
+        merge_in_fifo_ram_addr[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_ram_addr;
+        merge_in_fifo_len[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_len;
+        merge_in_fifo_tag[merge_in_fifo_wr_ptr_reg[MERGE_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_read_desc_tag;
+    end
+
+    if (op_table_start_en) begin
+        merge_op_tags[op_table_start_ptr] <= merge_tags_reg;
+    end
+
+    if (merge_status_fifo_we) begin
+        merge_status_fifo_tags[merge_status_fifo_wr_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]] <= merge_op_tags[status_fifo_rd_op_tag_reg];
+        merge_status_fifo_count[merge_status_fifo_wr_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]] <= op_table_tag[status_fifo_rd_op_tag_reg];
+        merge_status_fifo_error[merge_status_fifo_wr_ptr_reg[MERGE_STATUS_FIFO_ADDR_WIDTH-1:0]] <= m_axis_read_desc_status_error_next;
+        merge_status_fifo_wr_ptr_reg <= merge_status_fifo_wr_ptr_reg + 1;
+    end
+
+    if (rst) begin
+        merge_in_fifo_wr_ptr_reg <= 0;
+        merge_in_fifo_rd_ptr_reg <= 0;
+        merge_in_fifo_ready_reg <= 1'b0;
+        merge_flush_reg <= 1'b0;
+        merge_valid_reg <= 1'b0;
+        merge_status_fifo_wr_ptr_reg <= 0;
+        merge_status_fifo_rd_ptr_reg <= 0;
+        merge_status_index_reg <= 0;
+        merge_status_valid_reg <= 1'b0;
+    end
+end
+
 always @* begin
     req_state_next = REQ_STATE_IDLE;
 
     s_axis_read_desc_ready_next = 1'b0;
 
+    stat_rd_no_tags_next = !req_pcie_tag_valid_reg;
+    // request ready to go out, but held by flow control or in-flight limits
+    stat_rd_fc_stall_next = req_state_reg == REQ_STATE_START && TX_FC_ENABLE && !have_credit_reg;
+    stat_rd_tx_limit_stall_next = req_state_reg == REQ_STATE_START && RQ_SEQ_NUM_ENABLE && !active_tx_count_av_reg;
+
     req_pcie_addr_next = req_pcie_addr_reg;
     req_ram_sel_next = req_ram_sel_reg;
     req_ram_addr_next = req_ram_addr_reg;
@@ -592,7 +869,7 @@ always @* begin
     inc_active_op = 1'b0;
 
     op_table_start_ptr = req_op_tag_reg;
-    op_table_start_tag = s_axis_read_desc_tag;
+    op_table_start_tag = desc_tag;
     op_table_start_en = 1'b0;
 
     op_table_read_start_ptr = req_op_tag_reg;
@@ -725,21 +1002,21 @@ always @* begin
         REQ_STATE_IDLE: begin
             s_axis_read_desc_ready_next = init_done_reg && enable && req_op_tag_valid_reg;
 
-            if (s_axis_read_desc_ready && s_axis_read_desc_valid) begin
+            if (s_axis_read_desc_ready_reg && desc_valid) begin
                 s_axis_read_desc_ready_next = 1'b0;
-                req_ram_sel_next = s_axis_read_desc_ram_sel;
-                req_pcie_addr_next = s_axis_read_desc_pcie_addr;
-                req_ram_addr_next = s_axis_read_desc_ram_addr;
-                if (s_axis_read_desc_len == 0) begin
+                req_ram_sel_next = desc_ram_sel;
+                req_pcie_addr_next = desc_pcie_addr;
+                req_ram_addr_next = desc_ram_addr;
+                if (desc_len == 0) begin
                     // zero-length operation
                     req_op_count_next = 1;
                     req_zero_len_next = 1'b1;
                 end else begin
-                    req_op_count_next = s_axis_read_desc_len;
+                    req_op_count_next = desc_len;
                     req_zero_len_next = 1'b0;
                 end
                 op_table_start_ptr = req_op_tag_reg;
-                op_table_start_tag = s_axis_read_desc_tag;
+                op_table_start_tag = desc_tag;
                 op_table_start_en = 1'b1;
                 inc_active_op = 1'b1;
                 req_state_next = REQ_STATE_START;
@@ -1385,6 +1662,11 @@ always @* begin
     pcie_tag_table_finish_ptr = pcie_tag_reg;
     pcie_tag_table_finish_en = 1'b0;
 
+    stat_rd_req_finish_tag_next = pcie_tag_reg;
+    stat_lat = stat_time_reg - pcie_tag_table_start_time[pcie_tag_reg];
+    stat_rd_req_finish_latency_next = stat_lat >> 16 != 0 ? 16'hffff : stat_lat[15:0];
+    stat_rd_req_finish_valid_next = 1'b0;
+
     pcie_tag_fifo_wr_tag = pcie_tag_reg;
     pcie_tag_fifo_1_we = 1'b0;
     pcie_tag_fifo_2_we = 1'b0;
@@ -1402,6 +1684,8 @@ always @* begin
         pcie_tag_table_finish_en = 1'b1;
         dec_active_tag = 1'b1;
 
+        stat_rd_req_finish_valid_next = 1'b1;
+
         pcie_tag_fifo_wr_tag = pcie_tag_reg;
         if (pcie_tag_fifo_wr_tag < PCIE_TAG_COUNT_1 || !PCIE_TAG_COUNT_2) begin
             pcie_tag_fifo_1_we = 1'b1;
@@ -1443,11 +1727,13 @@ always @* begin
     op_tag_fifo_wr_tag = status_fifo_rd_op_tag_reg;
     op_tag_fifo_we = 1'b0;
 
+    merge_status_fifo_we = 1'b0;
+
     if (init_op_tag_reg) begin
         // initialize FIFO
         op_tag_fifo_wr_tag = init_count_reg;
         op_tag_fifo_we = 1'b1;
-    end else if (status_fifo_rd_valid_reg && (status_fifo_rd_mask_reg & ~out_done) == 0) begin
+    end else if (status_fifo_rd_valid_reg && (status_fifo_rd_mask_reg & ~out_done) == 0 && (!MERGE_ENABLE || !merge_status_fifo_full)) begin
         // got write completion, pop and return status
         status_fifo_rd_valid_next = 1'b0;
         op_table_update_status_en = 1'b1;
@@ -1461,7 +1747,12 @@ always @* begin
             if (op_table_read_commit[op_table_read_finish_ptr] && (op_table_read_count_start[op_table_read_finish_ptr] == op_table_read_count_finish[op_table_read_finish_ptr])) begin
                 op_tag_fifo_we = 1'b1;
                 dec_active_op = 1'b1;
-                m_axis_read_desc_status_valid_next = 1'b1;
+                if (MERGE_ENABLE) begin
+                    // expand to one status per merged descriptor
+                    merge_status_fifo_we = 1'b1;
+                end else begin
+                    m_axis_read_desc_status_valid_next = 1'b1;
+                end
             end
         end
     end
@@ -1483,10 +1774,20 @@ always @(posedge clk) begin
         init_op_tag_reg <= init_count_reg + 1 < 2**OP_TAG_WIDTH;
     end
 
-    status_busy_reg <= active_op_count_reg != 0 || active_tx_count_reg != 0;
+    status_busy_reg <= active_op_count_reg != 0 || active_tx_count_reg != 0
+        || (MERGE_ENABLE && (!merge_in_fifo_empty || merge_valid_reg || !merge_status_fifo_empty));
     status_error_cor_reg <= status_error_cor_next;
     status_error_uncor_reg <= status_error_uncor_next;
 
+    stat_rd_req_finish_tag_reg <= stat_rd_req_finish_tag_next;
+    stat_rd_req_finish_latency_reg <= stat_rd_req_finish_latency_next;
+    stat_rd_req_finish_valid_reg <= stat_rd_req_finish_valid_next;
+    stat_rd_no_tags_reg <= stat_rd_no_tags_next;
+    stat_rd_fc_stall_reg <= stat_rd_fc_stall_next;
+    stat_rd_tx_limit_stall_reg <= stat_rd_tx_limit_stall_next;
+
+    stat_time_reg <= stat_time_reg + 1;
+
     req_pcie_addr_reg <= req_pcie_addr_next;
     req_ram_sel_reg <= req_ram_sel_next;
     req_ram_addr_reg <= req_ram_addr_next;
@@ -1593,6 +1894,7 @@ always @(posedge clk) begin
         pcie_tag_table_ram_addr[pcie_tag_table_start_ptr_reg] <= pcie_tag_table_start_ram_addr_reg;
         pcie_tag_table_op_tag[pcie_tag_table_start_ptr_reg] <= pcie_tag_table_start_op_tag_reg;
         pcie_tag_table_zero_len[pcie_tag_table_start_ptr_reg] <= pcie_tag_table_start_zero_len_reg;
+        pcie_tag_table_start_time[pcie_tag_table_start_ptr_reg] <= stat_time_reg;
         pcie_tag_table_active_a[pcie_tag_table_start_ptr_reg] <= !pcie_tag_table_active_b[pcie_tag_table_start_ptr_reg];
     end
 
@@ -1703,6 +2005,11 @@ always @(posedge clk) begin
         status_busy_reg <= 1'b0;
         status_error_cor_reg <= 1'b0;
         status_error_uncor_reg <= 1'b0;
+
+        stat_rd_req_finish_valid_reg <= 1'b0;
+        stat_rd_no_tags_reg <= 1'b0;
+        stat_rd_fc_stall_reg <= 1'b0;
+        stat_rd_tx_limit_stall_reg <= 1'b0;
     end
 end
 
@@ -66,7 +66,13 @@ module dma_if_pcie_us_wr #
     // In-flight transmit limit
     parameter TX_LIMIT = 2**(RQ_SEQ_NUM_WIDTH-1),
     // Transmit flow control
-    parameter TX_FC_ENABLE = 0
+    parameter TX_FC_ENABLE = 0,
+    // Merge address-contiguous write descriptors into max payload size TLPs
+    parameter COALESCE_ENABLE = 0,
+    // Cycles to hold an open coalescing group before sending it
+    parameter COALESCE_TIMEOUT = 16,
+    // Maximum number of descriptors merged into one operation
+    parameter COALESCE_MAX_COUNT = 16
 )
 (
     input  wire                                 clk,
@@ -175,6 +181,10 @@ parameter MASK_FIFO_ADDR_WIDTH = $clog2(OP_TABLE_SIZE)+1;
 
 parameter OP_TAG_WIDTH = $clog2(OP_TABLE_SIZE);
 
+parameter COAL_IN_FIFO_ADDR_WIDTH = 2;
+parameter COAL_TAG_FIFO_ADDR_WIDTH = $clog2(OP_TABLE_SIZE)+2;
+parameter COAL_COUNT_WIDTH = $clog2(COALESCE_MAX_COUNT+1);
+
 parameter OUTPUT_FIFO_ADDR_WIDTH = 5;
 
 // bus width assertions
@@ -247,6 +257,11 @@ initial begin
         $error("Error: RAM_ADDR_WIDTH does not match RAM configuration (instance %m)");
         $finish;
     end
+
+    if (COALESCE_ENABLE && (COALESCE_MAX_COUNT < 1 || TAG_WIDTH < COAL_COUNT_WIDTH)) begin
+        $error("Error: Tag width too narrow for coalescing count (instance %m)");
+        $finish;
+    end
 end
 
 localparam [3:0]
@@ -392,6 +407,54 @@ reg [SEG_COUNT-1:0] ram_rd_resp_ready_cmb;
 
 reg status_busy_reg = 1'b0;
 
+// write coalescing
+reg [COAL_IN_FIFO_ADDR_WIDTH+1-1:0] coal_in_fifo_wr_ptr_reg = 0, coal_in_fifo_wr_ptr_next;
+reg [COAL_IN_FIFO_ADDR_WIDTH+1-1:0] coal_in_fifo_rd_ptr_reg = 0, coal_in_fifo_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [PCIE_ADDR_WIDTH-1:0] coal_in_fifo_pcie_addr[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [RAM_SEL_WIDTH-1:0] coal_in_fifo_ram_sel[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [RAM_ADDR_WIDTH-1:0] coal_in_fifo_ram_addr[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [LEN_WIDTH-1:0] coal_in_fifo_len[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+reg coal_in_fifo_ready_reg = 1'b0, coal_in_fifo_ready_next;
+
+wire coal_in_fifo_empty = coal_in_fifo_wr_ptr_reg == coal_in_fifo_rd_ptr_reg;
+
+wire [PCIE_ADDR_WIDTH-1:0] coal_in_pcie_addr = coal_in_fifo_pcie_addr[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [RAM_SEL_WIDTH-1:0] coal_in_ram_sel = coal_in_fifo_ram_sel[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [RAM_ADDR_WIDTH-1:0] coal_in_ram_addr = coal_in_fifo_ram_addr[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [LEN_WIDTH-1:0] coal_in_len = coal_in_fifo_len[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+
+reg [PCIE_ADDR_WIDTH-1:0] coal_pcie_addr_reg = {PCIE_ADDR_WIDTH{1'b0}}, coal_pcie_addr_next;
+reg [RAM_SEL_WIDTH-1:0] coal_ram_sel_reg = {RAM_SEL_WIDTH{1'b0}}, coal_ram_sel_next;
+reg [RAM_ADDR_WIDTH-1:0] coal_ram_addr_reg = {RAM_ADDR_WIDTH{1'b0}}, coal_ram_addr_next;
+reg [LEN_WIDTH-1:0] coal_len_reg = {LEN_WIDTH{1'b0}}, coal_len_next;
+reg [COAL_COUNT_WIDTH-1:0] coal_count_reg = 0, coal_count_next;
+reg [15:0] coal_timer_reg = 16'd0, coal_timer_next;
+reg coal_flush_reg = 1'b0, coal_flush_next;
+reg coal_valid_reg = 1'b0, coal_valid_next;
+
+// original descriptor tags, in order, for status expansion
+reg [COAL_TAG_FIFO_ADDR_WIDTH+1-1:0] coal_tag_fifo_wr_ptr_reg = 0, coal_tag_fifo_wr_ptr_next;
+reg [COAL_TAG_FIFO_ADDR_WIDTH+1-1:0] coal_tag_fifo_rd_ptr_reg = 0, coal_tag_fifo_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [TAG_WIDTH-1:0] coal_tag_fifo_tag[(2**COAL_TAG_FIFO_ADDR_WIDTH)-1:0];
+
+reg [COAL_COUNT_WIDTH-1:0] coal_release_count;
+reg [COAL_TAG_FIFO_ADDR_WIDTH+1-1:0] coal_status_count_reg = 0, coal_status_count_next;
+reg [TAG_WIDTH-1:0] coal_status_tag_reg = {TAG_WIDTH{1'b0}}, coal_status_tag_next;
+reg coal_status_valid_reg = 1'b0, coal_status_valid_next;
+
+// descriptor input to TLP segmentation
+wire [PCIE_ADDR_WIDTH-1:0] desc_pcie_addr = COALESCE_ENABLE ? coal_pcie_addr_reg : s_axis_write_desc_pcie_addr;
+wire [RAM_SEL_WIDTH-1:0] desc_ram_sel = COALESCE_ENABLE ? coal_ram_sel_reg : s_axis_write_desc_ram_sel;
+wire [RAM_ADDR_WIDTH-1:0] desc_ram_addr = COALESCE_ENABLE ? coal_ram_addr_reg : s_axis_write_desc_ram_addr;
+wire [LEN_WIDTH-1:0] desc_len = COALESCE_ENABLE ? coal_len_reg : s_axis_write_desc_len;
+wire [TAG_WIDTH-1:0] desc_tag = COALESCE_ENABLE ? coal_count_reg : s_axis_write_desc_tag;
+wire desc_valid = COALESCE_ENABLE ? coal_valid_reg && coal_flush_reg : s_axis_write_desc_valid;
+
 // internal datapath
 reg  [AXIS_PCIE_DATA_WIDTH-1:0]    m_axis_rq_tdata_int;
 reg  [AXIS_PCIE_KEEP_WIDTH-1:0]    m_axis_rq_tkeep_int;
@@ -410,11 +473,11 @@ assign m_axis_rq_seq_num_valid_1 = s_axis_rq_seq_num_valid_1 && (s_axis_rq_seq_n
 wire axis_rq_seq_num_valid_0_int = s_axis_rq_seq_num_valid_0 && !(s_axis_rq_seq_num_0 & SEQ_NUM_FLAG);
 wire axis_rq_seq_num_valid_1_int = s_axis_rq_seq_num_valid_1 && !(s_axis_rq_seq_num_1 & SEQ_NUM_FLAG);
 
-assign s_axis_write_desc_ready = s_axis_write_desc_ready_reg;
+assign s_axis_write_desc_ready = COALESCE_ENABLE ? coal_in_fifo_ready_reg : s_axis_write_desc_ready_reg;
 
-assign m_axis_write_desc_status_tag = m_axis_write_desc_status_tag_reg;
+assign m_axis_write_desc_status_tag = COALESCE_ENABLE ? coal_status_tag_reg : m_axis_write_desc_status_tag_reg;
 assign m_axis_write_desc_status_error = 4'd0;
-assign m_axis_write_desc_status_valid = m_axis_write_desc_status_valid_reg;
+assign m_axis_write_desc_status_valid = COALESCE_ENABLE ? coal_status_valid_reg : m_axis_write_desc_status_valid_reg;
 
 assign ram_rd_cmd_sel = ram_rd_cmd_sel_reg;
 assign ram_rd_cmd_addr = ram_rd_cmd_addr_reg;
@@ -475,6 +538,139 @@ initial begin
     end
 end
 
+// Write coalescing
+//
+// Incoming descriptors are queued in a small FIFO and merged into a group
+// while each one starts where the previous one ended, both on the PCIe side
+// and in the RAM, and the group still fits in a single max payload size TLP.
+// A group is sent to TLP segmentation when the next descriptor cannot be
+// merged, when it is full, or COALESCE_TIMEOUT cycles after it was opened.
+// The group carries the number of merged descriptors in place of the tag;
+// the original tags are kept in order in the tag FIFO and one status is
+// returned for each of them when the group completes.
+wire coal_in_fifo_we = coal_in_fifo_ready_reg && s_axis_write_desc_valid;
+
+wire coal_merge = coal_in_len != 0 && coal_in_len <= {max_payload_size_dw_reg, 2'b00}
+    && coal_in_ram_sel == coal_ram_sel_reg
+    && coal_in_pcie_addr == coal_pcie_addr_reg + coal_len_reg
+    && coal_in_ram_addr == coal_ram_addr_reg + coal_len_reg
+    && coal_len_reg + coal_in_len <= {max_payload_size_dw_reg, 2'b00};
+
+always @* begin
+    coal_in_fifo_wr_ptr_next = coal_in_fifo_wr_ptr_reg;
+    coal_in_fifo_rd_ptr_next = coal_in_fifo_rd_ptr_reg;
+
+    coal_pcie_addr_next = coal_pcie_addr_reg;
+    coal_ram_sel_next = coal_ram_sel_reg;
+    coal_ram_addr_next = coal_ram_addr_reg;
+    coal_len_next = coal_len_reg;
+    coal_count_next = coal_count_reg;
+    coal_timer_next = coal_timer_reg;
+    coal_flush_next = coal_flush_reg;
+    coal_valid_next = coal_valid_reg;
+
+    coal_tag_fifo_wr_ptr_next = coal_tag_fifo_wr_ptr_reg;
+    coal_tag_fifo_rd_ptr_next = coal_tag_fifo_rd_ptr_reg;
+
+    coal_status_count_next = coal_status_count_reg + coal_release_count;
+    coal_status_tag_next = coal_status_tag_reg;
+    coal_status_valid_next = 1'b0;
+
+    if (coal_in_fifo_we) begin
+        coal_in_fifo_wr_ptr_next = coal_in_fifo_wr_ptr_reg + 1;
+        coal_tag_fifo_wr_ptr_next = coal_tag_fifo_wr_ptr_reg + 1;
+    end
+
+    if (s_axis_write_desc_ready_reg && desc_valid) begin
+        // group accepted by TLP segmentation
+        coal_valid_next = 1'b0;
+    end else if (coal_valid_reg && !coal_flush_reg) begin
+        // send open group on timeout
+        if (coal_timer_reg != 0) begin
+            coal_timer_next = coal_timer_reg - 1;
+        end else begin
+            coal_flush_next = 1'b1;
+        end
+    end
+
+    if (!coal_in_fifo_empty) begin
+        if (!coal_valid_next) begin
+            // start new group
+            coal_pcie_addr_next = coal_in_pcie_addr;
+            coal_ram_sel_next = coal_in_ram_sel;
+            coal_ram_addr_next = coal_in_ram_addr;
+            coal_len_next = coal_in_len;
+            coal_count_next = 1;
+            coal_timer_next = COALESCE_TIMEOUT;
+            coal_flush_next = coal_in_len == 0 || coal_in_len >= {max_payload_size_dw_reg, 2'b00} || COALESCE_MAX_COUNT == 1;
+            coal_valid_next = 1'b1;
+            coal_in_fifo_rd_ptr_next = coal_in_fifo_rd_ptr_reg + 1;
+        end else if (!coal_flush_reg && coal_merge) begin
+            // contiguous, extend group
+            coal_len_next = coal_len_reg + coal_in_len;
+            coal_count_next = coal_count_reg + 1;
+            coal_flush_next = coal_flush_next || coal_len_next >= {max_payload_size_dw_reg, 2'b00} || coal_count_next == COALESCE_MAX_COUNT;
+            coal_in_fifo_rd_ptr_next = coal_in_fifo_rd_ptr_reg + 1;
+        end else begin
+            // not contiguous, send group
+            coal_flush_next = 1'b1;
+        end
+    end
+
+    // one status per original descriptor
+    if (coal_status_count_reg != 0) begin
+        coal_status_tag_next = coal_tag_fifo_tag[coal_tag_fifo_rd_ptr_reg[COAL_TAG_FIFO_ADDR_WIDTH-1:0]];
+        coal_status_valid_next = 1'b1;
+        coal_tag_fifo_rd_ptr_next = coal_tag_fifo_rd_ptr_reg + 1;
+        coal_status_count_next = coal_status_count_next - 1;
+    end
+
+    coal_in_fifo_ready_next = coal_in_fifo_wr_ptr_next != (coal_in_fifo_rd_ptr_next ^ (1 << COAL_IN_FIFO_ADDR_WIDTH))
+        && coal_tag_fifo_wr_ptr_next != (coal_tag_fifo_rd_ptr_next ^ (1 << COAL_TAG_FIFO_ADDR_WIDTH));
+end
+
+always @(posedge clk) begin
+    coal_in_fifo_wr_ptr_reg <= coal_in_fifo_wr_ptr_next;
+    coal_in_fifo_rd_ptr_reg <= coal_in_fifo_rd_ptr_next;
+    coal_in_fifo_ready_reg <= COALESCE_ENABLE && coal_in_fifo_ready_next;
+
+    coal_pcie_addr_reg <= coal_pcie_addr_next;
+    coal_ram_sel_reg <= coal_ram_sel_next;
+    coal_ram_addr_reg <= coal_ram_addr_next;
+    coal_len_reg <= coal_len_next;
+    coal_count_reg <= coal_count_next;
+    coal_timer_reg <= coal_timer_next;
+    coal_flush_reg <= coal_flush_next;
+    coal_valid_reg <= coal_valid_next;
+
+    coal_tag_fifo_wr_ptr_reg <= coal_tag_fifo_wr_ptr_next;
+    coal_tag_fifo_rd_ptr_reg <= coal_tag_fifo_rd_ptr_next;
+
+    coal_status_count_reg <= coal_status_count_next;
+    coal_status_tag_reg <= coal_status_tag_next;
+    coal_status_valid_reg <= coal_status_valid_next;
+
+    if (coal_in_fifo_we) begin
+        coal_in_fifo_pcie_addr[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_pcie_addr;
+        coal_in_fifo_ram_sel[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_ram_sel;
+        coal_in_fifo_ram_addr[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_ram_addr;
+        coal_in_fifo_len[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_len;
+        coal_tag_fifo_tag[coal_tag_fifo_wr_ptr_reg[COAL_TAG_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_tag;
+    end
+
+    if (rst) begin
+        coal_in_fifo_wr_ptr_reg <= 0;
+        coal_in_fifo_rd_ptr_reg <= 0;
+        coal_in_fifo_ready_reg <= 1'b0;
+        coal_flush_reg <= 1'b0;
+        coal_valid_reg <= 1'b0;
+        coal_tag_fifo_wr_ptr_reg <= 0;
+        coal_tag_fifo_rd_ptr_reg <= 0;
+        coal_status_count_reg <= 0;
+        coal_status_valid_reg <= 1'b0;
+    end
+end
+
 always @* begin
     req_state_next = REQ_STATE_IDLE;
 
@@ -519,18 +715,18 @@ always @* begin
             // idle state, wait for incoming descriptor
             s_axis_write_desc_ready_next = !op_table_active[op_table_start_ptr_reg[OP_TAG_WIDTH-1:0]] && ($unsigned(op_table_start_ptr_reg - op_table_finish_ptr_reg) < 2**OP_TAG_WIDTH) && enable;
 
-            pcie_addr_next = s_axis_write_desc_pcie_addr;
-            ram_sel_next = s_axis_write_desc_ram_sel;
-            ram_addr_next = s_axis_write_desc_ram_addr;
-            if (s_axis_write_desc_len == 0) begin
+            pcie_addr_next = desc_pcie_addr;
+            ram_sel_next = desc_ram_sel;
+            ram_addr_next = desc_ram_addr;
+            if (desc_len == 0) begin
                 // zero-length operation
                 op_count_next = 1;
                 zero_len_next = 1'b1;
             end else begin
-                op_count_next = s_axis_write_desc_len;
+                op_count_next = desc_len;
                 zero_len_next = 1'b0;
             end
-            tag_next = s_axis_write_desc_tag;
+            tag_next = desc_tag;
 
             // TLP size computation
             if (op_count_next <= {max_payload_size_dw_reg, 2'b00}-pcie_addr_next[1:0]) begin
@@ -553,7 +749,7 @@ always @* begin
                 end
             end
 
-            if (s_axis_write_desc_ready & s_axis_write_desc_valid) begin
+            if (s_axis_write_desc_ready_reg & desc_valid) begin
                 s_axis_write_desc_ready_next = 1'b0;
                 req_state_next = REQ_STATE_START;
             end else begin
@@ -1187,6 +1383,8 @@ always @* begin
     m_axis_write_desc_status_tag_next = op_table_tag[op_table_finish_ptr_reg[OP_TAG_WIDTH-1:0]];
     m_axis_write_desc_status_valid_next = 1'b0;
 
+    coal_release_count = 0;
+
     op_table_finish_en = 1'b0;
 
     if (op_table_active[op_table_finish_ptr_reg[OP_TAG_WIDTH-1:0]] && (!RQ_SEQ_NUM_ENABLE || op_table_tx_done[op_table_finish_ptr_reg[OP_TAG_WIDTH-1:0]]) && op_table_finish_ptr_reg != op_table_tx_finish_ptr_reg) begin
@@ -1194,7 +1392,12 @@ always @* begin
         dec_active_op = 1'b1;
 
         if (op_table_last[op_table_finish_ptr_reg[OP_TAG_WIDTH-1:0]]) begin
-            m_axis_write_desc_status_valid_next = 1'b1;
+            if (COALESCE_ENABLE) begin
+                // tag holds the number of merged descriptors
+                coal_release_count = op_table_tag[op_table_finish_ptr_reg[OP_TAG_WIDTH-1:0]];
+            end else begin
+                m_axis_write_desc_status_valid_next = 1'b1;
+            end
         end
     end
 end
@@ -1246,7 +1449,8 @@ always @(posedge clk) begin
     read_cmd_last_cycle_reg <= read_cmd_last_cycle_next;
     read_cmd_valid_reg <= read_cmd_valid_next;
 
-    status_busy_reg <= active_op_count_reg != 0 || active_tx_count_reg != 0;
+    status_busy_reg <= active_op_count_reg != 0 || active_tx_count_reg != 0
+        || (COALESCE_ENABLE && (!coal_in_fifo_empty || coal_valid_reg || coal_status_count_reg != 0));
 
     tlp_header_data_reg <= tlp_header_data_next;
     tlp_header_valid_reg <= tlp_header_valid_next;
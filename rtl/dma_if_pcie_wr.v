@@ -74,7 +74,13 @@ module dma_if_pcie_wr #
     // In-flight transmit limit
     parameter TX_LIMIT = 2**TX_SEQ_NUM_WIDTH,
     // Force 64 bit address
-    parameter TLP_FORCE_64_BIT_ADDR = 0
+    parameter TLP_FORCE_64_BIT_ADDR = 0,
+    // Merge address-contiguous write descriptors into max payload size TLPs
+    parameter COALESCE_ENABLE = 0,
+    // Cycles to hold an open coalescing group before sending it
+    parameter COALESCE_TIMEOUT = 16,
+    // Maximum number of descriptors merged into one operation
+    parameter COALESCE_MAX_COUNT = 16
 )
 (
     input  wire                                          clk,
@@ -177,6 +183,10 @@ parameter MASK_FIFO_ADDR_WIDTH = $clog2(OP_TABLE_SIZE)+1;
 
 parameter OP_TAG_WIDTH = $clog2(OP_TABLE_SIZE);
 
+parameter COAL_IN_FIFO_ADDR_WIDTH = 2;
+parameter COAL_TAG_FIFO_ADDR_WIDTH = $clog2(OP_TABLE_SIZE)+2;
+parameter COAL_COUNT_WIDTH = $clog2(COALESCE_MAX_COUNT+1);
+
 parameter TX_COUNT_WIDTH = $clog2(TX_LIMIT+1);
 
 // bus width assertions
@@ -235,6 +245,11 @@ initial begin
         $error("Error: IMM_WIDTH must not be larger than the PCIe interface width (instance %m)");
         $finish;
     end
+
+    if (COALESCE_ENABLE && (COALESCE_MAX_COUNT < 1 || TAG_WIDTH < COAL_COUNT_WIDTH)) begin
+        $error("Error: Tag width too narrow for coalescing count (instance %m)");
+        $finish;
+    end
 end
 
 localparam [2:0]
@@ -356,6 +371,64 @@ reg [RAM_SEG_COUNT-1:0] ram_rd_resp_ready_cmb;
 
 reg status_busy_reg = 1'b0;
 
+// write coalescing
+reg [COAL_IN_FIFO_ADDR_WIDTH+1-1:0] coal_in_fifo_wr_ptr_reg = 0, coal_in_fifo_wr_ptr_next;
+reg [COAL_IN_FIFO_ADDR_WIDTH+1-1:0] coal_in_fifo_rd_ptr_reg = 0, coal_in_fifo_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [PCIE_ADDR_WIDTH-1:0] coal_in_fifo_pcie_addr[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [RAM_SEL_WIDTH-1:0] coal_in_fifo_ram_sel[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [RAM_ADDR_WIDTH-1:0] coal_in_fifo_ram_addr[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [IMM_WIDTH-1:0] coal_in_fifo_imm[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg coal_in_fifo_imm_en[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [LEN_WIDTH-1:0] coal_in_fifo_len[(2**COAL_IN_FIFO_ADDR_WIDTH)-1:0];
+reg coal_in_fifo_ready_reg = 1'b0, coal_in_fifo_ready_next;
+
+wire coal_in_fifo_empty = coal_in_fifo_wr_ptr_reg == coal_in_fifo_rd_ptr_reg;
+
+wire [PCIE_ADDR_WIDTH-1:0] coal_in_pcie_addr = coal_in_fifo_pcie_addr[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [RAM_SEL_WIDTH-1:0] coal_in_ram_sel = coal_in_fifo_ram_sel[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [RAM_ADDR_WIDTH-1:0] coal_in_ram_addr = coal_in_fifo_ram_addr[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [IMM_WIDTH-1:0] coal_in_imm = coal_in_fifo_imm[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+wire coal_in_imm_en = IMM_ENABLE && coal_in_fifo_imm_en[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+wire [LEN_WIDTH-1:0] coal_in_len = coal_in_fifo_len[coal_in_fifo_rd_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]];
+
+reg [PCIE_ADDR_WIDTH-1:0] coal_pcie_addr_reg = {PCIE_ADDR_WIDTH{1'b0}}, coal_pcie_addr_next;
+reg [RAM_SEL_WIDTH-1:0] coal_ram_sel_reg = {RAM_SEL_WIDTH{1'b0}}, coal_ram_sel_next;
+reg [RAM_ADDR_WIDTH-1:0] coal_ram_addr_reg = {RAM_ADDR_WIDTH{1'b0}}, coal_ram_addr_next;
+reg [IMM_WIDTH-1:0] coal_imm_reg = {IMM_WIDTH{1'b0}}, coal_imm_next;
+reg coal_imm_en_reg = 1'b0, coal_imm_en_next;
+reg [LEN_WIDTH-1:0] coal_len_reg = {LEN_WIDTH{1'b0}}, coal_len_next;
+reg [COAL_COUNT_WIDTH-1:0] coal_count_reg = 0, coal_count_next;
+reg [15:0] coal_timer_reg = 16'd0, coal_timer_next;
+reg coal_flush_reg = 1'b0, coal_flush_next;
+reg coal_valid_reg = 1'b0, coal_valid_next;
+
+// original descriptor tags, in order, for status expansion
+reg [COAL_TAG_FIFO_ADDR_WIDTH+1-1:0] coal_tag_fifo_wr_ptr_reg = 0, coal_tag_fifo_wr_ptr_next;
+reg [COAL_TAG_FIFO_ADDR_WIDTH+1-1:0] coal_tag_fifo_rd_ptr_reg = 0, coal_tag_fifo_rd_ptr_next;
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [TAG_WIDTH-1:0] coal_tag_fifo_tag[(2**COAL_TAG_FIFO_ADDR_WIDTH)-1:0];
+
+reg [COAL_COUNT_WIDTH-1:0] coal_release_count;
+reg [COAL_TAG_FIFO_ADDR_WIDTH+1-1:0] coal_status_count_reg = 0, coal_status_count_next;
+reg [TAG_WIDTH-1:0] coal_status_tag_reg = {TAG_WIDTH{1'b0}}, coal_status_tag_next;
+reg coal_status_valid_reg = 1'b0, coal_status_valid_next;
+
+// descriptor input to TLP segmentation
+wire [PCIE_ADDR_WIDTH-1:0] desc_pcie_addr = COALESCE_ENABLE ? coal_pcie_addr_reg : s_axis_write_desc_pcie_addr;
+wire [RAM_SEL_WIDTH-1:0] desc_ram_sel = COALESCE_ENABLE ? coal_ram_sel_reg : s_axis_write_desc_ram_sel;
+wire [RAM_ADDR_WIDTH-1:0] desc_ram_addr = COALESCE_ENABLE ? coal_ram_addr_reg : s_axis_write_desc_ram_addr;
+wire [IMM_WIDTH-1:0] desc_imm = COALESCE_ENABLE ? coal_imm_reg : s_axis_write_desc_imm;
+wire desc_imm_en = COALESCE_ENABLE ? coal_imm_en_reg : s_axis_write_desc_imm_en;
+wire [LEN_WIDTH-1:0] desc_len = COALESCE_ENABLE ? coal_len_reg : s_axis_write_desc_len;
+wire [TAG_WIDTH-1:0] desc_tag = COALESCE_ENABLE ? coal_count_reg : s_axis_write_desc_tag;
+wire desc_valid = COALESCE_ENABLE ? coal_valid_reg && coal_flush_reg : s_axis_write_desc_valid;
+
 reg [OP_TAG_WIDTH-1:0] stat_wr_op_start_tag_reg = 0, stat_wr_op_start_tag_next;
 reg [LEN_WIDTH-1:0] stat_wr_op_start_len_reg = 0, stat_wr_op_start_len_next;
 reg stat_wr_op_start_valid_reg = 1'b0, stat_wr_op_start_valid_next;
@@ -378,11 +451,11 @@ assign tx_wr_req_tlp_valid = tx_wr_req_tlp_valid_reg;
 assign tx_wr_req_tlp_sop = tx_wr_req_tlp_sop_reg;
 assign tx_wr_req_tlp_eop = tx_wr_req_tlp_eop_reg;
 
-assign s_axis_write_desc_ready = s_axis_write_desc_ready_reg;
+assign s_axis_write_desc_ready = COALESCE_ENABLE ? coal_in_fifo_ready_reg : s_axis_write_desc_ready_reg;
 
-assign m_axis_write_desc_status_tag = m_axis_write_desc_status_tag_reg;
+assign m_axis_write_desc_status_tag = COALESCE_ENABLE ? coal_status_tag_reg : m_axis_write_desc_status_tag_reg;
 assign m_axis_write_desc_status_error = 4'd0;
-assign m_axis_write_desc_status_valid = m_axis_write_desc_status_valid_reg;
+assign m_axis_write_desc_status_valid = COALESCE_ENABLE ? coal_status_valid_reg : m_axis_write_desc_status_valid_reg;
 
 assign ram_rd_cmd_sel = ram_rd_cmd_sel_reg;
 assign ram_rd_cmd_addr = ram_rd_cmd_addr_reg;
@@ -467,6 +540,148 @@ initial begin
     end
 end
 
+// Write coalescing
+//
+// Incoming descriptors are queued in a small FIFO and merged into a group
+// while each one starts where the previous one ended, both on the PCIe side
+// and in the RAM, and the group still fits in a single max payload size TLP.
+// A group is sent to TLP segmentation when the next descriptor cannot be
+// merged, when it is full, or COALESCE_TIMEOUT cycles after it was opened.
+// The group carries the number of merged descriptors in place of the tag;
+// the original tags are kept in order in the tag FIFO and one status is
+// returned for each of them when the group completes.
+wire coal_in_fifo_we = coal_in_fifo_ready_reg && s_axis_write_desc_valid;
+
+wire coal_merge = !coal_imm_en_reg && !coal_in_imm_en
+    && coal_in_len != 0 && coal_in_len <= {max_payload_size_dw_reg, 2'b00}
+    && coal_in_ram_sel == coal_ram_sel_reg
+    && coal_in_pcie_addr == coal_pcie_addr_reg + coal_len_reg
+    && coal_in_ram_addr == coal_ram_addr_reg + coal_len_reg
+    && coal_len_reg + coal_in_len <= {max_payload_size_dw_reg, 2'b00};
+
+always @* begin
+    coal_in_fifo_wr_ptr_next = coal_in_fifo_wr_ptr_reg;
+    coal_in_fifo_rd_ptr_next = coal_in_fifo_rd_ptr_reg;
+
+    coal_pcie_addr_next = coal_pcie_addr_reg;
+    coal_ram_sel_next = coal_ram_sel_reg;
+    coal_ram_addr_next = coal_ram_addr_reg;
+    coal_imm_next = coal_imm_reg;
+    coal_imm_en_next = coal_imm_en_reg;
+    coal_len_next = coal_len_reg;
+    coal_count_next = coal_count_reg;
+    coal_timer_next = coal_timer_reg;
+    coal_flush_next = coal_flush_reg;
+    coal_valid_next = coal_valid_reg;
+
+    coal_tag_fifo_wr_ptr_next = coal_tag_fifo_wr_ptr_reg;
+    coal_tag_fifo_rd_ptr_next = coal_tag_fifo_rd_ptr_reg;
+
+    coal_status_count_next = coal_status_count_reg + coal_release_count;
+    coal_status_tag_next = coal_status_tag_reg;
+    coal_status_valid_next = 1'b0;
+
+    if (coal_in_fifo_we) begin
+        coal_in_fifo_wr_ptr_next = coal_in_fifo_wr_ptr_reg + 1;
+        coal_tag_fifo_wr_ptr_next = coal_tag_fifo_wr_ptr_reg + 1;
+    end
+
+    if (s_axis_write_desc_ready_reg && desc_valid) begin
+        // group accepted by TLP segmentation
+        coal_valid_next = 1'b0;
+    end else if (coal_valid_reg && !coal_flush_reg) begin
+        // send open group on timeout
+        if (coal_timer_reg != 0) begin
+            coal_timer_next = coal_timer_reg - 1;
+        end else begin
+            coal_flush_next = 1'b1;
+        end
+    end
+
+    if (!coal_in_fifo_empty) begin
+        if (!coal_valid_next) begin
+            // start new group
+            coal_pcie_addr_next = coal_in_pcie_addr;
+            coal_ram_sel_next = coal_in_ram_sel;
+            coal_ram_addr_next = coal_in_ram_addr;
+            coal_imm_next = coal_in_imm;
+            coal_imm_en_next = coal_in_imm_en;
+            coal_len_next = coal_in_len;
+            coal_count_next = 1;
+            coal_timer_next = COALESCE_TIMEOUT;
+            coal_flush_next = coal_in_imm_en || coal_in_len == 0 || coal_in_len >= {max_payload_size_dw_reg, 2'b00} || COALESCE_MAX_COUNT == 1;
+            coal_valid_next = 1'b1;
+            coal_in_fifo_rd_ptr_next = coal_in_fifo_rd_ptr_reg + 1;
+        end else if (!coal_flush_reg && coal_merge) begin
+            // contiguous, extend group
+            coal_len_next = coal_len_reg + coal_in_len;
+            coal_count_next = coal_count_reg + 1;
+            coal_flush_next = coal_flush_next || coal_len_next >= {max_payload_size_dw_reg, 2'b00} || coal_count_next == COALESCE_MAX_COUNT;
+            coal_in_fifo_rd_ptr_next = coal_in_fifo_rd_ptr_reg + 1;
+        end else begin
+            // not contiguous, send group
+            coal_flush_next = 1'b1;
+        end
+    end
+
+    // one status per original descriptor
+    if (coal_status_count_reg != 0) begin
+        coal_status_tag_next = coal_tag_fifo_tag[coal_tag_fifo_rd_ptr_reg[COAL_TAG_FIFO_ADDR_WIDTH-1:0]];
+        coal_status_valid_next = 1'b1;
+        coal_tag_fifo_rd_ptr_next = coal_tag_fifo_rd_ptr_reg + 1;
+        coal_status_count_next = coal_status_count_next - 1;
+    end
+
+    coal_in_fifo_ready_next = coal_in_fifo_wr_ptr_next != (coal_in_fifo_rd_ptr_next ^ (1 << COAL_IN_FIFO_ADDR_WIDTH))
+        && coal_tag_fifo_wr_ptr_next != (coal_tag_fifo_rd_ptr_next ^ (1 << COAL_TAG_FIFO_ADDR_WIDTH));
+end
+
+always @(posedge clk) begin
+    coal_in_fifo_wr_ptr_reg <= coal_in_fifo_wr_ptr_next;
+    coal_in_fifo_rd_ptr_reg <= coal_in_fifo_rd_ptr_next;
+    coal_in_fifo_ready_reg <= COALESCE_ENABLE && coal_in_fifo_ready_next;
+
+    coal_pcie_addr_reg <= coal_pcie_addr_next;
+    coal_ram_sel_reg <= coal_ram_sel_next;
+    coal_ram_addr_reg <= coal_ram_addr_next;
+    coal_imm_reg <= coal_imm_next;
+    coal_imm_en_reg <= coal_imm_en_next;
+    coal_len_reg <= coal_len_next;
+    coal_count_reg <= coal_count_next;
+    coal_timer_reg <= coal_timer_next;
+    coal_flush_reg <= coal_flush_next;
+    coal_valid_reg <= coal_valid_next;
+
+    coal_tag_fifo_wr_ptr_reg <= coal_tag_fifo_wr_ptr_next;
+    coal_tag_fifo_rd_ptr_reg <= coal_tag_fifo_rd_ptr_next;
+
+    coal_status_count_reg <= coal_status_count_next;
+    coal_status_tag_reg <= coal_status_tag_next;
+    coal_status_valid_reg <= coal_status_valid_next;
+
+    if (coal_in_fifo_we) begin
+        coal_in_fifo_pcie_addr[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_pcie_addr;
+        coal_in_fifo_ram_sel[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_ram_sel;
+        coal_in_fifo_ram_addr[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_ram_addr;
+        coal_in_fifo_imm[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_imm;
+        coal_in_fifo_imm_en[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_imm_en;
+        coal_in_fifo_len[coal_in_fifo_wr_ptr_reg[COAL_IN_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_len;
+        coal_tag_fifo_tag[coal_tag_fifo_wr_ptr_reg[COAL_TAG_FIFO_ADDR_WIDTH-1:0]] <= s_axis_write_desc_tag;
+    end
+
+    if (rst) begin
+        coal_in_fifo_wr_ptr_reg <= 0;
+        coal_in_fifo_rd_ptr_reg <= 0;
+        coal_in_fifo_ready_reg <= 1'b0;
+        coal_flush_reg <= 1'b0;
+        coal_valid_reg <= 1'b0;
+        coal_tag_fifo_wr_ptr_reg <= 0;
+        coal_tag_fifo_rd_ptr_reg <= 0;
+        coal_status_count_reg <= 0;
+        coal_status_valid_reg <= 1'b0;
+    end
+end
+
 always @* begin
     req_state_next = REQ_STATE_IDLE;
 
@@ -522,25 +737,25 @@ always @* begin
             // idle state, wait for incoming descriptor
             s_axis_write_desc_ready_next = !op_table_active[op_table_start_ptr_reg[OP_TAG_WIDTH-1:0]] && ($unsigned(op_table_start_ptr_reg - op_table_finish_ptr_reg) < 2**OP_TAG_WIDTH) && enable;
 
-            pcie_addr_next = s_axis_write_desc_pcie_addr;
-            if (IMM_ENABLE && s_axis_write_desc_imm_en) begin
+            pcie_addr_next = desc_pcie_addr;
+            if (IMM_ENABLE && desc_imm_en) begin
                 ram_sel_next = 0;
                 ram_addr_next = 0;
             end else begin
-                ram_sel_next = s_axis_write_desc_ram_sel;
-                ram_addr_next = s_axis_write_desc_ram_addr;
+                ram_sel_next = desc_ram_sel;
+                ram_addr_next = desc_ram_addr;
             end
-            imm_next = s_axis_write_desc_imm;
-            imm_en_next = IMM_ENABLE && s_axis_write_desc_imm_en;
-            if (s_axis_write_desc_len == 0) begin
+            imm_next = desc_imm;
+            imm_en_next = IMM_ENABLE && desc_imm_en;
+            if (desc_len == 0) begin
                 // zero-length operation
                 op_count_next = 1;
                 zero_len_next = 1'b1;
             end else begin
-                op_count_next = s_axis_write_desc_len;
+                op_count_next = desc_len;
                 zero_len_next = 1'b0;
             end
-            tag_next = s_axis_write_desc_tag;
+            tag_next = desc_tag;
 
             // TLP size computation
             if (op_count_next <= {max_payload_size_dw_reg, 2'b00}-pcie_addr_next[1:0]) begin
@@ -563,9 +778,9 @@ always @* begin
                 end
             end
 
-            stat_wr_op_start_len_next = s_axis_write_desc_len;
+            stat_wr_op_start_len_next = desc_len;
 
-            if (s_axis_write_desc_ready & s_axis_write_desc_valid) begin
+            if (s_axis_write_desc_ready_reg & desc_valid) begin
                 stat_wr_op_start_tag_next = stat_wr_op_start_tag_reg+1;
                 stat_wr_op_start_valid_next = 1'b1;
 
@@ -1015,6 +1230,8 @@ always @* begin
     m_axis_write_desc_status_tag_next = op_table_tag[op_table_finish_ptr_reg[OP_TAG_WIDTH-1:0]];
     m_axis_write_desc_status_valid_next = 1'b0;
 
+    coal_release_count = 0;
+
     op_table_finish_en = 1'b0;
 
     stat_wr_req_finish_tag_next = op_table_finish_ptr_reg[OP_TAG_WIDTH-1:0];
@@ -1029,7 +1246,12 @@ always @* begin
             stat_wr_op_finish_tag_next = stat_wr_op_finish_tag_reg + 1;
             stat_wr_op_finish_valid_next = 1'b1;
 
-            m_axis_write_desc_status_valid_next = 1'b1;
+            if (COALESCE_ENABLE) begin
+                // tag holds the number of merged descriptors
+                coal_release_count = op_table_tag[op_table_finish_ptr_reg[OP_TAG_WIDTH-1:0]];
+            end else begin
+                m_axis_write_desc_status_valid_next = 1'b1;
+            end
         end
     end
 end
@@ -1129,7 +1351,8 @@ always @(posedge clk) begin
     ram_rd_cmd_addr_reg <= ram_rd_cmd_addr_next;
     ram_rd_cmd_valid_reg <= ram_rd_cmd_valid_next;
 
-    status_busy_reg <= active_op_count_reg != 0 || active_tx_count_reg != 0;
+    status_busy_reg <= active_op_count_reg != 0 || active_tx_count_reg != 0
+        || (COALESCE_ENABLE && (!coal_in_fifo_empty || coal_valid_reg || coal_status_count_reg != 0));
 
     stat_wr_op_start_tag_reg <= stat_wr_op_start_tag_next;
     stat_wr_op_start_len_reg <= stat_wr_op_start_len_next;
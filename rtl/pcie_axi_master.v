@@ -52,7 +52,13 @@ module pcie_axi_master #
     // Maximum AXI burst length to generate
     parameter AXI_MAX_BURST_LEN = 256,
     // Force 64 bit address
-    parameter TLP_FORCE_64_BIT_ADDR = 0
+    parameter TLP_FORCE_64_BIT_ADDR = 0,
+    // Enable read-ahead buffer
+    parameter PREFETCH_ENABLE = 0,
+    // Read-ahead line size in bytes
+    parameter PREFETCH_SIZE = 64,
+    // Read-ahead line lifetime in cycles (0 for no limit)
+    parameter PREFETCH_LIFETIME = 1024
 )
 (
     input  wire                                    clk,
@@ -133,6 +139,8 @@ module pcie_axi_master #
 
 wire [1:0] status_error_uncor_int;
 
+wire prefetch_invalidate;
+
 wire [TLP_SEG_COUNT*TLP_HDR_WIDTH-1:0]  read_rx_req_tlp_hdr;
 wire [TLP_SEG_COUNT-1:0]                read_rx_req_tlp_valid;
 wire [TLP_SEG_COUNT-1:0]                read_rx_req_tlp_sop;
@@ -173,6 +181,9 @@ assign read_rx_req_tlp_eop   = rx_req_tlp_eop & ~select_wr;
 // Ready from selected downstream module
 assign rx_req_tlp_ready = select_wr ? write_rx_req_tlp_ready : read_rx_req_tlp_ready;
 
+// Drop read-ahead data when a write request arrives and again when it completes
+assign prefetch_invalidate = (write_rx_req_tlp_valid[0] && write_rx_req_tlp_ready) || (m_axi_bvalid && m_axi_bready);
+
 // Frame register: track selected port across multi-beat TLPs
 always @(posedge clk) begin
     if (rx_req_tlp_valid && rx_req_tlp_ready) begin
@@ -198,7 +209,10 @@ pcie_axi_master_rd #(
     .AXI_STRB_WIDTH(AXI_STRB_WIDTH),
     .AXI_ID_WIDTH(AXI_ID_WIDTH),
     .AXI_MAX_BURST_LEN(AXI_MAX_BURST_LEN),
-    .TLP_FORCE_64_BIT_ADDR(TLP_FORCE_64_BIT_ADDR)
+    .TLP_FORCE_64_BIT_ADDR(TLP_FORCE_64_BIT_ADDR),
+    .PREFETCH_ENABLE(PREFETCH_ENABLE),
+    .PREFETCH_SIZE(PREFETCH_SIZE),
+    .PREFETCH_LIFETIME(PREFETCH_LIFETIME)
 )
 pcie_axi_master_rd_inst (
     .clk(clk),
@@ -244,6 +258,11 @@ pcie_axi_master_rd_inst (
     .m_axi_rvalid(m_axi_rvalid),
     .m_axi_rready(m_axi_rready),
 
+    /*
+     * Read-ahead control
+     */
+    .prefetch_invalidate(prefetch_invalidate),
+
     /*
      * Configuration
      */
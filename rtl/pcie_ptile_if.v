@@ -210,6 +210,7 @@ module pcie_ptile_if #
      * Configuration outputs
      */
     output wire [F_COUNT-1:0]                         ext_tag_enable,
+    output wire [F_COUNT-1:0]                         ten_bit_tag_enable,
     output wire [F_COUNT-1:0]                         rcb_128b,
     output wire [7:0]                                 bus_num,
     output wire [F_COUNT*3-1:0]                       max_read_request_size,
@@ -459,7 +460,7 @@ pcie_ptile_cfg_inst (
     .cfg_acs_p2p_req_redirect_en(),
     .cfg_acs_at_blocking_en(),
     .cfg_acs_validation_en(),
-    .cfg_10b_tag_req_en(),
+    .cfg_10b_tag_req_en(ten_bit_tag_enable),
     .cfg_vf_10b_tag_req_en(),
     .cfg_prs_response_failure(),
     .cfg_prs_uprgi(),
@@ -50,7 +50,13 @@ module pcie_us_axi_master #
     // Width of AXI ID signal
     parameter AXI_ID_WIDTH = 8,
     // Maximum AXI burst length to generate
-    parameter AXI_MAX_BURST_LEN = 256
+    parameter AXI_MAX_BURST_LEN = 256,
+    // Enable read-ahead buffer
+    parameter PREFETCH_ENABLE = 0,
+    // Read-ahead line size in bytes
+    parameter PREFETCH_SIZE = 64,
+    // Read-ahead line lifetime in cycles (0 for no limit)
+    parameter PREFETCH_LIFETIME = 1024
 )
 (
     input  wire                               clk,
@@ -148,6 +154,8 @@ wire [1:0] select;
 
 wire [1:0] status_error_uncor_int;
 
+wire prefetch_invalidate;
+
 pcie_us_axis_cq_demux #(
     .M_COUNT(2),
     .AXIS_PCIE_DATA_WIDTH(AXIS_PCIE_DATA_WIDTH),
@@ -186,6 +194,9 @@ cq_demux_inst (
 assign select[1] = req_type == 4'b0001;
 assign select[0] = ~select[1];
 
+// drop read-ahead data when a write request arrives and again when it completes
+assign prefetch_invalidate = (axis_cq_tvalid_write && axis_cq_tready_write) || (m_axi_bvalid && m_axi_bready);
+
 pcie_us_axi_master_rd #(
     .AXIS_PCIE_DATA_WIDTH(AXIS_PCIE_DATA_WIDTH),
     .AXIS_PCIE_KEEP_WIDTH(AXIS_PCIE_KEEP_WIDTH),
@@ -195,7 +206,10 @@ pcie_us_axi_master_rd #(
     .AXI_ADDR_WIDTH(AXI_ADDR_WIDTH),
     .AXI_STRB_WIDTH(AXI_STRB_WIDTH),
     .AXI_ID_WIDTH(AXI_ID_WIDTH),
-    .AXI_MAX_BURST_LEN(AXI_MAX_BURST_LEN)
+    .AXI_MAX_BURST_LEN(AXI_MAX_BURST_LEN),
+    .PREFETCH_ENABLE(PREFETCH_ENABLE),
+    .PREFETCH_SIZE(PREFETCH_SIZE),
+    .PREFETCH_LIFETIME(PREFETCH_LIFETIME)
 )
 pcie_us_axi_master_rd_inst (
     .clk(clk),
@@ -241,6 +255,11 @@ pcie_us_axi_master_rd_inst (
     .m_axi_rvalid(m_axi_rvalid),
     .m_axi_rready(m_axi_rready),
 
+    /*
+     * Read-ahead control
+     */
+    .prefetch_invalidate(prefetch_invalidate),
+
     /*
      * Configuration
      */
@@ -50,7 +50,13 @@ module pcie_us_axi_master_rd #
     // Width of AXI ID signal
     parameter AXI_ID_WIDTH = 8,
     // Maximum AXI burst length to generate
-    parameter AXI_MAX_BURST_LEN = 256
+    parameter AXI_MAX_BURST_LEN = 256,
+    // Enable read-ahead buffer
+    parameter PREFETCH_ENABLE = 0,
+    // Read-ahead line size in bytes
+    parameter PREFETCH_SIZE = 64,
+    // Read-ahead line lifetime in cycles (0 for no limit)
+    parameter PREFETCH_LIFETIME = 1024
 )
 (
     input  wire                               clk,
@@ -96,6 +102,11 @@ module pcie_us_axi_master_rd #
     input  wire                               m_axi_rvalid,
     output wire                               m_axi_rready,
 
+    /*
+     * Read-ahead control
+     */
+    input  wire                               prefetch_invalidate,
+
     /*
      * Configuration
      */
@@ -175,6 +186,18 @@ initial begin
         $error("Error: AXI max burst size must be at least 128 bytes (instance %m)");
         $finish;
     end
+
+    if (PREFETCH_ENABLE) begin
+        if (PREFETCH_SIZE < AXI_STRB_WIDTH || PREFETCH_SIZE > 4096 || 2**$clog2(PREFETCH_SIZE) != PREFETCH_SIZE) begin
+            $error("Error: PREFETCH_SIZE must be a power of two between the AXI data width in bytes and 4096 (instance %m)");
+            $finish;
+        end
+
+        if (PREFETCH_SIZE > AXI_MAX_BURST_SIZE) begin
+            $error("Error: PREFETCH_SIZE must not exceed AXI max burst size (instance %m)");
+            $finish;
+        end
+    end
 end
 
 localparam [3:0]
@@ -274,9 +297,57 @@ reg [7:0] m_axi_arlen_reg = 8'd0, m_axi_arlen_next;
 reg m_axi_arvalid_reg = 1'b0, m_axi_arvalid_next;
 reg m_axi_rready_reg = 1'b0, m_axi_rready_next;
 
+// read-ahead buffer
+localparam PF_BEATS = PREFETCH_SIZE/AXI_STRB_WIDTH > 0 ? PREFETCH_SIZE/AXI_STRB_WIDTH : 1;
+localparam PF_INDEX_WIDTH = PF_BEATS > 1 ? $clog2(PF_BEATS) : 1;
+localparam PF_LINE_SHIFT = $clog2(PF_BEATS*AXI_STRB_WIDTH);
+localparam PF_TIMER_WIDTH = PREFETCH_LIFETIME > 0 ? $clog2(PREFETCH_LIFETIME+1) : 1;
+localparam [AXI_ADDR_WIDTH-1:0] PF_LINE_MASK = {AXI_ADDR_WIDTH{1'b1}} << PF_LINE_SHIFT;
+
+localparam [1:0]
+    PF_STATE_IDLE = 2'd0,
+    PF_STATE_FILL = 2'd1,
+    PF_STATE_READ = 2'd2;
+
+reg [1:0] pf_state_reg = PF_STATE_IDLE, pf_state_next;
+
+reg [AXI_ADDR_WIDTH-1:0] pf_araddr_reg = {AXI_ADDR_WIDTH{1'b0}}, pf_araddr_next;
+reg [7:0] pf_arlen_reg = 8'd0, pf_arlen_next;
+reg pf_arvalid_reg = 1'b0, pf_arvalid_next;
+
+reg [AXI_ADDR_WIDTH-1:0] pf_line_addr_reg = {AXI_ADDR_WIDTH{1'b0}}, pf_line_addr_next;
+reg pf_line_valid_reg = 1'b0, pf_line_valid_next;
+reg pf_line_inval_reg = 1'b0, pf_line_inval_next;
+reg [PF_TIMER_WIDTH-1:0] pf_line_timer_reg = {PF_TIMER_WIDTH{1'b0}}, pf_line_timer_next;
+reg [PF_INDEX_WIDTH-1:0] pf_fill_index_reg = {PF_INDEX_WIDTH{1'b0}}, pf_fill_index_next;
+reg [PF_INDEX_WIDTH-1:0] pf_read_index_reg = {PF_INDEX_WIDTH{1'b0}}, pf_read_index_next;
+reg [7:0] pf_read_count_reg = 8'd0, pf_read_count_next;
+reg [7:0] pf_pass_count_reg = 8'd0, pf_pass_count_next;
+
+// buffered line
+(* ram_style = "distributed", ramstyle = "no_rw_check, mlab" *)
+reg [AXI_DATA_WIDTH-1:0] pf_data_mem[(2**PF_INDEX_WIDTH)-1:0];
+
+reg pf_data_wr_en;
+reg pf_pass_start;
+reg pf_pass_finish;
+
+reg pf_arready;
+reg pf_rvalid;
+reg pf_rready;
+
+wire [PF_INDEX_WIDTH-1:0] pf_req_index = (m_axi_araddr_reg >> AXI_BURST_SIZE) & (PF_BEATS-1);
+wire pf_req_fit = pf_req_index + m_axi_arlen_reg < PF_BEATS;
+wire pf_req_hit = pf_line_valid_reg && !prefetch_invalidate && (m_axi_araddr_reg & PF_LINE_MASK) == pf_line_addr_reg;
+
+// internal AXI read interface (through the read-ahead buffer when enabled)
+wire                      m_axi_arready_int = PREFETCH_ENABLE ? pf_arready : m_axi_arready;
+wire [AXI_DATA_WIDTH-1:0] m_axi_rdata_int = PREFETCH_ENABLE && pf_state_reg == PF_STATE_READ ? pf_data_mem[pf_read_index_reg] : m_axi_rdata;
+wire                      m_axi_rvalid_int = PREFETCH_ENABLE ? pf_rvalid : m_axi_rvalid;
+
 reg [AXI_DATA_WIDTH-1:0] save_axi_rdata_reg = {AXI_DATA_WIDTH{1'b0}};
 
-wire [AXI_DATA_WIDTH-1:0] shift_axi_rdata = {m_axi_rdata, save_axi_rdata_reg} >> ((AXI_STRB_WIDTH/4-offset_reg)*32);
+wire [AXI_DATA_WIDTH-1:0] shift_axi_rdata = {m_axi_rdata_int, save_axi_rdata_reg} >> ((AXI_STRB_WIDTH/4-offset_reg)*32);
 
 reg status_error_cor_reg = 1'b0, status_error_cor_next;
 reg status_error_uncor_reg = 1'b0, status_error_uncor_next;
@@ -293,15 +364,15 @@ wire                               m_axis_cc_tready_int_early;
 assign s_axis_cq_tready = s_axis_cq_tready_reg;
 
 assign m_axi_arid = {AXI_ID_WIDTH{1'b0}};
-assign m_axi_araddr = m_axi_araddr_reg;
-assign m_axi_arlen = m_axi_arlen_reg;
+assign m_axi_araddr = PREFETCH_ENABLE ? pf_araddr_reg : m_axi_araddr_reg;
+assign m_axi_arlen = PREFETCH_ENABLE ? pf_arlen_reg : m_axi_arlen_reg;
 assign m_axi_arsize = AXI_BURST_SIZE;
 assign m_axi_arburst = 2'b01;
 assign m_axi_arlock = 1'b0;
 assign m_axi_arcache = 4'b0011;
 assign m_axi_arprot = 3'b010;
-assign m_axi_arvalid = m_axi_arvalid_reg;
-assign m_axi_rready = m_axi_rready_reg;
+assign m_axi_arvalid = PREFETCH_ENABLE ? pf_arvalid_reg : m_axi_arvalid_reg;
+assign m_axi_rready = PREFETCH_ENABLE ? pf_rready : m_axi_rready_reg;
 
 assign status_error_cor = status_error_cor_reg;
 assign status_error_uncor = status_error_uncor_reg;
@@ -345,7 +416,7 @@ always @* begin
 
     m_axi_araddr_next = m_axi_araddr_reg;
     m_axi_arlen_next = m_axi_arlen_reg;
-    m_axi_arvalid_next = m_axi_arvalid_reg && !m_axi_arready;
+    m_axi_arvalid_next = m_axi_arvalid_reg && !m_axi_arready_int;
 
     axi_addr_next = axi_addr_reg;
     op_count_next = op_count_reg;
@@ -499,7 +570,7 @@ always @* begin
         end
         AXI_STATE_START: begin
             // start state, compute TLP length
-            if (!tlp_cmd_valid_reg && !m_axi_arvalid) begin
+            if (!tlp_cmd_valid_reg && !m_axi_arvalid_reg) begin
                 if (op_dword_count_reg <= max_payload_size_dw_reg) begin
                     // packet smaller than max payload size
                     // assumed to not cross 4k boundary, send one TLP
@@ -710,8 +781,8 @@ always @* begin
             end else begin
                 m_axi_rready_next = m_axis_cc_tready_int_early && input_active_reg;
 
-                if (m_axis_cc_tready_int_reg && ((m_axi_rready && m_axi_rvalid) || !input_active_reg)) begin
-                    transfer_in_save = m_axi_rready && m_axi_rvalid;
+                if (m_axis_cc_tready_int_reg && ((m_axi_rready_reg && m_axi_rvalid_int) || !input_active_reg)) begin
+                    transfer_in_save = m_axi_rready_reg && m_axi_rvalid_int;
 
                     if (AXIS_PCIE_DATA_WIDTH >= 256 && bubble_cycle_reg) begin
                         // bubble cycle; store input data and update input cycle count
@@ -794,8 +865,8 @@ always @* begin
             m_axis_cc_tdata_int[31] = 1'b0; // force ECRC
             m_axis_cc_tdata_int[63:32] = shift_axi_rdata[63:32];
 
-            if (m_axis_cc_tready_int_reg && ((m_axi_rready && m_axi_rvalid) || !input_active_reg)) begin
-                transfer_in_save = m_axi_rready && m_axi_rvalid;
+            if (m_axis_cc_tready_int_reg && ((m_axi_rready_reg && m_axi_rvalid_int) || !input_active_reg)) begin
+                transfer_in_save = m_axi_rready_reg && m_axi_rvalid_int;
 
                 // some data is transferred with header
                 dword_count_next = dword_count_reg - 1;
@@ -855,7 +926,7 @@ always @* begin
             // transfer state, transfer data
             m_axi_rready_next = m_axis_cc_tready_int_early && input_active_reg;
 
-            if (m_axis_cc_tready_int_reg && ((m_axi_rready && m_axi_rvalid) || !input_active_reg)) begin
+            if (m_axis_cc_tready_int_reg && ((m_axi_rready_reg && m_axi_rvalid_int) || !input_active_reg)) begin
                 transfer_in_save = 1'b1;
 
                 if (bubble_cycle_reg) begin
@@ -1096,7 +1167,161 @@ always @(posedge clk) begin
     max_payload_size_dw_reg <= 11'd32 << (max_payload_size > PAYLOAD_MAX ? PAYLOAD_MAX : max_payload_size);
 
     if (transfer_in_save) begin
-        save_axi_rdata_reg <= m_axi_rdata;
+        save_axi_rdata_reg <= m_axi_rdata_int;
+    end
+end
+
+// read-ahead buffer
+// Reads that fit within one aligned line are widened to a burst for the whole
+// line, and later reads that hit the line are returned from the buffer without
+// an AXI read.  Other reads pass straight through.  The line is dropped on
+// prefetch_invalidate and, if PREFETCH_LIFETIME is nonzero, after that many
+// cycles so that data changed behind the buffer is not served indefinitely.
+always @* begin
+    pf_state_next = PF_STATE_IDLE;
+
+    pf_araddr_next = pf_araddr_reg;
+    pf_arlen_next = pf_arlen_reg;
+    pf_arvalid_next = pf_arvalid_reg && !m_axi_arready;
+
+    pf_line_addr_next = pf_line_addr_reg;
+    pf_line_valid_next = pf_line_valid_reg;
+    pf_line_inval_next = pf_line_inval_reg;
+    pf_line_timer_next = pf_line_timer_reg;
+    pf_fill_index_next = pf_fill_index_reg;
+    pf_read_index_next = pf_read_index_reg;
+    pf_read_count_next = pf_read_count_reg;
+
+    pf_data_wr_en = 1'b0;
+    pf_pass_start = 1'b0;
+    pf_pass_finish = 1'b0;
+
+    pf_arready = 1'b0;
+    pf_rvalid = 1'b0;
+    pf_rready = 1'b0;
+
+    if (PREFETCH_LIFETIME > 0 && pf_line_valid_reg) begin
+        if (pf_line_timer_reg == 0) begin
+            pf_line_valid_next = 1'b0;
+        end else begin
+            pf_line_timer_next = pf_line_timer_reg - 1;
+        end
+    end
+
+    case (pf_state_reg)
+        PF_STATE_IDLE: begin
+            // pass through read data
+            pf_rvalid = m_axi_rvalid;
+            pf_rready = m_axi_rready_reg;
+            pf_pass_finish = m_axi_rready_reg && m_axi_rvalid && m_axi_rlast;
+
+            if (m_axi_arvalid_reg && (!pf_arvalid_reg || m_axi_arready)) begin
+                if (pf_req_fit) begin
+                    // wait for pass-through reads to complete to keep data in order
+                    if (pf_pass_count_reg == 0) begin
+                        pf_arready = 1'b1;
+                        pf_read_index_next = pf_req_index;
+                        pf_read_count_next = m_axi_arlen_reg;
+                        if (pf_req_hit) begin
+                            // hit; return data from buffer
+                            pf_state_next = PF_STATE_READ;
+                        end else begin
+                            // miss; read whole line
+                            pf_araddr_next = m_axi_araddr_reg & PF_LINE_MASK;
+                            pf_arlen_next = PF_BEATS-1;
+                            pf_arvalid_next = 1'b1;
+                            pf_line_addr_next = m_axi_araddr_reg & PF_LINE_MASK;
+                            pf_line_valid_next = 1'b0;
+                            pf_line_inval_next = 1'b0;
+                            pf_fill_index_next = 0;
+                            pf_state_next = PF_STATE_FILL;
+                        end
+                    end else begin
+                        pf_state_next = PF_STATE_IDLE;
+                    end
+                end else begin
+                    // pass through
+                    pf_arready = 1'b1;
+                    pf_araddr_next = m_axi_araddr_reg;
+                    pf_arlen_next = m_axi_arlen_reg;
+                    pf_arvalid_next = 1'b1;
+                    pf_pass_start = 1'b1;
+                    pf_state_next = PF_STATE_IDLE;
+                end
+            end else begin
+                pf_state_next = PF_STATE_IDLE;
+            end
+        end
+        PF_STATE_FILL: begin
+            // store line in buffer
+            pf_rready = 1'b1;
+
+            if (m_axi_rvalid) begin
+                pf_data_wr_en = 1'b1;
+                pf_fill_index_next = pf_fill_index_reg + 1;
+                if (m_axi_rlast) begin
+                    pf_line_valid_next = !pf_line_inval_reg;
+                    pf_line_timer_next = PREFETCH_LIFETIME;
+                    pf_state_next = PF_STATE_READ;
+                end else begin
+                    pf_state_next = PF_STATE_FILL;
+                end
+            end else begin
+                pf_state_next = PF_STATE_FILL;
+            end
+        end
+        PF_STATE_READ: begin
+            // return requested beats from buffer
+            pf_rvalid = 1'b1;
+
+            if (m_axi_rready_reg) begin
+                pf_read_index_next = pf_read_index_reg + 1;
+                pf_read_count_next = pf_read_count_reg - 1;
+                if (pf_read_count_reg == 0) begin
+                    pf_state_next = PF_STATE_IDLE;
+                end else begin
+                    pf_state_next = PF_STATE_READ;
+                end
+            end else begin
+                pf_state_next = PF_STATE_READ;
+            end
+        end
+    endcase
+
+    pf_pass_count_next = pf_pass_count_reg + pf_pass_start - pf_pass_finish;
+
+    if (prefetch_invalidate) begin
+        // also covers a line fill that is still in progress
+        pf_line_valid_next = 1'b0;
+        pf_line_inval_next = 1'b1;
+    end
+end
+
+always @(posedge clk) begin
+    pf_state_reg <= pf_state_next;
+
+    pf_araddr_reg <= pf_araddr_next;
+    pf_arlen_reg <= pf_arlen_next;
+    pf_arvalid_reg <= pf_arvalid_next;
+
+    pf_line_addr_reg <= pf_line_addr_next;
+    pf_line_valid_reg <= pf_line_valid_next;
+    pf_line_inval_reg <= pf_line_inval_next;
+    pf_line_timer_reg <= pf_line_timer_next;
+    pf_fill_index_reg <= pf_fill_index_next;
+    pf_read_index_reg <= pf_read_index_next;
+    pf_read_count_reg <= pf_read_count_next;
+    pf_pass_count_reg <= pf_pass_count_next;
+
+    if (pf_data_wr_en) begin
+        pf_data_mem[pf_fill_index_reg] <= m_axi_rdata;
+    end
+
+    if (rst || !PREFETCH_ENABLE) begin
+        pf_state_reg <= PF_STATE_IDLE;
+        pf_arvalid_reg <= 1'b0;
+        pf_line_valid_reg <= 1'b0;
+        pf_pass_count_reg <= 8'd0;
     end
 end
 
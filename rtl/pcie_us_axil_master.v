@@ -178,17 +178,18 @@ localparam [2:0]
     CPL_STATUS_CRS = 3'b010, // configuration request retry status
     CPL_STATUS_CA  = 3'b100; // completer abort
 
-localparam [2:0]
-    STATE_IDLE = 3'd0,
-    STATE_HEADER = 3'd1,
-    STATE_READ = 3'd2,
-    STATE_WRITE_1 = 3'd3,
-    STATE_WRITE_2 = 3'd4,
-    STATE_WAIT_END = 3'd5,
-    STATE_CPL_1 = 3'd6,
-    STATE_CPL_2 = 3'd7;
-
-reg [2:0] state_reg = STATE_IDLE, state_next;
+localparam [3:0]
+    STATE_IDLE = 4'd0,
+    STATE_HEADER = 4'd1,
+    STATE_READ = 4'd2,
+    STATE_WRITE_1 = 4'd3,
+    STATE_WRITE_2 = 4'd4,
+    STATE_WRITE_3 = 4'd5,
+    STATE_WAIT_END = 4'd6,
+    STATE_CPL_1 = 4'd7,
+    STATE_CPL_2 = 4'd8;
+
+reg [3:0] state_reg = STATE_IDLE, state_next;
 
 reg [10:0] dword_count_reg = 11'd0, dword_count_next;
 reg [3:0] type_reg = 4'd0, type_next;
@@ -201,6 +202,10 @@ reg [3:0] first_be_reg = 4'd0, first_be_next;
 reg [3:0] last_be_reg = 4'd0, last_be_next;
 reg cpl_data_reg = 1'b0, cpl_data_next;
 
+reg [AXIS_PCIE_DATA_WIDTH-1:0] cq_data_reg = {AXIS_PCIE_DATA_WIDTH{1'b0}}, cq_data_next;
+reg cq_last_reg = 1'b0, cq_last_next;
+reg [3:0] dword_ptr_reg = 4'd0, dword_ptr_next;
+
 reg s_axis_cq_tready_reg = 1'b0, s_axis_cq_tready_next;
 
 reg [AXI_ADDR_WIDTH-1:0] m_axil_addr_reg = {AXI_ADDR_WIDTH{1'b0}}, m_axil_addr_next;
@@ -257,6 +262,10 @@ always @* begin
     last_be_next = last_be_reg;
     cpl_data_next = cpl_data_reg;
 
+    cq_data_next = cq_data_reg;
+    cq_last_next = cq_last_reg;
+    dword_ptr_next = dword_ptr_reg;
+
     m_axis_cc_tdata_int = {AXIS_PCIE_DATA_WIDTH{1'b0}};
     m_axis_cc_tkeep_int = {AXIS_PCIE_KEEP_WIDTH{1'b0}};
     m_axis_cc_tvalid_int = 1'b0;
@@ -339,6 +348,9 @@ always @* begin
             s_axis_cq_tready_next = m_axis_cc_tready_int_early;
 
             if (s_axis_cq_tready && s_axis_cq_tvalid) begin
+                cq_data_next = s_axis_cq_tdata;
+                cq_last_next = s_axis_cq_tlast;
+
                 // header fields
                 m_axil_addr_next = {s_axis_cq_tdata[63:2], 2'b00};
                 if (AXIS_PCIE_DATA_WIDTH > 64) begin
@@ -409,6 +421,21 @@ always @* begin
                         end else if (AXIS_PCIE_DATA_WIDTH < 256 && dword_count_next == 11'd1) begin
                             s_axis_cq_tready_next = 1'b1;
                             state_next = STATE_WRITE_1;
+                        end else if (type_next == REQ_MEM_WRITE && dword_count_next > 11'd1) begin
+                            // burst write, one AXI lite write per dword
+                            if (AXIS_PCIE_DATA_WIDTH >= 256) begin
+                                // first dword follows header
+                                dword_ptr_next = 4'd5;
+                                m_axil_awvalid_next = 1'b1;
+                                m_axil_wvalid_next = 1'b1;
+                                m_axil_bready_next = 1'b1;
+                                s_axis_cq_tready_next = 1'b0;
+                                state_next = STATE_WRITE_2;
+                            end else begin
+                                dword_ptr_next = 4'd0;
+                                s_axis_cq_tready_next = 1'b1;
+                                state_next = STATE_WRITE_3;
+                            end
                         end else begin
                             // bad length
                             status_next = CPL_STATUS_CA; // completer abort
@@ -484,6 +511,8 @@ always @* begin
             m_axil_wstrb_next = first_be_reg;
 
             if (s_axis_cq_tready && s_axis_cq_tvalid) begin
+                cq_last_next = s_axis_cq_tlast;
+
                 if (type_next == REQ_MEM_READ || type_next == REQ_IO_READ) begin
                     // read request
                     if (s_axis_cq_tlast && dword_count_next == 11'd1) begin
@@ -509,6 +538,11 @@ always @* begin
                     if (dword_count_next == 11'd1) begin
                         s_axis_cq_tready_next = 1'b1;
                         state_next = STATE_WRITE_1;
+                    end else if (type_next == REQ_MEM_WRITE && dword_count_next > 11'd1) begin
+                        // burst write, one AXI lite write per dword
+                        dword_ptr_next = 4'd0;
+                        s_axis_cq_tready_next = 1'b1;
+                        state_next = STATE_WRITE_3;
                     end else begin
                         // bad length
                         status_next = CPL_STATUS_CA; // completer abort
@@ -619,6 +653,8 @@ always @* begin
             m_axil_wdata_next = s_axis_cq_tdata[31:0];
 
             if (s_axis_cq_tready && s_axis_cq_tvalid) begin
+                cq_last_next = s_axis_cq_tlast;
+
                 if (s_axis_cq_tlast) begin
                     m_axil_awvalid_next = 1'b1;
                     m_axil_wvalid_next = 1'b1;
@@ -639,10 +675,22 @@ always @* begin
 
             if (m_axil_bready && m_axil_bvalid) begin
                 m_axil_bready_next = 1'b0;
-                if (type_reg == REQ_MEM_WRITE) begin
+                if (type_reg == REQ_MEM_WRITE && dword_count_reg > 11'd1) begin
+                    // burst write, move on to next dword
+                    dword_count_next = dword_count_reg - 1;
+                    m_axil_addr_next = {m_axil_addr_reg[AXI_ADDR_WIDTH-1:2]+1'b1, 2'b00};
+                    m_axil_wstrb_next = dword_count_next == 11'd1 ? last_be_reg : 4'b1111;
+                    state_next = STATE_WRITE_3;
+                end else if (type_reg == REQ_MEM_WRITE) begin
                     // memory write - posted, no completion
-                    s_axis_cq_tready_next = m_axis_cc_tready_int_early;
-                    state_next = STATE_IDLE;
+                    if (cq_last_reg) begin
+                        s_axis_cq_tready_next = m_axis_cc_tready_int_early;
+                        state_next = STATE_IDLE;
+                    end else begin
+                        // drop any trailing data
+                        s_axis_cq_tready_next = 1'b1;
+                        state_next = STATE_WAIT_END;
+                    end
                 end else begin
                     // IO write - non-posted, send completion
                     m_axis_cc_tvalid_int = 1'b1;
@@ -681,6 +729,47 @@ always @* begin
                 state_next = STATE_WRITE_2;
             end
         end
+        STATE_WRITE_3: begin
+            // write 3 state, issue next dword of burst write
+            if (dword_ptr_reg == 0) begin
+                // next data beat
+                m_axil_wdata_next = s_axis_cq_tdata[31:0];
+
+                if (cq_last_reg) begin
+                    // truncated packet
+                    // report uncorrectable error
+                    status_error_uncor_next = 1'b1;
+                    s_axis_cq_tready_next = m_axis_cc_tready_int_early;
+                    state_next = STATE_IDLE;
+                end else if (s_axis_cq_tready && s_axis_cq_tvalid) begin
+                    cq_data_next = s_axis_cq_tdata;
+                    cq_last_next = s_axis_cq_tlast;
+                    dword_ptr_next = 4'd1;
+
+                    m_axil_awvalid_next = 1'b1;
+                    m_axil_wvalid_next = 1'b1;
+                    m_axil_bready_next = 1'b1;
+                    s_axis_cq_tready_next = 1'b0;
+                    state_next = STATE_WRITE_2;
+                end else begin
+                    s_axis_cq_tready_next = 1'b1;
+                    state_next = STATE_WRITE_3;
+                end
+            end else begin
+                // next dword from current beat
+                m_axil_wdata_next = cq_data_reg[dword_ptr_reg*32 +: 32];
+                if (dword_ptr_reg == AXIS_PCIE_DATA_WIDTH/32-1) begin
+                    dword_ptr_next = 4'd0;
+                end else begin
+                    dword_ptr_next = dword_ptr_reg + 1;
+                end
+
+                m_axil_awvalid_next = 1'b1;
+                m_axil_wvalid_next = 1'b1;
+                m_axil_bready_next = 1'b1;
+                state_next = STATE_WRITE_2;
+            end
+        end
         STATE_WAIT_END: begin
             // wait end state, wait for end of completion request
             s_axis_cq_tready_next = 1'b1;
@@ -836,6 +925,10 @@ always @(posedge clk) begin
     last_be_reg <= last_be_next;
     cpl_data_reg <= cpl_data_next;
 
+    cq_data_reg <= cq_data_next;
+    cq_last_reg <= cq_last_next;
+    dword_ptr_reg <= dword_ptr_next;
+
     m_axil_addr_reg <= m_axil_addr_next;
     m_axil_wdata_reg <= m_axil_wdata_next;
     m_axil_wstrb_reg <= m_axil_wstrb_next;
@@ -0,0 +1,35 @@
+#!/bin/bash
+
+dev=$1
+en=$2
+
+if [ -z "$dev" ]; then
+    echo "Error: no device specified"
+    exit 1
+fi
+
+if [ -z "$en" ]; then
+    echo "Error: must specify operation"
+    exit 1
+fi
+
+if [ ! -e "/sys/bus/pci/devices/$dev" ]; then
+    dev="0000:$dev"
+fi
+
+if [ ! -e "/sys/bus/pci/devices/$dev" ]; then
+    echo "Error: device $dev not found"
+    exit 1
+fi
+
+echo "Device control 2:" $(setpci -s $dev CAP_EXP+28.w)
+
+if (($en > 0)); then
+    echo "Enabling 10-bit tag on $dev..."
+    setpci -s $dev CAP_EXP+28.w=1000:1000
+else
+    echo "Disabling 10-bit tag on $dev..."
+    setpci -s $dev CAP_EXP+28.w=0000:1000
+fi
+
+echo "Device control 2:" $(setpci -s $dev CAP_EXP+28.w)
@@ -100,6 +100,9 @@ class TB(object):
         self.read_desc_status_sink = DescStatusSink(DescStatusBus.from_prefix(dut, "m_axis_read_desc_status"), dut.clk, dut.rst)
 
         dut.requester_id.setimmediatevalue(0)
+        dut.ten_bit_tag_enable.setimmediatevalue(int(os.getenv("PARAM_PCIE_TAG_COUNT", "256")) > 256)
+        dut.cplh_fc_limit.setimmediatevalue(0)
+        dut.cpld_fc_limit.setimmediatevalue(0)
 
         dut.enable.setimmediatevalue(0)
 
@@ -277,6 +280,194 @@ async def run_test_read_errors(dut, idle_inserter=None, backpressure_inserter=No
     await RisingEdge(dut.clk)
 
 
+async def run_test_read_burst(dut, idle_inserter=None, backpressure_inserter=None):
+
+    tb = TB(dut)
+
+    byte_lanes = tb.dma_ram.byte_lanes
+    tag_count = 2**len(tb.read_desc_source.bus.tag)
+    merge = int(os.getenv("PARAM_MERGE_ENABLE", "0"))
+    merge_max_count = int(os.getenv("PARAM_MERGE_MAX_COUNT", "1"))
+
+    cur_tag = 1
+
+    tb.set_idle_generator(idle_inserter)
+    tb.set_backpressure_generator(backpressure_inserter)
+
+    await tb.cycle_reset()
+
+    await tb.rc.enumerate()
+
+    dev = tb.rc.find_device(tb.dev.functions[0].pcie_id)
+    await dev.enable_device()
+    await dev.set_master()
+
+    mem = tb.rc.mem_pool.alloc_region(16*1024*1024)
+    mem_base = mem.get_absolute_address(0)
+
+    tb.dut.requester_id <= tb.dev.bus_num << 8
+    tb.dut.enable <= 1
+
+    req_count = 0
+
+    async def count_reqs():
+        nonlocal req_count
+        while True:
+            await RisingEdge(dut.clk)
+            if dut.stat_rd_req_start_valid.value.integer:
+                req_count += 1
+
+    cocotb.start_soon(count_reqs())
+
+    max_read_req = 128 << dut.max_read_request_size.value.integer
+
+    for block_len, pcie_stride in itertools.product([4, 8, 16, 32, byte_lanes], [0, 1]):
+        pcie_stride = block_len*(pcie_stride+1)
+        for block_count in [1, 4, 16, 64]:
+            tb.log.info("block length %d, pcie stride %d, block count %d", block_len, pcie_stride, block_count)
+            pcie_addr = 0x1000
+            ram_addr = 0x1000
+            length = block_len*block_count
+            test_data = bytearray([x % 256 for x in range(pcie_stride*block_count)])
+
+            mem[pcie_addr:pcie_addr+len(test_data)] = test_data
+            test_data = b''.join(test_data[k*pcie_stride:k*pcie_stride+block_len] for k in range(block_count))
+
+            tb.dma_ram.write(ram_addr-256, b'\xaa'*(len(test_data)+512))
+
+            req_count = 0
+            tags = set()
+
+            # descriptors into adjacent RAM, issued back to back; only those
+            # that are also adjacent in host memory can be merged
+            for k in range(block_count):
+                desc = DescTransaction(pcie_addr=mem_base+pcie_addr+k*pcie_stride, ram_addr=ram_addr+k*block_len, ram_sel=0, len=block_len, tag=cur_tag)
+                await tb.read_desc_source.send(desc)
+                tags.add(cur_tag)
+                cur_tag = (cur_tag + 1) % tag_count
+
+            # operations may complete out of order
+            for k in range(block_count):
+                status = await tb.read_desc_status_sink.recv()
+
+                tb.log.debug("status: %s", status)
+
+                assert int(status.tag) in tags
+                assert int(status.error) == 0
+
+                tags.remove(int(status.tag))
+
+            tb.log.info("%d descriptors, %d read requests", block_count, req_count)
+
+            if merge and pcie_stride == block_len:
+                merge_count = min(merge_max_count, max_read_req // block_len)
+                assert req_count == (block_count + merge_count - 1) // merge_count
+            else:
+                assert req_count == block_count
+
+            tb.log.debug("%s", tb.dma_ram.hexdump_str((ram_addr & ~0xf)-16, (((ram_addr & 0xf)+length-1) & ~0xf)+48, prefix="RAM "))
+
+            assert tb.dma_ram.read(ram_addr-8, len(test_data)+16) == b'\xaa'*8+test_data+b'\xaa'*8
+
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+
+
+
+async def run_test_read_tags(dut):
+
+    tb = TB(dut)
+
+    tag_count = 2**len(tb.read_desc_source.bus.tag)
+    ten_bit_tag = int(dut.ten_bit_tag_enable.value)
+
+    cur_tag = 1
+
+    await tb.cycle_reset()
+
+    await tb.rc.enumerate()
+
+    dev = tb.rc.find_device(tb.dev.functions[0].pcie_id)
+    await dev.enable_device()
+    await dev.set_master()
+
+    mem = tb.rc.mem_pool.alloc_region(16*1024*1024)
+    mem_base = mem.get_absolute_address(0)
+
+    tb.dut.requester_id <= tb.dev.bus_num << 8
+    tb.dut.enable <= 1
+
+    req_tags = []
+    hdr_tags = []
+
+    async def monitor_tags():
+        while True:
+            await RisingEdge(dut.clk)
+            if dut.stat_rd_req_start_valid.value.integer:
+                req_tags.append(dut.stat_rd_req_start_tag.value.integer)
+            if dut.tx_rd_req_tlp_valid.value.integer and dut.tx_rd_req_tlp_ready.value.integer and dut.tx_rd_req_tlp_sop.value.integer:
+                hdr = dut.tx_rd_req_tlp_hdr.value.integer
+                tag = (hdr >> 72) & 0xff
+                tag |= ((hdr >> 115) & 1) << 8  # T8
+                tag |= ((hdr >> 119) & 1) << 9  # T9
+                hdr_tags.append(tag)
+
+    cocotb.start_soon(monitor_tags())
+
+    # hold completions so that requests pile up and use up the tag space
+    tb.dev.rx_cpl_tlp_source.pause = True
+
+    block_len = 4
+    block_count = 384
+    pcie_addr = 0x1000
+    ram_addr = 0x1000
+    length = block_len*block_count
+    test_data = bytearray([x % 256 for x in range(length)])
+
+    # leave gaps in host memory so that descriptors are never merged
+    for k in range(block_count):
+        mem[pcie_addr+k*block_len*2:pcie_addr+k*block_len*2+block_len] = test_data[k*block_len:(k+1)*block_len]
+
+    tb.dma_ram.write(ram_addr-256, b'\xaa'*(len(test_data)+512))
+
+    for k in range(block_count):
+        desc = DescTransaction(pcie_addr=mem_base+pcie_addr+k*block_len*2, ram_addr=ram_addr+k*block_len, ram_sel=0, len=block_len, tag=cur_tag)
+        await tb.read_desc_source.send(desc)
+        cur_tag = (cur_tag + 1) % tag_count
+
+    for k in range(block_count*4):
+        await RisingEdge(dut.clk)
+        if len(req_tags) >= block_count:
+            break
+
+    tb.log.info("%d requests outstanding, max tag %d", len(req_tags), max(req_tags))
+
+    tb.dev.rx_cpl_tlp_source.pause = False
+
+    for k in range(block_count):
+        status = await tb.read_desc_status_sink.recv()
+
+        tb.log.debug("status: %s", status)
+
+        assert int(status.error) == 0
+
+    # tag bits 9:8 must go out in T9:T8
+    assert hdr_tags == req_tags
+
+    if ten_bit_tag:
+        assert len(req_tags) == block_count
+        assert max(req_tags) > 255
+    else:
+        assert max(req_tags) <= 255
+
+    tb.log.debug("%s", tb.dma_ram.hexdump_str((ram_addr & ~0xf)-16, (((ram_addr & 0xf)+length-1) & ~0xf)+48, prefix="RAM "))
+
+    assert tb.dma_ram.read(ram_addr-8, len(test_data)+16) == b'\xaa'*8+test_data+b'\xaa'*8
+
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+
+
 def cycle_pause():
     return itertools.cycle([1, 1, 1, 0])
 
@@ -294,12 +485,16 @@ if cocotb.SIM_NAME:
     for test in [
                 run_test_read,
                 run_test_read_errors,
+                run_test_read_burst,
             ]:
 
         factory = TestFactory(test)
         factory.add_option(("idle_inserter", "backpressure_inserter"), [(None, None), (cycle_pause, cycle_pause)])
         factory.generate_tests()
 
+    factory = TestFactory(run_test_read_tags)
+    factory.generate_tests()
+
 
 # cocotb-test
 
@@ -318,9 +513,10 @@ def get_verilator_compile_args():
     ]
 
 
+@pytest.mark.parametrize("merge_enable", [0, 1])
 @pytest.mark.parametrize("pcie_offset", list(range(4))+list(range(4096-4, 4096)))
 @pytest.mark.parametrize("pcie_data_width", [64, 128, 256, 512])
-def test_dma_if_pcie_rd(request, pcie_data_width, pcie_offset):
+def test_dma_if_pcie_rd(request, pcie_data_width, pcie_offset, merge_enable):
     dut = "dma_if_pcie_rd"
     module = os.path.splitext(os.path.basename(__file__))[0]
     toplevel = dut
@@ -353,6 +549,9 @@ def test_dma_if_pcie_rd(request, pcie_data_width, pcie_offset):
     parameters['CPLD_FC_LIMIT'] = parameters['CPLH_FC_LIMIT']*4
     parameters['TLP_FORCE_64_BIT_ADDR'] = 0
     parameters['CHECK_BUS_NUMBER'] = 0
+    parameters['MERGE_ENABLE'] = merge_enable
+    parameters['MERGE_TIMEOUT'] = 16
+    parameters['MERGE_MAX_COUNT'] = 4
 
     extra_env = {f'PARAM_{k}': str(v) for k, v in parameters.items()}
 
@@ -427,3 +626,55 @@ def test_dma_if_pcie_rd_multi_beat_alignment(request, pcie_offset):
         sim_build=sim_build,
         extra_env=extra_env,
     )
+
+
+@pytest.mark.parametrize("pcie_tag_count", [256, 1024])
+def test_dma_if_pcie_rd_ten_bit_tag(request, pcie_tag_count):
+    dut = "dma_if_pcie_rd"
+    module = os.path.splitext(os.path.basename(__file__))[0]
+    toplevel = dut
+
+    verilog_sources = [
+        os.path.join(rtl_dir, f"{dut}.v"),
+    ]
+
+    parameters = {}
+
+    parameters['TLP_DATA_WIDTH'] = 256
+    parameters['TLP_HDR_WIDTH'] = 128
+    parameters['TLP_SEG_COUNT'] = 1
+    parameters['TX_SEQ_NUM_COUNT'] = 1
+    parameters['TX_SEQ_NUM_WIDTH'] = 6
+    parameters['TX_SEQ_NUM_ENABLE'] = 1
+    parameters['RAM_SEL_WIDTH'] = 2
+    parameters['RAM_ADDR_WIDTH'] = 16
+    parameters['RAM_SEG_COUNT'] = parameters['TLP_SEG_COUNT']*2
+    parameters['RAM_SEG_DATA_WIDTH'] = parameters['TLP_DATA_WIDTH']*2 // parameters['RAM_SEG_COUNT']
+    parameters['RAM_SEG_BE_WIDTH'] = parameters['RAM_SEG_DATA_WIDTH'] // 8
+    parameters['RAM_SEG_ADDR_WIDTH'] = parameters['RAM_ADDR_WIDTH'] - (parameters['RAM_SEG_COUNT']*parameters['RAM_SEG_BE_WIDTH']-1).bit_length()
+    parameters['PCIE_ADDR_WIDTH'] = 64
+    parameters['PCIE_TAG_COUNT'] = pcie_tag_count
+    parameters['LEN_WIDTH'] = 20
+    parameters['TAG_WIDTH'] = 8
+    parameters['OP_TABLE_SIZE'] = parameters['PCIE_TAG_COUNT']
+    parameters['TX_LIMIT'] = 2**(parameters['TX_SEQ_NUM_WIDTH']-1)
+    parameters['CPLH_FC_LIMIT'] = 512
+    parameters['CPLD_FC_LIMIT'] = parameters['CPLH_FC_LIMIT']*4
+    parameters['TLP_FORCE_64_BIT_ADDR'] = 0
+    parameters['CHECK_BUS_NUMBER'] = 0
+
+    extra_env = {f'PARAM_{k}': str(v) for k, v in parameters.items()}
+
+    sim_build = os.path.join(tests_dir, "sim_build",
+        request.node.name.replace('[', '-').replace(']', ''))
+
+    cocotb_test.simulator.run(
+        python_search=[tests_dir],
+        verilog_sources=verilog_sources,
+        verilog_compile_args=get_verilator_compile_args(),
+        toplevel=toplevel,
+        module=module,
+        parameters=parameters,
+        sim_build=sim_build,
+        extra_env=extra_env,
+    )
@@ -322,6 +322,103 @@ async def run_test_read_errors(dut, idle_inserter=None, backpressure_inserter=No
     await RisingEdge(dut.clk)
 
 
+async def run_test_read_burst(dut, idle_inserter=None, backpressure_inserter=None):
+
+    tb = TB(dut)
+
+    byte_lanes = tb.dma_ram.byte_lanes
+    tag_count = 2**len(tb.read_desc_source.bus.tag)
+    merge = int(os.getenv("PARAM_MERGE_ENABLE", "0"))
+    merge_max_count = int(os.getenv("PARAM_MERGE_MAX_COUNT", "1"))
+
+    cur_tag = 1
+
+    tb.set_idle_generator(idle_inserter)
+    tb.set_backpressure_generator(backpressure_inserter)
+
+    await FallingEdge(dut.rst)
+    await Timer(100, 'ns')
+
+    await tb.rc.enumerate()
+
+    dev = tb.rc.find_device(tb.dev.functions[0].pcie_id)
+    await dev.enable_device()
+    await dev.set_master()
+
+    mem = tb.rc.mem_pool.alloc_region(16*1024*1024)
+    mem_base = mem.get_absolute_address(0)
+
+    tb.dut.enable.value = 1
+
+    req_count = 0
+
+    async def count_reqs():
+        nonlocal req_count
+        while True:
+            await RisingEdge(dut.clk)
+            if dut.stat_rd_req_finish_valid.value.integer:
+                req_count += 1
+
+    cocotb.start_soon(count_reqs())
+
+    max_read_req = 128 << dut.max_read_request_size.value.integer
+
+    for block_len, pcie_stride in itertools.product([4, 8, 16, 32, byte_lanes], [0, 1]):
+        pcie_stride = block_len*(pcie_stride+1)
+        for block_count in [1, 4, 16, 64]:
+            tb.log.info("block length %d, pcie stride %d, block count %d", block_len, pcie_stride, block_count)
+            pcie_addr = 0x1000
+            ram_addr = 0x1000
+            length = block_len*block_count
+            test_data = bytearray([x % 256 for x in range(pcie_stride*block_count)])
+
+            mem[pcie_addr:pcie_addr+len(test_data)] = test_data
+            test_data = b''.join(test_data[k*pcie_stride:k*pcie_stride+block_len] for k in range(block_count))
+
+            tb.dma_ram.write(ram_addr-256, b'\xaa'*(len(test_data)+512))
+
+            req_count = 0
+            tags = set()
+
+            # descriptors into adjacent RAM, issued back to back; only those
+            # that are also adjacent in host memory can be merged
+            for k in range(block_count):
+                desc = DescTransaction(pcie_addr=mem_base+pcie_addr+k*pcie_stride, ram_addr=ram_addr+k*block_len, ram_sel=0, len=block_len, tag=cur_tag)
+                await tb.read_desc_source.send(desc)
+                tags.add(cur_tag)
+                cur_tag = (cur_tag + 1) % tag_count
+
+            # operations may complete out of order
+            for k in range(block_count):
+                status = await tb.read_desc_status_sink.recv()
+
+                tb.log.debug("status: %s", status)
+
+                assert int(status.tag) in tags
+                assert int(status.error) == 0
+
+                tags.remove(int(status.tag))
+
+            # let the last request finish
+            for k in range(4):
+                await RisingEdge(dut.clk)
+
+            tb.log.info("%d descriptors, %d read requests", block_count, req_count)
+
+            if merge and pcie_stride == block_len:
+                merge_count = min(merge_max_count, max_read_req // block_len)
+                assert req_count == (block_count + merge_count - 1) // merge_count
+            else:
+                assert req_count == block_count
+
+            tb.log.debug("%s", tb.dma_ram.hexdump_str((ram_addr & ~0xf)-16, (((ram_addr & 0xf)+length-1) & ~0xf)+48, prefix="RAM "))
+
+            assert tb.dma_ram.read(ram_addr-8, len(test_data)+16) == b'\xaa'*8+test_data+b'\xaa'*8
+
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+
+
 def cycle_pause():
     return itertools.cycle([1, 1, 1, 0])
 
@@ -331,6 +428,7 @@ if cocotb.SIM_NAME:
     for test in [
                 run_test_read,
                 run_test_read_errors,
+                run_test_read_burst,
             ]:
 
         factory = TestFactory(test)
@@ -344,9 +442,10 @@ tests_dir = os.path.dirname(__file__)
 rtl_dir = os.path.abspath(os.path.join(tests_dir, '..', '..', 'rtl'))
 
 
+@pytest.mark.parametrize("merge_enable", [0, 1])
 @pytest.mark.parametrize("pcie_offset", list(range(4))+list(range(4096-4, 4096)))
 @pytest.mark.parametrize("axis_pcie_data_width", [64, 128, 256, 512])
-def test_dma_if_pcie_us_rd(request, axis_pcie_data_width, pcie_offset):
+def test_dma_if_pcie_us_rd(request, axis_pcie_data_width, pcie_offset, merge_enable):
     dut = "dma_if_pcie_us_rd"
     module = os.path.splitext(os.path.basename(__file__))[0]
     toplevel = dut
@@ -376,6 +475,9 @@ def test_dma_if_pcie_us_rd(request, axis_pcie_data_width, pcie_offset):
     parameters['OP_TABLE_SIZE'] = parameters['PCIE_TAG_COUNT']
     parameters['TX_LIMIT'] = 2**(parameters['RQ_SEQ_NUM_WIDTH']-1)
     parameters['TX_FC_ENABLE'] = 1
+    parameters['MERGE_ENABLE'] = merge_enable
+    parameters['MERGE_TIMEOUT'] = 16
+    parameters['MERGE_MAX_COUNT'] = 4
 
     extra_env = {f'PARAM_{k}': str(v) for k, v in parameters.items()}
 
@@ -240,6 +240,99 @@ async def run_test_write(dut, idle_inserter=None, backpressure_inserter=None):
     await RisingEdge(dut.clk)
 
 
+async def run_test_write_burst(dut, idle_inserter=None, backpressure_inserter=None):
+
+    tb = TB(dut)
+
+    byte_lanes = tb.dma_ram.byte_lanes
+    tag_count = 2**len(tb.write_desc_source.bus.tag)
+    coalesce = int(os.getenv("PARAM_COALESCE_ENABLE", "0"))
+    coalesce_max_count = int(os.getenv("PARAM_COALESCE_MAX_COUNT", "1"))
+
+    cur_tag = 1
+
+    tb.set_idle_generator(idle_inserter)
+    tb.set_backpressure_generator(backpressure_inserter)
+
+    await FallingEdge(dut.rst)
+    await Timer(100, 'ns')
+
+    await tb.rc.enumerate()
+
+    dev = tb.rc.find_device(tb.dev.functions[0].pcie_id)
+    await dev.enable_device()
+    await dev.set_master()
+
+    mem = tb.rc.mem_pool.alloc_region(16*1024*1024)
+    mem_base = mem.get_absolute_address(0)
+
+    tb.dut.enable.value = 1
+
+    req_count = 0
+
+    async def count_reqs():
+        nonlocal req_count
+        while True:
+            await RisingEdge(dut.clk)
+            if dut.m_axis_rq_tvalid.value.integer and dut.m_axis_rq_tready.value.integer and dut.m_axis_rq_tlast.value.integer:
+                req_count += 1
+
+    cocotb.start_soon(count_reqs())
+
+    max_payload = 128 << dut.max_payload_size.value.integer
+
+    for block_len, pcie_stride in itertools.product([4, 8, 16, 32, byte_lanes], [0, 1]):
+        pcie_stride = block_len*(pcie_stride+1)
+        for block_count in [1, 4, 16, 64]:
+            tb.log.info("block length %d, pcie stride %d, block count %d", block_len, pcie_stride, block_count)
+            pcie_addr = 0x1000
+            ram_addr = 0x1000
+            length = pcie_stride*block_count
+            test_data = bytearray([x % 256 for x in range(block_len*block_count)])
+
+            tb.dma_ram.write(ram_addr & 0xffff80, b'\x55'*(len(test_data)+256))
+            mem[pcie_addr-128:pcie_addr-128+length+256] = b'\xaa'*(length+256)
+            tb.dma_ram.write(ram_addr, test_data)
+
+            req_count = 0
+            tags = []
+
+            # descriptors from adjacent RAM, issued back to back; only those
+            # that are also adjacent in host memory can be coalesced
+            for k in range(block_count):
+                desc = DescTransaction(pcie_addr=mem_base+pcie_addr+k*pcie_stride, ram_addr=ram_addr+k*block_len, ram_sel=0, len=block_len, tag=cur_tag)
+                await tb.write_desc_source.send(desc)
+                tags.append(cur_tag)
+                cur_tag = (cur_tag + 1) % tag_count
+
+            for tag in tags:
+                status = await tb.write_desc_status_sink.recv()
+
+                tb.log.debug("status: %s", status)
+
+                assert int(status.tag) == tag
+                assert int(status.error) == 0
+
+            await Timer(100 + (length // byte_lanes), 'ns')
+
+            tb.log.info("%d descriptors, %d write requests", block_count, req_count)
+
+            if coalesce and pcie_stride == block_len:
+                coalesce_count = min(coalesce_max_count, max_payload // block_len)
+                assert req_count == (block_count + coalesce_count - 1) // coalesce_count
+            else:
+                assert req_count == block_count
+
+            tb.log.debug("%s", hexdump_str(mem, (pcie_addr & ~0xf)-16, (((pcie_addr & 0xf)+length-1) & ~0xf)+48, prefix="PCIe "))
+
+            test_data = b''.join(test_data[k*block_len:(k+1)*block_len]+b'\xaa'*(pcie_stride-block_len) for k in range(block_count))
+
+            assert mem[pcie_addr-1:pcie_addr+length+1] == b'\xaa'+test_data+b'\xaa'
+
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+
+
 def cycle_pause():
     return itertools.cycle([1, 1, 1, 0])
 
@@ -250,6 +343,10 @@ if cocotb.SIM_NAME:
     factory.add_option(("idle_inserter", "backpressure_inserter"), [(None, None), (cycle_pause, cycle_pause)])
     factory.generate_tests()
 
+    factory = TestFactory(run_test_write_burst)
+    factory.add_option(("idle_inserter", "backpressure_inserter"), [(None, None), (cycle_pause, cycle_pause)])
+    factory.generate_tests()
+
 
 # cocotb-test
 
@@ -257,9 +354,10 @@ tests_dir = os.path.dirname(__file__)
 rtl_dir = os.path.abspath(os.path.join(tests_dir, '..', '..', 'rtl'))
 
 
+@pytest.mark.parametrize("coalesce_enable", [0, 1])
 @pytest.mark.parametrize("pcie_offset", list(range(4))+list(range(4096-4, 4096)))
 @pytest.mark.parametrize("axis_pcie_data_width", [64, 128, 256, 512])
-def test_dma_if_pcie_us_wr(request, axis_pcie_data_width, pcie_offset):
+def test_dma_if_pcie_us_wr(request, axis_pcie_data_width, pcie_offset, coalesce_enable):
     dut = "dma_if_pcie_us_wr"
     module = os.path.splitext(os.path.basename(__file__))[0]
     toplevel = dut
@@ -288,6 +386,9 @@ def test_dma_if_pcie_us_wr(request, axis_pcie_data_width, pcie_offset):
     parameters['OP_TABLE_SIZE'] = 2**(parameters['RQ_SEQ_NUM_WIDTH']-1)
     parameters['TX_LIMIT'] = 2**(parameters['RQ_SEQ_NUM_WIDTH']-1)
     parameters['TX_FC_ENABLE'] = 1
+    parameters['COALESCE_ENABLE'] = coalesce_enable
+    parameters['COALESCE_TIMEOUT'] = 16
+    parameters['COALESCE_MAX_COUNT'] = 16
 
     extra_env = {f'PARAM_{k}': str(v) for k, v in parameters.items()}
 
@@ -141,6 +141,11 @@ class TB(object):
 
         dut.completer_id.setimmediatevalue(0)
         dut.completer_id_enable.setimmediatevalue(0)
+        dut.prefetch_invalidate.setimmediatevalue(0)
+
+        # monitor AXI read bursts
+        self.ar_count = 0
+        cocotb.start_soon(self._run_monitor_ar())
 
         # monitor error outputs
         self.status_error_cor_asserted = False
@@ -158,6 +163,18 @@ class TB(object):
             self.dev.cc_sink.set_pause_generator(generator())
             self.axi_ram.ar_channel.set_pause_generator(generator())
 
+    async def _run_monitor_ar(self):
+        while True:
+            await RisingEdge(self.dut.clk)
+            if self.dut.m_axi_arvalid.value.integer and self.dut.m_axi_arready.value.integer:
+                self.ar_count += 1
+
+    async def invalidate_prefetch(self):
+        self.dut.prefetch_invalidate.value = 1
+        await RisingEdge(self.dut.clk)
+        self.dut.prefetch_invalidate.value = 0
+        await RisingEdge(self.dut.clk)
+
     async def _run_monitor_status_error_cor(self):
         while True:
             await RisingEdge(self.dut.status_error_cor)
@@ -203,6 +220,7 @@ async def run_test_read(dut, idle_inserter=None, backpressure_inserter=None):
 
             tb.axi_ram.write(pcie_addr-128, b'\x55'*(len(test_data)+256))
             tb.axi_ram.write(pcie_addr, test_data)
+            await tb.invalidate_prefetch()
 
             tb.log.debug("%s", tb.axi_ram.hexdump_str((pcie_addr & ~0xf)-16, (((pcie_addr & 0xf)+length-1) & ~0xf)+48, prefix="AXI "))
 
@@ -219,6 +237,70 @@ async def run_test_read(dut, idle_inserter=None, backpressure_inserter=None):
     await RisingEdge(dut.clk)
 
 
+async def run_test_prefetch(dut, idle_inserter=None, backpressure_inserter=None):
+
+    tb = TB(dut)
+
+    byte_lanes = tb.axi_ram.byte_lanes
+
+    prefetch_enable = int(os.getenv("PARAM_PREFETCH_ENABLE", "0"))
+    line_size = max(int(os.getenv("PARAM_PREFETCH_SIZE", "64")), byte_lanes)
+
+    tb.set_idle_generator(idle_inserter)
+    tb.set_backpressure_generator(backpressure_inserter)
+
+    await FallingEdge(dut.rst)
+    await Timer(100, 'ns')
+
+    await tb.rc.enumerate()
+
+    dev = tb.rc.find_device(tb.dev.functions[0].pcie_id)
+    await dev.enable_device()
+
+    dev_bar0 = dev.bar_window[0]
+
+    pcie_addr = 0x1000
+    test_data = bytearray([x % 256 for x in range(line_size*4)])
+
+    tb.axi_ram.write(pcie_addr, test_data)
+    await tb.invalidate_prefetch()
+
+    tb.log.info("Sequential dword reads")
+
+    ar_count = tb.ar_count
+
+    for offset in range(0, len(test_data), 4):
+        val = await dev_bar0.read(pcie_addr+offset, 4, timeout=10000, timeout_unit='ns')
+
+        assert val == test_data[offset:offset+4]
+
+    ar_count = tb.ar_count - ar_count
+
+    tb.log.info("AXI read bursts: %d", ar_count)
+
+    if prefetch_enable:
+        assert ar_count == len(test_data) // line_size
+    else:
+        assert ar_count == len(test_data) // 4
+
+    tb.log.info("Read after invalidate")
+
+    val = await dev_bar0.read(pcie_addr, 4, timeout=10000, timeout_unit='ns')
+    assert val == test_data[0:4]
+
+    tb.axi_ram.write(pcie_addr, b'\xaa'*4)
+    await tb.invalidate_prefetch()
+
+    val = await dev_bar0.read(pcie_addr, 4, timeout=10000, timeout_unit='ns')
+    assert val == b'\xaa'*4
+
+    assert not tb.status_error_cor_asserted
+    assert not tb.status_error_uncor_asserted
+
+    await RisingEdge(dut.clk)
+    await RisingEdge(dut.clk)
+
+
 async def run_test_bad_ops(dut, idle_inserter=None, backpressure_inserter=None):
 
     tb = TB(dut)
@@ -309,7 +391,7 @@ def cycle_pause():
 
 if cocotb.SIM_NAME:
 
-    for test in [run_test_read, run_test_bad_ops]:
+    for test in [run_test_read, run_test_prefetch, run_test_bad_ops]:
 
         factory = TestFactory(test)
         factory.add_option(("idle_inserter", "backpressure_inserter"), [(None, None), (cycle_pause, cycle_pause)])
@@ -323,8 +405,9 @@ rtl_dir = os.path.abspath(os.path.join(tests_dir, '..', '..', 'rtl'))
 
 
 @pytest.mark.parametrize("offset_group", list(range(8)))
+@pytest.mark.parametrize("prefetch_enable", [0, 1])
 @pytest.mark.parametrize("axis_pcie_data_width", [64, 128, 256, 512])
-def test_pcie_us_axi_master_rd(request, axis_pcie_data_width, offset_group):
+def test_pcie_us_axi_master_rd(request, axis_pcie_data_width, prefetch_enable, offset_group):
     dut = "pcie_us_axi_master_rd"
     module = os.path.splitext(os.path.basename(__file__))[0]
     toplevel = dut
@@ -344,6 +427,9 @@ def test_pcie_us_axi_master_rd(request, axis_pcie_data_width, offset_group):
     parameters['AXI_STRB_WIDTH'] = parameters['AXI_DATA_WIDTH'] // 8
     parameters['AXI_ID_WIDTH'] = 8
     parameters['AXI_MAX_BURST_LEN'] = 256
+    parameters['PREFETCH_ENABLE'] = prefetch_enable
+    parameters['PREFETCH_SIZE'] = 64
+    parameters['PREFETCH_LIFETIME'] = 1024
 
     extra_env = {f'PARAM_{k}': str(v) for k, v in parameters.items()}
 
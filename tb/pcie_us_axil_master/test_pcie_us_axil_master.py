@@ -190,8 +190,8 @@ async def run_test_write(dut, idle_inserter=None, backpressure_inserter=None):
     dev_bar0 = dev.bar_window[0]
     dev_bar1 = dev.bar_window[1]
 
-    for length in range(0, 5):
-        for pcie_offset in range(4-length+1):
+    for length in list(range(0, 5))+[8, 16, 32, 64, 66]:
+        for pcie_offset in range(max(4-length+1, 4)):
             tb.log.info("length %d, pcie_offset %d", length, pcie_offset)
             pcie_addr = pcie_offset+0x1000
             test_data = bytearray([x % 256 for x in range(length)])
@@ -200,7 +200,8 @@ async def run_test_write(dut, idle_inserter=None, backpressure_inserter=None):
 
             await dev_bar0.write(pcie_addr, test_data)
 
-            await Timer(100, 'ns')
+            # wait for write to complete
+            val = await dev_bar0.read(0, 4, timeout=10000, timeout_unit='ns')
 
             tb.log.debug("%s", tb.axil_ram.hexdump_str((pcie_addr & ~0xf)-16, (((pcie_addr & 0xf)+length-1) & ~0xf)+48))
 
@@ -354,28 +355,6 @@ async def run_test_bad_ops(dut, idle_inserter=None, backpressure_inserter=None):
     dev_bar0 = dev.bar_window[0]
     dev_bar1 = dev.bar_window[1]
 
-    tb.log.info("Test bad write")
-
-    length = 32
-    pcie_addr = 0x1000
-    test_data = bytearray([x % 256 for x in range(length)])
-
-    tb.axil_ram.write(pcie_addr-128, b'\x55'*(len(test_data)+256))
-
-    await dev_bar0.write(pcie_addr, test_data)
-
-    await Timer(100, 'ns')
-
-    tb.log.debug("%s", tb.axil_ram.hexdump_str((pcie_addr & ~0xf)-16, (((pcie_addr & 0xf)+length-1) & ~0xf)+48, prefix="AXI "))
-
-    assert tb.axil_ram.read(pcie_addr-1, len(test_data)+2) == b'\x55'*(len(test_data)+2)
-
-    assert not tb.status_error_cor_asserted
-    assert tb.status_error_uncor_asserted
-
-    tb.status_error_cor_asserted = False
-    tb.status_error_uncor_asserted = False
-
     tb.log.info("Test bad read")
 
     length = 32